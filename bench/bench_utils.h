@@ -0,0 +1,39 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <vector>
+#include "dsptk/signals.h"
+
+namespace bench {
+
+	const double sampleRate = 48000.;
+
+	/**
+	 * @brief Reports samples/second (items_per_second) and the time per sample for a case processing samplesPerIteration.
+	 * The console shows time_per_sample with its unit (e.g. 4.2ns), the JSON output holds it in seconds.
+	*/
+	inline void SetSamplesProcessed(benchmark::State& state, std::int64_t samplesPerIteration) {
+		state.SetItemsProcessed(state.iterations() * samplesPerIteration);
+		state.counters["time_per_sample"] = benchmark::Counter(
+			(double)samplesPerIteration,
+			benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+	}
+
+	/**
+	 * @brief Reproducible uniform noise in [-gain, gain), the input of most cases.
+	*/
+	inline std::vector<double> Noise(std::size_t size, double gain = 1.) {
+		std::vector<double> signal(size);
+		dsptk::WhiteNoise noise(dsptk::WhiteNoise::Distribution::Uniform, gain, 1234);
+		noise.Generate(signal.data(), (int)signal.size());
+		return signal;
+	}
+
+	/**
+	 * @brief Block sizes swept by the per block cases.
+	*/
+	inline void BlockSizes(benchmark::internal::Benchmark* b) {
+		b->RangeMultiplier(4)->Range(64, 16384);
+	}
+}
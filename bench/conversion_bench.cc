@@ -0,0 +1,77 @@
+#include <cstdint>
+#include <vector>
+#include "bench_utils.h"
+#include "dsptk/audiobuffer.h"
+#include "dsptk/conversion.h"
+
+namespace conversion {
+
+	// Args: channels, frames per block. Samples processed count every channel.
+	static void ConversionArgs(benchmark::internal::Benchmark* b) {
+		for (int channels : { 2, 8, 64 }) {
+			b->Args({ channels, 1024 });
+		}
+	}
+
+	static void DeinterleaveInt16(benchmark::State& state) {
+		const int numChannels = (int)state.range(0);
+		const int nFrames = (int)state.range(1);
+		std::vector<std::int16_t> input((std::size_t)numChannels * nFrames);
+		const auto noise = bench::Noise(input.size());
+		for (std::size_t i = 0; i < input.size(); i++) {
+			input[i] = (std::int16_t)(noise[i] * 32767.);
+		}
+		dsptk::AudioBuffer<double> output(numChannels, nFrames);
+		for (auto _ : state) {
+			dsptk::Deinterleave(input.data(), dsptk::SampleFormat::Int16, output);
+			benchmark::DoNotOptimize(output.GetChannel(0).data());
+		}
+		bench::SetSamplesProcessed(state, (std::int64_t)input.size());
+	}
+	BENCHMARK(DeinterleaveInt16)->Apply(ConversionArgs);
+
+	static void DeinterleaveInt24(benchmark::State& state) {
+		const int numChannels = (int)state.range(0);
+		const int nFrames = (int)state.range(1);
+		std::vector<unsigned char> input((std::size_t)numChannels * nFrames * 3, 0x5a);
+		dsptk::AudioBuffer<double> output(numChannels, nFrames);
+		for (auto _ : state) {
+			dsptk::Deinterleave(input.data(), dsptk::SampleFormat::Int24, output);
+			benchmark::DoNotOptimize(output.GetChannel(0).data());
+		}
+		bench::SetSamplesProcessed(state, (std::int64_t)numChannels * nFrames);
+	}
+	BENCHMARK(DeinterleaveInt24)->Apply(ConversionArgs);
+
+	static void InterleaveInt16(benchmark::State& state, bool dithered) {
+		const int numChannels = (int)state.range(0);
+		const int nFrames = (int)state.range(1);
+		dsptk::AudioBuffer<double> input(numChannels, nFrames);
+		const auto noise = bench::Noise(nFrames);
+		for (int c = 0; c < numChannels; c++) {
+			std::copy(noise.begin(), noise.end(), input[c].begin());
+		}
+		std::vector<std::int16_t> output((std::size_t)numChannels * nFrames);
+		dsptk::TpdfDither dither(1);
+		for (auto _ : state) {
+			dsptk::Interleave(input.GetView(), output.data(), dsptk::SampleFormat::Int16, dithered ? &dither : nullptr);
+			benchmark::DoNotOptimize(output.data());
+		}
+		bench::SetSamplesProcessed(state, (std::int64_t)output.size());
+	}
+	BENCHMARK_CAPTURE(InterleaveInt16, plain, false)->Apply(ConversionArgs);
+	BENCHMARK_CAPTURE(InterleaveInt16, dithered, true)->Apply(ConversionArgs);
+
+	static void InterleaveFloat(benchmark::State& state) {
+		const int numChannels = (int)state.range(0);
+		const int nFrames = (int)state.range(1);
+		dsptk::AudioBuffer<double> input(numChannels, nFrames);
+		std::vector<float> output((std::size_t)numChannels * nFrames);
+		for (auto _ : state) {
+			dsptk::Interleave(input.GetView(), output.data(), dsptk::SampleFormat::Float32);
+			benchmark::DoNotOptimize(output.data());
+		}
+		bench::SetSamplesProcessed(state, (std::int64_t)output.size());
+	}
+	BENCHMARK(InterleaveFloat)->Apply(ConversionArgs);
+}
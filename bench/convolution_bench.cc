@@ -0,0 +1,37 @@
+#include <vector>
+#include "bench_utils.h"
+#include "dsptk/convolution.h"
+#include "dsptk/signals.h"
+
+namespace convolution {
+
+	// Input sizes against a 64 taps kernel
+	static void InputSizes(benchmark::internal::Benchmark* b) {
+		for (int size = 256; size <= 16384; size *= 4) {
+			b->Args({ size, 64 });
+		}
+	}
+
+	template <std::vector<double>(*convolve)(const std::vector<double>&, const std::vector<double>&)>
+	static void Convolve(benchmark::State& state) {
+		const auto input = bench::Noise(state.range(0));
+		const auto kernel = bench::Noise(state.range(1));
+		for (auto _ : state) {
+			benchmark::DoNotOptimize(convolve(input, kernel));
+		}
+		bench::SetSamplesProcessed(state, state.range(0));
+	}
+	BENCHMARK_TEMPLATE(Convolve, dsptk::convolve)->Apply(InputSizes);
+	BENCHMARK_TEMPLATE(Convolve, dsptk::convolve_out)->Apply(InputSizes);
+	BENCHMARK_TEMPLATE(Convolve, dsptk::fft_convolve)->Apply(InputSizes)->Args({ 1 << 20, 1 << 16 });
+
+	static void DeconvolveSweep(benchmark::State& state) {
+		const double duration = (double)state.range(0);
+		const auto recorded = dsptk::exponential_sweep(20., 20000., duration, bench::sampleRate);
+		for (auto _ : state) {
+			benchmark::DoNotOptimize(dsptk::deconvolve_sweep(recorded, 20., 20000., duration, bench::sampleRate, 8192, 3));
+		}
+		bench::SetSamplesProcessed(state, (std::int64_t)recorded.size());
+	}
+	BENCHMARK(DeconvolveSweep)->Arg(1)->Arg(10)->Unit(benchmark::kMillisecond);
+}
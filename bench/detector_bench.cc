@@ -0,0 +1,44 @@
+#include <vector>
+#include "bench_utils.h"
+#include "dsptk/detector.h"
+
+namespace detector {
+
+	static void DecoupledPeakDetectorProcessSample(benchmark::State& state) {
+		const auto input = bench::Noise(state.range(0));
+		std::vector<double> output(input.size());
+		dsptk::DecoupledPeakDetector detector(bench::sampleRate, 0.001, 0.1);
+		for (auto _ : state) {
+			for (std::size_t i = 0; i < input.size(); i++) {
+				output[i] = detector.ProcessSample(input[i]);
+			}
+			benchmark::DoNotOptimize(output.data());
+		}
+		bench::SetSamplesProcessed(state, state.range(0));
+	}
+	BENCHMARK(DecoupledPeakDetectorProcessSample)->Apply(bench::BlockSizes);
+
+	static void DecoupledPeakDetectorProcessBlock(benchmark::State& state) {
+		const auto input = bench::Noise(state.range(0));
+		std::vector<double> output(input.size());
+		dsptk::DecoupledPeakDetector detector(bench::sampleRate, 0.001, 0.1);
+		for (auto _ : state) {
+			detector.ProcessBlock(input.data(), output.data(), (int)input.size());
+			benchmark::DoNotOptimize(output.data());
+		}
+		bench::SetSamplesProcessed(state, state.range(0));
+	}
+	BENCHMARK(DecoupledPeakDetectorProcessBlock)->Apply(bench::BlockSizes);
+
+	static void RmsDetectorProcessBlock(benchmark::State& state) {
+		const auto input = bench::Noise(state.range(0));
+		std::vector<double> output(input.size());
+		dsptk::RmsDetector detector(bench::sampleRate, 0.3);
+		for (auto _ : state) {
+			detector.ProcessBlock(input.data(), output.data(), (int)input.size());
+			benchmark::DoNotOptimize(output.data());
+		}
+		bench::SetSamplesProcessed(state, state.range(0));
+	}
+	BENCHMARK(RmsDetectorProcessBlock)->Apply(bench::BlockSizes);
+}
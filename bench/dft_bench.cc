@@ -0,0 +1,37 @@
+#include <complex>
+#include <vector>
+#include "bench_utils.h"
+#include "dsptk/dft.h"
+
+namespace dft {
+
+	static void RealDftAnalysis(benchmark::State& state) {
+		const auto input = bench::Noise(state.range(0));
+		for (auto _ : state) {
+			benchmark::DoNotOptimize(dsptk::real_dft_analysis(input));
+		}
+		bench::SetSamplesProcessed(state, state.range(0));
+	}
+	BENCHMARK(RealDftAnalysis)->RangeMultiplier(4)->Range(16, 1024);
+
+	static void Fft(benchmark::State& state) {
+		const auto input = bench::Noise(state.range(0));
+		std::vector<std::complex<double>> data(input.size());
+		for (auto _ : state) {
+			std::copy(input.begin(), input.end(), data.begin());
+			dsptk::fft(data);
+			benchmark::DoNotOptimize(data.data());
+		}
+		bench::SetSamplesProcessed(state, state.range(0));
+	}
+	BENCHMARK(Fft)->RangeMultiplier(8)->Range(64, 1 << 21);
+
+	static void IfftReal(benchmark::State& state) {
+		const std::vector<std::complex<double>> spectrum(state.range(0) / 2 + 1, { 1., 0.5 });
+		for (auto _ : state) {
+			benchmark::DoNotOptimize(dsptk::ifft_real(spectrum));
+		}
+		bench::SetSamplesProcessed(state, state.range(0));
+	}
+	BENCHMARK(IfftReal)->RangeMultiplier(8)->Range(64, 1 << 21);
+}
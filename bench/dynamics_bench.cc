@@ -0,0 +1,64 @@
+#include <vector>
+#include "bench_utils.h"
+#include "dsptk/dynamics.h"
+
+namespace dynamics {
+
+	static void CompressorProcessBlock(benchmark::State& state, bool gainTable) {
+		auto input = bench::Noise(state.range(0));
+		std::vector<double> output(input.size()), gain(input.size());
+		dsptk::Compressor compressor(-20., 4., 6., bench::sampleRate, 0.005, 0.1);
+		if (gainTable) {
+			compressor.EnableGainTable();
+		}
+		for (auto _ : state) {
+			compressor.ProcessBlock(input.data(), nullptr, output.data(), gain.data(), (int)input.size());
+			benchmark::DoNotOptimize(output.data());
+		}
+		bench::SetSamplesProcessed(state, state.range(0));
+	}
+	BENCHMARK_CAPTURE(CompressorProcessBlock, curve, false)->Apply(bench::BlockSizes);
+	BENCHMARK_CAPTURE(CompressorProcessBlock, table, true)->Apply(bench::BlockSizes);
+
+	static void ExpanderProcessBlock(benchmark::State& state) {
+		auto input = bench::Noise(state.range(0), 0.1);
+		std::vector<double> output(input.size()), gain(input.size());
+		dsptk::Expander expander(-30., 2., -40., bench::sampleRate, 0.001, 0.1);
+		for (auto _ : state) {
+			expander.ProcessBlock(input.data(), nullptr, output.data(), gain.data(), (int)input.size());
+			benchmark::DoNotOptimize(output.data());
+		}
+		bench::SetSamplesProcessed(state, state.range(0));
+	}
+	BENCHMARK(ExpanderProcessBlock)->Apply(bench::BlockSizes);
+
+	static void GateProcessBlock(benchmark::State& state) {
+		auto input = bench::Noise(state.range(0), 0.1);
+		std::vector<double> output(input.size()), gain(input.size());
+		dsptk::Gate gate(-30., -80., bench::sampleRate, 0.001, 0.1);
+		for (auto _ : state) {
+			gate.ProcessBlock(input.data(), nullptr, output.data(), gain.data(), (int)input.size());
+			benchmark::DoNotOptimize(output.data());
+		}
+		bench::SetSamplesProcessed(state, state.range(0));
+	}
+	BENCHMARK(GateProcessBlock)->Apply(bench::BlockSizes);
+
+	static void MultibandCompressorProcessBlock(benchmark::State& state) {
+		const auto input = bench::Noise(state.range(0));
+		std::vector<double> buffer(input.size());
+		dsptk::MultibandCompressor compressor({ 200., 2000., 8000. }, bench::sampleRate);
+		compressor.Prepare(bench::sampleRate, (int)input.size());
+		for (int band = 0; band < compressor.GetNumBands(); band++) {
+			compressor.SetThreshold(band, -20.);
+			compressor.SetRatio(band, 4.);
+		}
+		for (auto _ : state) {
+			std::copy(input.begin(), input.end(), buffer.begin());
+			compressor.ProcessBlock(buffer.data(), (int)buffer.size());
+			benchmark::DoNotOptimize(buffer.data());
+		}
+		bench::SetSamplesProcessed(state, state.range(0));
+	}
+	BENCHMARK(MultibandCompressorProcessBlock)->Apply(bench::BlockSizes);
+}
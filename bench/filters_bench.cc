@@ -0,0 +1,123 @@
+#include <memory>
+#include <vector>
+#include "bench_utils.h"
+#include "dsptk/filters.h"
+
+namespace filters {
+
+	// Each maker builds a filter with typical settings, so cases are templated on the maker
+	struct DCBlocker { static dsptk::DCBlocker Make() { return dsptk::DCBlocker(10., bench::sampleRate); } };
+	struct SinglePoleLowPass { static dsptk::SinglePoleLowPass Make() { return dsptk::SinglePoleLowPass(1000., bench::sampleRate); } };
+	struct SinglePoleHiPass { static dsptk::SinglePoleHiPass Make() { return dsptk::SinglePoleHiPass(1000., bench::sampleRate); } };
+	struct BandPass { static dsptk::BandPassFilter Make() { return dsptk::BandPassFilter(1000., 100., bench::sampleRate); } };
+	struct BandReject { static dsptk::BandRejectFilter Make() { return dsptk::BandRejectFilter(1000., 100., bench::sampleRate); } };
+	struct Parametric { static dsptk::ParametricFilter Make() { return dsptk::ParametricFilter(1000., 100., dsptk::DB(6.), bench::sampleRate); } };
+	struct LowPassShelving { static dsptk::LowPassShelvingFilter Make() { return dsptk::LowPassShelvingFilter(200., dsptk::DB(6.), bench::sampleRate); } };
+	struct HiPassShelving { static dsptk::HiPassShelvingFilter Make() { return dsptk::HiPassShelvingFilter(5000., dsptk::DB(6.), bench::sampleRate); } };
+	struct ButterworthLowPass { static dsptk::ButterworthLowPass Make() { return dsptk::ButterworthLowPass(1000., bench::sampleRate); } };
+	struct ButterworthHiPass { static dsptk::ButterworthHiPass Make() { return dsptk::ButterworthHiPass(1000., bench::sampleRate); } };
+	struct AllPass { static dsptk::AllPassFilter Make() { return dsptk::AllPassFilter(1000., bench::sampleRate); } };
+	struct KWeighting { static dsptk::KWeightingFilter Make() { return dsptk::KWeightingFilter(bench::sampleRate); } };
+
+	template <class Maker>
+	static void ProcessSample(benchmark::State& state) {
+		const auto input = bench::Noise(state.range(0));
+		std::vector<double> output(input.size());
+		auto filter = Maker::Make();
+		for (auto _ : state) {
+			for (std::size_t i = 0; i < input.size(); i++) {
+				output[i] = filter.ProcessSample(input[i]);
+			}
+			benchmark::DoNotOptimize(output.data());
+		}
+		bench::SetSamplesProcessed(state, state.range(0));
+	}
+	BENCHMARK_TEMPLATE(ProcessSample, DCBlocker)->Apply(bench::BlockSizes);
+	BENCHMARK_TEMPLATE(ProcessSample, SinglePoleLowPass)->Apply(bench::BlockSizes);
+	BENCHMARK_TEMPLATE(ProcessSample, SinglePoleHiPass)->Apply(bench::BlockSizes);
+	BENCHMARK_TEMPLATE(ProcessSample, BandPass)->Apply(bench::BlockSizes);
+	BENCHMARK_TEMPLATE(ProcessSample, BandReject)->Apply(bench::BlockSizes);
+	BENCHMARK_TEMPLATE(ProcessSample, Parametric)->Apply(bench::BlockSizes);
+	BENCHMARK_TEMPLATE(ProcessSample, LowPassShelving)->Apply(bench::BlockSizes);
+	BENCHMARK_TEMPLATE(ProcessSample, HiPassShelving)->Apply(bench::BlockSizes);
+	BENCHMARK_TEMPLATE(ProcessSample, ButterworthLowPass)->Apply(bench::BlockSizes);
+	BENCHMARK_TEMPLATE(ProcessSample, ButterworthHiPass)->Apply(bench::BlockSizes);
+	BENCHMARK_TEMPLATE(ProcessSample, AllPass)->Apply(bench::BlockSizes);
+	BENCHMARK_TEMPLATE(ProcessSample, KWeighting)->Apply(bench::BlockSizes);
+
+	// Filters called through the base class pointer, as in a FilterBank
+	template <class Maker>
+	static void ProcessSampleVirtual(benchmark::State& state) {
+		const auto input = bench::Noise(state.range(0));
+		std::vector<double> output(input.size());
+		std::unique_ptr<dsptk::Filter> filter = std::make_unique<decltype(Maker::Make())>(Maker::Make());
+		benchmark::DoNotOptimize(filter.get());
+		for (auto _ : state) {
+			for (std::size_t i = 0; i < input.size(); i++) {
+				output[i] = filter->ProcessSample(input[i]);
+			}
+			benchmark::DoNotOptimize(output.data());
+		}
+		bench::SetSamplesProcessed(state, state.range(0));
+	}
+	BENCHMARK_TEMPLATE(ProcessSampleVirtual, ButterworthLowPass)->Apply(bench::BlockSizes);
+
+	static void LinkwitzRileyCrossover(benchmark::State& state) {
+		const auto input = bench::Noise(state.range(0));
+		std::vector<double> low(input.size()), high(input.size());
+		dsptk::LinkwitzRileyCrossover crossover(1000., bench::sampleRate);
+		for (auto _ : state) {
+			for (std::size_t i = 0; i < input.size(); i++) {
+				crossover.ProcessSample(input[i], low[i], high[i]);
+			}
+			benchmark::DoNotOptimize(low.data());
+			benchmark::DoNotOptimize(high.data());
+		}
+		bench::SetSamplesProcessed(state, state.range(0));
+	}
+	BENCHMARK(LinkwitzRileyCrossover)->Apply(bench::BlockSizes);
+
+	// A 4 band equalizer
+	static void FilterBank(benchmark::State& state) {
+		const auto input = bench::Noise(state.range(0));
+		std::vector<double> output(input.size());
+
+		dsptk::FilterBank bank;
+		std::shared_ptr<dsptk::Filter> bands[] = {
+			std::make_shared<dsptk::ButterworthHiPass>(40., bench::sampleRate),
+			std::make_shared<dsptk::LowPassShelvingFilter>(200., dsptk::DB(3.), bench::sampleRate),
+			std::make_shared<dsptk::ParametricFilter>(1000., 200., dsptk::DB(-6.), bench::sampleRate),
+			std::make_shared<dsptk::HiPassShelvingFilter>(8000., dsptk::DB(2.), bench::sampleRate)
+		};
+		for (auto& band : bands) {
+			bank.AddFilter(band);
+		}
+
+		for (auto _ : state) {
+			for (std::size_t i = 0; i < input.size(); i++) {
+				output[i] = bank.ProcessSample(input[i]);
+			}
+			benchmark::DoNotOptimize(output.data());
+		}
+		bench::SetSamplesProcessed(state, state.range(0));
+	}
+	BENCHMARK(FilterBank)->Apply(bench::BlockSizes);
+
+	static void MeanSquare(benchmark::State& state) {
+		const auto input = bench::Noise(state.range(0));
+		for (auto _ : state) {
+			benchmark::DoNotOptimize(dsptk::MeanSquare(input));
+		}
+		bench::SetSamplesProcessed(state, state.range(0));
+	}
+	BENCHMARK(MeanSquare)->Apply(bench::BlockSizes);
+
+	static void RootMeanSquare(benchmark::State& state) {
+		const auto input = bench::Noise(state.range(0));
+		for (auto _ : state) {
+			benchmark::DoNotOptimize(dsptk::RootMeanSquare(input));
+		}
+		bench::SetSamplesProcessed(state, state.range(0));
+	}
+	BENCHMARK(RootMeanSquare)->Apply(bench::BlockSizes);
+}
@@ -0,0 +1,33 @@
+#include <vector>
+#include "bench_utils.h"
+#include "dsptk/metering.h"
+
+namespace metering {
+
+	// Stereo, samples counted per channel
+	static void LoudnessMeterProcessBlock(benchmark::State& state) {
+		const auto left = bench::Noise(state.range(0));
+		const auto right = bench::Noise(state.range(0), 0.5);
+		const double* channels[] = { left.data(), right.data() };
+		dsptk::LoudnessMeter meter(2, bench::sampleRate);
+		for (auto _ : state) {
+			meter.ProcessBlock(channels, (int)left.size());
+			benchmark::DoNotOptimize(meter.GetMomentaryLoudness());
+		}
+		bench::SetSamplesProcessed(state, state.range(0));
+	}
+	BENCHMARK(LoudnessMeterProcessBlock)->Apply(bench::BlockSizes);
+
+	static void TruePeakMeterProcessBlock(benchmark::State& state) {
+		const auto left = bench::Noise(state.range(0));
+		const auto right = bench::Noise(state.range(0), 0.5);
+		const double* channels[] = { left.data(), right.data() };
+		dsptk::TruePeakMeter meter(2, (int)left.size());
+		for (auto _ : state) {
+			meter.ProcessBlock(channels, (int)left.size());
+			benchmark::DoNotOptimize(meter.GetMaxPeak(0));
+		}
+		bench::SetSamplesProcessed(state, state.range(0));
+	}
+	BENCHMARK(TruePeakMeterProcessBlock)->Apply(bench::BlockSizes);
+}
@@ -0,0 +1,198 @@
+# Performance regression check, run as a script:
+#
+#   cmake -DBENCH=<dsptk_bench> -DBASELINE=<baseline.json> -DOUTPUT=<results.json> -P perf_check.cmake
+#
+# Runs the benchmarks with repetitions and compares the median cpu time of each case against the baseline,
+# failing when a case is more than THRESHOLD percent slower. With UPDATE_BASELINE=ON the results replace the
+# baseline instead. Options (-D):
+#   THRESHOLD    allowed slowdown in percent (default 10)
+#   REPETITIONS  runs per case, the median is compared (default 5)
+#   MIN_TIME     minimum seconds per repetition (default 0.1)
+#   FILTER       benchmark regex (default /1024, every processor at one block size)
+#   CPU          core to pin the run to with taskset, when available (Linux)
+#   RESULTS      compare an existing results file instead of running BENCH
+
+cmake_minimum_required(VERSION 3.19)
+
+if(NOT DEFINED THRESHOLD)
+  set(THRESHOLD 10)
+endif()
+if(NOT DEFINED REPETITIONS)
+  set(REPETITIONS 5)
+endif()
+if(NOT DEFINED MIN_TIME)
+  set(MIN_TIME 0.1)
+endif()
+if(NOT DEFINED FILTER)
+  set(FILTER "/1024")
+endif()
+if(NOT DEFINED BASELINE)
+  message(FATAL_ERROR "BASELINE is required")
+endif()
+
+# Run the benchmarks
+
+if(NOT DEFINED RESULTS)
+  if(NOT DEFINED BENCH OR NOT DEFINED OUTPUT)
+    message(FATAL_ERROR "BENCH and OUTPUT are required unless RESULTS is given")
+  endif()
+
+  set(command "${BENCH}")
+  if(DEFINED CPU AND NOT CPU STREQUAL "")
+    find_program(TASKSET taskset)
+    if(TASKSET)
+      set(command "${TASKSET}" -c ${CPU} "${BENCH}")
+    else()
+      message(WARNING "taskset not found, running unpinned")
+    endif()
+  endif()
+
+  # Interleaving the repetitions of all cases spreads slow periods of the machine over every case
+  execute_process(
+    COMMAND ${command}
+      --benchmark_filter=${FILTER}
+      --benchmark_repetitions=${REPETITIONS}
+      --benchmark_min_time=${MIN_TIME}
+      --benchmark_enable_random_interleaving=true
+      --benchmark_report_aggregates_only=true
+      --benchmark_out=${OUTPUT}
+      --benchmark_out_format=json
+    RESULT_VARIABLE result
+    OUTPUT_QUIET
+  )
+  if(NOT result EQUAL 0)
+    message(FATAL_ERROR "${BENCH} failed: ${result}")
+  endif()
+  set(RESULTS "${OUTPUT}")
+endif()
+
+file(READ "${RESULTS}" results)
+
+string(JSON scaling ERROR_VARIABLE error GET "${results}" context cpu_scaling_enabled)
+if(scaling STREQUAL "ON" OR scaling STREQUAL "true")
+  message(WARNING "CPU frequency scaling is enabled, use the performance governor for stable results")
+endif()
+
+if(UPDATE_BASELINE)
+  file(WRITE "${BASELINE}" "${results}")
+  message(STATUS "Baseline updated: ${BASELINE}")
+  return()
+endif()
+
+if(NOT EXISTS "${BASELINE}")
+  message(FATAL_ERROR "No baseline at ${BASELINE}, record one on this machine first: build the dsptk_perf_baseline target (or run with UPDATE_BASELINE=ON)")
+endif()
+file(READ "${BASELINE}" baseline)
+
+# Converts a JSON number to an integer number of thousandths, math() has no floating point
+function(to_thousandths value out)
+  string(REGEX MATCH "^(-?)([0-9]*)\\.?([0-9]*)[eE]?([-+]?[0-9]*)$" valid "${value}")
+  if(NOT valid)
+    message(FATAL_ERROR "Not a number: ${value}")
+  endif()
+  set(integerPart "${CMAKE_MATCH_2}")
+  set(fractionPart "${CMAKE_MATCH_3}")
+  set(exponent "${CMAKE_MATCH_4}")
+  if(exponent STREQUAL "")
+    set(exponent 0)
+  endif()
+  math(EXPR digits "${exponent} + 3")
+  if(digits LESS 0)
+    set(${out} 0 PARENT_SCOPE)
+    return()
+  endif()
+  string(APPEND fractionPart "00000000000000000000")
+  string(SUBSTRING "${fractionPart}" 0 ${digits} fractionPart)
+  # Leading zeros are still decimal for math()
+  math(EXPR result "0${integerPart}${fractionPart}")
+  set(${out} ${result} PARENT_SCOPE)
+endfunction()
+
+# Median cpu time of every case, in thousandths of ns, as <prefix><case identifier> variables and a list of case names
+function(read_medians json prefix)
+  set(names "")
+  string(JSON count LENGTH "${json}" benchmarks)
+  if(count EQUAL 0)
+    set(${prefix}names "" PARENT_SCOPE)
+    return()
+  endif()
+  math(EXPR last "${count} - 1")
+  foreach(i RANGE ${last})
+    string(JSON entry GET "${json}" benchmarks ${i})
+    string(JSON runType GET "${entry}" run_type)
+    string(JSON aggregate ERROR_VARIABLE error GET "${entry}" aggregate_name)
+    # Single repetition runs have no aggregates, their iteration is the value
+    if(runType STREQUAL "aggregate" AND NOT aggregate STREQUAL "median")
+      continue()
+    endif()
+    string(JSON name GET "${entry}" run_name)
+    string(JSON time GET "${entry}" cpu_time)
+    string(JSON unit GET "${entry}" time_unit)
+    to_thousandths("${time}" value)
+    if(unit STREQUAL "us")
+      math(EXPR value "${value} * 1000")
+    elseif(unit STREQUAL "ms")
+      math(EXPR value "${value} * 1000000")
+    elseif(unit STREQUAL "s")
+      math(EXPR value "${value} * 1000000000")
+    endif()
+
+    string(MAKE_C_IDENTIFIER "${name}" id)
+    set(${prefix}${id} ${value} PARENT_SCOPE)
+    list(APPEND names "${name}")
+  endforeach()
+  set(${prefix}names "${names}" PARENT_SCOPE)
+endfunction()
+
+read_medians("${baseline}" base_)
+read_medians("${results}" new_)
+
+set(regressions "")
+set(report "")
+list(SORT new_names)
+foreach(name IN LISTS new_names)
+  string(MAKE_C_IDENTIFIER "${name}" id)
+  if(NOT DEFINED base_${id})
+    string(APPEND report "  ${name}: new case, not in the baseline\n")
+    continue()
+  endif()
+  set(before ${base_${id}})
+  set(after ${new_${id}})
+  if(before EQUAL 0)
+    continue()
+  endif()
+  # Change in tenths of a percent
+  math(EXPR change "(${after} - ${before}) * 1000 / ${before}")
+  set(sign "+")
+  set(magnitude ${change})
+  if(change LESS 0)
+    set(sign "-")
+    math(EXPR magnitude "-${change}")
+  endif()
+  math(EXPR changeInteger "${magnitude} / 10")
+  math(EXPR changeDecimal "${magnitude} % 10")
+  math(EXPR beforeNs "${before} / 1000")
+  math(EXPR afterNs "${after} / 1000")
+  set(line "  ${name}: ${beforeNs} ns -> ${afterNs} ns (${sign}${changeInteger}.${changeDecimal}%)")
+  math(EXPR limit "${THRESHOLD} * 10")
+  if(change GREATER limit)
+    list(APPEND regressions "${name}")
+    string(APPEND report "${line} REGRESSION\n")
+  else()
+    string(APPEND report "${line}\n")
+  endif()
+endforeach()
+
+foreach(name IN LISTS base_names)
+  string(MAKE_C_IDENTIFIER "${name}" id)
+  if(NOT DEFINED new_${id})
+    string(APPEND report "  ${name}: missing from the results\n")
+  endif()
+endforeach()
+
+message(STATUS "Median cpu time against ${BASELINE} (threshold ${THRESHOLD}%):\n${report}")
+
+list(LENGTH regressions numRegressions)
+if(numRegressions GREATER 0)
+  message(FATAL_ERROR "${numRegressions} case(s) regressed more than ${THRESHOLD}%: ${regressions}")
+endif()
@@ -0,0 +1,32 @@
+#include <vector>
+#include "bench_utils.h"
+#include "dsptk/audiobuffer.h"
+#include "dsptk/resampler.h"
+
+namespace resampler {
+
+	// Args: quality, input frames per block. Samples processed count the input.
+	static void ResamplerArgs(benchmark::internal::Benchmark* b) {
+		for (int quality = 0; quality < 3; quality++) {
+			b->Args({ quality, 1024 });
+		}
+	}
+
+	static void Resample(benchmark::State& state, double inputRate, double outputRate, bool arbitrary) {
+		const auto quality = (dsptk::ResamplerQuality)state.range(0);
+		const int nFrames = (int)state.range(1);
+		auto resampler = arbitrary ? dsptk::Resampler(1, outputRate / inputRate, quality)
+			: dsptk::Resampler::ForRates(1, inputRate, outputRate, quality);
+		resampler.Prepare(nFrames);
+		const auto noise = bench::Noise(nFrames);
+		const double* input = noise.data();
+		dsptk::AudioBuffer<double> output(1, resampler.GetMaxOutputFrames(nFrames));
+		for (auto _ : state) {
+			benchmark::DoNotOptimize(resampler.ProcessBlock(dsptk::BufferView<const double>(&input, 1, nFrames), output.GetView()));
+		}
+		bench::SetSamplesProcessed(state, nFrames);
+	}
+	BENCHMARK_CAPTURE(Resample, up44100to48000, 44100., 48000., false)->Apply(ResamplerArgs);
+	BENCHMARK_CAPTURE(Resample, down96000to44100, 96000., 44100., false)->Apply(ResamplerArgs);
+	BENCHMARK_CAPTURE(Resample, arbitrary44100to48000, 44100., 48000., true)->Apply(ResamplerArgs);
+}
@@ -0,0 +1,76 @@
+#include <vector>
+#include "bench_utils.h"
+#include "dsptk/signals.h"
+
+namespace signals {
+
+	static void Sin(benchmark::State& state) {
+		for (auto _ : state) {
+			benchmark::DoNotOptimize(dsptk::sin(997., bench::sampleRate, (int)state.range(0)));
+		}
+		bench::SetSamplesProcessed(state, state.range(0));
+	}
+	BENCHMARK(Sin)->Apply(bench::BlockSizes);
+
+	static void OscillatorGenerate(benchmark::State& state, dsptk::Oscillator::Mode mode) {
+		std::vector<double> output(state.range(0));
+		dsptk::Oscillator oscillator(997., bench::sampleRate, mode);
+		for (auto _ : state) {
+			oscillator.Generate(output.data(), (int)output.size());
+			benchmark::DoNotOptimize(output.data());
+		}
+		bench::SetSamplesProcessed(state, state.range(0));
+	}
+	BENCHMARK_CAPTURE(OscillatorGenerate, exact, dsptk::Oscillator::Mode::Exact)->Apply(bench::BlockSizes);
+	BENCHMARK_CAPTURE(OscillatorGenerate, quadrature, dsptk::Oscillator::Mode::Quadrature)->Apply(bench::BlockSizes);
+	BENCHMARK_CAPTURE(OscillatorGenerate, polynomial, dsptk::Oscillator::Mode::Polynomial)->Apply(bench::BlockSizes);
+
+	// 256 voices sharing the standard tables, one block each per iteration
+	static void WavetableOscillatorVoices(benchmark::State& state) {
+		std::vector<dsptk::WavetableOscillator> voices;
+		for (int v = 0; v < 256; v++) {
+			voices.emplace_back(dsptk::WavetableSet::Get((dsptk::WavetableSet::Waveform)(v % 4)), 50. + 37.3 * v, bench::sampleRate);
+		}
+		std::vector<double> output(state.range(0));
+		for (auto _ : state) {
+			for (auto& voice : voices) {
+				voice.Generate(output.data(), (int)output.size());
+				benchmark::DoNotOptimize(output.data());
+			}
+		}
+		bench::SetSamplesProcessed(state, state.range(0) * (std::int64_t)voices.size());
+	}
+	BENCHMARK(WavetableOscillatorVoices)->RangeMultiplier(4)->Range(64, 1024);
+
+	static void WhiteNoiseGenerate(benchmark::State& state, dsptk::WhiteNoise::Distribution distribution) {
+		std::vector<double> output(state.range(0));
+		dsptk::WhiteNoise noise(distribution, 1., 1234);
+		for (auto _ : state) {
+			noise.Generate(output.data(), (int)output.size());
+			benchmark::DoNotOptimize(output.data());
+		}
+		bench::SetSamplesProcessed(state, state.range(0));
+	}
+	BENCHMARK_CAPTURE(WhiteNoiseGenerate, uniform, dsptk::WhiteNoise::Distribution::Uniform)->Apply(bench::BlockSizes);
+	BENCHMARK_CAPTURE(WhiteNoiseGenerate, gaussian, dsptk::WhiteNoise::Distribution::Gaussian)->Apply(bench::BlockSizes);
+
+	static void PinkNoiseGenerate(benchmark::State& state) {
+		std::vector<double> output(state.range(0));
+		dsptk::PinkNoise noise(1., 1234);
+		for (auto _ : state) {
+			noise.Generate(output.data(), (int)output.size());
+			benchmark::DoNotOptimize(output.data());
+		}
+		bench::SetSamplesProcessed(state, state.range(0));
+	}
+	BENCHMARK(PinkNoiseGenerate)->Apply(bench::BlockSizes);
+
+	static void ExponentialSweep(benchmark::State& state) {
+		const double duration = state.range(0) / bench::sampleRate;
+		for (auto _ : state) {
+			benchmark::DoNotOptimize(dsptk::exponential_sweep(20., 20000., duration, bench::sampleRate));
+		}
+		bench::SetSamplesProcessed(state, state.range(0));
+	}
+	BENCHMARK(ExponentialSweep)->Apply(bench::BlockSizes);
+}
@@ -0,0 +1,95 @@
+#include "arena.h"
+#include <new>
+
+namespace dsptk {
+
+	ScratchArena::ScratchArena(std::size_t bytes)
+	{
+		Reserve(bytes);
+	}
+
+	ScratchArena::ScratchArena(const ScratchArena& other)
+	{
+		Reserve(other.capacity);
+	}
+
+	ScratchArena& ScratchArena::operator=(const ScratchArena& other)
+	{
+		if (this != &other) {
+			Reserve(other.capacity);
+		}
+		return *this;
+	}
+
+	ScratchArena::~ScratchArena()
+	{
+		FreeOverflow();
+		if (memory) {
+			::operator delete(memory, std::align_val_t{ alignment });
+		}
+	}
+
+	void ScratchArena::Reserve(std::size_t bytes)
+	{
+		bytes = (bytes + alignment - 1) / alignment * alignment;
+		FreeOverflow();
+		if (bytes != capacity) {
+			if (memory) {
+				::operator delete(memory, std::align_val_t{ alignment });
+				memory = nullptr;
+			}
+			if (bytes > 0) {
+				memory = static_cast<unsigned char*>(::operator new(bytes, std::align_val_t{ alignment }));
+			}
+			capacity = bytes;
+		}
+		top = 0;
+	}
+
+	void ScratchArena::Reset()
+	{
+		top = 0;
+		if (!overflowBlocks.empty()) {
+			FreeOverflow();
+		}
+	}
+
+	ArenaStats ScratchArena::GetStats() const
+	{
+		ArenaStats stats;
+		stats.capacity = capacity;
+		stats.used = top;
+		stats.highWater = highWater;
+		stats.overflows = overflows;
+		return stats;
+	}
+
+	void ScratchArena::ResetStats()
+	{
+		highWater = top;
+		overflows = 0;
+	}
+
+	void* ScratchArena::Overflow(std::size_t bytes)
+	{
+		assert(!"ScratchArena overflow: reserve more memory at prepare time");
+		overflows++;
+		overflowBytes += bytes;
+		if (top + overflowBytes > highWater) {
+			highWater = top + overflowBytes;
+		}
+		void* block = ::operator new(bytes > 0 ? bytes : alignment, std::align_val_t{ alignment });
+		overflowBlocks.push_back(block);
+		return block;
+	}
+
+	void ScratchArena::FreeOverflow()
+	{
+		for (void* block : overflowBlocks) {
+			::operator delete(block, std::align_val_t{ alignment });
+		}
+		overflowBlocks.clear();
+		overflowBytes = 0;
+	}
+
+}
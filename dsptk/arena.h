@@ -0,0 +1,149 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <vector>
+#include "audiobuffer.h"
+
+namespace dsptk {
+
+	/**
+	 * @brief Usage counters of a ScratchArena.
+	*/
+	struct ArenaStats {
+		/** Reserved bytes. */
+		std::size_t capacity = 0;
+		/** Bytes in use now. */
+		std::size_t used = 0;
+		/** Most bytes in use at once since creation or ResetStats, overflowed ones included: the capacity to reserve. */
+		std::size_t highWater = 0;
+		/** Allocations that didn't fit and went to the heap. */
+		std::size_t overflows = 0;
+	};
+
+	/**
+	 * @brief Bump allocator for the scratch memory of a processing graph.
+	 *
+	 * The graph reserves it at prepare time with the largest need of its processors, then each
+	 * processor takes its temporary buffers from it while processing a block: allocating is a pointer
+	 * increment, nothing is freed one by one and the same cache-hot memory is reused by every processor.
+	 * ScratchScope gives the memory taken inside a scope back when leaving it, Reset empties the arena
+	 * (once per block).
+	 *
+	 * Running out of space is a sizing error: debug builds assert, release builds fall back to the heap
+	 * (counted in the stats and freed by the next Reset) so processing stays correct.
+	 * Allocations are 64 bytes aligned, like AudioBuffer channels.
+	*/
+	class ScratchArena {
+	public:
+		static constexpr std::size_t alignment = 64;
+
+		ScratchArena() = default;
+
+		/**
+		 * @brief Creates an arena of the given size, see Reserve.
+		*/
+		explicit ScratchArena(std::size_t bytes);
+
+		// Copies get their own memory of the same capacity, empty
+		ScratchArena(const ScratchArena& other);
+		ScratchArena& operator=(const ScratchArena& other);
+
+		~ScratchArena();
+
+		/**
+		 * @brief Allocates the memory of the arena, discarding anything allocated. Not real time safe.
+		*/
+		void Reserve(std::size_t bytes);
+
+		/**
+		 * @brief Arena bytes taken by an allocation of count elements of T, for sizing.
+		*/
+		template <typename T>
+		static constexpr std::size_t BytesFor(std::size_t count) {
+			return (count * sizeof(T) + alignment - 1) / alignment * alignment;
+		}
+
+		/**
+		 * @brief Uninitialized room for count elements of T.
+		*/
+		template <typename T>
+		T* Allocate(std::size_t count) {
+			return static_cast<T*>(AllocateBytes(BytesFor<T>(count)));
+		}
+
+		/**
+		 * @brief Uninitialized channel of nFrames samples.
+		*/
+		template <typename T>
+		ChannelView<T> AllocateChannel(int nFrames) {
+			return ChannelView<T>(Allocate<T>((std::size_t)nFrames), nFrames);
+		}
+
+		/**
+		 * @brief Current top of the arena, Release(mark) frees everything allocated after it.
+		*/
+		std::size_t GetMark() const { return top; }
+
+		void Release(std::size_t mark) {
+			assert(mark <= top);
+			top = mark;
+		}
+
+		/**
+		 * @brief Frees everything, call at the start or end of each block.
+		*/
+		void Reset();
+
+		std::size_t GetCapacity() const { return capacity; }
+		std::size_t GetAvailable() const { return capacity - top; }
+
+		ArenaStats GetStats() const;
+
+		/**
+		 * @brief Restarts the high water mark and overflow count.
+		*/
+		void ResetStats();
+
+	private:
+		unsigned char* memory = nullptr;
+		std::size_t capacity = 0;
+		std::size_t top = 0;
+		std::size_t highWater = 0;
+		std::size_t overflows = 0;
+		std::size_t overflowBytes = 0;
+		std::vector<void*> overflowBlocks;
+
+		void* AllocateBytes(std::size_t bytes) {
+			if (bytes > capacity - top) {
+				return Overflow(bytes);
+			}
+			void* block = memory + top;
+			top += bytes;
+			if (top > highWater) {
+				highWater = top;
+			}
+			return block;
+		}
+
+		void* Overflow(std::size_t bytes);
+		void FreeOverflow();
+	};
+
+	/**
+	 * @brief Gives back the arena memory allocated during its lifetime.
+	*/
+	class ScratchScope {
+	public:
+		explicit ScratchScope(ScratchArena& arena) : arena(arena), mark(arena.GetMark()) {}
+		~ScratchScope() { arena.Release(mark); }
+
+		ScratchScope(const ScratchScope&) = delete;
+		ScratchScope& operator=(const ScratchScope&) = delete;
+
+	private:
+		ScratchArena& arena;
+		std::size_t mark;
+	};
+
+}
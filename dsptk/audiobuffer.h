@@ -0,0 +1,234 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace dsptk {
+
+	/**
+	 * @brief Non owning view of the samples of one channel, a pointer and a size.
+	 * ChannelView<double> converts to ChannelView<const double>, vectors convert to views.
+	*/
+	template <typename T>
+	class ChannelView {
+	public:
+		ChannelView() = default;
+		ChannelView(T* data, int size) : samples(data), numFrames(size) {}
+
+		template <typename U, typename = std::enable_if_t<std::is_convertible<U(*)[], T(*)[]>::value>>
+		ChannelView(const ChannelView<U>& other) : samples(other.data()), numFrames(other.size()) {}
+
+		template <typename U, typename = std::enable_if_t<std::is_convertible<U(*)[], T(*)[]>::value>>
+		ChannelView(std::vector<U>& vector) : samples(vector.data()), numFrames((int)vector.size()) {}
+
+		template <typename U, typename = std::enable_if_t<std::is_convertible<const U(*)[], T(*)[]>::value>>
+		ChannelView(const std::vector<U>& vector) : samples(vector.data()), numFrames((int)vector.size()) {}
+
+		T* data() const { return samples; }
+		int size() const { return numFrames; }
+		bool empty() const { return numFrames == 0; }
+
+		T* begin() const { return samples; }
+		T* end() const { return samples + numFrames; }
+
+		T& operator[](int index) const {
+			assert(index >= 0 && index < numFrames);
+			return samples[index];
+		}
+
+		/**
+		 * @brief View of nFrames samples starting at offset.
+		*/
+		ChannelView SubBlock(int offset, int nFrames) const {
+			assert(offset >= 0 && nFrames >= 0 && offset + nFrames <= numFrames);
+			return ChannelView(samples + offset, nFrames);
+		}
+
+	private:
+		T* samples = nullptr;
+		int numFrames = 0;
+	};
+
+	/**
+	 * @brief Non owning view of a range of frames of planar multichannel audio.
+	 * Sub-blocks share the channel pointers of the viewed buffer, taking one copies no samples.
+	*/
+	template <typename T>
+	class BufferView {
+	public:
+		BufferView() = default;
+
+		/**
+		 * @brief Views planar audio.
+		 * @param channels one pointer per channel, must outlive the view.
+		 * @param numChannels the number of channels.
+		 * @param nFrames the number of samples per channel.
+		 * @param offset the first frame of the view.
+		*/
+		BufferView(T* const* channels, int numChannels, int nFrames, int offset = 0)
+			: channels(channels), channelCount(numChannels), numFrames(nFrames), offset(offset) {}
+
+		template <typename U, typename = std::enable_if_t<std::is_convertible<U(*)[], T(*)[]>::value>>
+		BufferView(const BufferView<U>& other)
+			: channels(other.GetChannelPointers()), channelCount(other.GetNumChannels()), numFrames(other.GetNumFrames()), offset(other.GetOffset()) {}
+
+		int GetNumChannels() const { return channelCount; }
+		int GetNumFrames() const { return numFrames; }
+
+		ChannelView<T> GetChannel(int channel) const {
+			assert(channel >= 0 && channel < channelCount);
+			return ChannelView<T>(channels[channel] + offset, numFrames);
+		}
+
+		ChannelView<T> operator[](int channel) const { return GetChannel(channel); }
+
+		/**
+		 * @brief View of nFrames frames starting at offset.
+		*/
+		BufferView SubBlock(int offset, int nFrames) const {
+			assert(offset >= 0 && nFrames >= 0 && offset + nFrames <= numFrames);
+			return BufferView(channels, channelCount, nFrames, this->offset + offset);
+		}
+
+		/**
+		 * @brief Pointers to the start of the viewed buffer, GetOffset() frames before the view.
+		*/
+		T* const* GetChannelPointers() const { return channels; }
+		int GetOffset() const { return offset; }
+
+	private:
+		T* const* channels = nullptr;
+		int channelCount = 0;
+		int numFrames = 0;
+		int offset = 0;
+	};
+
+	/**
+	 * @brief Planar multichannel audio buffer.
+	 *
+	 * All channels live in a single allocation, each one starting at a 64 bytes boundary (a cache line,
+	 * the widest SIMD register) so kernels can use aligned loads on whole channels. Samples are zeroed
+	 * on creation and resize.
+	*/
+	template <typename T>
+	class AudioBuffer {
+	public:
+		static constexpr std::size_t alignment = 64;
+
+		AudioBuffer() = default;
+
+		/**
+		 * @brief Creates a buffer of silence.
+		 * @param numChannels the number of channels.
+		 * @param nFrames the number of samples per channel.
+		*/
+		AudioBuffer(int numChannels, int nFrames) {
+			Resize(numChannels, nFrames);
+		}
+
+		AudioBuffer(const AudioBuffer& other) : AudioBuffer(other.GetNumChannels(), other.GetNumFrames()) {
+			std::copy(other.storage, other.storage + other.channelStride * other.GetNumChannels(), storage);
+		}
+
+		AudioBuffer(AudioBuffer&& other) noexcept {
+			swap(other);
+		}
+
+		AudioBuffer& operator=(AudioBuffer other) noexcept {
+			swap(other);
+			return *this;
+		}
+
+		~AudioBuffer() {
+			Free();
+		}
+
+		void swap(AudioBuffer& other) noexcept {
+			std::swap(storage, other.storage);
+			std::swap(channels, other.channels);
+			std::swap(numFrames, other.numFrames);
+			std::swap(channelStride, other.channelStride);
+		}
+
+		/**
+		 * @brief Changes the size, the contents are discarded.
+		*/
+		void Resize(int numChannels, int nFrames) {
+			Free();
+			numFrames = nFrames;
+			// Rounded up to whole cache lines so every channel is aligned
+			const std::size_t samplesPerLine = alignment / sizeof(T);
+			channelStride = ((std::size_t)nFrames + samplesPerLine - 1) / samplesPerLine * samplesPerLine;
+			const std::size_t total = channelStride * numChannels;
+			if (total > 0) {
+				storage = static_cast<T*>(::operator new(total * sizeof(T), std::align_val_t{ alignment }));
+				std::fill(storage, storage + total, T());
+			}
+			channels.resize(numChannels);
+			for (int c = 0; c < numChannels; c++) {
+				channels[c] = storage + c * channelStride;
+			}
+		}
+
+		/**
+		 * @brief Sets every sample to zero.
+		*/
+		void Clear() {
+			std::fill(storage, storage + channelStride * GetNumChannels(), T());
+		}
+
+		int GetNumChannels() const { return (int)channels.size(); }
+		int GetNumFrames() const { return numFrames; }
+
+		ChannelView<T> GetChannel(int channel) {
+			return GetView().GetChannel(channel);
+		}
+
+		ChannelView<const T> GetChannel(int channel) const {
+			return GetView().GetChannel(channel);
+		}
+
+		ChannelView<T> operator[](int channel) { return GetChannel(channel); }
+		ChannelView<const T> operator[](int channel) const { return GetChannel(channel); }
+
+		/**
+		 * @brief One pointer per channel, the layout of the raw pointer APIs.
+		*/
+		T* const* GetChannelPointers() { return channels.data(); }
+		const T* const* GetChannelPointers() const { return channels.data(); }
+
+		BufferView<T> GetView() {
+			return BufferView<T>(channels.data(), GetNumChannels(), numFrames);
+		}
+
+		BufferView<const T> GetView() const {
+			return BufferView<const T>(channels.data(), GetNumChannels(), numFrames);
+		}
+
+		operator BufferView<T>() { return GetView(); }
+		operator BufferView<const T>() const { return GetView(); }
+
+		BufferView<T> SubBlock(int offset, int nFrames) { return GetView().SubBlock(offset, nFrames); }
+		BufferView<const T> SubBlock(int offset, int nFrames) const { return GetView().SubBlock(offset, nFrames); }
+
+	private:
+		T* storage = nullptr;
+		std::vector<T*> channels;
+		int numFrames = 0;
+		std::size_t channelStride = 0;
+
+		void Free() {
+			if (storage) {
+				::operator delete(storage, std::align_val_t{ alignment });
+				storage = nullptr;
+			}
+			channels.clear();
+		}
+	};
+
+}
@@ -0,0 +1,206 @@
+#include "conversion.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+namespace dsptk {
+
+	namespace {
+
+		// Frames per tile: with 64 channels of doubles a tile of both sides is 64KB at most
+		constexpr int tileFrames = 64;
+
+		// Clips and rounds half away from zero (the caller truncates)
+		inline double Quantize(double x, double scale, double dither) {
+			const double v = std::min(std::max(x * scale + dither, -scale), scale - 1.);
+			return v + std::copysign(.5, v);
+		}
+
+		/*
+		* A codec reads a sample of the stream as a scaled T, integer codecs quantize a double to a level
+		* (rounded and clipped) and write it. Unit is the type the stream is addressed in, a sample takes units of them.
+		*/
+
+		struct Int16Codec {
+			using Unit = std::int16_t;
+			static constexpr int units = 1;
+			static constexpr bool integer = true;
+			static constexpr double scale = 32768.;
+
+			template <typename T>
+			static T Read(const Unit* p) { return (T)p[0] * (T)(1. / scale); }
+
+			static double Quantize(double x, double dither) { return dsptk::Quantize(x, scale, dither); }
+			static void Write(Unit* p, double level) { p[0] = (Unit)(std::int32_t)level; }
+		};
+
+		struct Int24Codec {
+			using Unit = unsigned char;
+			static constexpr int units = 3;
+			static constexpr bool integer = true;
+			static constexpr double scale = 8388608.;
+
+			template <typename T>
+			static T Read(const Unit* p) {
+				// Sample in the top bytes, the arithmetic shift extends the sign
+				const std::int32_t v = (std::int32_t)((std::uint32_t)p[0] << 8 | (std::uint32_t)p[1] << 16 | (std::uint32_t)p[2] << 24) >> 8;
+				return (T)v * (T)(1. / scale);
+			}
+
+			static double Quantize(double x, double dither) { return dsptk::Quantize(x, scale, dither); }
+			static void Write(Unit* p, double level) {
+				const std::int32_t v = (std::int32_t)level;
+				p[0] = (Unit)v;
+				p[1] = (Unit)(v >> 8);
+				p[2] = (Unit)(v >> 16);
+			}
+		};
+
+		struct Int32Codec {
+			using Unit = std::int32_t;
+			static constexpr int units = 1;
+			static constexpr bool integer = true;
+			static constexpr double scale = 2147483648.;
+
+			template <typename T>
+			static T Read(const Unit* p) { return (T)((double)p[0] * (1. / scale)); }
+
+			static double Quantize(double x, double dither) { return dsptk::Quantize(x, scale, dither); }
+			static void Write(Unit* p, double level) { p[0] = (Unit)level; }
+		};
+
+		struct Float32Codec {
+			using Unit = float;
+			static constexpr int units = 1;
+			static constexpr bool integer = false;
+
+			template <typename T>
+			static T Read(const Unit* p) { return (T)p[0]; }
+
+			static double Quantize(double x, double) { return x; }
+			static void Write(Unit* p, double x) { p[0] = (Unit)x; }
+		};
+
+		// Channels is the channel count when known at compile time (mono, stereo), 0 otherwise
+		template <typename Codec, int channels, typename T>
+		void DeinterleaveFrames(const typename Codec::Unit* input, int numChannels, BufferView<T> output) {
+			const int C = channels ? channels : numChannels;
+			const std::size_t stride = (std::size_t)C * Codec::units;
+			const int nFrames = output.GetNumFrames();
+
+			for (int start = 0; start < nFrames; start += tileFrames) {
+				const int n = std::min(tileFrames, nFrames - start);
+				const typename Codec::Unit* tile = input + start * stride;
+				for (int c = 0; c < C; c++) {
+					const typename Codec::Unit* x = tile + c * Codec::units;
+					T* y = output.GetChannel(c).data() + start;
+					for (int f = 0; f < n; f++) {
+						y[f] = Codec::template Read<T>(x + f * stride);
+					}
+				}
+			}
+		}
+
+		template <typename Codec, int channels, typename T>
+		void InterleaveFrames(BufferView<const T> input, typename Codec::Unit* output, int numChannels, TpdfDither* dither) {
+			const int C = channels ? channels : numChannels;
+			const std::size_t stride = (std::size_t)C * Codec::units;
+			const int nFrames = input.GetNumFrames();
+			double noise[tileFrames] = {};
+			double levels[tileFrames];
+
+			for (int start = 0; start < nFrames; start += tileFrames) {
+				const int n = std::min(tileFrames, nFrames - start);
+				typename Codec::Unit* tile = output + start * stride;
+				for (int c = 0; c < C; c++) {
+					const T* x = input.GetChannel(c).data() + start;
+					typename Codec::Unit* y = tile + c * Codec::units;
+					if (Codec::integer) {
+						// Quantized contiguously first, the strided stores alone don't stop vectorization
+						if (dither) {
+							dither->Fill(noise, levels, n);
+						}
+						for (int f = 0; f < n; f++) {
+							levels[f] = Codec::Quantize((double)x[f], noise[f]);
+						}
+						for (int f = 0; f < n; f++) {
+							Codec::Write(y + f * stride, levels[f]);
+						}
+					}
+					else {
+						for (int f = 0; f < n; f++) {
+							Codec::Write(y + f * stride, (double)x[f]);
+						}
+					}
+				}
+			}
+		}
+
+		template <typename Codec, typename T>
+		void DeinterleaveAs(const void* interleaved, BufferView<T> output) {
+			const auto* input = static_cast<const typename Codec::Unit*>(interleaved);
+			switch (output.GetNumChannels()) {
+			case 1: DeinterleaveFrames<Codec, 1>(input, 1, output); break;
+			case 2: DeinterleaveFrames<Codec, 2>(input, 2, output); break;
+			default: DeinterleaveFrames<Codec, 0>(input, output.GetNumChannels(), output); break;
+			}
+		}
+
+		template <typename Codec, typename T>
+		void InterleaveAs(BufferView<const T> input, void* interleaved, TpdfDither* dither) {
+			auto* output = static_cast<typename Codec::Unit*>(interleaved);
+			switch (input.GetNumChannels()) {
+			case 1: InterleaveFrames<Codec, 1>(input, output, 1, dither); break;
+			case 2: InterleaveFrames<Codec, 2>(input, output, 2, dither); break;
+			default: InterleaveFrames<Codec, 0>(input, output, input.GetNumChannels(), dither); break;
+			}
+		}
+
+		template <typename T>
+		void DeinterleaveFormat(const void* interleaved, SampleFormat format, BufferView<T> output) {
+			switch (format) {
+			case SampleFormat::Int16: DeinterleaveAs<Int16Codec>(interleaved, output); break;
+			case SampleFormat::Int24: DeinterleaveAs<Int24Codec>(interleaved, output); break;
+			case SampleFormat::Int32: DeinterleaveAs<Int32Codec>(interleaved, output); break;
+			case SampleFormat::Float32: DeinterleaveAs<Float32Codec>(interleaved, output); break;
+			}
+		}
+
+		template <typename T>
+		void InterleaveFormat(BufferView<const T> input, void* interleaved, SampleFormat format, TpdfDither* dither) {
+			switch (format) {
+			case SampleFormat::Int16: InterleaveAs<Int16Codec>(input, interleaved, dither); break;
+			case SampleFormat::Int24: InterleaveAs<Int24Codec>(input, interleaved, dither); break;
+			case SampleFormat::Int32: InterleaveAs<Int32Codec>(input, interleaved, dither); break;
+			case SampleFormat::Float32: InterleaveAs<Float32Codec>(input, interleaved, dither); break;
+			}
+		}
+	}
+
+	int BytesPerSample(SampleFormat format) {
+		switch (format) {
+		case SampleFormat::Int16: return 2;
+		case SampleFormat::Int24: return 3;
+		case SampleFormat::Int32: return 4;
+		case SampleFormat::Float32: return 4;
+		}
+		return 0;
+	}
+
+	void Deinterleave(const void* interleaved, SampleFormat format, BufferView<double> output) {
+		DeinterleaveFormat(interleaved, format, output);
+	}
+
+	void Deinterleave(const void* interleaved, SampleFormat format, BufferView<float> output) {
+		DeinterleaveFormat(interleaved, format, output);
+	}
+
+	void Interleave(BufferView<const double> input, void* interleaved, SampleFormat format, TpdfDither* dither) {
+		InterleaveFormat(input, interleaved, format, dither);
+	}
+
+	void Interleave(BufferView<const float> input, void* interleaved, SampleFormat format, TpdfDither* dither) {
+		InterleaveFormat(input, interleaved, format, dither);
+	}
+
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include "audiobuffer.h"
+#include "signals.h"
+
+namespace dsptk {
+
+	/**
+	 * @brief Sample formats of interleaved audio I/O, integers are signed and full scale is [-1, 1).
+	 * Int24 is packed in 3 bytes, little endian; the other formats use the host byte order.
+	*/
+	enum class SampleFormat { Int16, Int24, Int32, Float32 };
+
+	/**
+	 * @brief Size of a sample in the interleaved stream.
+	*/
+	int BytesPerSample(SampleFormat format);
+
+	/**
+	 * @brief Triangular (TPDF) dither of 2 LSB peak to peak, the sum of two uniform values.
+	 * Interleave adds it before rounding to integer formats, turning the quantization error into
+	 * noise uncorrelated with the signal.
+	*/
+	class TpdfDither {
+	public:
+		/**
+		 * @param seed the seed of the noise, the same seed always dithers the same way.
+		*/
+		explicit TpdfDither(std::uint64_t seed = 0) : random(seed) {}
+
+		/**
+		 * @brief Fills a buffer with dither values in LSBs, in (-1, 1).
+		 * @param scratch nFrames values of working space.
+		*/
+		void Fill(double* output, double* scratch, int nFrames) {
+			random.FillUniform(output, nFrames);
+			random.FillUniform(scratch, nFrames);
+			for (int i = 0; i < nFrames; i++) {
+				output[i] = .5 * (output[i] + scratch[i]);
+			}
+		}
+
+	private:
+		RandomGenerator random;
+	};
+
+	/**
+	 * @brief Converts interleaved frames to planar samples.
+	 *
+	 * Frames are processed in tiles that stay in L1 cache whatever the channel count; mono and stereo
+	 * have their own loops with a compile time stride so the compiler can vectorize them.
+	 * @param interleaved output.GetNumFrames() frames of output.GetNumChannels() samples.
+	 * @param format the format of the interleaved samples.
+	 * @param output the planar buffer (or view) to fill.
+	*/
+	void Deinterleave(const void* interleaved, SampleFormat format, BufferView<double> output);
+
+	/**
+	 * @copydoc Deinterleave(const void*, SampleFormat, BufferView<double>)
+	*/
+	void Deinterleave(const void* interleaved, SampleFormat format, BufferView<float> output);
+
+	/**
+	 * @brief Converts planar samples to interleaved frames.
+	 *
+	 * Integer formats are rounded to the nearest value and clipped to full scale, float is stored as is.
+	 * @param input the planar samples.
+	 * @param interleaved receives input.GetNumFrames() frames of input.GetNumChannels() samples.
+	 * @param format the format of the interleaved samples.
+	 * @param dither dither to add before rounding to integers, nullptr for none.
+	*/
+	void Interleave(BufferView<const double> input, void* interleaved, SampleFormat format, TpdfDither* dither = nullptr);
+
+	/**
+	 * @copydoc Interleave(BufferView<const double>, void*, SampleFormat, TpdfDither*)
+	*/
+	void Interleave(BufferView<const float> input, void* interleaved, SampleFormat format, TpdfDither* dither = nullptr);
+
+}
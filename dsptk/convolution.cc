@@ -1,6 +1,13 @@
 #include "convolution.h"
+#include "dft.h"
+#include "signals.h"
+#include "simd.h"
+#include "tracing.h"
+#include <cmath>
+#include <complex>
 #include <algorithm>
 #include <iterator>
+#include <utility>
 
 namespace dsptk {
 	std::vector<double> convolve(const std::vector<double>& input, const std::vector<double>& kernel) {
@@ -25,19 +32,195 @@ namespace dsptk {
 
 	std::vector<double> convolve_out(const std::vector<double>& input, const std::vector<double>& kernel) {
 		if (input.size() == 0 || kernel.size() == 0) return std::vector<double>(0);
-		size_t resultSize = input.size() + kernel.size() - 1;
+		const int inputSize = (int)input.size();
+		const int kernelSize = (int)kernel.size();
+		const int resultSize = inputSize + kernelSize - 1;
 		auto result = std::vector<double>(resultSize, 0.);
 
+		// result[i] is the dot product of the reversed kernel with the input samples it overlaps
+		const std::vector<double> reversed(kernel.rbegin(), kernel.rend());
+		const auto dotProduct = simd::GetKernels().dotProduct;
 		for (int i = 0; i < resultSize; i++) {
-			// Sum each relevant point into the result
-			for (int j = 0; j < kernel.size(); j++) {
-				int input_index = i - j;
-				if (input_index >= 0 && input_index < input.size())
-					result[i] += kernel[j] * input[input_index];
+			const int first = std::max(0, i - kernelSize + 1);
+			const int last = std::min(i, inputSize - 1);
+			result[i] = dotProduct(reversed.data() + (first - i + kernelSize - 1), input.data() + first, last - first + 1);
+		}
+
+		return result;
+	}
+
+	/*
+	* Circular convolution of two real signals of a power of two size with a single complex forward transform:
+	* z = a + ib, then A[k] B[k] = -i/4 (Z[k]^2 - conj(Z[N - k])^2). The result is real, so only half the spectrum is inverted.
+	*/
+	static std::vector<double> circular_convolve(const std::vector<double>& a, const std::vector<double>& b, size_t N) {
+
+		std::vector<std::complex<double>> z(N);
+		for (size_t i = 0; i < std::min(a.size(), N); i++) z[i].real(a[i]);
+		for (size_t i = 0; i < std::min(b.size(), N); i++) z[i].imag(b[i]);
+
+		fft(z);
+
+		std::vector<std::complex<double>> product(N / 2 + 1);
+		for (size_t k = 0; k < product.size(); k++) {
+			const std::complex<double> zk = z[k];
+			const std::complex<double> zn = std::conj(z[(N - k) & (N - 1)]);
+			const std::complex<double> d = zk * zk - zn * zn;
+			product[k] = std::complex<double>(d.imag() * .25, -d.real() * .25);
+		}
+		z = std::vector<std::complex<double>>();
+
+		return ifft_real(product);
+	}
+
+	std::vector<double> fft_convolve(const std::vector<double>& input, const std::vector<double>& kernel) {
+		DSPTK_TRACE_SCOPE("fft_convolve");
+
+		if (input.size() == 0 || kernel.size() == 0) return std::vector<double>(0);
+		const size_t resultSize = input.size() + kernel.size() - 1;
+
+		auto product = circular_convolve(input, kernel, fft_size(resultSize));
+
+		std::vector<double> result(resultSize);
+		for (size_t i = 0; i < resultSize; i++) {
+			result[i] = product[i];
+		}
+		return result;
+	}
+
+	BlockConvolver::BlockConvolver(std::vector<double> impulseResponse, int partitionSize)
+		: impulseResponse(std::move(impulseResponse)) {
+		Prepare(partitionSize);
+	}
+
+	void BlockConvolver::Prepare(int maxBlockSize) {
+		partitionSize = fft_size((size_t)std::max(1, maxBlockSize));
+		numPartitions = (impulseResponse.size() + partitionSize - 1) / partitionSize;
+		numBins = partitionSize + 1;
+		work.assign(2 * partitionSize, 0.);
+		plan = FftPlan(work.size());
+
+		// Each partition zero padded to 2B, so its product with a partition of input is a linear convolution
+		responseSpectra.assign(numPartitions * numBins, 0.);
+		for (size_t p = 0; p < numPartitions; p++) {
+			std::fill(work.begin(), work.end(), 0.);
+			const size_t first = p * partitionSize;
+			const size_t last = std::min(first + partitionSize, impulseResponse.size());
+			for (size_t i = first; i < last; i++) {
+				work[i - first] = impulseResponse[i];
 			}
+			fft(work, plan);
+			std::copy(work.begin(), work.begin() + numBins, responseSpectra.begin() + p * numBins);
 		}
 
+		inputSpectra.assign(numPartitions * numBins, 0.);
+		pastSum.assign(numBins, 0.);
+		partition.assign(partitionSize, 0.);
+		overlap.assign(partitionSize, 0.);
+		Reset();
+	}
+
+	void BlockConvolver::ProcessBlock(const double* input, double* output, int nFrames) {
+		if (nFrames <= 0) return;
+		if (numPartitions == 0) {
+			std::fill(output, output + nFrames, 0.);
+			return;
+		}
+		for (size_t done = 0; done < (size_t)nFrames;) {
+			const size_t n = std::min((size_t)nFrames - done, partitionSize - fill);
+			ProcessPartition(input + done, output + done, n);
+			done += n;
+		}
+	}
+
+	void BlockConvolver::ProcessPartition(const double* input, double* output, size_t nFrames) {
+		std::copy(input, input + nFrames, partition.begin() + fill);
+		const bool complete = fill + nFrames == partitionSize;
+
+		// The samples of the partition so far, the later ones are still 0
+		for (size_t i = 0; i < partitionSize; i++) {
+			work[i] = partition[i];
+		}
+		std::fill(work.begin() + partitionSize, work.end(), 0.);
+		fft(work, plan);
+		if (complete) {
+			newestSpectrum = (newestSpectrum + 1) % numPartitions;
+			std::copy(work.begin(), work.begin() + numBins, inputSpectra.begin() + newestSpectrum * numBins);
+		}
+
+		const std::complex<double>* response = responseSpectra.data();
+		for (size_t k = 0; k < numBins; k++) {
+			work[k] = pastSum[k] + work[k] * response[k];
+		}
+		// The spectrum of a real signal
+		const size_t size = work.size();
+		for (size_t k = numBins; k < size; k++) {
+			work[k] = std::conj(work[size - k]);
+		}
+		fft(work, plan, true);
+
+		for (size_t i = 0; i < nFrames; i++) {
+			output[i] = work[fill + i].real() + overlap[fill + i];
+		}
+		fill += nFrames;
+		if (!complete) return;
+
+		// Next partition: carry the second half, and sum the older partitions of input with the later ones of the response
+		for (size_t i = 0; i < partitionSize; i++) {
+			overlap[i] = work[partitionSize + i].real();
+		}
+		std::fill(partition.begin(), partition.end(), 0.);
+		fill = 0;
+		std::fill(pastSum.begin(), pastSum.end(), 0.);
+		for (size_t p = 1; p < numPartitions; p++) {
+			const std::complex<double>* x = inputSpectra.data() + ((newestSpectrum + numPartitions + 1 - p) % numPartitions) * numBins;
+			const std::complex<double>* h = responseSpectra.data() + p * numBins;
+			for (size_t k = 0; k < numBins; k++) {
+				pastSum[k] += x[k] * h[k];
+			}
+		}
+	}
+
+	void BlockConvolver::Reset() {
+		std::fill(inputSpectra.begin(), inputSpectra.end(), 0.);
+		std::fill(pastSum.begin(), pastSum.end(), 0.);
+		std::fill(partition.begin(), partition.end(), 0.);
+		std::fill(overlap.begin(), overlap.end(), 0.);
+		newestSpectrum = 0;
+		fill = 0;
+	}
+
+	SweepImpulseResponses deconvolve_sweep(const std::vector<double>& recorded, double startFreq, double endFreq,
+		double duration, double samplerate, size_t irLength, int numHarmonics) {
+
+		const std::vector<double> inverse = exponential_sweep_inverse(startFreq, endFreq, duration, samplerate);
+		const size_t linearStart = inverse.size() - 1;
+		const double harmonicSpacing = duration * samplerate / std::log(endFreq / startFreq);
+
+		std::vector<size_t> starts{ linearStart };
+		for (int k = 2; k < numHarmonics + 2; k++) {
+			const size_t offset = (size_t)std::lround(harmonicSpacing * std::log((double)k));
+			starts.push_back(linearStart - std::min(offset, linearStart));
+		}
+
+		// Only the responses are needed, a circular convolution aliasing the rest of the result away from them is enough
+		const size_t N = fft_size(std::max(recorded.size() + linearStart - starts.back(), linearStart + irLength));
+		auto product = circular_convolve(recorded, inverse, N);
+
+		auto extract = [&product](size_t start, size_t length) {
+			std::vector<double> ir(length);
+			for (size_t i = 0; i < length; i++) {
+				ir[i] = product[start + i];
+			}
+			return ir;
+		};
+
+		SweepImpulseResponses result;
+		result.linear = extract(linearStart, irLength);
+		for (size_t h = 1; h < starts.size(); h++) {
+			result.harmonics.push_back(extract(starts[h], std::min(irLength, starts[h - 1] - starts[h])));
+		}
 		return result;
 	}
 
-}
\ No newline at end of file
+}
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <complex>
+#include <cstddef>
 #include <vector>
+#include "dft.h"
 
 namespace dsptk {
 
@@ -19,4 +22,83 @@ namespace dsptk {
 	*/
 	std::vector<double> convolve_out(const std::vector<double>&, const std::vector<double>&);
 
-}
\ No newline at end of file
+	/**
+	* @brief Linear convolution through the FFT, same result as convolve in O(N log N).
+	*/
+	std::vector<double> fft_convolve(const std::vector<double>&, const std::vector<double>&);
+
+	/**
+	* @brief Streaming convolution with an impulse response, block by block.
+	*
+	* Uniformly partitioned overlap-add: the impulse response is cut into partitions of a power of two size B,
+	* transformed once, and each B input samples are transformed once into a delay line of spectra. A block
+	* costs a forward and an inverse FFT of 2B points and one spectrum product per partition. The output is
+	* the linear convolution of the whole stream without latency: a partially filled partition is transformed
+	* as it is and the part of the result past it carried to the next blocks. No allocations after Prepare.
+	*/
+	class BlockConvolver final {
+	public:
+		/**
+		* @param partitionSize the partition size B, rounded up to a power of two.
+		*/
+		explicit BlockConvolver(std::vector<double> impulseResponse, int partitionSize = 1024);
+
+		/**
+		* @brief Partitions the impulse response for blocks of maxBlockSize and forgets the tail. Not real time safe.
+		*/
+		void Prepare(int maxBlockSize);
+
+		/**
+		* @brief Convolves the next block of the stream, of any length; blocks of the prepared size are the cheapest.
+		* @param output receives nFrames samples, may be the same as input.
+		*/
+		void ProcessBlock(const double* input, double* output, int nFrames);
+
+		/**
+		* @brief Forgets the tail of the previous blocks.
+		*/
+		void Reset();
+
+	private:
+		std::vector<double> impulseResponse;
+		std::size_t partitionSize = 0;
+		std::size_t numPartitions = 0;
+		std::size_t numBins = 0;								// partitionSize + 1, the spectra are of real signals
+		std::vector<std::complex<double>> responseSpectra;		// numBins per partition
+		std::vector<std::complex<double>> inputSpectra;		// Delay line of the full input partitions, numBins each
+		std::size_t newestSpectrum = 0;
+		std::vector<std::complex<double>> pastSum;				// Products of the older partitions for the current one
+		std::vector<std::complex<double>> work;				// 2 partitionSize
+		FftPlan plan;											// Of the work size
+		std::vector<double> partition;							// The input of the current partition
+		std::vector<double> overlap;							// The result past the previous partition
+		std::size_t fill = 0;
+
+		void ProcessPartition(const double* input, double* output, std::size_t nFrames);
+	};
+
+	/**
+	* @brief Impulse responses recovered from an exponential sweep measurement.
+	*/
+	struct SweepImpulseResponses {
+		/** The linear impulse response. */
+		std::vector<double> linear;
+		/** The harmonic distortion impulse responses, harmonics[0] is the 2nd harmonic. */
+		std::vector<std::vector<double>> harmonics;
+	};
+
+	/**
+	* @brief Deconvolves the response of a system to an exponential_sweep into its impulse responses.
+	*
+	* The harmonic distortion products of the sweep appear before the linear response, the k-th harmonic
+	* T * ln(k) / ln(f2 / f1) seconds earlier. Each harmonic response is truncated to the gap before the previous one.
+	*
+	* @param recorded the system output, starting with the sweep playback and including the decay tail.
+	* @param startFreq, endFreq, duration, samplerate the parameters used to generate the sweep.
+	* @param irLength the length of each returned impulse response in samples.
+	* @param numHarmonics the number of harmonic responses to extract, starting from the 2nd harmonic.
+	*/
+	SweepImpulseResponses deconvolve_sweep(const std::vector<double>& recorded, double startFreq, double endFreq,
+		double duration, double samplerate, std::size_t irLength, int numHarmonics = 0);
+
+}
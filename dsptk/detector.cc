@@ -5,19 +5,100 @@
 
 namespace dsptk {
 
-    double DecoupledPeakDetector::ProcessSample(double input)
+    void DecoupledPeakDetector::ProcessBlock(const double* input, double* output, int nFrames)
     {
-        const double x = std::abs(input);
+        for (int s = 0; s < nFrames; s++) {
+            output[s] = Step(input[s]);
+        }
+    }
+
+
+    RmsDetector::RmsDetector(double sampleRate, double windowTime)
+        : Detector(sampleRate, windowTime, windowTime), windowTime{ windowTime }
+    {
+        calculateFactors();
+    }
 
-        const double k = x > lastOutput ? attackFactor : releaseFactor;
+    double RmsDetector::ProcessSample(double input)
+    {
+        const double squared = input * input;
 
-        lastOutput += k * (x - lastOutput);
+        runningSum += squared - window[position];
+        window[position] = squared;
 
-        if (std::isnan(lastOutput)) {
-            lastOutput = 0.;
+        if (++position == window.size()) {
+            position = 0;
+            renormalize();
         }
 
-        return lastOutput;
+        return std::sqrt(std::max(runningSum, 0.) * inverseWindowSize);
+    }
+
+    void RmsDetector::ProcessBlock(const double* input, double* output, int nFrames)
+    {
+        int s = 0;
+        while (s < nFrames) {
+            // Process up to the end of the circular window so the inner loop has no wrap check
+            const int segment = std::min(nFrames - s, (int)(window.size() - position));
+            double* slot = window.data() + position;
+            double sum = runningSum;
+
+            for (int i = 0; i < segment; i++) {
+                const double squared = input[s + i] * input[s + i];
+                sum += squared - slot[i];
+                slot[i] = squared;
+                output[s + i] = std::sqrt(std::max(sum, 0.) * inverseWindowSize);
+            }
+
+            runningSum = sum;
+            position += segment;
+            s += segment;
+
+            if (position == window.size()) {
+                position = 0;
+                renormalize();
+            }
+        }
+    }
+
+    void RmsDetector::setWindowTime(double windowTime)
+    {
+        if (windowTime != RmsDetector::windowTime)
+        {
+            RmsDetector::windowTime = windowTime;
+            calculateFactors();
+        }
+    }
+
+    void RmsDetector::reset()
+    {
+        std::fill(window.begin(), window.end(), 0.);
+        position = 0;
+        runningSum = 0.;
+    }
+
+    void RmsDetector::calculateFactors()
+    {
+        Detector::calculateFactors();
+
+        const size_t windowSize = std::max<size_t>(1, (size_t)std::round(windowTime * sampleRate));
+        if (windowSize != window.size()) {
+            window.assign(windowSize, 0.);
+            position = 0;
+            runningSum = 0.;
+        }
+        inverseWindowSize = 1. / (double)windowSize;
+    }
+
+    void RmsDetector::renormalize()
+    {
+        // The running sum accumulates rounding errors on every add/subtract pair,
+        // recompute it exactly from the window contents.
+        double sum = 0.;
+        for (double value : window) {
+            sum += value;
+        }
+        runningSum = sum;
     }
 
 
@@ -30,6 +111,13 @@ namespace dsptk {
         calculateFactors();
     }
 
+    void Detector::ProcessBlock(const double* input, double* output, int nFrames)
+    {
+        for (int s = 0; s < nFrames; s++) {
+            output[s] = ProcessSample(input[s]);
+        }
+    }
+
     void Detector::calculateFactors()
     {
         attackFactor = 1. - std::exp(-2.2 / (attackTime * sampleRate));     // Rise Time 10%/90%
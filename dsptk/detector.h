@@ -1,5 +1,10 @@
 #pragma once
 
+#include <cmath>
+#include <cstddef>
+#include <vector>
+#include "audiobuffer.h"
+
 namespace dsptk {
 
 	/** 
@@ -24,12 +29,37 @@ namespace dsptk {
 		*/
 		virtual double ProcessSample(double input) = 0;
 
+		/**
+		* \brief Process a block of samples.
+		* 
+		* The default implementation calls ProcessSample for each sample, derived detectors
+		* override it with a loop free of virtual calls.
+		* 
+		* \param input the samples to be processed.
+		* \param output receives the detector output for each input sample, may alias input.
+		* \param nFrames the number of samples in the block.
+		*/
+		virtual void ProcessBlock(const double* input, double* output, int nFrames);
+
+		/**
+		* \brief Process a block of samples.
+		* 
+		* \param input the samples to be processed.
+		* \param output receives the detector output, at least as long as input, may alias input.
+		*/
+		void ProcessBlock(ChannelView<const double> input, ChannelView<double> output) {
+			assert(output.size() >= input.size());
+			ProcessBlock(input.data(), output.data(), input.size());
+		}
+
+		virtual ~Detector() = default;
+
 		void setSampleRate(double sampleRate);
 		void setAttackTime(double attackTime);
 		void setReleaseTime(double releaseTime);
 
 	protected:
-		void calculateFactors();
+		virtual void calculateFactors();
 
 		double sampleRate;
 		double attackTime;
@@ -45,16 +75,82 @@ namespace dsptk {
 	* Decoupled Peak Detector implementation as described in
 	* http://c4dm.eecs.qmul.ac.uk/audioengineering/compressors/documents/report.pdf Massberg/Reiss pages 30 - 32
 	* Udo Zolzer DAFX 2nd Ed. page 230
+	* 
+	* The class is final so calls through a DecoupledPeakDetector object or reference
+	* (as Compressor does) are resolved statically and can be inlined.
 	*/
-	class DecoupledPeakDetector : virtual public Detector {
+	class DecoupledPeakDetector final : public Detector {
 
 	public:
 		using Detector::Detector;
 		DecoupledPeakDetector(double sampleRate, double attackTime, double releaseTime) : Detector(sampleRate, attackTime, releaseTime) {};
-		virtual double ProcessSample(double input) override;
+
+		double ProcessSample(double input) override {
+			return Step(input);
+		}
+
+		using Detector::ProcessBlock;
+		void ProcessBlock(const double* input, double* output, int nFrames) override;
 
 	private:
 		double lastOutput = .0;
+
+		inline double Step(double input) {
+			const double x = std::abs(input);
+
+			const double k = x > lastOutput ? attackFactor : releaseFactor;
+
+			lastOutput += k * (x - lastOutput);
+
+			if (std::isnan(lastOutput)) {
+				lastOutput = 0.;
+			}
+
+			return lastOutput;
+		}
+	};
+
+	/**
+	* \brief Windowed RMS Detector.
+	* 
+	* Keeps a running sum of squares over a circular window so each sample costs O(1)
+	* instead of re-summing the whole window. The running sum is recomputed from the
+	* window contents once per window length to stop floating-point drift.
+	*/
+	class RmsDetector final : public Detector {
+
+	public:
+		/**
+		* \brief Creates a windowed RMS detector.
+		* 
+		* \param sampleRate the signal sample rate expressed as samples per second.
+		* \param windowTime the integration window expressed in seconds.
+		*/
+		RmsDetector(double sampleRate, double windowTime);
+
+		double ProcessSample(double input) override;
+
+		using Detector::ProcessBlock;
+		void ProcessBlock(const double* input, double* output, int nFrames) override;
+
+		void setWindowTime(double windowTime);
+
+		/**
+		* \brief Clears the window contents.
+		*/
+		void reset();
+
+	protected:
+		void calculateFactors() override;
+
+	private:
+		void renormalize();
+
+		double windowTime;
+		std::vector<double> window;
+		std::size_t position = 0;
+		double runningSum = .0;
+		double inverseWindowSize = 1.;
 	};
 
 }	// End namespace dsptk
\ No newline at end of file
@@ -1,7 +1,12 @@
 #include "dft.h"
 #include "constants.h"
+#include "simd.h"
+#include "tracing.h"
+#include <cassert>
 #include <cmath>
 #include <limits>
+#include <utility>
+#include <algorithm>
 
 namespace dsptk {
 
@@ -65,4 +70,190 @@ namespace dsptk {
 		return result;
 	}
 
-}
\ No newline at end of file
+	size_t fft_size(size_t size) {
+		size_t n = 1;
+		while (n < size) n <<= 1;
+		return n;
+	}
+
+	// Complex values per cache block, 256 KiB
+	static constexpr size_t fftCacheBlock = 1 << 14;
+
+	/*
+	* exp(sign 2 PI i k / N) for k < N / 2, interleaved cos/sin.
+	* Only the first octant needs trigonometric functions, the rest of the half circle follows by symmetry.
+	*/
+	static std::vector<double> twiddle_table(size_t N, double sign) {
+
+		const size_t half = N / 2;
+		const size_t quarter = N / 4;
+		std::vector<double> twiddles(2 * half);
+		for (size_t k = 0; k <= N / 8 && k < half; k++) {
+			const double phase = DOUBLE_PI<double> * (double)k / (double)N;
+			const double c = std::cos(phase);
+			const double s = sign * std::sin(phase);
+			twiddles[2 * k] = c;
+			twiddles[2 * k + 1] = s;
+			if (quarter > 0) {
+				twiddles[2 * (quarter - k)] = sign * s;
+				twiddles[2 * (quarter - k) + 1] = sign * c;
+			}
+		}
+		for (size_t k = std::max<size_t>(quarter, 1); k < half; k++) {
+			twiddles[2 * k] = -sign * twiddles[2 * (k - quarter) + 1];
+			twiddles[2 * k + 1] = sign * twiddles[2 * (k - quarter)];
+		}
+		return twiddles;
+	}
+
+	/*
+	* Contiguous twiddles of every stage in the layout of the butterfly kernel, stage len starts at offset 2 len - 4.
+	* The twiddles of the last stage are W^k = exp(-+2 PI i k / N), earlier stages use every (N / len) th.
+	*/
+	static std::vector<double> stage_twiddles(size_t N, bool inverse) {
+
+		const std::vector<double> twiddles = twiddle_table(N, inverse ? 1. : -1.);
+		std::vector<double> stageTwiddles(4 * (N - 1));
+		for (size_t len = 2; len <= N; len <<= 1) {
+			const size_t step = N / len;
+			double* w = stageTwiddles.data() + 2 * len - 4;
+			for (size_t k = 0; k < len / 2; k++) {
+				const double wr = twiddles[2 * k * step];
+				const double wi = twiddles[2 * k * step + 1];
+				w[4 * k] = wr;
+				w[4 * k + 1] = -wi;
+				w[4 * k + 2] = wi;
+				w[4 * k + 3] = wr;
+			}
+		}
+		return stageTwiddles;
+	}
+
+	/*
+	* The butterflies of every stage on the bit reversed signal x of N complex values, and the 1/N scale of the inverse.
+	*/
+	static void fft_stages(double* x, size_t N, const double* stageTwiddles, bool inverse) {
+
+		const auto stageButterflies = simd::GetKernels().fftButterflies;
+		auto butterflies = [x, stageTwiddles, stageButterflies](size_t len, size_t begin, size_t end) {
+			stageButterflies(x, len, begin, end, stageTwiddles + 2 * len - 4);
+		};
+
+		// The first stages run depth first over blocks that fit in cache, the rest stream through the whole signal
+		const size_t blockSize = std::min(N, fftCacheBlock);
+		for (size_t block = 0; block < N; block += blockSize) {
+			for (size_t len = 2; len <= blockSize; len <<= 1) {
+				butterflies(len, block, block + blockSize);
+			}
+		}
+		for (size_t len = 2 * blockSize; len <= N; len <<= 1) {
+			butterflies(len, 0, N);
+		}
+
+		if (inverse) {
+			const double scale = 1. / (double)N;
+			for (size_t i = 0; i < 2 * N; i++) {
+				x[i] *= scale;
+			}
+		}
+	}
+
+	/*
+	* Iterative decimation in time with the bit reversed permutation first.
+	* Butterflies work on the real/imaginary parts directly, avoiding the NaN checks of
+	* std::complex multiplication, and each stage reads its twiddles contiguously.
+	*/
+	void fft(std::vector<std::complex<double>>& data, bool inverse) {
+		DSPTK_TRACE_SCOPE("fft", (std::int64_t)data.size());
+
+		const size_t N = data.size();
+		assert((N & (N - 1)) == 0 && "The FFT size must be a power of two");
+		if (N < 2) return;
+
+		// Bit reversed permutation
+		for (size_t i = 1, j = 0; i < N; i++) {
+			size_t bit = N >> 1;
+			for (; j & bit; bit >>= 1) {
+				j ^= bit;
+			}
+			j ^= bit;
+			if (i < j) {
+				std::swap(data[i], data[j]);
+			}
+		}
+
+		// std::complex is layout compatible with double[2]
+		fft_stages(reinterpret_cast<double*>(data.data()), N, stage_twiddles(N, inverse).data(), inverse);
+	}
+
+	FftPlan::FftPlan(size_t size) : size(size) {
+		assert((size & (size - 1)) == 0 && "The FFT size must be a power of two");
+		if (size < 2) return;
+
+		for (size_t i = 1, j = 0; i < size; i++) {
+			size_t bit = size >> 1;
+			for (; j & bit; bit >>= 1) {
+				j ^= bit;
+			}
+			j ^= bit;
+			if (i < j) {
+				swaps.emplace_back(i, j);
+			}
+		}
+		forwardTwiddles = stage_twiddles(size, false);
+		inverseTwiddles = stage_twiddles(size, true);
+	}
+
+	void fft(std::vector<std::complex<double>>& data, const FftPlan& plan, bool inverse) {
+		DSPTK_TRACE_SCOPE("fft", (std::int64_t)data.size());
+		assert(data.size() == plan.size && "The data size must be the size of the plan");
+
+		const size_t N = plan.size;
+		if (N < 2) return;
+
+		for (const auto& swap : plan.swaps) {
+			std::swap(data[swap.first], data[swap.second]);
+		}
+
+		const std::vector<double>& stageTwiddles = inverse ? plan.inverseTwiddles : plan.forwardTwiddles;
+		fft_stages(reinterpret_cast<double*>(data.data()), N, stageTwiddles.data(), inverse);
+	}
+
+	/*
+	* The even and odd samples of x are the real and imaginary parts of a half size inverse transform of
+	* Y[k] = (C[k] + C[k + N/2]) / 2 + i exp(2 PI i k / N) (C[k] - C[k + N/2]) / 2, where C[k + N/2] = conj(C[N/2 - k]).
+	*/
+	std::vector<double> ifft_real(const std::vector<std::complex<double>>& spectrum) {
+		DSPTK_TRACE_SCOPE("ifft_real", (std::int64_t)spectrum.size());
+
+		if (spectrum.size() < 2) return spectrum.empty() ? std::vector<double>() : std::vector<double>{ spectrum[0].real() };
+
+		const size_t half = spectrum.size() - 1;
+		const size_t N = 2 * half;
+		const std::vector<double> twiddles = twiddle_table(N, 1.);
+
+		std::vector<std::complex<double>> y(half);
+		for (size_t k = 0; k < half; k++) {
+			const std::complex<double> c = spectrum[k];
+			const std::complex<double> cMirror = std::conj(spectrum[half - k]);
+			const double er = .5 * (c.real() + cMirror.real());
+			const double ei = .5 * (c.imag() + cMirror.imag());
+			const double dr = .5 * (c.real() - cMirror.real());
+			const double di = .5 * (c.imag() - cMirror.imag());
+			const double wr = twiddles[2 * k];
+			const double wi = twiddles[2 * k + 1];
+			// e + i w d
+			y[k] = { er - (wr * di + wi * dr), ei + (wr * dr - wi * di) };
+		}
+
+		fft(y, true);
+
+		std::vector<double> result(N);
+		for (size_t m = 0; m < half; m++) {
+			result[2 * m] = y[m].real();
+			result[2 * m + 1] = y[m].imag();
+		}
+		return result;
+	}
+
+}
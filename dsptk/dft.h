@@ -1,7 +1,10 @@
 #pragma once
 
+#include <cstddef>
 #include <vector>
 #include <array>
+#include <complex>
+#include <utility>
 
 namespace dsptk {
 	/**
@@ -9,4 +12,56 @@ namespace dsptk {
 	*/
 	std::array<std::vector<double>, 2> real_dft_analysis(const std::vector<double>&);
 
-}
\ No newline at end of file
+	/**
+	* @brief In place radix-2 Fast Fourier Transform.
+	* 
+	* @param data the complex signal, its size must be a power of two.
+	* @param inverse computes the inverse transform, scaled by 1/N so fft followed by inverse fft is the identity.
+	*/
+	void fft(std::vector<std::complex<double>>& data, bool inverse = false);
+
+	/**
+	* @brief The bit reversed permutation and the twiddles of every stage of an FFT size, computed once
+	* so transforms of that size don't allocate.
+	*/
+	class FftPlan final {
+	public:
+		/**
+		* @param size the transform size, a power of two. Not real time safe.
+		*/
+		explicit FftPlan(std::size_t size = 0);
+
+		std::size_t GetSize() const { return size; }
+
+	private:
+		friend void fft(std::vector<std::complex<double>>&, const FftPlan&, bool);
+
+		std::size_t size = 0;
+		std::vector<std::pair<std::size_t, std::size_t>> swaps;	// The pairs i < j of the permutation
+		std::vector<double> forwardTwiddles;
+		std::vector<double> inverseTwiddles;
+	};
+
+	/**
+	* @brief In place radix-2 FFT with a plan, same result as fft without allocating.
+	*
+	* @param data the complex signal, of the size of the plan.
+	* @param inverse computes the inverse transform, scaled by 1/N.
+	*/
+	void fft(std::vector<std::complex<double>>& data, const FftPlan& plan, bool inverse = false);
+
+	/**
+	* @brief Inverse FFT of the spectrum of a real signal, using a transform of half the size.
+	* 
+	* @param spectrum the first N/2 + 1 bins of the spectrum, the rest follow from its conjugate symmetry. N must be a power of two.
+	* @return the N real samples, scaled as fft with inverse = true.
+	*/
+	std::vector<double> ifft_real(const std::vector<std::complex<double>>& spectrum);
+
+	/**
+	* @brief Smallest power of two greater or equal than size, the sizes fft and FftPlan accept.
+	* The transforms are radix-2 only: other sizes assert, and give a wrong spectrum without asserts.
+	*/
+	std::size_t fft_size(std::size_t size);
+
+}
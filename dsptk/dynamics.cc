@@ -1,11 +1,34 @@
+#include <cassert>
+#include <cmath>
+#include <limits>
 #include <vector>
 #include "dynamics.h"
 #include "dsptypes.h"
+#include "simd.h"
+#include "tracing.h"
 
 namespace dsptk {
 
 
     double GainReductionComputer::Compute(double sample) {
+        return tableEnabled ? LookUp(sample) : ComputeCurve(sample);
+    }
+
+    void GainReductionComputer::ComputeBlock(const double* input, double* output, int nFrames)
+    {
+        if (tableEnabled) {
+            for (int s = 0; s < nFrames; s++) {
+                output[s] = LookUp(input[s]);
+            }
+        }
+        else {
+            for (int s = 0; s < nFrames; s++) {
+                output[s] = ComputeCurve(input[s]);
+            }
+        }
+    }
+
+    double GainReductionComputer::ComputeCurve(double sample) const {
 
         double gainReduction = 0.;
 
@@ -30,20 +53,87 @@ namespace dsptk {
 
     void GainReductionComputer::SetThreshold(double threshold)
     {
+        if (threshold == GainReductionComputer::threshold) return;
         GainReductionComputer::threshold = threshold;
         CalculateKneeLimits();
+        RebuildTable();
     }
 
     void GainReductionComputer::SetRatio(double ratio)
     {
+        if (ratio == GainReductionComputer::ratio) return;
         GainReductionComputer::ratio = ratio;
         CalculateReductionFactor();
+        RebuildTable();
     }
 
     void GainReductionComputer::SetKneeWidth(double kneeWidth)
     {
+        if (kneeWidth == GainReductionComputer::kneeWidth) return;
         GainReductionComputer::kneeWidth = kneeWidth;
         CalculateKneeLimits();
+        RebuildTable();
+    }
+
+    bool GainReductionComputer::EnableTable(double minDb, double maxDb, int size)
+    {
+        // An empty range has no step between points, a reversed one looks up before the table
+        const bool validRange = std::isfinite(minDb) && std::isfinite(maxDb) && minDb < maxDb;
+        assert(validRange && "Gain table range is empty");
+        if (!validRange) return false;
+
+        tableEnabled = true;
+        tableMin = minDb;
+        tableMax = maxDb;
+        size = std::max(size, 2);
+        tableValues.assign(size, 0.);
+        tableSlopes.assign(size, 0.);
+        RebuildTable();
+        return true;
+    }
+
+    void GainReductionComputer::DisableTable()
+    {
+        if (transferCurve) return;
+        tableEnabled = false;
+    }
+
+    void GainReductionComputer::SetTransferCurve(std::function<double(double)> curve)
+    {
+        transferCurve = std::move(curve);
+        if (!tableEnabled) {
+            EnableTable();
+        }
+        else {
+            RebuildTable();
+        }
+    }
+
+    void GainReductionComputer::ClearTransferCurve()
+    {
+        transferCurve = nullptr;
+        RebuildTable();
+    }
+
+    void GainReductionComputer::RebuildTable()
+    {
+        if (!tableEnabled) return;
+
+        const int size = (int)tableValues.size();
+        const double step = (tableMax - tableMin) / (size - 1);
+        tableScale = 1. / step;
+        lastSegment = size - 2;
+
+        for (int i = 0; i < size; i++) {
+            const double level = tableMin + i * step;
+            tableValues[i] = transferCurve ? transferCurve(level) : ComputeCurve(level);
+        }
+
+        // Slope of each segment, the last one repeats the previous so values past maxDb are extrapolated
+        for (int i = 0; i < size - 1; i++) {
+            tableSlopes[i] = tableValues[i + 1] - tableValues[i];
+        }
+        tableSlopes[size - 1] = tableSlopes[size - 2];
     }
 
     void GainReductionComputer::CalculateKneeLimits()
@@ -61,39 +151,71 @@ namespace dsptk {
     Compressor::Compressor(double threshold, double ratio, double kneeWidth, double sampleRate, double attackMs, double releaseMs)
         : grDetector{ sampleRate, attackMs, releaseMs }
         , reductionComputer{ threshold, ratio, kneeWidth }
+        , ownScratch{ ScratchBytes(defaultBlockSize) }
+    {
+    }
+
+    void Compressor::Prepare(int maxBlockSize, ScratchArena* arena)
     {
+        Compressor::maxBlockSize = std::max(1, maxBlockSize);
+        sharedScratch = arena;
+        ownScratch.Reserve(arena ? 0 : ScratchBytes(Compressor::maxBlockSize));
     }
 
-    void Compressor::ProcessBlock(double* input, double* sidechain, double* output, double* vcaGain, int nFrames)
+    void Compressor::ProcessBlock(const double* input, const double* sidechain, double* output, double* vcaGain, int nFrames)
     {
-        std::vector<double> localBuffer(nFrames);
+        // The dB control signal lives in scratch memory, given back on return
+        ScratchArena& scratch = sharedScratch ? *sharedScratch : ownScratch;
+        ScratchScope scope(scratch);
+        double* localBuffer = scratch.Allocate<double>((std::size_t)std::min(nFrames, maxBlockSize));
 
+        const double* control = sidechain ? sidechain : input;
+        for (int start = 0; start < nFrames; start += maxBlockSize) {
+            ProcessChunk(input + start, control + start, output + start, vcaGain + start, localBuffer, std::min(maxBlockSize, nFrames - start));
+        }
+    }
+
+    void Compressor::ProcessChunk(const double* input, const double* control, double* output, double* vcaGain, double* localBuffer, int nFrames)
+    {
         // Log of control (sidechain or input) signal
-        double* controlSignal = sidechain ? sidechain : input;
-        for (int s = 0; s < nFrames; s++) {
-            localBuffer[s] = dsptk::DB::fromLinearGain(controlSignal[s]).asDB();
+        {
+            DSPTK_PROFILE_STAGE(profiler, Level, nFrames);
+            DSPTK_TRACE_SCOPE("Compressor level");
+            simd::GetKernels().linearToDb(control, localBuffer, nFrames);
         }
 
         // Pass log of control signal through gain curve
         // Here we have the control signal converted to dBs between -infinite and zero (or greater)
-        for (int s = 0; s < nFrames; s++) {
-            vcaGain[s] = reductionComputer.Compute(localBuffer[s]);
-        }
+        {
+            DSPTK_PROFILE_STAGE(profiler, Curve, nFrames);
+            DSPTK_TRACE_SCOPE("Compressor curve");
+            reductionComputer.ComputeBlock(localBuffer, localBuffer, nFrames);
 
-        // Back to linear for feeding the detector
-        for (int s = 0; s < nFrames; s++) {
-            vcaGain[s] = dsptk::DB(vcaGain[s]).asLinearGain();
+            // Back to linear for feeding the detector
+            simd::GetKernels().dbToLinear(localBuffer, vcaGain, nFrames);
         }
 
         // Attack/Release post gain curve
-        for (int s = 0; s < nFrames; s++) {
-            // Here we have a gain factor between 0dB and -inf, so we need to invert the input to the detector and its output.
-            vcaGain[s] = 1. - grDetector.ProcessSample(1. - vcaGain[s]);
+        // Here we have a gain factor between 0dB and -inf, so we need to invert the input to the detector and its output.
+        {
+            DSPTK_PROFILE_STAGE(profiler, Smoothing, nFrames);
+            DSPTK_TRACE_SCOPE("Compressor smoothing");
+            for (int s = 0; s < nFrames; s++) {
+                vcaGain[s] = 1. - vcaGain[s];
+            }
+            grDetector.ProcessBlock(vcaGain, vcaGain, nFrames);
+            for (int s = 0; s < nFrames; s++) {
+                vcaGain[s] = 1. - vcaGain[s];
+            }
         }
 
         // Apply the gain profile
-        for (int s = 0; s < nFrames; s++) {
-            output[s] = input[s] * vcaGain[s];
+        {
+            DSPTK_PROFILE_STAGE(profiler, Gain, nFrames);
+            DSPTK_TRACE_SCOPE("Compressor gain");
+            for (int s = 0; s < nFrames; s++) {
+                output[s] = input[s] * vcaGain[s];
+            }
         }
 
     }
@@ -128,4 +250,253 @@ namespace dsptk {
         reductionComputer.SetKneeWidth(kneeWidth);
     }
 
+    bool Compressor::EnableGainTable(double minDb, double maxDb, int size)
+    {
+        return reductionComputer.EnableTable(minDb, maxDb, size);
+    }
+
+    void Compressor::DisableGainTable()
+    {
+        reductionComputer.DisableTable();
+    }
+
+    void Compressor::SetTransferCurve(std::function<double(double)> curve)
+    {
+        reductionComputer.SetTransferCurve(std::move(curve));
+    }
+
+    void Compressor::ClearTransferCurve()
+    {
+        reductionComputer.ClearTransferCurve();
+    }
+
+
+    Expander::Expander(double threshold, double ratio, double range, double sampleRate, double attackTime, double releaseTime)
+        : levelDetector{ sampleRate, 0., releaseTime }
+        , gainDetector{ sampleRate, attackTime, releaseTime }
+        , sampleRate{ sampleRate }
+        , threshold{ threshold }
+        , ratio{ ratio }
+        , range{ range }
+    {
+        CalculateConstants();
+    }
+
+    void Expander::ProcessBlock(const double* input, const double* sidechain, double* output, double* gain, int nFrames)
+    {
+        const double* controlSignal = sidechain ? sidechain : input;
+
+        // Choose the gain law once per block
+        if (std::isinf(ratio)) {
+            Process<true>(controlSignal, gain, nFrames);
+        }
+        else {
+            Process<false>(controlSignal, gain, nFrames);
+        }
+
+        // Apply the gain profile
+        for (int s = 0; s < nFrames; s++) {
+            output[s] = input[s] * gain[s];
+        }
+    }
+
+    template <bool infiniteRatio>
+    void Expander::Process(const double* control, double* gain, int nFrames)
+    {
+        levelDetector.ProcessBlock(control, gain, nFrames);
+
+        bool isOpen = open;
+        int counter = holdCounter;
+
+        for (int s = 0; s < nFrames; s++) {
+            const double level = gain[s];
+
+            // Stays open above the closing level, below it the hold counts down before closing
+            const bool aboveClose = level >= closeLevel;
+            counter = aboveClose ? holdSamples : counter - (counter > 0);
+            isOpen = (level > openLevel) | (isOpen & (aboveClose | (counter > 0)));
+
+            double closedGain = rangeGain;
+            if constexpr (!infiniteRatio) {
+                closedGain = std::max(rangeGain, std::pow(level * inverseThreshold, ratio - 1.));
+            }
+
+            gain[s] = isOpen ? 1. : closedGain;
+        }
+
+        open = isOpen;
+        holdCounter = counter;
+
+        // Attack/Release on the gain
+        gainDetector.ProcessBlock(gain, gain, nFrames);
+    }
+
+    void Expander::SetSampleRate(double sampleRate)
+    {
+        Expander::sampleRate = sampleRate;
+        levelDetector.setSampleRate(sampleRate);
+        gainDetector.setSampleRate(sampleRate);
+        CalculateConstants();
+    }
+
+    void Expander::SetAttackTime(double attackTime)
+    {
+        gainDetector.setAttackTime(attackTime);
+    }
+
+    void Expander::SetReleaseTime(double releaseTime)
+    {
+        levelDetector.setReleaseTime(releaseTime);
+        gainDetector.setReleaseTime(releaseTime);
+    }
+
+    void Expander::SetThreshold(double threshold)
+    {
+        Expander::threshold = threshold;
+        CalculateConstants();
+    }
+
+    void Expander::SetRatio(double ratio)
+    {
+        Expander::ratio = ratio;
+    }
+
+    void Expander::SetRange(double range)
+    {
+        Expander::range = range;
+        CalculateConstants();
+    }
+
+    void Expander::SetHysteresis(double hysteresis)
+    {
+        Expander::hysteresis = hysteresis;
+        CalculateConstants();
+    }
+
+    void Expander::SetHoldTime(double holdTime)
+    {
+        Expander::holdTime = holdTime;
+        CalculateConstants();
+    }
+
+    void Expander::CalculateConstants()
+    {
+        openLevel = dsptk::DB(threshold).asLinearGain();
+        closeLevel = dsptk::DB(threshold - hysteresis).asLinearGain();
+        inverseThreshold = 1. / openLevel;
+        rangeGain = dsptk::DB(range).asLinearGain();
+        holdSamples = (int)std::round(holdTime * sampleRate);
+    }
+
+    Gate::Gate(double threshold, double range, double sampleRate, double attackTime, double releaseTime)
+        : Expander{ threshold, std::numeric_limits<double>::infinity(), range, sampleRate, attackTime, releaseTime }
+    {
+    }
+
+    MultibandCompressor::MultibandCompressor(const std::vector<double>& crossoverFrequencies, double sampleRate)
+    {
+        const int numCrossovers = (int)crossoverFrequencies.size();
+
+        for (double frequency : crossoverFrequencies) {
+            crossovers.emplace_back(frequency, sampleRate);
+        }
+
+        // Band b is split off by crossover b, so it misses the phase shift of crossovers b + 1 onwards
+        for (int b = 0; b <= numCrossovers; b++) {
+            compensationStart.push_back((int)allPasses.size());
+            for (int c = b + 1; c < numCrossovers; c++) {
+                allPasses.emplace_back(crossoverFrequencies[c], sampleRate);
+            }
+            bands.push_back(Band{ { 0., 1., 0. }, { sampleRate, .01, .1 } });
+        }
+        compensationStart.push_back((int)allPasses.size());
+
+        bandSamples.resize(bands.size());
+        Prepare(sampleRate, defaultBlockSize);
+    }
+
+    void MultibandCompressor::Prepare(double sampleRate, int maxBlockSize)
+    {
+        assert(maxBlockSize > 0);
+        for (auto& crossover : crossovers) {
+            crossover.UpdateSamplerate(sampleRate);
+        }
+        for (auto& allPass : allPasses) {
+            allPass.UpdateSamplerate(sampleRate);
+        }
+        for (auto& band : bands) {
+            band.grDetector.setSampleRate(sampleRate);
+        }
+
+        MultibandCompressor::maxBlockSize = maxBlockSize;
+        bandGain.assign(bands.size() * maxBlockSize, 1.);
+    }
+
+    void MultibandCompressor::ProcessBlock(double* buffer, int nFrames)
+    {
+        for (int start = 0; start < nFrames; start += maxBlockSize) {
+            ProcessChunk(buffer + start, std::min(maxBlockSize, nFrames - start));
+        }
+    }
+
+    void MultibandCompressor::ProcessChunk(double* buffer, int nFrames)
+    {
+        const int numCrossovers = (int)crossovers.size();
+        const int numBands = (int)bands.size();
+        double* split = bandSamples.data();
+
+        for (int s = 0; s < nFrames; s++) {
+
+            // Split, each crossover takes the high output of the previous one
+            double rest = buffer[s];
+            for (int c = 0; c < numCrossovers; c++) {
+                crossovers[c].ProcessSample(rest, split[c], rest);
+            }
+            split[numCrossovers] = rest;
+
+            double output = 0.;
+            for (int b = 0; b < numBands; b++) {
+                double x = split[b];
+                for (int a = compensationStart[b]; a < compensationStart[b + 1]; a++) {
+                    x = allPasses[a].ProcessSample(x);
+                }
+
+                // Same gain path as Compressor: level -> gain curve -> linear -> attack/release
+                Band& band = bands[b];
+                double gain = dsptk::DB(band.reductionComputer.Compute(dsptk::DB::fromLinearGain(x).asDB())).asLinearGain();
+                gain = 1. - band.grDetector.ProcessSample(1. - gain);
+
+                bandGain[b * maxBlockSize + s] = gain;
+                output += x * gain;
+            }
+
+            buffer[s] = output;
+        }
+    }
+
+    void MultibandCompressor::SetThreshold(int band, double threshold)
+    {
+        bands[band].reductionComputer.SetThreshold(threshold);
+    }
+
+    void MultibandCompressor::SetRatio(int band, double ratio)
+    {
+        bands[band].reductionComputer.SetRatio(ratio);
+    }
+
+    void MultibandCompressor::SetKneeWidth(int band, double kneeWidth)
+    {
+        bands[band].reductionComputer.SetKneeWidth(kneeWidth);
+    }
+
+    void MultibandCompressor::SetAttackTime(int band, double attackTime)
+    {
+        bands[band].grDetector.setAttackTime(attackTime);
+    }
+
+    void MultibandCompressor::SetReleaseTime(int band, double releaseTime)
+    {
+        bands[band].grDetector.setReleaseTime(releaseTime);
+    }
+
 }	// End namespace dsptk
\ No newline at end of file
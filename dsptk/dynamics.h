@@ -1,6 +1,13 @@
 #pragma once
 
+#include <algorithm>
+#include <functional>
+#include <vector>
+#include "arena.h"
+#include "audiobuffer.h"
 #include "detector.h"
+#include "filters.h"
+#include "profiling.h"
 
 namespace dsptk {
 
@@ -15,10 +22,54 @@ namespace dsptk {
 
         double Compute(double);
 
+        /**
+         * @brief Computes the gain reduction for a block of levels.
+         * @param input the levels in dB.
+         * @param output receives the gain reduction in dB, may alias input.
+         * @param nFrames the number of values in the block.
+        */
+        void ComputeBlock(const double* input, double* output, int nFrames);
+
         void SetThreshold(double threshold);
         void SetRatio(double ratio);
         void SetKneeWidth(double kneeWidth);
 
+        /**
+         * @brief Precomputes the transfer curve into a lookup table with linear interpolation.
+         * 
+         * Compute then runs without branches on the knee position. The table is rebuilt
+         * when the threshold, ratio or knee width change.
+         * Below minDb the value at minDb is held, above maxDb the last segment is extended,
+         * which is exact for the built in curve when maxDb is past the knee.
+         * @param minDb the lowest level in the table.
+         * @param maxDb the highest level in the table.
+         * @param size the number of points in the table.
+         * @return false if minDb isn't below maxDb (asserts in debug builds), the table is left as it was.
+        */
+        bool EnableTable(double minDb = -96., double maxDb = 24., int size = 1024);
+
+        /**
+         * @brief Goes back to evaluating the built in curve on each call.
+         * Has no effect while a transfer curve is set.
+        */
+        void DisableTable();
+
+        bool IsTableEnabled() const { return tableEnabled; }
+
+        /**
+         * @brief Replaces the built in curve with a user defined one, e.g. multi slope or expander plus compressor.
+         * 
+         * The curve is tabulated over the current table range (enabling the table with the
+         * default range if needed) so it costs the same as the built in one.
+         * @param curve returns the gain reduction in dB for an input level in dB.
+        */
+        void SetTransferCurve(std::function<double(double)> curve);
+
+        /**
+         * @brief Removes the user defined curve, going back to threshold, ratio and knee.
+        */
+        void ClearTransferCurve();
+
     private:
         double threshold;
         double ratio;
@@ -28,6 +79,26 @@ namespace dsptk {
         double kneeEnd;
         double reductionFactor;
 
+        // Lookup table state
+        bool tableEnabled = false;
+        double tableMin = 0.;
+        double tableMax = 0.;
+        double tableScale = 1.;         // Table points per dB
+        double lastSegment = 0.;
+        std::vector<double> tableValues;
+        std::vector<double> tableSlopes;
+        std::function<double(double)> transferCurve;
+
+        double ComputeCurve(double sample) const;
+        void RebuildTable();
+
+        inline double LookUp(double sample) const {
+            // Argument order sends NaN to the table start
+            const double position = (std::max(tableMin, sample) - tableMin) * tableScale;
+            const int index = (int)std::min(position, lastSegment);
+            return tableValues[index] + (position - index) * tableSlopes[index];
+        }
+
         void CalculateKneeLimits();
         void CalculateReductionFactor();
     };
@@ -36,7 +107,30 @@ namespace dsptk {
     public:
         Compressor(double threshold, double ratio, double kneeWidth, double sampleRate, double attackMs, double releaseMs);
 
-        void ProcessBlock(double* input, double* sidechain, double* output, double* grMeter, int nFrames);
+        /**
+         * @brief Sets the largest block processed at once, larger blocks are processed in chunks, and where the
+         * scratch memory comes from. Not real time safe without an arena (the compressor's own is resized).
+         * @param maxBlockSize the chunk size, 1024 by default.
+         * @param arena a shared arena with at least ScratchBytes(maxBlockSize) free while processing,
+         * nullptr to use the compressor's own.
+        */
+        void Prepare(int maxBlockSize, ScratchArena* arena = nullptr);
+
+        /**
+         * @brief Scratch memory ProcessBlock takes from the arena.
+        */
+        static std::size_t ScratchBytes(int maxBlockSize) { return ScratchArena::BytesFor<double>((std::size_t)maxBlockSize); }
+
+        void ProcessBlock(const double* input, const double* sidechain, double* output, double* grMeter, int nFrames);
+
+        /**
+         * @brief Process a block of samples, output and gain at least as long as input.
+         * An empty sidechain view compresses from the input.
+        */
+        void ProcessBlock(ChannelView<double> input, ChannelView<double> sidechain, ChannelView<double> output, ChannelView<double> gain) {
+            assert(output.size() >= input.size() && gain.size() >= input.size() && (sidechain.empty() || sidechain.size() >= input.size()));
+            ProcessBlock(input.data(), sidechain.empty() ? nullptr : sidechain.data(), output.data(), gain.data(), input.size());
+        }
 
         void SetSampleRate(double sampleRate);
         void SetAttackTime(double attackTime);
@@ -46,9 +140,235 @@ namespace dsptk {
         void SetRatio(double ratio);
         void SetKneeWidth(double kneeWidth);
 
+        /**
+         * @copydoc GainReductionComputer::EnableTable()
+        */
+        bool EnableGainTable(double minDb = -96., double maxDb = 24., int size = 1024);
+
+        /**
+         * @copydoc GainReductionComputer::DisableTable()
+        */
+        void DisableGainTable();
+
+        /**
+         * @copydoc GainReductionComputer::SetTransferCurve()
+        */
+        void SetTransferCurve(std::function<double(double)> curve);
+
+        /**
+         * @copydoc GainReductionComputer::ClearTransferCurve()
+        */
+        void ClearTransferCurve();
+
+#ifdef DSPTK_ENABLE_PROFILING
+        /**
+         * @brief ProcessBlock stages, indices of the profiler stages.
+        */
+        enum Stage { Level, Curve, Smoothing, Gain };
+
+        /**
+         * @brief Per stage load of ProcessBlock.
+        */
+        const profiling::Profiler& GetProfiler() const { return profiler; }
+        profiling::Profiler& GetProfiler() { return profiler; }
+#endif
+
     private:
+        static constexpr int defaultBlockSize = 1024;
+
         DecoupledPeakDetector grDetector;
         GainReductionComputer reductionComputer;
+        int maxBlockSize = defaultBlockSize;
+        ScratchArena ownScratch;
+        ScratchArena* sharedScratch = nullptr;
+
+        void ProcessChunk(const double* input, const double* control, double* output, double* vcaGain, double* localBuffer, int nFrames);
+#ifdef DSPTK_ENABLE_PROFILING
+        profiling::Profiler profiler{ { "level", "curve", "smoothing", "gain" } };
+#endif
+    };
+
+    /**
+     * @brief Downward expander with hold and hysteresis.
+     * 
+     * The control signal (sidechain or input) goes through a peak follower with instant attack.
+     * The expander opens when the level rises above the threshold and closes when it stays below
+     * threshold - hysteresis for longer than the hold time. While closed levels are expanded
+     * by the ratio, never attenuating more than the range. The gain is then smoothed with the
+     * attack (opening) and release (closing) times.
+     * 
+     * Levels are compared in the linear domain and the state update has no data dependent branches,
+     * with infinite ratio (see Gate) there are no log/pow calls per sample.
+    */
+    class Expander {
+    public:
+        /**
+         * @brief Creates an expander.
+         * @param threshold the opening threshold in dB.
+         * @param ratio the expansion ratio, 1:ratio below the threshold.
+         * @param range the maximum attenuation in dB (negative).
+         * @param sampleRate the signal sample rate in samples/second.
+         * @param attackTime the opening time in seconds.
+         * @param releaseTime the closing time in seconds.
+        */
+        Expander(double threshold, double ratio, double range, double sampleRate, double attackTime, double releaseTime);
+
+        /**
+         * @brief Process a block of samples.
+         * @param input the input samples.
+         * @param sidechain the control signal, nullptr to use the input.
+         * @param output receives the processed samples, may alias input.
+         * @param gain receives the linear gain applied to each sample.
+         * @param nFrames the number of samples.
+        */
+        void ProcessBlock(const double* input, const double* sidechain, double* output, double* gain, int nFrames);
+
+        /**
+         * @brief Process a block of samples, output and gain at least as long as input.
+         * An empty sidechain view uses the input as control signal.
+        */
+        void ProcessBlock(ChannelView<const double> input, ChannelView<const double> sidechain, ChannelView<double> output, ChannelView<double> gain) {
+            assert(output.size() >= input.size() && gain.size() >= input.size() && (sidechain.empty() || sidechain.size() >= input.size()));
+            ProcessBlock(input.data(), sidechain.empty() ? nullptr : sidechain.data(), output.data(), gain.data(), input.size());
+        }
+
+        void SetSampleRate(double sampleRate);
+        void SetAttackTime(double attackTime);
+        void SetReleaseTime(double releaseTime);
+
+        void SetThreshold(double threshold);
+        void SetRatio(double ratio);
+        void SetRange(double range);
+
+        /**
+         * @brief Sets how far below the threshold the level must drop to close, in dB.
+        */
+        void SetHysteresis(double hysteresis);
+
+        /**
+         * @brief Sets how long the expander stays open after the level drops, in seconds.
+        */
+        void SetHoldTime(double holdTime);
+
+    private:
+        DecoupledPeakDetector levelDetector;
+        DecoupledPeakDetector gainDetector;
+
+        double sampleRate;
+        double threshold;
+        double ratio;
+        double range;
+        double hysteresis = 0.;
+        double holdTime = 0.;
+
+        // Linear domain constants
+        double openLevel;
+        double closeLevel;
+        double inverseThreshold;
+        double rangeGain;
+        int holdSamples = 0;
+
+        // State
+        bool open = false;
+        int holdCounter = 0;
+
+        void CalculateConstants();
+
+        template <bool infiniteRatio>
+        void Process(const double* control, double* gain, int nFrames);
+    };
+
+    /**
+     * @brief Noise gate, an expander with infinite ratio: when closed the signal is attenuated by the range.
+    */
+    class Gate : public Expander {
+    public:
+        /**
+         * @brief Creates a gate.
+         * @param threshold the opening threshold in dB.
+         * @param range the attenuation when closed in dB (negative).
+         * @param sampleRate the signal sample rate in samples/second.
+         * @param attackTime the opening time in seconds.
+         * @param releaseTime the closing time in seconds.
+        */
+        Gate(double threshold, double range, double sampleRate, double attackTime, double releaseTime);
+    };
+
+    /**
+     * @brief Multiband compressor.
+     * 
+     * Splits the input with Linkwitz-Riley crossovers, compresses each band with its own gain computer
+     * and peak detector and sums the bands back. Lower bands go through the all pass equivalent of
+     * every crossover above them so all bands stay phase coherent and, without compression, the
+     * output is an all pass version of the input.
+     * 
+     * Splitting, gain computing and summing run in a single loop over the block, there are no
+     * per band passes over the data and no allocations after Prepare.
+     * 
+     * Bands are numbered from the lowest frequency, a band has no compression until configured (ratio 1:1).
+    */
+    class MultibandCompressor {
+    public:
+        /**
+         * @brief Creates a multiband compressor.
+         * @param crossoverFrequencies the crossover frequencies in Hz in ascending order, there will be one band more than crossovers.
+         * @param sampleRate the signal sample rate in samples/second.
+        */
+        MultibandCompressor(const std::vector<double>& crossoverFrequencies, double sampleRate);
+
+        /**
+         * @brief Allocates the buffers and updates the sample rate. Not real time safe.
+         * @param sampleRate the signal sample rate in samples/second.
+         * @param maxBlockSize the chunk size, larger blocks are processed in chunks, 1024 by default.
+        */
+        void Prepare(double sampleRate, int maxBlockSize);
+
+        /**
+         * @brief Process a block of samples in place.
+         * @param buffer the input samples, overwritten with the output.
+         * @param nFrames the number of samples, blocks above the prepared size are processed in chunks.
+        */
+        void ProcessBlock(double* buffer, int nFrames);
+
+        /**
+         * @brief Process a block of samples in place.
+        */
+        void ProcessBlock(ChannelView<double> buffer) {
+            ProcessBlock(buffer.data(), buffer.size());
+        }
+
+        int GetNumBands() const { return (int)bands.size(); }
+
+        /**
+         * @brief Linear gain applied to a band on each sample of the last processed block (or chunk).
+        */
+        const double* GetBandGain(int band) const { return bandGain.data() + band * maxBlockSize; }
+
+        void SetThreshold(int band, double threshold);
+        void SetRatio(int band, double ratio);
+        void SetKneeWidth(int band, double kneeWidth);
+        void SetAttackTime(int band, double attackTime);
+        void SetReleaseTime(int band, double releaseTime);
+
+    private:
+        struct Band {
+            GainReductionComputer reductionComputer;
+            DecoupledPeakDetector grDetector;
+        };
+
+        std::vector<LinkwitzRileyCrossover> crossovers;
+        // Phase compensation, band b uses allPasses[compensationStart[b]] up to compensationStart[b + 1]
+        std::vector<AllPassFilter> allPasses;
+        std::vector<int> compensationStart;
+        std::vector<Band> bands;
+
+        static constexpr int defaultBlockSize = 1024;
+
+        std::vector<double> bandSamples;
+        std::vector<double> bandGain;
+        int maxBlockSize = 0;
+
+        void ProcessChunk(double* buffer, int nFrames);
     };
 
 }	// End namespace dsptk
@@ -1,5 +1,8 @@
 #include "filters.h"
 #include "constants.h"
+#include "simd.h"
+#include "tracing.h"
+#include <algorithm>
 #include <cmath>
 
 namespace dsptk {
@@ -10,6 +13,13 @@ namespace dsptk {
 	{
 	}
 
+	void Filter::ProcessBlock(const double* input, double* output, int nFrames)
+	{
+		for (int n = 0; n < nFrames; n++) {
+			output[n] = ProcessSample(input[n]);
+		}
+	}
+
 	void Filter::UpdateSamplerate(double samplerate)
 	{
 		if (samplerate == mSamplerate) return;
@@ -24,6 +34,18 @@ namespace dsptk {
 		CalculateConstants();
 	}
 
+	void FilterBank::ProcessBlock(const double* input, double* output, int nFrames)
+	{
+		if (output != input) {
+			std::copy(input, input + nFrames, output);
+		}
+		for (std::size_t i = 0; i < filters.size(); i++) {
+			DSPTK_PROFILE_STAGE(profiler, (int)i, nFrames);
+			DSPTK_TRACE_SCOPE("FilterBank filter", (std::int64_t)i);
+			filters[i]->ProcessBlock(output, output, nFrames);
+		}
+	}
+
 	BandFilter::BandFilter(double frequency, double bandwidth, double samplerate)
 		:Filter{ frequency, samplerate }
 		, mBandwidth{ bandwidth }
@@ -109,11 +131,7 @@ namespace dsptk {
 
 		if (input.size() < 2) return 0.;
 
-		double ms = 0.;
-
-		for (double value : input) {
-			ms += value * value;
-		}
+		const double ms = simd::GetKernels().sumOfSquares(input.data(), (int)input.size());
 		return ms / (double)(input.size() - 1);
 	}
 
@@ -421,4 +439,175 @@ namespace dsptk {
 		return gbFactor / std::tan(cutBoostFreq / 2.);
 	}
 
+	BiquadFilter::BiquadFilter(double frequency, double q, double samplerate)
+		: Filter{ frequency, samplerate }
+		, mQ{ q }
+	{
+	}
+
+	void BiquadFilter::ProcessBlock(const double* input, double* output, int nFrames)
+	{
+		if (nFrames <= 0) return;
+		double state[2] = { w1, w2 };
+		simd::GetKernels().biquad({ b0, b1, b2, a1, a2 }, state, input, output, nFrames);
+		w0 = state[0];
+		w1 = state[0];
+		w2 = state[1];
+	}
+
+	void BiquadFilter::UpdateQ(double q)
+	{
+		if (q == mQ) return;
+		mQ = q;
+		CalculateConstants();
+	}
+
+	ButterworthLowPass::ButterworthLowPass(double frequency, double samplerate, double q)
+		: BiquadFilter{ frequency, q, samplerate }
+	{
+		CalculateConstants();
+	}
+
+	void ButterworthLowPass::CalculateConstants()
+	{
+		const double w = DOUBLE_PI<double> * mFrequency / mSamplerate;
+		const double cosW = std::cos(w);
+		const double alpha = std::sin(w) / (2. * mQ);
+		const double a0 = 1. + alpha;
+
+		b0 = (1. - cosW) / 2. / a0;
+		b1 = (1. - cosW) / a0;
+		b2 = b0;
+		a1 = -2. * cosW / a0;
+		a2 = (1. - alpha) / a0;
+	}
+
+	ButterworthHiPass::ButterworthHiPass(double frequency, double samplerate, double q)
+		: BiquadFilter{ frequency, q, samplerate }
+	{
+		CalculateConstants();
+	}
+
+	void ButterworthHiPass::CalculateConstants()
+	{
+		const double w = DOUBLE_PI<double> * mFrequency / mSamplerate;
+		const double cosW = std::cos(w);
+		const double alpha = std::sin(w) / (2. * mQ);
+		const double a0 = 1. + alpha;
+
+		b0 = (1. + cosW) / 2. / a0;
+		b1 = -(1. + cosW) / a0;
+		b2 = b0;
+		a1 = -2. * cosW / a0;
+		a2 = (1. - alpha) / a0;
+	}
+
+	AllPassFilter::AllPassFilter(double frequency, double samplerate, double q)
+		: BiquadFilter{ frequency, q, samplerate }
+	{
+		CalculateConstants();
+	}
+
+	void AllPassFilter::CalculateConstants()
+	{
+		const double w = DOUBLE_PI<double> * mFrequency / mSamplerate;
+		const double cosW = std::cos(w);
+		const double alpha = std::sin(w) / (2. * mQ);
+		const double a0 = 1. + alpha;
+
+		b0 = (1. - alpha) / a0;
+		b1 = -2. * cosW / a0;
+		b2 = 1.;
+		a1 = b1;
+		a2 = b0;
+	}
+
+	LinkwitzRileyCrossover::LinkwitzRileyCrossover(double frequency, double samplerate)
+		: lowPass1{ frequency, samplerate }
+		, lowPass2{ frequency, samplerate }
+		, hiPass1{ frequency, samplerate }
+		, hiPass2{ frequency, samplerate }
+	{
+	}
+
+	void LinkwitzRileyCrossover::UpdateSamplerate(double samplerate)
+	{
+		lowPass1.UpdateSamplerate(samplerate);
+		lowPass2.UpdateSamplerate(samplerate);
+		hiPass1.UpdateSamplerate(samplerate);
+		hiPass2.UpdateSamplerate(samplerate);
+	}
+
+	void LinkwitzRileyCrossover::UpdateFrequency(double frequency)
+	{
+		lowPass1.UpdateFrequency(frequency);
+		lowPass2.UpdateFrequency(frequency);
+		hiPass1.UpdateFrequency(frequency);
+		hiPass2.UpdateFrequency(frequency);
+	}
+
+	/*
+	* K-weighting constants as given by ITU-R BS.1770 for 48kHz, refitted to shelf/hi pass
+	* parameters so they can be recalculated for any sample rate.
+	*/
+	namespace kweighting {
+		constexpr double shelfFrequency = 1681.974450955533;
+		constexpr double shelfGain = 3.999843853973347;
+		constexpr double shelfQ = 0.7071752369554196;
+		constexpr double hiPassFrequency = 38.13547087602444;
+		constexpr double hiPassQ = 0.5003270373238773;
+	}
+
+	KWeightingFilter::KWeightingFilter(double samplerate)
+		: Filter{ kweighting::shelfFrequency, samplerate }
+		, shelf{ samplerate }
+		, hiPass{ samplerate }
+	{
+	}
+
+	void KWeightingFilter::CalculateConstants()
+	{
+		shelf.UpdateSamplerate(mSamplerate);
+		hiPass.UpdateSamplerate(mSamplerate);
+	}
+
+	KWeightingFilter::Shelf::Shelf(double samplerate)
+		: BiquadFilter{ kweighting::shelfFrequency, kweighting::shelfQ, samplerate }
+	{
+		CalculateConstants();
+	}
+
+	void KWeightingFilter::Shelf::CalculateConstants()
+	{
+		const double K = std::tan(PI<double> * mFrequency / mSamplerate);
+		const double Vh = std::pow(10., kweighting::shelfGain / 20.);
+		const double Vb = std::pow(Vh, 0.4996667741545416);
+		const double a0 = 1. + K / mQ + K * K;
+
+		b0 = (Vh + Vb * K / mQ + K * K) / a0;
+		b1 = 2. * (K * K - Vh) / a0;
+		b2 = (Vh - Vb * K / mQ + K * K) / a0;
+		a1 = 2. * (K * K - 1.) / a0;
+		a2 = (1. - K / mQ + K * K) / a0;
+	}
+
+	KWeightingFilter::RlbHiPass::RlbHiPass(double samplerate)
+		: BiquadFilter{ kweighting::hiPassFrequency, kweighting::hiPassQ, samplerate }
+	{
+		CalculateConstants();
+	}
+
+	void KWeightingFilter::RlbHiPass::CalculateConstants()
+	{
+		const double K = std::tan(PI<double> * mFrequency / mSamplerate);
+		const double a0 = 1. + K / mQ + K * K;
+
+		// The standard keeps the numerator unnormalized
+		b0 = 1.;
+		b1 = -2.;
+		b2 = 1.;
+		a1 = 2. * (K * K - 1.) / a0;
+		a2 = (1. - K / mQ + K * K) / a0;
+	}
+
 }	// End namespace dsptk
\ No newline at end of file
@@ -2,7 +2,9 @@
 #include <vector>
 #include <cmath>
 #include <memory>
+#include "audiobuffer.h"
 #include "dsptypes.h"
+#include "profiling.h"
 
 namespace dsptk {
 
@@ -25,6 +27,14 @@ namespace dsptk {
 		*/
 		virtual double ProcessSample(double input) = 0;
 
+		/**
+		 * @brief Process a block of the signal, the same as ProcessSample on each sample.
+		 * @param input the input block.
+		 * @param output the output block, may be the same as input.
+		 * @param nFrames the number of samples in the block.
+		*/
+		virtual void ProcessBlock(const double* input, double* output, int nFrames);
+
 		/**
 		 * @brief Updates the sample rate of the signal to be filtered. 
 				  In case the new sample rate is different from the current one
@@ -60,6 +70,9 @@ namespace dsptk {
 		*/
 		void AddFilter(std::shared_ptr<Filter>& filter) {
 			filters.push_back(filter);
+#ifdef DSPTK_ENABLE_PROFILING
+			profiler.AddStage("filter");
+#endif
 		}
 
 		/**
@@ -68,8 +81,12 @@ namespace dsptk {
 		 * @param position the position of the filter to be removed.
 		*/
 		void RemoveFilterAt(int position) {
-			if (position >= 0 && position < filters.size())
+			if (position >= 0 && position < filters.size()) {
 				filters.erase(filters.begin() + position);
+#ifdef DSPTK_ENABLE_PROFILING
+				profiler.RemoveStage(position);
+#endif
+			}
 		}
 
 		/**
@@ -85,6 +102,24 @@ namespace dsptk {
 			return output;
 		}
 
+		/**
+		 * @brief Process a block of the signal through all the filters in the bank, one filter at a time.
+		 * @param input the input block.
+		 * @param output the output block, may be the same as input.
+		 * @param nFrames the number of samples in the block.
+		*/
+		void ProcessBlock(const double* input, double* output, int nFrames);
+
+		/**
+		 * @brief Process a block of the signal through all the filters in the bank.
+		 * @param input the input block.
+		 * @param output the output block, at least as long as input, may be the same as input.
+		*/
+		void ProcessBlock(ChannelView<const double> input, ChannelView<double> output) {
+			assert(output.size() >= input.size());
+			ProcessBlock(input.data(), output.data(), input.size());
+		}
+
 		/**
 		 * @brief Updates the sample rate of all the filters in the bank.
 		 * It just call UpdateSamplerate on each filter.
@@ -96,8 +131,19 @@ namespace dsptk {
 			}
 		}
 
+#ifdef DSPTK_ENABLE_PROFILING
+		/**
+		 * @brief Per filter load of ProcessBlock, stage i is the filter at position i.
+		*/
+		const profiling::Profiler& GetProfiler() const { return profiler; }
+		profiling::Profiler& GetProfiler() { return profiler; }
+#endif
+
 	private:
 		std::vector<std::shared_ptr<Filter>> filters;
+#ifdef DSPTK_ENABLE_PROFILING
+		profiling::Profiler profiler;
+#endif
 	};
 
 	/**
@@ -423,6 +469,204 @@ namespace dsptk {
 		inline void CalculateConstants() override;
 	};
 
+	/**
+	 * @brief Base class for second order (biquad) filters.
+	 * 
+	 * Implemented in direct form II, derived classes only calculate the constants.
+	 * 
+	 * @see <a href="https://www.w3.org/TR/audio-eq-cookbook/">
+		Robert Bristow-Johnson - Cookbook formulae for audio EQ biquad filter coefficients
+		</a>
+	*/
+	class BiquadFilter : public Filter
+	{
+	public:
+		/**
+		 * @brief Constructor of a biquad filter.
+		 * @param frequency the operating frequency in Hz.
+		 * @param q the quality factor.
+		 * @param samplerate the signal sample rate in samples/second.
+		*/
+		BiquadFilter(double frequency, double q, double samplerate);
+
+		/**
+		 * @copydoc Filter::ProcessSample()
+		*/
+		double ProcessSample(double input) override {
+			w0 = input - a1 * w1 - a2 * w2;
+			double output = b0 * w0 + b1 * w1 + b2 * w2;
+
+			// Update filter state
+			w2 = w1;
+			w1 = w0;
+
+			return output;
+		}
+
+		/**
+		 * @brief Process a block with the biquad kernel of the CPU (see simd.h).
+		*/
+		void ProcessBlock(const double* input, double* output, int nFrames) override;
+
+		/**
+		 * @brief Updates the quality factor.
+		 * @param q the quality factor.
+		*/
+		void UpdateQ(double q);
+
+	protected:
+		double mQ;
+
+		// Filter state
+		double w0 = .0;
+		double w1 = .0;
+		double w2 = .0;
+		// Filter constants: Should be calculated at construction time and on parameters update.
+		double b0 = 1., b1 = 0., b2 = 0., a1 = 0., a2 = 0.;
+	};
+
+	/**
+	 * @brief Second order Butterworth low pass filter.
+	*/
+	class ButterworthLowPass : public BiquadFilter
+	{
+	public:
+		/**
+		 * @brief Creates a second order low pass filter.
+		 * @param frequency the -3dB cutoff frequency.
+		 * @param samplerate the signal sample rate in samples/second.
+		 * @param q the quality factor, Butterworth response by default.
+		*/
+		ButterworthLowPass(double frequency, double samplerate, double q = BUTTERWORTH_Q);
+
+		static constexpr double BUTTERWORTH_Q = 0.70710678118654752440;
+
+	private:
+		void CalculateConstants() override;
+	};
+
+	/**
+	 * @brief Second order Butterworth hi pass filter.
+	*/
+	class ButterworthHiPass : public BiquadFilter
+	{
+	public:
+		/**
+		 * @brief Creates a second order hi pass filter.
+		 * @param frequency the -3dB cutoff frequency.
+		 * @param samplerate the signal sample rate in samples/second.
+		 * @param q the quality factor, Butterworth response by default.
+		*/
+		ButterworthHiPass(double frequency, double samplerate, double q = ButterworthLowPass::BUTTERWORTH_Q);
+
+	private:
+		void CalculateConstants() override;
+	};
+
+	/**
+	 * @brief Second order all pass filter.
+	*/
+	class AllPassFilter : public BiquadFilter
+	{
+	public:
+		/**
+		 * @brief Creates a second order all pass filter.
+		 * @param frequency the frequency where the phase shift is 180 degrees.
+		 * @param samplerate the signal sample rate in samples/second.
+		 * @param q the quality factor, Butterworth poles by default.
+		*/
+		AllPassFilter(double frequency, double samplerate, double q = ButterworthLowPass::BUTTERWORTH_Q);
+
+	private:
+		void CalculateConstants() override;
+	};
+
+	/**
+	 * @brief 4th order Linkwitz-Riley crossover.
+	 * 
+	 * Splits the signal into a low and a high band with two cascaded Butterworth sections each.
+	 * Both outputs are in phase and add up to an all pass response, the same as AllPassFilter
+	 * at the crossover frequency, so a multiband split can be phase compensated.
+	*/
+	class LinkwitzRileyCrossover
+	{
+	public:
+		/**
+		 * @brief Creates a crossover.
+		 * @param frequency the crossover frequency in Hz, both bands are 6dB down there.
+		 * @param samplerate the signal sample rate in samples/second.
+		*/
+		LinkwitzRileyCrossover(double frequency, double samplerate);
+
+		/**
+		 * @brief Splits a sample of the signal.
+		 * @param input the current sample.
+		 * @param low receives the low band output.
+		 * @param high receives the high band output.
+		*/
+		void ProcessSample(double input, double& low, double& high) {
+			low = lowPass2.ProcessSample(lowPass1.ProcessSample(input));
+			high = hiPass2.ProcessSample(hiPass1.ProcessSample(input));
+		}
+
+		void UpdateSamplerate(double samplerate);
+
+		void UpdateFrequency(double frequency);
+
+	private:
+		ButterworthLowPass lowPass1;
+		ButterworthLowPass lowPass2;
+		ButterworthHiPass hiPass1;
+		ButterworthHiPass hiPass2;
+	};
+
+	/**
+	 * @brief K-weighting filter for loudness measurement.
+	 * 
+	 * A high shelf modelling the acoustic effect of the head followed by the RLB hi pass,
+	 * both as biquads with the constants recalculated for the sample rate.
+	 * 
+	 * @see <a href="https://www.itu.int/rec/R-REC-BS.1770">
+		ITU-R BS.1770 - Algorithms to measure audio programme loudness and true-peak audio level
+		</a>
+	*/
+	class KWeightingFilter : public Filter
+	{
+	public:
+		/**
+		 * @brief Creates a K-weighting filter.
+		 * @param samplerate the signal sample rate in samples/second.
+		*/
+		explicit KWeightingFilter(double samplerate);
+
+		/**
+		 * @copydoc Filter::ProcessSample()
+		*/
+		double ProcessSample(double input) override {
+			return hiPass.ProcessSample(shelf.ProcessSample(input));
+		}
+
+	private:
+		class Shelf : public BiquadFilter {
+		public:
+			explicit Shelf(double samplerate);
+		private:
+			void CalculateConstants() override;
+		};
+
+		class RlbHiPass : public BiquadFilter {
+		public:
+			explicit RlbHiPass(double samplerate);
+		private:
+			void CalculateConstants() override;
+		};
+
+		Shelf shelf;
+		RlbHiPass hiPass;
+
+		void CalculateConstants() override;
+	};
+
 	double MeanSquare(const std::vector<double>& input);
 
 	double RootMeanSquare(const std::vector<double>& input);
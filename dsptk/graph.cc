@@ -0,0 +1,245 @@
+#include "graph.h"
+#include "tracing.h"
+#include <algorithm>
+#include <cassert>
+
+namespace dsptk {
+
+	void FilterNode::Process(BufferView<const double> inputs, BufferView<double> outputs) {
+		filter->ProcessBlock(inputs[0].data(), outputs[0].data(), inputs.GetNumFrames());
+	}
+
+	void FilterBankNode::Process(BufferView<const double> inputs, BufferView<double> outputs) {
+		bank.ProcessBlock(inputs[0], outputs[0]);
+	}
+
+	void CompressorNode::Prepare(int maxBlockSize) {
+		compressor.Prepare(maxBlockSize);
+	}
+
+	void CompressorNode::Process(BufferView<const double> inputs, BufferView<double> outputs) {
+		const double* sidechain = GetNumInputs() > 1 ? inputs[1].data() : nullptr;
+		compressor.ProcessBlock(inputs[0].data(), sidechain, outputs[0].data(), outputs[1].data(), inputs.GetNumFrames());
+	}
+
+	void ConvolverNode::Prepare(int maxBlockSize) {
+		convolver.Prepare(maxBlockSize);
+	}
+
+	void ConvolverNode::Process(BufferView<const double> inputs, BufferView<double> outputs) {
+		convolver.ProcessBlock(inputs[0].data(), outputs[0].data(), inputs.GetNumFrames());
+	}
+
+	void GainNode::Process(BufferView<const double> inputs, BufferView<double> outputs) {
+		for (int c = 0; c < inputs.GetNumChannels(); c++) {
+			const double* input = inputs[c].data();
+			double* output = outputs[c].data();
+			for (int i = 0; i < inputs.GetNumFrames(); i++) {
+				output[i] = gain * input[i];
+			}
+		}
+	}
+
+	// A node with its edges and buffers, queued on the pool when its last predecessor finishes
+	class ProcessingGraph::NodeTask final : public Task {
+	public:
+		NodeTask(ProcessingGraph& graph, std::unique_ptr<GraphNode> node)
+			: graph(graph), node(std::move(node)), sources(this->node->GetNumInputs()) {}
+
+		void Run(WorkStealingPool& pool, int worker) override {
+			graph.Execute(*this);
+			graph.Finish(*this, pool, worker);
+		}
+
+		ProcessingGraph& graph;
+		std::unique_ptr<GraphNode> node;
+		std::vector<std::vector<Source>> sources;	// Per input, in connection order
+		std::vector<int> successors;				// Distinct nodes reading an output
+		int numPredecessors = 0;					// Distinct nodes read
+		std::atomic<int> pending{ 0 };				// Predecessors still running in this chunk
+		AudioBuffer<double> outputs;
+		AudioBuffer<double> mix;					// Sums of the inputs with several sources
+		std::vector<const double*> inputs;
+	};
+
+	ProcessingGraph::ProcessingGraph(int numInputs, int numOutputs)
+		: numInputs(numInputs), numOutputs(numOutputs), outputSources(numOutputs) {
+		assert(numInputs >= 0 && numOutputs >= 0);
+	}
+
+	ProcessingGraph::~ProcessingGraph() = default;
+
+	int ProcessingGraph::AddNode(std::unique_ptr<GraphNode> node) {
+		assert(node);
+		nodes.push_back(std::make_unique<NodeTask>(*this, std::move(node)));
+		prepared = false;
+		return (int)nodes.size() - 1;
+	}
+
+	bool ProcessingGraph::Connect(int source, int output, int destination, int input) {
+		if (source < 0 || source >= GetNumNodes() || destination < 0 || destination >= GetNumNodes()) return false;
+		if (output < 0 || output >= nodes[source]->node->GetNumOutputs()) return false;
+		if (input < 0 || input >= nodes[destination]->node->GetNumInputs()) return false;
+		nodes[destination]->sources[input].push_back({ source, output });
+		prepared = false;
+		return true;
+	}
+
+	bool ProcessingGraph::ConnectInput(int graphInput, int destination, int input) {
+		if (graphInput < 0 || graphInput >= numInputs || destination < 0 || destination >= GetNumNodes()) return false;
+		if (input < 0 || input >= nodes[destination]->node->GetNumInputs()) return false;
+		nodes[destination]->sources[input].push_back({ -1, graphInput });
+		prepared = false;
+		return true;
+	}
+
+	bool ProcessingGraph::ConnectOutput(int source, int output, int graphOutput) {
+		if (source < 0 || source >= GetNumNodes() || graphOutput < 0 || graphOutput >= numOutputs) return false;
+		if (output < 0 || output >= nodes[source]->node->GetNumOutputs()) return false;
+		outputSources[graphOutput].push_back({ source, output });
+		prepared = false;
+		return true;
+	}
+
+	bool ProcessingGraph::Prepare(int maxBlockSize) {
+		assert(maxBlockSize > 0);
+		prepared = false;
+		this->maxBlockSize = maxBlockSize;
+
+		for (auto& task : nodes) {
+			task->successors.clear();
+		}
+		for (int n = 0; n < GetNumNodes(); n++) {
+			std::vector<int> predecessors;
+			for (const auto& input : nodes[n]->sources) {
+				for (const Source& source : input) {
+					if (source.node >= 0) predecessors.push_back(source.node);
+				}
+			}
+			std::sort(predecessors.begin(), predecessors.end());
+			predecessors.erase(std::unique(predecessors.begin(), predecessors.end()), predecessors.end());
+			nodes[n]->numPredecessors = (int)predecessors.size();
+			for (int predecessor : predecessors) {
+				nodes[predecessor]->successors.push_back(n);
+			}
+		}
+
+		// Kahn's algorithm, the serial order and the cycle check
+		order.clear();
+		roots.clear();
+		std::vector<int> pending(nodes.size());
+		for (int n = 0; n < GetNumNodes(); n++) {
+			pending[n] = nodes[n]->numPredecessors;
+			if (pending[n] == 0) {
+				order.push_back(n);
+				roots.push_back(nodes[n].get());
+			}
+		}
+		for (std::size_t i = 0; i < order.size(); i++) {
+			for (int successor : nodes[order[i]]->successors) {
+				if (--pending[successor] == 0) order.push_back(successor);
+			}
+		}
+		if (order.size() != nodes.size()) {
+			return false;
+		}
+
+		for (auto& task : nodes) {
+			const int nodeInputs = task->node->GetNumInputs();
+			task->outputs = AudioBuffer<double>(task->node->GetNumOutputs(), maxBlockSize);
+			task->mix = AudioBuffer<double>(nodeInputs, maxBlockSize);
+			task->inputs.assign(nodeInputs, nullptr);
+			task->node->Prepare(maxBlockSize);
+		}
+		silence.assign(maxBlockSize, 0.);
+		prepared = true;
+		return true;
+	}
+
+	bool ProcessingGraph::Process(BufferView<const double> input, BufferView<double> output, WorkStealingPool* pool) {
+		assert(input.GetNumChannels() == numInputs && output.GetNumChannels() == numOutputs);
+		assert(input.GetNumFrames() == output.GetNumFrames());
+		// The buffers of the nodes don't match the graph, or don't exist
+		if (!prepared) {
+			for (int c = 0; c < output.GetNumChannels(); c++) {
+				std::fill(output[c].data(), output[c].data() + output.GetNumFrames(), 0.);
+			}
+			return false;
+		}
+		for (int offset = 0; offset < output.GetNumFrames(); offset += maxBlockSize) {
+			const int nFrames = std::min(maxBlockSize, output.GetNumFrames() - offset);
+			ProcessChunk(input.SubBlock(offset, nFrames), output.SubBlock(offset, nFrames), pool);
+		}
+		return true;
+	}
+
+	void ProcessingGraph::ProcessChunk(BufferView<const double> input, BufferView<double> output, WorkStealingPool* pool) {
+		DSPTK_TRACE_SCOPE("ProcessingGraph chunk", (std::int64_t)input.GetNumFrames());
+		chunkInput = input;
+		chunkFrames = input.GetNumFrames();
+
+		if (pool == nullptr || pool->GetNumThreads() == 1) {
+			for (int n : order) {
+				Execute(*nodes[n]);
+			}
+		}
+		else {
+			for (auto& task : nodes) {
+				task->pending.store(task->numPredecessors, std::memory_order_relaxed);
+			}
+			remaining.store(GetNumNodes(), std::memory_order_relaxed);
+			pool->Run(roots.data(), (int)roots.size(), remaining);
+		}
+
+		for (int c = 0; c < numOutputs; c++) {
+			double* channel = output[c].data();
+			std::fill(channel, channel + chunkFrames, 0.);
+			for (const Source& source : outputSources[c]) {
+				const double* data = GetSourceData(source);
+				for (int i = 0; i < chunkFrames; i++) {
+					channel[i] += data[i];
+				}
+			}
+		}
+	}
+
+	const double* ProcessingGraph::GetSourceData(const Source& source) const {
+		return source.node < 0 ? chunkInput[source.port].data() : nodes[source.node]->outputs[source.port].data();
+	}
+
+	void ProcessingGraph::Execute(NodeTask& task) {
+		for (int i = 0; i < (int)task.sources.size(); i++) {
+			const auto& sources = task.sources[i];
+			if (sources.empty()) {
+				task.inputs[i] = silence.data();
+			}
+			else if (sources.size() == 1) {
+				task.inputs[i] = GetSourceData(sources[0]);
+			}
+			else {
+				double* sum = task.mix[i].data();
+				const double* first = GetSourceData(sources[0]);
+				std::copy(first, first + chunkFrames, sum);
+				for (std::size_t s = 1; s < sources.size(); s++) {
+					const double* data = GetSourceData(sources[s]);
+					for (int f = 0; f < chunkFrames; f++) {
+						sum[f] += data[f];
+					}
+				}
+				task.inputs[i] = sum;
+			}
+		}
+		task.node->Process(BufferView<const double>(task.inputs.data(), (int)task.inputs.size(), chunkFrames), task.outputs.SubBlock(0, chunkFrames));
+	}
+
+	void ProcessingGraph::Finish(NodeTask& task, WorkStealingPool& pool, int worker) {
+		// The release half hands the outputs to the successor, the acquire half takes those of the other predecessors
+		for (int successor : task.successors) {
+			if (nodes[successor]->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+				pool.Push(worker, nodes[successor].get());
+			}
+		}
+		remaining.fetch_sub(1, std::memory_order_release);
+	}
+
+}
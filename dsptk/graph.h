@@ -0,0 +1,204 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "audiobuffer.h"
+#include "convolution.h"
+#include "dynamics.h"
+#include "filters.h"
+#include "threadpool.h"
+
+namespace dsptk {
+
+	/**
+	 * @brief A processor of a ProcessingGraph, with a fixed number of mono inputs and outputs.
+	*/
+	class GraphNode {
+	public:
+		GraphNode(int numInputs, int numOutputs) : numInputs(numInputs), numOutputs(numOutputs) {}
+		virtual ~GraphNode() = default;
+
+		int GetNumInputs() const { return numInputs; }
+		int GetNumOutputs() const { return numOutputs; }
+
+		/**
+		 * @brief Called by ProcessingGraph::Prepare, blocks are never longer than maxBlockSize afterwards.
+		*/
+		virtual void Prepare(int /*maxBlockSize*/) {}
+
+		/**
+		 * @brief Processes a block.
+		 * @param inputs GetNumInputs() channels, silence for the unconnected ones.
+		 * @param outputs GetNumOutputs() channels of the same length to fill.
+		*/
+		virtual void Process(BufferView<const double> inputs, BufferView<double> outputs) = 0;
+
+	private:
+		const int numInputs;
+		const int numOutputs;
+	};
+
+	/**
+	 * @brief A Filter, one input, one output.
+	*/
+	class FilterNode final : public GraphNode {
+	public:
+		explicit FilterNode(std::shared_ptr<Filter> filter) : GraphNode(1, 1), filter(std::move(filter)) {}
+
+		void Process(BufferView<const double> inputs, BufferView<double> outputs) override;
+
+	private:
+		std::shared_ptr<Filter> filter;
+	};
+
+	/**
+	 * @brief A FilterBank, one input, one output.
+	*/
+	class FilterBankNode final : public GraphNode {
+	public:
+		explicit FilterBankNode(FilterBank bank) : GraphNode(1, 1), bank(std::move(bank)) {}
+
+		void Process(BufferView<const double> inputs, BufferView<double> outputs) override;
+
+	private:
+		FilterBank bank;
+	};
+
+	/**
+	 * @brief A Compressor: input 0 is compressed, from input 1 when it has a sidechain; output 0 is the compressed
+	 * signal and output 1 the gain.
+	*/
+	class CompressorNode final : public GraphNode {
+	public:
+		explicit CompressorNode(Compressor compressor, bool sidechain = false)
+			: GraphNode(sidechain ? 2 : 1, 2), compressor(std::move(compressor)) {}
+
+		void Prepare(int maxBlockSize) override;
+		void Process(BufferView<const double> inputs, BufferView<double> outputs) override;
+
+	private:
+		Compressor compressor;
+	};
+
+	/**
+	 * @brief A BlockConvolver partitioned for the chunks of the graph, one input, one output.
+	*/
+	class ConvolverNode final : public GraphNode {
+	public:
+		explicit ConvolverNode(std::vector<double> impulseResponse) : GraphNode(1, 1), convolver(std::move(impulseResponse)) {}
+
+		void Prepare(int maxBlockSize) override;
+		void Process(BufferView<const double> inputs, BufferView<double> outputs) override;
+
+	private:
+		BlockConvolver convolver;
+	};
+
+	/**
+	 * @brief Multiplies each of numChannels inputs by a gain; with the summing of the inputs it makes a mixer.
+	*/
+	class GainNode final : public GraphNode {
+	public:
+		GainNode(int numChannels, double gain) : GraphNode(numChannels, numChannels), gain(gain) {}
+
+		void SetGain(double gain) { this->gain = gain; }
+
+		void Process(BufferView<const double> inputs, BufferView<double> outputs) override;
+
+	private:
+		double gain;
+	};
+
+	/**
+	 * @brief Directed acyclic graph of GraphNodes processing blocks, serially or on a WorkStealingPool.
+	 *
+	 * Edges go from a node output (or a graph input) to a node input (or a graph output); an input takes any
+	 * number of edges and gets their sum, in the order they were connected, so the output is the same bit
+	 * for bit whatever the schedule and the number of threads. Each node owns the buffers of its outputs,
+	 * and a node takes the output buffer of its single source directly.
+	 *
+	 * On a pool each block starts the nodes without predecessors, and the last predecessor finishing a node
+	 * queues it on its own worker, so independent channels and branches run concurrently while chains stay
+	 * on a core. Process doesn't allocate or lock (unless a node does), Prepare does.
+	*/
+	class ProcessingGraph final {
+	public:
+		ProcessingGraph(int numInputs, int numOutputs);
+		~ProcessingGraph();
+
+		ProcessingGraph(const ProcessingGraph&) = delete;
+		ProcessingGraph& operator=(const ProcessingGraph&) = delete;
+
+		int GetNumInputs() const { return numInputs; }
+		int GetNumOutputs() const { return numOutputs; }
+		int GetNumNodes() const { return (int)nodes.size(); }
+
+		/**
+		 * @brief Adds a node, Prepare must be called again before processing.
+		 * @return the id of the node.
+		*/
+		int AddNode(std::unique_ptr<GraphNode> node);
+
+		/**
+		 * @brief Adds an edge from an output of the source node to an input of the destination node.
+		 * @return false if a node or a port doesn't exist.
+		*/
+		bool Connect(int source, int output, int destination, int input);
+
+		/**
+		 * @brief Adds an edge from an input of the graph to an input of a node.
+		*/
+		bool ConnectInput(int graphInput, int destination, int input);
+
+		/**
+		 * @brief Adds an edge from an output of a node to an output of the graph.
+		*/
+		bool ConnectOutput(int source, int output, int graphOutput);
+
+		/**
+		 * @brief Orders the nodes, allocates the buffers and prepares the nodes.
+		 * @return false if the edges make a cycle, the graph can't process then.
+		*/
+		bool Prepare(int maxBlockSize);
+
+		/**
+		 * @brief Processes a block of any length, in chunks of at most the prepared size.
+		 * @param input GetNumInputs() channels.
+		 * @param output GetNumOutputs() channels as long as input, may not alias it.
+		 * @param pool workers to run the nodes on, nullptr to run them in order on this thread.
+		 * @return false, with a silent output, if the graph isn't prepared: never prepared, Prepare failed or
+		 * nodes and edges changed since.
+		*/
+		bool Process(BufferView<const double> input, BufferView<double> output, WorkStealingPool* pool = nullptr);
+
+	private:
+		struct Source {
+			int node;	// -1 for a graph input
+			int port;
+		};
+
+		class NodeTask;
+
+		void ProcessChunk(BufferView<const double> input, BufferView<double> output, WorkStealingPool* pool);
+		void Execute(NodeTask& task);
+		const double* GetSourceData(const Source& source) const;
+		void Finish(NodeTask& task, WorkStealingPool& pool, int worker);
+
+		const int numInputs;
+		const int numOutputs;
+		std::vector<std::unique_ptr<NodeTask>> nodes;
+		std::vector<std::vector<Source>> outputSources;
+		std::vector<int> order;
+		std::vector<Task*> roots;
+		std::vector<double> silence;
+		int maxBlockSize = 0;
+		bool prepared = false;
+
+		// State of the chunk being processed, written before the tasks are queued
+		BufferView<const double> chunkInput;
+		int chunkFrames = 0;
+		std::atomic<int> remaining{ 0 };
+	};
+
+}
@@ -0,0 +1,256 @@
+#include "metering.h"
+#include "constants.h"
+#include "dsptypes.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+namespace dsptk {
+
+	LoudnessMeter::LoudnessMeter(int numChannels, double samplerate)
+		: samplerate{ samplerate }
+		, filters(numChannels, KWeightingFilter{ samplerate })
+		, weights(numChannels, 1.)
+		, stepSize{ std::max(1, (int)std::round(samplerate * .1)) }
+		, histogramCount(histogramBins, 0)
+		, histogramEnergy(histogramBins, 0.)
+	{
+	}
+
+	void LoudnessMeter::SetChannelWeight(int channel, double weight)
+	{
+		if (channel >= 0 && channel < weights.size())
+			weights[channel] = weight;
+	}
+
+	void LoudnessMeter::ProcessBlock(BufferView<const double> input)
+	{
+		const int numChannels = (int)filters.size();
+		const int nFrames = input.GetNumFrames();
+		assert(input.GetNumChannels() >= numChannels);
+
+		int start = 0;
+		while (start < nFrames) {
+			// Process up to the end of the current 100ms step
+			const int segment = std::min(nFrames - start, stepSize - stepPosition);
+
+			for (int c = 0; c < numChannels; c++) {
+				KWeightingFilter& filter = filters[c];
+				const double* x = input.GetChannel(c).data() + start;
+				double sum = 0.;
+				for (int s = 0; s < segment; s++) {
+					const double y = filter.ProcessSample(x[s]);
+					sum += y * y;
+				}
+				stepEnergy += weights[c] * sum;
+			}
+
+			stepPosition += segment;
+			start += segment;
+
+			if (stepPosition == stepSize) {
+				CloseStep();
+			}
+		}
+	}
+
+	void LoudnessMeter::CloseStep()
+	{
+		const double energy = stepEnergy / stepSize;
+		stepEnergy = 0.;
+		stepPosition = 0;
+
+		// Running window sums: add the new step, drop the one leaving each window
+		stepIndex = (stepIndex + 1) % shortTermSteps;
+		const double leavingMomentary = steps[(stepIndex + shortTermSteps - momentarySteps) % shortTermSteps];
+		shortTermSum += energy - steps[stepIndex];
+		momentarySum += energy - leavingMomentary;
+		steps[stepIndex] = energy;
+
+		if (stepIndex == 0) {
+			// Recalculate once per short-term window to get rid of accumulated rounding errors
+			shortTermSum = 0.;
+			for (double step : steps) {
+				shortTermSum += step;
+			}
+			momentarySum = 0.;
+			for (int i = 0; i < momentarySteps; i++) {
+				momentarySum += steps[(shortTermSteps - i) % shortTermSteps];
+			}
+		}
+
+		// Gating blocks are 400ms long with 75% overlap, one each step once the first is complete
+		if (++stepCount >= momentarySteps) {
+			AddGatingBlock(std::max(momentarySum, 0.) / momentarySteps);
+		}
+	}
+
+	void LoudnessMeter::AddGatingBlock(double energy)
+	{
+		const double loudness = ToLoudness(energy);
+		if (!(loudness > absoluteGate)) return;
+
+		const int bin = std::min(histogramBins - 1, (int)((loudness - absoluteGate) * binsPerLU));
+		histogramCount[bin]++;
+		histogramEnergy[bin] += energy;
+	}
+
+	double LoudnessMeter::GetMomentaryLoudness() const
+	{
+		return ToLoudness(std::max(momentarySum, 0.) / momentarySteps);
+	}
+
+	double LoudnessMeter::GetShortTermLoudness() const
+	{
+		return ToLoudness(std::max(shortTermSum, 0.) / shortTermSteps);
+	}
+
+	double LoudnessMeter::GetIntegratedLoudness() const
+	{
+		// Absolute gate: every block in the histogram is above it
+		std::uint64_t count = 0;
+		double energy = 0.;
+		for (int bin = 0; bin < histogramBins; bin++) {
+			count += histogramCount[bin];
+			energy += histogramEnergy[bin];
+		}
+		if (count == 0) return -std::numeric_limits<double>::infinity();
+
+		// Relative gate
+		const double threshold = ToLoudness(energy / count) + relativeGate;
+		const int firstBin = std::max(0, (int)((threshold - absoluteGate) * binsPerLU));
+
+		count = 0;
+		energy = 0.;
+		for (int bin = firstBin; bin < histogramBins; bin++) {
+			count += histogramCount[bin];
+			energy += histogramEnergy[bin];
+		}
+		if (count == 0) return -std::numeric_limits<double>::infinity();
+
+		return ToLoudness(energy / count);
+	}
+
+	void LoudnessMeter::Reset()
+	{
+		for (auto& filter : filters) {
+			filter = KWeightingFilter{ samplerate };
+		}
+		stepPosition = 0;
+		stepEnergy = 0.;
+		steps.fill(0.);
+		stepIndex = 0;
+		stepCount = 0;
+		momentarySum = 0.;
+		shortTermSum = 0.;
+		std::fill(histogramCount.begin(), histogramCount.end(), 0);
+		std::fill(histogramEnergy.begin(), histogramEnergy.end(), 0.);
+	}
+
+	double LoudnessMeter::ToLoudness(double energy)
+	{
+		return -0.691 + 10. * std::log10(energy);
+	}
+
+
+	TruePeakMeter::TruePeakMeter(int numChannels, int maxBlockSize)
+		: maxBlockSize{ std::max(1, maxBlockSize) }
+		, work(numChannels, std::vector<double>(historySize + std::max(1, maxBlockSize), 0.))
+		, interpolated(std::max(1, maxBlockSize), 0.)
+		, blockPeaks(numChannels, 0.)
+		, maxPeaks(numChannels, 0.)
+	{
+	}
+
+	/*
+	* Hann windowed sinc cut at the original Nyquist frequency, split into phases.
+	* Taps are stored reversed so phase p of output m is the dot product with input m - 11 ... m.
+	*/
+	const TruePeakMeter::PhaseTable& TruePeakMeter::GetPhaseTable()
+	{
+		static const PhaseTable table = [] {
+			PhaseTable phases{};
+			const int length = oversampling * tapsPerPhase;
+			const double center = (length - 1) / 2.;
+
+			for (int p = 0; p < oversampling; p++) {
+				double sum = 0.;
+				for (int k = 0; k < tapsPerPhase; k++) {
+					const int n = p + k * oversampling;
+					const double t = (n - center) / oversampling;
+					const double sinc = t == 0. ? 1. : std::sin(PI<double> * t) / (PI<double> * t);
+					const double window = .5 - .5 * std::cos(DOUBLE_PI<double> * (n + .5) / length);
+					phases[p][tapsPerPhase - 1 - k] = sinc * window;
+					sum += sinc * window;
+				}
+				// Unity gain at DC for every phase
+				for (double& tap : phases[p]) {
+					tap /= sum;
+				}
+			}
+			return phases;
+		}();
+		return table;
+	}
+
+	void TruePeakMeter::ProcessBlock(BufferView<const double> input)
+	{
+		const int nFrames = input.GetNumFrames();
+		assert(input.GetNumChannels() >= (int)work.size());
+		for (int c = 0; c < work.size(); c++) {
+			const double* channel = input.GetChannel(c).data();
+			double peak = 0.;
+			for (int start = 0; start < nFrames; start += maxBlockSize) {
+				peak = std::max(peak, ProcessChannel(work[c], channel + start, std::min(maxBlockSize, nFrames - start)));
+			}
+			blockPeaks[c] = peak;
+			maxPeaks[c] = std::max(maxPeaks[c], peak);
+		}
+	}
+
+	double TruePeakMeter::ProcessChannel(std::vector<double>& channelWork, const double* input, int nFrames)
+	{
+		const PhaseTable& phases = GetPhaseTable();
+		double* x = channelWork.data();
+		double* y = interpolated.data();
+
+		std::copy(input, input + nFrames, x + historySize);
+
+		double peak = 0.;
+		for (const auto& taps : phases) {
+			// Tap outer, sample inner: independent multiply-adds across the block
+			std::fill(y, y + nFrames, 0.);
+			for (int k = 0; k < tapsPerPhase; k++) {
+				const double tap = taps[k];
+				const double* xk = x + k;
+				for (int m = 0; m < nFrames; m++) {
+					y[m] += tap * xk[m];
+				}
+			}
+			for (int m = 0; m < nFrames; m++) {
+				peak = std::max(peak, std::abs(y[m]));
+			}
+		}
+
+		// Keep the last samples as history for the next block
+		std::copy(x + nFrames, x + nFrames + historySize, x);
+
+		return peak;
+	}
+
+	double TruePeakMeter::GetMaxPeakDB(int channel) const
+	{
+		return DB::fromLinearGain(maxPeaks[channel]).asDB();
+	}
+
+	void TruePeakMeter::Reset()
+	{
+		for (auto& channelWork : work) {
+			std::fill(channelWork.begin(), channelWork.end(), 0.);
+		}
+		std::fill(blockPeaks.begin(), blockPeaks.end(), 0.);
+		std::fill(maxPeaks.begin(), maxPeaks.end(), 0.);
+	}
+
+}	// End namespace dsptk
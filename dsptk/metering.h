@@ -0,0 +1,186 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "audiobuffer.h"
+#include "filters.h"
+
+namespace dsptk {
+
+	/**
+	 * @brief Streaming loudness meter.
+	 * 
+	 * Measures momentary (400ms), short-term (3s) and gated integrated loudness in LUFS.
+	 * K-weighted energy is accumulated in 100ms steps, the momentary and short-term windows
+	 * are running sums over the last 4 and 30 steps.
+	 * 
+	 * Integrated loudness keeps a histogram of the gating blocks (0.1 LU bins from -70 LUFS up)
+	 * holding the count and energy of the blocks in each bin, so memory doesn't grow with the
+	 * programme length. The relative gate is resolved to the bin holding the threshold.
+	 * 
+	 * @see <a href="https://www.itu.int/rec/R-REC-BS.1770">
+		ITU-R BS.1770 - Algorithms to measure audio programme loudness and true-peak audio level
+		</a>
+	 * @see <a href="https://tech.ebu.ch/publications/r128">EBU R 128 - Loudness normalisation and permitted maximum level of audio signals</a>
+	*/
+	class LoudnessMeter {
+	public:
+		/**
+		 * @brief Creates a loudness meter.
+		 * @param numChannels the number of channels, all weighted 1.0.
+		 * @param samplerate the signal sample rate in samples/second.
+		*/
+		LoudnessMeter(int numChannels, double samplerate);
+
+		/**
+		 * @brief Sets the weight of a channel in the sum.
+		 * BS.1770 uses 1.0 for left, right and center, 1.41 for the surround channels, LFE is excluded with 0.
+		 * @param channel the channel index.
+		 * @param weight the power weight.
+		*/
+		void SetChannelWeight(int channel, double weight);
+
+		/**
+		 * @brief Meters a block of audio.
+		 * @param input one pointer per channel to nFrames samples each.
+		 * @param nFrames the number of samples per channel.
+		*/
+		void ProcessBlock(const double* const* input, int nFrames) {
+			ProcessBlock(BufferView<const double>(input, (int)filters.size(), nFrames));
+		}
+
+		/**
+		 * @brief Meters a block of audio, at least one channel per metered channel.
+		*/
+		void ProcessBlock(BufferView<const double> input);
+
+		/**
+		 * @brief Loudness over the last 400ms in LUFS.
+		*/
+		double GetMomentaryLoudness() const;
+
+		/**
+		 * @brief Loudness over the last 3s in LUFS.
+		*/
+		double GetShortTermLoudness() const;
+
+		/**
+		 * @brief Gated loudness since the start or the last Reset in LUFS, -infinity when all blocks are gated.
+		*/
+		double GetIntegratedLoudness() const;
+
+		/**
+		 * @brief Clears all the measurements and the filters state.
+		*/
+		void Reset();
+
+	private:
+		static constexpr int momentarySteps = 4;
+		static constexpr int shortTermSteps = 30;
+		static constexpr double absoluteGate = -70.;
+		static constexpr double relativeGate = -10.;
+		static constexpr double binsPerLU = 10.;
+		static constexpr int histogramBins = 800;		// -70 to +10 LUFS
+
+		double samplerate;
+		std::vector<KWeightingFilter> filters;
+		std::vector<double> weights;
+
+		// Current 100ms step
+		int stepSize;
+		int stepPosition = 0;
+		double stepEnergy = 0.;
+
+		// Mean square of the last steps, newest at stepIndex
+		std::array<double, shortTermSteps> steps{};
+		int stepIndex = 0;
+		int stepCount = 0;
+		double momentarySum = 0.;
+		double shortTermSum = 0.;
+
+		// Gating blocks histogram
+		std::vector<std::uint64_t> histogramCount;
+		std::vector<double> histogramEnergy;
+
+		void CloseStep();
+		void AddGatingBlock(double energy);
+
+		static double ToLoudness(double energy);
+	};
+
+	/**
+	 * @brief True-peak meter.
+	 * 
+	 * Upsamples each channel 4 times with a 48 taps polyphase FIR and reports the largest
+	 * absolute value per block, catching the inter-sample peaks a sample peak meter misses.
+	 * The phase tables are computed once and shared by all meters, each phase is evaluated as
+	 * multiply-adds over the whole block so the compiler can vectorize it.
+	 * 
+	 * @see <a href="https://www.itu.int/rec/R-REC-BS.1770">
+		ITU-R BS.1770 Annex 2 - Guidelines for accurate measurement of true-peak level
+		</a>
+	*/
+	class TruePeakMeter {
+	public:
+		static constexpr int oversampling = 4;
+		static constexpr int tapsPerPhase = 12;
+
+		/**
+		 * @brief Creates a true-peak meter.
+		 * @param numChannels the number of channels.
+		 * @param maxBlockSize the largest block ProcessBlock is called with, larger blocks are processed in chunks.
+		*/
+		TruePeakMeter(int numChannels, int maxBlockSize);
+
+		/**
+		 * @brief Meters a block of audio.
+		 * @param input one pointer per channel to nFrames samples each.
+		 * @param nFrames the number of samples per channel.
+		*/
+		void ProcessBlock(const double* const* input, int nFrames) {
+			ProcessBlock(BufferView<const double>(input, (int)work.size(), nFrames));
+		}
+
+		/**
+		 * @brief Meters a block of audio, at least one channel per metered channel.
+		*/
+		void ProcessBlock(BufferView<const double> input);
+
+		/**
+		 * @brief Linear true-peak of a channel in the last processed block.
+		*/
+		double GetBlockPeak(int channel) const { return blockPeaks[channel]; }
+
+		/**
+		 * @brief Linear true-peak of a channel since the start or the last Reset.
+		*/
+		double GetMaxPeak(int channel) const { return maxPeaks[channel]; }
+
+		/**
+		 * @brief True-peak of a channel since the start or the last Reset in dBTP.
+		*/
+		double GetMaxPeakDB(int channel) const;
+
+		/**
+		 * @brief Clears the peaks and the interpolator history.
+		*/
+		void Reset();
+
+	private:
+		using PhaseTable = std::array<std::array<double, tapsPerPhase>, oversampling>;
+		static const PhaseTable& GetPhaseTable();
+
+		static constexpr int historySize = tapsPerPhase - 1;
+
+		int maxBlockSize;
+		// Per channel: the last input samples followed by room for a block
+		std::vector<std::vector<double>> work;
+		std::vector<double> interpolated;
+		std::vector<double> blockPeaks;
+		std::vector<double> maxPeaks;
+
+		double ProcessChannel(std::vector<double>& channelWork, const double* input, int nFrames);
+	};
+
+}	// End namespace dsptk
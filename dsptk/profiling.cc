@@ -0,0 +1,109 @@
+#include "profiling.h"
+#include <chrono>
+#include <thread>
+
+namespace dsptk {
+	namespace profiling {
+
+		double CyclesPerSecond() {
+			static const double rate = [] {
+#ifdef DSPTK_HAS_RDTSC
+				using Clock = std::chrono::steady_clock;
+				const auto timeStart = Clock::now();
+				const std::uint64_t cyclesStart = ReadCycles();
+				std::this_thread::sleep_for(std::chrono::milliseconds(20));
+				const std::uint64_t cyclesEnd = ReadCycles();
+				const double seconds = std::chrono::duration<double>(Clock::now() - timeStart).count();
+				return (double)(cyclesEnd - cyclesStart) / seconds;
+#else
+				return 1e9;
+#endif
+			}();
+			return rate;
+		}
+
+		Profiler::Profiler(const std::vector<std::string>& stageNames)
+			: names(stageNames)
+			, stages(new Counters[stageNames.size()]) {}
+
+		Profiler::Profiler(const Profiler& other)
+			: names(other.names)
+			, stages(new Counters[other.names.size()]) {}
+
+		Profiler& Profiler::operator=(const Profiler& other) {
+			if (this != &other) {
+				names = other.names;
+				stages.reset(new Counters[names.size()]);
+			}
+			return *this;
+		}
+
+		int Profiler::AddStage(const std::string& name) {
+			std::unique_ptr<Counters[]> newStages(new Counters[names.size() + 1]);
+			for (std::size_t i = 0; i < names.size(); i++) {
+				newStages[i].cycles = stages[i].cycles.load();
+				newStages[i].maxCycles = stages[i].maxCycles.load();
+				newStages[i].samples = stages[i].samples.load();
+				newStages[i].calls = stages[i].calls.load();
+			}
+			names.push_back(name);
+			stages = std::move(newStages);
+			return (int)names.size() - 1;
+		}
+
+		void Profiler::RemoveStage(int stage) {
+			if (stage < 0 || stage >= (int)names.size())
+				return;
+			std::unique_ptr<Counters[]> newStages(new Counters[names.size() - 1]);
+			for (std::size_t i = 0, j = 0; i < names.size(); i++) {
+				if ((int)i == stage)
+					continue;
+				newStages[j].cycles = stages[i].cycles.load();
+				newStages[j].maxCycles = stages[i].maxCycles.load();
+				newStages[j].samples = stages[i].samples.load();
+				newStages[j].calls = stages[i].calls.load();
+				j++;
+			}
+			names.erase(names.begin() + stage);
+			stages = std::move(newStages);
+		}
+
+		std::vector<StageStats> Profiler::Snapshot() const {
+			std::vector<StageStats> snapshot(names.size());
+			for (std::size_t i = 0; i < names.size(); i++) {
+				snapshot[i].name = names[i];
+			}
+
+			// Sequence lock read: copy, then retry if a record started or was running meanwhile
+			while (true) {
+				const std::uint32_t sequenceStart = sequence.load(std::memory_order_acquire);
+				if (sequenceStart & 1) {
+					std::this_thread::yield();
+					continue;
+				}
+				for (std::size_t i = 0; i < names.size(); i++) {
+					snapshot[i].cycles = stages[i].cycles.load(std::memory_order_relaxed);
+					snapshot[i].maxCycles = stages[i].maxCycles.load(std::memory_order_relaxed);
+					snapshot[i].samples = stages[i].samples.load(std::memory_order_relaxed);
+					snapshot[i].calls = stages[i].calls.load(std::memory_order_relaxed);
+				}
+				std::atomic_thread_fence(std::memory_order_acquire);
+				if (sequence.load(std::memory_order_relaxed) == sequenceStart)
+					return snapshot;
+			}
+		}
+
+		void Profiler::Reset() {
+			const std::uint32_t sequenceStart = sequence.load(std::memory_order_relaxed);
+			sequence.store(sequenceStart + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			for (std::size_t i = 0; i < names.size(); i++) {
+				stages[i].cycles.store(0, std::memory_order_relaxed);
+				stages[i].maxCycles.store(0, std::memory_order_relaxed);
+				stages[i].samples.store(0, std::memory_order_relaxed);
+				stages[i].calls.store(0, std::memory_order_relaxed);
+			}
+			sequence.store(sequenceStart + 2, std::memory_order_release);
+		}
+	}
+}
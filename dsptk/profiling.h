@@ -0,0 +1,162 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define DSPTK_HAS_RDTSC 1
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define DSPTK_HAS_RDTSC 1
+#else
+#include <chrono>
+#endif
+
+/*
+* Processors instrument their stages with DSPTK_PROFILE_STAGE. Unless the library is built with
+* DSPTK_ENABLE_PROFILING (CMake option of the same name) the macro expands to nothing and the processors
+* have no profiler member, so the instrumentation costs nothing.
+*/
+#ifdef DSPTK_ENABLE_PROFILING
+#define DSPTK_PROFILE_CONCAT_IMPL(a, b) a##b
+#define DSPTK_PROFILE_CONCAT(a, b) DSPTK_PROFILE_CONCAT_IMPL(a, b)
+#define DSPTK_PROFILE_STAGE(profiler, stage, samples) \
+	::dsptk::profiling::ScopedStage DSPTK_PROFILE_CONCAT(dsptkProfileStage, __LINE__)(profiler, stage, samples)
+#else
+#define DSPTK_PROFILE_STAGE(profiler, stage, samples) ((void)0)
+#endif
+
+namespace dsptk {
+	namespace profiling {
+
+		/**
+		 * @brief Current value of the cycle counter, the TSC on x86 and nanoseconds of steady_clock elsewhere.
+		*/
+		inline std::uint64_t ReadCycles() {
+#ifdef DSPTK_HAS_RDTSC
+			return __rdtsc();
+#else
+			return (std::uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+		}
+
+		/**
+		 * @brief Rate of ReadCycles in counts per second, measured against steady_clock on first use.
+		*/
+		double CyclesPerSecond();
+
+		/**
+		 * @brief Accumulated counters of a stage.
+		*/
+		struct StageStats {
+			std::string name;
+			/** Cycles spent in the stage. */
+			std::uint64_t cycles = 0;
+			/** Longest single call. */
+			std::uint64_t maxCycles = 0;
+			/** Samples processed. */
+			std::uint64_t samples = 0;
+			/** Number of calls. */
+			std::uint64_t calls = 0;
+		};
+
+		/**
+		 * @brief Per stage counters of a processor.
+		 *
+		 * Record is called by the processing thread only and never blocks. Snapshot can be polled from any
+		 * other thread: the counters are guarded by a sequence lock, the reader retries while a record is
+		 * in progress and always gets the counters of all stages at the same instant.
+		 * Stages are configured (AddStage, RemoveStage) while nobody is polling, copies start from zero.
+		*/
+		class Profiler {
+		public:
+			Profiler() = default;
+			explicit Profiler(const std::vector<std::string>& stageNames);
+
+			Profiler(const Profiler& other);
+			Profiler& operator=(const Profiler& other);
+
+			/**
+			 * @brief Adds a stage, returns its index.
+			*/
+			int AddStage(const std::string& name);
+
+			/**
+			 * @brief Removes a stage, the following ones move down.
+			*/
+			void RemoveStage(int stage);
+
+			int GetNumStages() const { return (int)names.size(); }
+
+			/**
+			 * @brief Adds a call of a stage, processing thread only.
+			*/
+			void Record(int stage, std::uint64_t cycles, std::uint64_t samples) {
+				Counters& counters = stages[stage];
+				const std::uint32_t sequenceStart = sequence.load(std::memory_order_relaxed);
+				sequence.store(sequenceStart + 1, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_release);
+
+				counters.cycles.store(counters.cycles.load(std::memory_order_relaxed) + cycles, std::memory_order_relaxed);
+				if (cycles > counters.maxCycles.load(std::memory_order_relaxed)) {
+					counters.maxCycles.store(cycles, std::memory_order_relaxed);
+				}
+				counters.samples.store(counters.samples.load(std::memory_order_relaxed) + samples, std::memory_order_relaxed);
+				counters.calls.store(counters.calls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+				sequence.store(sequenceStart + 2, std::memory_order_release);
+			}
+
+			/**
+			 * @brief Consistent copy of the counters of every stage, safe to call from any thread.
+			*/
+			std::vector<StageStats> Snapshot() const;
+
+			/**
+			 * @brief Zeroes the counters, processing thread only (or while it is stopped).
+			*/
+			void Reset();
+
+		private:
+			struct Counters {
+				std::atomic<std::uint64_t> cycles{ 0 };
+				std::atomic<std::uint64_t> maxCycles{ 0 };
+				std::atomic<std::uint64_t> samples{ 0 };
+				std::atomic<std::uint64_t> calls{ 0 };
+			};
+
+			std::vector<std::string> names;
+			// Atomics can't be moved, the array is rebuilt when stages change
+			std::unique_ptr<Counters[]> stages;
+			// Odd while a record is in progress
+			std::atomic<std::uint32_t> sequence{ 0 };
+		};
+
+		/**
+		 * @brief Records the cycles between its construction and destruction as a call of a stage.
+		*/
+		class ScopedStage {
+		public:
+			ScopedStage(Profiler& profiler, int stage, int samples)
+				: profiler(profiler), stage(stage), samples(samples), start(ReadCycles()) {}
+
+			~ScopedStage() {
+				profiler.Record(stage, ReadCycles() - start, (std::uint64_t)samples);
+			}
+
+			ScopedStage(const ScopedStage&) = delete;
+			ScopedStage& operator=(const ScopedStage&) = delete;
+
+		private:
+			Profiler& profiler;
+			int stage;
+			int samples;
+			std::uint64_t start;
+		};
+	}
+}
@@ -0,0 +1,233 @@
+#include "resampler.h"
+#include "constants.h"
+#include "simd.h"
+#include "tracing.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <tuple>
+
+namespace dsptk {
+
+	namespace {
+
+		struct Preset {
+			int numTaps;			// At the lower rate
+			double attenuation;		// dB
+			int numPhases;			// Of an arbitrary ratio
+		};
+
+		const Preset presets[] = {
+			{ 32, 70., 128 },		// Fast
+			{ 96, 100., 512 },		// Normal
+			{ 192, 140., 2048 },	// High
+		};
+
+		// Rational ratios with more phases become arbitrary ones, a table of 1024 phases is 1.5MB at High
+		const int maxRationalPhases = 1024;
+
+		// The chunk size until Prepare
+		const int defaultBlockSize = 1024;
+
+		// Modified Bessel function of the first kind, order 0
+		double BesselI0(double x) {
+			double sum = 1.;
+			double term = 1.;
+			for (int k = 1; term > 1e-20 * sum; k++) {
+				const double factor = .5 * x / k;
+				term *= factor * factor;
+				sum += term;
+			}
+			return sum;
+		}
+
+		// The shape parameter of a Kaiser window with a stopband of attenuation dB
+		double KaiserBeta(double attenuation) {
+			if (attenuation > 50.) return .1102 * (attenuation - 8.7);
+			if (attenuation > 21.) return .5842 * std::pow(attenuation - 21., .4) + .07886 * (attenuation - 21.);
+			return 0.;
+		}
+
+		// The table of a preset with its stopband starting at the Nyquist frequency of the lower rate
+		std::shared_ptr<const PolyphaseTable> DesignTable(ResamplerQuality quality, double lowestRatio, int numPhases) {
+			const Preset& preset = presets[(int)quality];
+			const double scale = std::min(1., lowestRatio);
+			const int numTaps = (int)std::ceil(preset.numTaps / scale);
+			// Kaiser's estimate of the transition band for the filter length, in cycles per input sample
+			const double transition = (preset.attenuation - 7.95) / (2.285 * dsptk::DOUBLE_PI<double> * numTaps);
+			return PolyphaseTable::Get(numTaps, numPhases, .5 * scale - .5 * transition, preset.attenuation);
+		}
+	}
+
+	std::shared_ptr<const PolyphaseTable> PolyphaseTable::Get(int numTaps, int numPhases, double cutoff, double attenuation) {
+		using Key = std::tuple<int, int, double, double>;
+		static std::mutex mutex;
+		static std::map<Key, std::weak_ptr<const PolyphaseTable>> tables;
+
+		std::lock_guard<std::mutex> lock(mutex);
+		auto& entry = tables[Key(numTaps, numPhases, cutoff, attenuation)];
+		std::shared_ptr<const PolyphaseTable> table = entry.lock();
+		if (!table) {
+			table = std::make_shared<const PolyphaseTable>(numTaps, numPhases, cutoff, attenuation);
+			entry = table;
+			// Forget the tables no resampler holds anymore
+			for (auto it = tables.begin(); it != tables.end();) {
+				it = it->second.expired() ? tables.erase(it) : std::next(it);
+			}
+		}
+		return table;
+	}
+
+	PolyphaseTable::PolyphaseTable(int numTaps, int numPhases, double cutoff, double attenuation)
+		: numTaps(numTaps), numPhases(numPhases), taps((std::size_t)(numPhases + 1) * numTaps) {
+		assert(numTaps > 0 && numPhases > 0 && cutoff > 0. && cutoff <= .5);
+		const double beta = KaiserBeta(attenuation);
+		const double windowScale = 1. / BesselI0(beta);
+		const double center = .5 * numTaps;
+
+		for (int p = 0; p <= numPhases; p++) {
+			double* row = taps.data() + (std::size_t)p * numTaps;
+			double sum = 0.;
+			for (int i = 0; i < numTaps; i++) {
+				// Tap i weighs the input sample numTaps - 1 - i before the newest, the kernel is centered at numTaps / 2
+				const double x = (double)p / numPhases + (numTaps - 1 - i) - center;
+				const double u = 2. * cutoff * x;
+				const double sinc = u == 0. ? 1. : std::sin(dsptk::PI<double> * u) / (dsptk::PI<double> * u);
+				const double position = x / center;
+				const double window = BesselI0(beta * std::sqrt(std::max(0., 1. - position * position))) * windowScale;
+				row[i] = 2. * cutoff * sinc * window;
+				sum += row[i];
+			}
+			// Unity gain at DC on every phase, the ripple of the sampled kernel would modulate it otherwise
+			for (int i = 0; i < numTaps; i++) {
+				row[i] /= sum;
+			}
+		}
+	}
+
+	Resampler::Resampler(int numChannels, int interpolation, int decimation, ResamplerQuality quality)
+		: numChannels(numChannels), ratio((double)interpolation / decimation), minRatio(ratio) {
+		assert(numChannels >= 0 && interpolation > 0 && decimation > 0);
+		const int divisor = std::gcd(interpolation, decimation);
+		interpolation /= divisor;
+		decimation /= divisor;
+		if (interpolation <= maxRationalPhases) {
+			this->interpolation = interpolation;
+			this->decimation = decimation;
+			table = DesignTable(quality, ratio, interpolation);
+		}
+		else {
+			table = DesignTable(quality, ratio, presets[(int)quality].numPhases);
+		}
+		Prepare(defaultBlockSize);
+	}
+
+	Resampler::Resampler(int numChannels, double ratio, ResamplerQuality quality, double minRatio)
+		: numChannels(numChannels), ratio(ratio), minRatio(minRatio > 0. ? std::min(minRatio, ratio) : ratio) {
+		assert(numChannels >= 0 && ratio > 0.);
+		table = DesignTable(quality, this->minRatio, presets[(int)quality].numPhases);
+		Prepare(defaultBlockSize);
+	}
+
+	Resampler Resampler::ForRates(int numChannels, double inputRate, double outputRate, ResamplerQuality quality) {
+		assert(inputRate > 0. && outputRate > 0.);
+		const double maxRate = 2147483647.;
+		if (inputRate == std::floor(inputRate) && outputRate == std::floor(outputRate) && std::max(inputRate, outputRate) <= maxRate) {
+			return Resampler(numChannels, (int)outputRate, (int)inputRate, quality);
+		}
+		return Resampler(numChannels, outputRate / inputRate, quality);
+	}
+
+	void Resampler::Prepare(int maxBlockSize) {
+		assert(maxBlockSize > 0);
+		this->maxBlockSize = std::max(1, maxBlockSize);
+		history.Resize(numChannels, table->GetNumTaps() - 1 + this->maxBlockSize);
+		Reset();
+	}
+
+	void Resampler::Reset() {
+		history.Clear();
+		inputIndex = 0;
+		phase = 0;
+		fraction = 0.;
+	}
+
+	int Resampler::GetMaxOutputFrames(int nInput) const {
+		return (int)std::ceil(nInput * ratio) + 1;
+	}
+
+	bool Resampler::SetRatio(double ratio) {
+		if (IsRational() || !(ratio >= minRatio)) return false;
+		this->ratio = ratio;
+		return true;
+	}
+
+	int Resampler::ProcessBlock(BufferView<const double> input, BufferView<double> output) {
+		DSPTK_TRACE_SCOPE("Resampler block", (std::int64_t)input.GetNumFrames());
+		assert(input.GetNumChannels() == numChannels && output.GetNumChannels() == numChannels);
+		assert(output.GetNumFrames() >= GetMaxOutputFrames(input.GetNumFrames()));
+
+		int nOutput = 0;
+		for (int start = 0; start < input.GetNumFrames(); start += maxBlockSize) {
+			const int nFrames = std::min(maxBlockSize, input.GetNumFrames() - start);
+			nOutput += ProcessChunk(input.SubBlock(start, nFrames), output.SubBlock(nOutput, output.GetNumFrames() - nOutput));
+		}
+		return nOutput;
+	}
+
+	int Resampler::ProcessChunk(BufferView<const double> input, BufferView<double> output) {
+		const int nFrames = input.GetNumFrames();
+		const int numTaps = table->GetNumTaps();
+		const int numPhases = table->GetNumPhases();
+		const auto dotProduct = simd::GetKernels().dotProduct;
+		const double step = 1. / ratio;
+
+		// Every channel walks the same positions from the saved one
+		long long index = inputIndex;
+		int p = phase;
+		double f = fraction;
+		int nOutput = 0;
+		for (int c = 0; c < numChannels; c++) {
+			double* samples = history[c].data();
+			std::copy(input[c].data(), input[c].data() + nFrames, samples + numTaps - 1);
+			double* out = output[c].data();
+			index = inputIndex;
+			p = phase;
+			f = fraction;
+			nOutput = 0;
+
+			// The taps of the output after input sample index start at samples + index
+			if (IsRational()) {
+				for (; index < nFrames; nOutput++) {
+					out[nOutput] = dotProduct(table->GetPhase(p), samples + index, numTaps);
+					p += decimation;
+					index += p / interpolation;
+					p %= interpolation;
+				}
+			}
+			else {
+				for (; index < nFrames; nOutput++) {
+					const double position = f * numPhases;
+					const int row = std::min((int)position, numPhases - 1);
+					const double weight = position - row;
+					const double a = dotProduct(table->GetPhase(row), samples + index, numTaps);
+					const double b = dotProduct(table->GetPhase(row + 1), samples + index, numTaps);
+					out[nOutput] = a + weight * (b - a);
+					f += step;
+					const double whole = std::floor(f);
+					index += (long long)whole;
+					f -= whole;
+				}
+			}
+
+			std::copy(samples + nFrames, samples + nFrames + numTaps - 1, samples);
+		}
+		inputIndex = index - nFrames;
+		phase = p;
+		fraction = f;
+		return nOutput;
+	}
+
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <cassert>
+#include <memory>
+#include <vector>
+#include "audiobuffer.h"
+
+namespace dsptk {
+
+	/**
+	 * @brief Presets of the resampler, trading taps (CPU) against the stopband and the passband width.
+	 *
+	 * | preset | taps  | stopband | passband at 44.1 kHz | arbitrary ratio phases |
+	 * |--------|-------|----------|----------------------|------------------------|
+	 * | Fast   | 32    | 70 dB    | 16.1 kHz             | 128                    |
+	 * | Normal | 96    | 100 dB   | 19.1 kHz             | 512                    |
+	 * | High   | 192   | 140 dB   | 19.9 kHz             | 2048                   |
+	 *
+	 * Taps are counted at the lower of the two rates, downsampling multiplies them by the ratio.
+	*/
+	enum class ResamplerQuality { Fast, Normal, High };
+
+	/**
+	 * @brief The phases of a windowed sinc (Kaiser window) low pass, each a row of taps ready for a dot
+	 * product with the input. Immutable and shared by every resampler with the same design.
+	*/
+	class PolyphaseTable final {
+	public:
+		/**
+		 * @brief The table of a design, computed on the first request and shared while a resampler holds it.
+		 * @param numTaps the taps of a phase, in input samples.
+		 * @param numPhases the phases in an input sample, the table has one more for the interpolation.
+		 * @param cutoff the -6 dB frequency in cycles per input sample.
+		 * @param attenuation the stopband attenuation in dB, sets the Kaiser window.
+		*/
+		static std::shared_ptr<const PolyphaseTable> Get(int numTaps, int numPhases, double cutoff, double attenuation);
+
+		PolyphaseTable(int numTaps, int numPhases, double cutoff, double attenuation);
+
+		int GetNumTaps() const { return numTaps; }
+		int GetNumPhases() const { return numPhases; }
+
+		/**
+		 * @brief The taps of the output sample phase / numPhases input samples after the newest input sample,
+		 * in input order (oldest first). Every phase sums to 1.
+		*/
+		const double* GetPhase(int phase) const {
+			assert(phase >= 0 && phase <= numPhases);
+			return taps.data() + (std::size_t)phase * numTaps;
+		}
+
+	private:
+		int numTaps;
+		int numPhases;
+		std::vector<double> taps;
+	};
+
+	/**
+	 * @brief Polyphase windowed sinc sample rate converter.
+	 *
+	 * A rational ratio L / M walks the L phases of its table exactly; an arbitrary ratio, which can change
+	 * while processing, interpolates linearly between the two nearest of a fixed number of phases, an error
+	 * about as low as the stopband of the preset. The anti-aliasing cutoff is set for the lowest ratio the
+	 * resampler is built for. Each output sample is one or two dot products of the SIMD kernels.
+	 *
+	 * Streaming: every block continues the previous one, the output has a latency of GetLatency() input
+	 * samples and the first output sample is at the time of the first input sample.
+	*/
+	class Resampler final {
+	public:
+		/**
+		 * @brief Resampler of the rational ratio interpolation / decimation, e.g. 160 / 147 from 44.1 to 48 kHz.
+		 * Reduces the fraction; falls back to an arbitrary ratio when more than 1024 phases remain.
+		*/
+		Resampler(int numChannels, int interpolation, int decimation, ResamplerQuality quality = ResamplerQuality::Normal);
+
+		/**
+		 * @brief Resampler of an arbitrary, variable, ratio.
+		 * @param ratio the output rate over the input rate.
+		 * @param minRatio the lowest ratio SetRatio will be given, 0 for ratio.
+		*/
+		Resampler(int numChannels, double ratio, ResamplerQuality quality = ResamplerQuality::Normal, double minRatio = 0.);
+
+		/**
+		 * @brief Resampler converting inputRate to outputRate, rational when both are integers.
+		*/
+		static Resampler ForRates(int numChannels, double inputRate, double outputRate, ResamplerQuality quality = ResamplerQuality::Normal);
+
+		/**
+		 * @brief Allocates the buffers and clears the history. Not real time safe.
+		 * @param maxBlockSize the input chunk size, larger blocks are processed in chunks, 1024 by default.
+		*/
+		void Prepare(int maxBlockSize);
+
+		/**
+		 * @brief Resamples the next block of the stream.
+		 * @param input one channel per channel of the resampler, any number of frames.
+		 * @param output at least GetMaxOutputFrames(input frames) frames.
+		 * @return the number of frames written to the output.
+		*/
+		int ProcessBlock(BufferView<const double> input, BufferView<double> output);
+
+		/**
+		 * @brief The most frames ProcessBlock writes for nInput input frames at the current ratio.
+		*/
+		int GetMaxOutputFrames(int nInput) const;
+
+		/**
+		 * @brief Changes the ratio of an arbitrary ratio resampler from the next output sample.
+		 * @return false for a rational resampler or a ratio below the minimum it was built for.
+		*/
+		bool SetRatio(double ratio);
+
+		double GetRatio() const { return ratio; }
+
+		/**
+		 * @brief Whether the ratio is followed exactly with the phases of a rational ratio.
+		*/
+		bool IsRational() const { return interpolation > 0; }
+
+		/**
+		 * @brief Delay of the output in input samples: feed as many zeros to flush the end of a stream.
+		*/
+		double GetLatency() const { return .5 * table->GetNumTaps(); }
+
+		int GetNumChannels() const { return numChannels; }
+
+		/**
+		 * @brief Clears the history, the next block starts a new stream.
+		*/
+		void Reset();
+
+	private:
+		int numChannels;
+		double ratio;
+		double minRatio;
+		// L and M of a rational ratio, 0 for an arbitrary one
+		int interpolation = 0;
+		int decimation = 0;
+		std::shared_ptr<const PolyphaseTable> table;
+
+		// Position of the next output sample: the newest input sample it needs, from the start of the next
+		// block, and the phase after it
+		long long inputIndex = 0;
+		int phase = 0;			// Of L, rational ratio
+		double fraction = 0.;	// In [0, 1), arbitrary ratio
+
+		// Per channel, the last numTaps - 1 input samples then the block
+		AudioBuffer<double> history;
+		int maxBlockSize = 0;
+
+		int ProcessChunk(BufferView<const double> input, BufferView<double> output);
+	};
+
+}
@@ -0,0 +1,343 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include "audiobuffer.h"
+
+namespace dsptk {
+
+	/**
+	 * @brief Positions of a single producer, single consumer ring, shared by RingBuffer and MultichannelRingBuffer.
+	 *
+	 * Both positions only grow (the slot is the position modulo the power of two capacity), each is written
+	 * by one side and published with release/acquire, so every operation is wait-free: a fixed number of
+	 * steps whatever the other thread does. Each side keeps its position and its last reading of the other
+	 * side's position on a cache line of its own, so the producer and the consumer don't invalidate each
+	 * other's line except to publish, and only look at the other side when the cached value isn't enough.
+	*/
+	class RingIndices {
+	public:
+		static constexpr std::size_t cacheLineSize = 64;
+
+		/**
+		 * @param capacity a power of two.
+		*/
+		explicit RingIndices(int capacity) : capacity(capacity), mask((std::size_t)capacity - 1) {
+			assert(capacity > 0 && (capacity & (capacity - 1)) == 0);
+		}
+
+		/**
+		 * @brief Smallest power of two capacity holding at least n items.
+		*/
+		static int RoundUpCapacity(int n) {
+			int capacity = 1;
+			while (capacity < n) capacity <<= 1;
+			return capacity;
+		}
+
+		int GetCapacity() const { return capacity; }
+
+		/**
+		 * @brief Free slots, producer side.
+		*/
+		int GetWriteAvailable() {
+			producer.cachedRead = consumer.read.load(std::memory_order_acquire);
+			return capacity - (int)(producer.write.load(std::memory_order_relaxed) - producer.cachedRead);
+		}
+
+		/**
+		 * @brief Up to n free slots from the returned slot on, producer side.
+		*/
+		int ReserveWrite(int n, int& slot) {
+			const std::size_t write = producer.write.load(std::memory_order_relaxed);
+			if (capacity - (int)(write - producer.cachedRead) < n) {
+				producer.cachedRead = consumer.read.load(std::memory_order_acquire);
+			}
+			slot = (int)(write & mask);
+			return std::min(n, capacity - (int)(write - producer.cachedRead));
+		}
+
+		/**
+		 * @brief Publishes n written slots to the consumer.
+		*/
+		void CommitWrite(int n) {
+			producer.write.store(producer.write.load(std::memory_order_relaxed) + (std::size_t)n, std::memory_order_release);
+		}
+
+		/**
+		 * @brief Items ready to be read, consumer side.
+		*/
+		int GetReadAvailable() {
+			consumer.cachedWrite = producer.write.load(std::memory_order_acquire);
+			return (int)(consumer.cachedWrite - consumer.read.load(std::memory_order_relaxed));
+		}
+
+		/**
+		 * @brief Up to n readable slots from the returned slot on, consumer side.
+		*/
+		int ReserveRead(int n, int& slot) {
+			const std::size_t read = consumer.read.load(std::memory_order_relaxed);
+			if ((int)(consumer.cachedWrite - read) < n) {
+				consumer.cachedWrite = producer.write.load(std::memory_order_acquire);
+			}
+			slot = (int)(read & mask);
+			return std::min(n, (int)(consumer.cachedWrite - read));
+		}
+
+		/**
+		 * @brief Gives n read slots back to the producer.
+		*/
+		void CommitRead(int n) {
+			consumer.read.store(consumer.read.load(std::memory_order_relaxed) + (std::size_t)n, std::memory_order_release);
+		}
+
+		/**
+		 * @brief Empties the ring, only while neither side is using it.
+		*/
+		void Reset() {
+			producer.write.store(0, std::memory_order_relaxed);
+			producer.cachedRead = 0;
+			consumer.read.store(0, std::memory_order_relaxed);
+			consumer.cachedWrite = 0;
+		}
+
+	private:
+		struct alignas(cacheLineSize) Producer {
+			std::atomic<std::size_t> write{ 0 };
+			std::size_t cachedRead = 0;
+		};
+
+		struct alignas(cacheLineSize) Consumer {
+			std::atomic<std::size_t> read{ 0 };
+			std::size_t cachedWrite = 0;
+		};
+
+		// Read only after construction, shared by both sides
+		alignas(cacheLineSize) const int capacity;
+		const std::size_t mask;
+		Producer producer;
+		Consumer consumer;
+	};
+
+	/**
+	 * @brief The slots of a ring operation: the range to the end of the storage, then the wrapped part (often empty).
+	*/
+	template <typename T>
+	struct RingSpans {
+		ChannelView<T> first;
+		ChannelView<T> second;
+
+		int size() const { return first.size() + second.size(); }
+	};
+
+	/**
+	 * @brief Wait-free single producer, single consumer ring buffer, to pass audio between two threads.
+	 *
+	 * One thread writes, another reads, none of them ever blocks, allocates or calls the system. Besides
+	 * Write and Read, which copy, PrepareWrite/PrepareRead give the slots themselves as two contiguous
+	 * spans (the second one when the range wraps around the end of the storage) so a producer can render
+	 * or a consumer process in place, then CommitWrite/CommitRead publish them.
+	 * The capacity is rounded up to a power of two.
+	*/
+	template <typename T>
+	class RingBuffer final {
+	public:
+		/**
+		 * @param minCapacity the least number of items the ring holds, rounded up to a power of two.
+		*/
+		explicit RingBuffer(int minCapacity)
+			: indices(RingIndices::RoundUpCapacity(minCapacity)), storage(new T[indices.GetCapacity()]()) {}
+
+		RingBuffer(const RingBuffer&) = delete;
+		RingBuffer& operator=(const RingBuffer&) = delete;
+
+		int GetCapacity() const { return indices.GetCapacity(); }
+
+		/**
+		 * @brief Free slots, producer side.
+		*/
+		int GetWriteAvailable() { return indices.GetWriteAvailable(); }
+
+		/**
+		 * @brief Readable items, consumer side.
+		*/
+		int GetReadAvailable() { return indices.GetReadAvailable(); }
+
+		/**
+		 * @brief Up to n free slots to fill, fewer when the ring is fuller; CommitWrite publishes them.
+		*/
+		RingSpans<T> PrepareWrite(int n) {
+			int slot;
+			const int count = indices.ReserveWrite(n, slot);
+			return Spans(slot, count);
+		}
+
+		void CommitWrite(int n) { indices.CommitWrite(n); }
+
+		/**
+		 * @brief Up to n items to read, fewer when the ring has less; CommitRead frees them.
+		*/
+		RingSpans<const T> PrepareRead(int n) {
+			int slot;
+			const int count = indices.ReserveRead(n, slot);
+			const RingSpans<T> spans = Spans(slot, count);
+			return { spans.first, spans.second };
+		}
+
+		void CommitRead(int n) { indices.CommitRead(n); }
+
+		/**
+		 * @brief Copies up to n items in.
+		 * @return the items written, fewer than n when the ring is full.
+		*/
+		int Write(const T* input, int n) {
+			const RingSpans<T> spans = PrepareWrite(n);
+			std::copy(input, input + spans.first.size(), spans.first.begin());
+			std::copy(input + spans.first.size(), input + spans.size(), spans.second.begin());
+			CommitWrite(spans.size());
+			return spans.size();
+		}
+
+		/**
+		 * @brief Copies up to n items out.
+		 * @return the items read, fewer than n when the ring has less.
+		*/
+		int Read(T* output, int n) {
+			const RingSpans<const T> spans = PrepareRead(n);
+			std::copy(spans.first.begin(), spans.first.end(), output);
+			std::copy(spans.second.begin(), spans.second.end(), output + spans.first.size());
+			CommitRead(spans.size());
+			return spans.size();
+		}
+
+		/**
+		 * @brief Empties the ring, only while neither side is using it.
+		*/
+		void Reset() { indices.Reset(); }
+
+	private:
+		RingSpans<T> Spans(int slot, int count) const {
+			const int first = std::min(count, GetCapacity() - slot);
+			return { ChannelView<T>(storage.get() + slot, first), ChannelView<T>(storage.get(), count - first) };
+		}
+
+		RingIndices indices;
+		const std::unique_ptr<T[]> storage;
+	};
+
+	/**
+	 * @brief The frames of a multichannel ring operation, like RingSpans.
+	*/
+	template <typename T>
+	struct MultichannelRingSpans {
+		BufferView<T> first;
+		BufferView<T> second;
+
+		int GetNumFrames() const { return first.GetNumFrames() + second.GetNumFrames(); }
+	};
+
+	/**
+	 * @brief RingBuffer of planar multichannel frames: the channels move together, a position per ring.
+	 *
+	 * Storage is an AudioBuffer (64 bytes aligned channels), the spans are views of it ready for the
+	 * BufferView APIs of the processors.
+	*/
+	template <typename T>
+	class MultichannelRingBuffer final {
+	public:
+		/**
+		 * @param minFrames the least number of frames the ring holds, rounded up to a power of two.
+		*/
+		MultichannelRingBuffer(int numChannels, int minFrames)
+			: indices(RingIndices::RoundUpCapacity(minFrames)), storage(numChannels, indices.GetCapacity()) {}
+
+		MultichannelRingBuffer(const MultichannelRingBuffer&) = delete;
+		MultichannelRingBuffer& operator=(const MultichannelRingBuffer&) = delete;
+
+		int GetNumChannels() const { return storage.GetNumChannels(); }
+		int GetCapacity() const { return indices.GetCapacity(); }
+
+		/**
+		 * @brief Free frames, producer side.
+		*/
+		int GetWriteAvailable() { return indices.GetWriteAvailable(); }
+
+		/**
+		 * @brief Readable frames, consumer side.
+		*/
+		int GetReadAvailable() { return indices.GetReadAvailable(); }
+
+		/**
+		 * @brief Up to nFrames free frames to fill, CommitWrite publishes them.
+		*/
+		MultichannelRingSpans<T> PrepareWrite(int nFrames) {
+			int slot;
+			const int count = indices.ReserveWrite(nFrames, slot);
+			return Spans(slot, count);
+		}
+
+		void CommitWrite(int nFrames) { indices.CommitWrite(nFrames); }
+
+		/**
+		 * @brief Up to nFrames frames to read, CommitRead frees them.
+		*/
+		MultichannelRingSpans<const T> PrepareRead(int nFrames) {
+			int slot;
+			const int count = indices.ReserveRead(nFrames, slot);
+			const MultichannelRingSpans<T> spans = Spans(slot, count);
+			return { spans.first, spans.second };
+		}
+
+		void CommitRead(int nFrames) { indices.CommitRead(nFrames); }
+
+		/**
+		 * @brief Copies the frames of input in, it must have the channels of the ring.
+		 * @return the frames written, fewer than input has when the ring is full.
+		*/
+		int Write(BufferView<const T> input) {
+			assert(input.GetNumChannels() == GetNumChannels());
+			const MultichannelRingSpans<T> spans = PrepareWrite(input.GetNumFrames());
+			Copy(input.SubBlock(0, spans.first.GetNumFrames()), spans.first);
+			Copy(input.SubBlock(spans.first.GetNumFrames(), spans.second.GetNumFrames()), spans.second);
+			CommitWrite(spans.GetNumFrames());
+			return spans.GetNumFrames();
+		}
+
+		/**
+		 * @brief Copies frames out to fill output, it must have the channels of the ring.
+		 * @return the frames read, fewer than output has when the ring has less.
+		*/
+		int Read(BufferView<T> output) {
+			assert(output.GetNumChannels() == GetNumChannels());
+			const MultichannelRingSpans<const T> spans = PrepareRead(output.GetNumFrames());
+			Copy(spans.first, output.SubBlock(0, spans.first.GetNumFrames()));
+			Copy(spans.second, output.SubBlock(spans.first.GetNumFrames(), spans.second.GetNumFrames()));
+			CommitRead(spans.GetNumFrames());
+			return spans.GetNumFrames();
+		}
+
+		/**
+		 * @brief Empties the ring, only while neither side is using it.
+		*/
+		void Reset() { indices.Reset(); }
+
+	private:
+		MultichannelRingSpans<T> Spans(int slot, int count) {
+			const int first = std::min(count, GetCapacity() - slot);
+			return { storage.SubBlock(slot, first), storage.SubBlock(0, count - first) };
+		}
+
+		static void Copy(BufferView<const T> from, BufferView<T> to) {
+			for (int c = 0; c < from.GetNumChannels(); c++) {
+				std::copy(from[c].begin(), from[c].end(), to[c].begin());
+			}
+		}
+
+		RingIndices indices;
+		AudioBuffer<T> storage;
+	};
+
+}
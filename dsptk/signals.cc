@@ -1,6 +1,10 @@
 #include "signals.h"
 #include "constants.h"
+#include "dft.h"
+#include <algorithm>
 #include <cmath>
+#include <complex>
+#include <cstring>
 
 namespace dsptk {
 	
@@ -35,4 +39,444 @@ namespace dsptk {
 	std::vector<double> sin(double freq, double samplerate, int numberOfSamples, double gain) {
 		return sin(freq/samplerate, numberOfSamples, gain);
 	}
+
+	/*
+	* sin(2 * PI * x) for x in [-0.5, 0.5).
+	* The symmetry around a quarter period folds x into [0, 0.25] where a Taylor series
+	* up to the 15th power is accurate to ~1e-11. Only min/abs/copysign, no branches.
+	*/
+	static inline double PolynomialSin(double x) {
+		const double a = std::abs(x);
+		const double theta = DOUBLE_PI<double> * std::min(a, .5 - a);
+		const double t2 = theta * theta;
+
+		double result = 1. - t2 * (1. / 210.);
+		result = 1. - t2 * (1. / 156.) * result;
+		result = 1. - t2 * (1. / 110.) * result;
+		result = 1. - t2 * (1. / 72.) * result;
+		result = 1. - t2 * (1. / 42.) * result;
+		result = 1. - t2 * (1. / 20.) * result;
+		result = 1. - t2 * (1. / 6.) * result;
+
+		return std::copysign(theta * result, x);
+	}
+
+	/*
+	* x(n) = gain * sin(2 PI f1 T / R * (exp(t R / T) - 1)), with R = ln(f2 / f1) [Farina 2000].
+	* The instantaneous frequency f1 * exp(t R / T) grows exponentially from f1 to f2.
+	*/
+	std::vector<double> exponential_sweep(double startFreq, double endFreq, double duration, double samplerate, double gain) {
+
+		const int N = (int)std::round(duration * samplerate);
+		const double R = std::log(endFreq / startFreq);
+		const double k = DOUBLE_PI<double> * startFreq * duration / R;
+		const double rate = R / (duration * samplerate);
+
+		std::vector<double> signal(N);
+		for (int n = 0; n < N; n++) {
+			signal[n] = gain * std::sin(k * (std::exp(rate * n) - 1.));
+		}
+		return signal;
+	}
+
+	/*
+	* The sweep spends T / (R f) seconds per Hz at frequency f, so the magnitude of its spectrum is
+	* fs / 2 * sqrt(T / (R f)). Reversing it and applying the envelope exp(-t R / T), which is f / f2 at the
+	* reversed frequency f, leaves a product spectrum of fs^2 T / (4 R f2), constant across the band.
+	*/
+	std::vector<double> exponential_sweep_inverse(double startFreq, double endFreq, double duration, double samplerate) {
+
+		const int N = (int)std::round(duration * samplerate);
+		const double R = std::log(endFreq / startFreq);
+		const double k = DOUBLE_PI<double> * startFreq * duration / R;
+		const double rate = R / (duration * samplerate);
+
+		// The envelope at reversed sample n is exp(-rate n) = exp(rate m) * exp(-rate (N - 1)), m being the sweep sample
+		const double scale = 4. * R * endFreq / (samplerate * samplerate * duration) * std::exp(-rate * (N - 1));
+
+		std::vector<double> inverse(N);
+		for (int m = 0; m < N; m++) {
+			const double growth = std::exp(rate * m);
+			inverse[N - 1 - m] = scale * growth * std::sin(k * (growth - 1.));
+		}
+		return inverse;
+	}
+
+	Oscillator::Oscillator(double frequency, double samplerate, Mode mode, double gain)
+		: mMode{ mode }
+		, mFrequency{ frequency }
+		, mSamplerate{ samplerate }
+		, mGain{ gain }
+	{
+		CalculateConstants();
+	}
+
+	void Oscillator::Generate(double* output, int nFrames)
+	{
+		switch (mMode) {
+		case Mode::Exact:
+			for (int i = 0; i < nFrames; i++) {
+				output[i] = std::sin(DOUBLE_PI<double> * (mPhase + i * mIncrement)) * mGain;
+			}
+			break;
+		case Mode::Quadrature:
+			GenerateQuadrature(output, nFrames);
+			break;
+		case Mode::Polynomial:
+			for (int i = 0; i < nFrames; i++) {
+				// Wrap into [-0.5, 0.5), phase and increment are positive so truncation rounds
+				double x = mPhase + i * mIncrement;
+				x -= (double)(int)(x + .5);
+				output[i] = PolynomialSin(x) * mGain;
+			}
+			break;
+		}
+
+		mPhase += nFrames * mIncrement;
+		mPhase -= std::floor(mPhase);
+	}
+
+	void Oscillator::GenerateQuadrature(double* output, int nFrames)
+	{
+		double c = mCos;
+		double s = mSin;
+
+		int i = 0;
+		while (i < nFrames) {
+			const int segment = std::min(nFrames - i, mSamplesToRenormalize);
+			for (int n = 0; n < segment; n++) {
+				output[i + n] = s * mGain;
+				const double nextC = c * mRotationCos - s * mRotationSin;
+				s = c * mRotationSin + s * mRotationCos;
+				c = nextC;
+			}
+			i += segment;
+			mSamplesToRenormalize -= segment;
+
+			if (mSamplesToRenormalize == 0) {
+				// First order correction towards the unit circle, the error is tiny after a period
+				const double k = 1.5 - .5 * (c * c + s * s);
+				c *= k;
+				s *= k;
+				mSamplesToRenormalize = renormalizationPeriod;
+			}
+		}
+
+		mCos = c;
+		mSin = s;
+	}
+
+	void Oscillator::SetFrequency(double frequency)
+	{
+		if (frequency == mFrequency) return;
+		mFrequency = frequency;
+		CalculateConstants();
+	}
+
+	void Oscillator::SetPhase(double phase)
+	{
+		mPhase = phase - std::floor(phase);
+		mCos = std::cos(DOUBLE_PI<double> * mPhase);
+		mSin = std::sin(DOUBLE_PI<double> * mPhase);
+	}
+
+	void Oscillator::CalculateConstants()
+	{
+		// Negative frequencies wrap to an equivalent positive increment
+		mIncrement = mFrequency / mSamplerate;
+		mIncrement -= std::floor(mIncrement);
+
+		mRotationCos = std::cos(DOUBLE_PI<double> * mIncrement);
+		mRotationSin = std::sin(DOUBLE_PI<double> * mIncrement);
+	}
+
+	/*
+	* Each level is the inverse FFT of the truncated spectrum, a sine of amplitude A at bin h is -i A N / 2.
+	* All levels share the scale of the first one so switching levels does not change the loudness.
+	*/
+	WavetableSet::WavetableSet(const std::vector<double>& harmonics)
+		: mTables(numLevels * (tableSize + 1))
+	{
+		double scale = 1.;
+		for (int level = 0; level < numLevels; level++) {
+			const size_t maxHarmonic = std::min(harmonics.size(), (size_t)(tableSize / 4) >> level);
+
+			std::vector<std::complex<double>> spectrum(tableSize / 2 + 1);
+			for (size_t h = 1; h <= maxHarmonic; h++) {
+				spectrum[h] = { 0., -harmonics[h - 1] * tableSize / 2 };
+			}
+			std::vector<double> table = ifft_real(spectrum);
+
+			if (level == 0) {
+				double peak = 0.;
+				for (double x : table) peak = std::max(peak, std::abs(x));
+				scale = peak > 0. ? 1. / peak : 1.;
+			}
+
+			float* destination = mTables.data() + level * (tableSize + 1);
+			for (int i = 0; i < tableSize; i++) {
+				destination[i] = (float)(table[i] * scale);
+			}
+			destination[tableSize] = destination[0];
+		}
+	}
+
+	static std::vector<double> StandardHarmonics(WavetableSet::Waveform waveform) {
+		std::vector<double> harmonics(WavetableSet::tableSize / 4, 0.);
+		for (size_t i = 0; i < harmonics.size(); i++) {
+			const double h = (double)(i + 1);
+			const bool odd = (i % 2) == 0;
+			switch (waveform) {
+			case WavetableSet::Waveform::Sine:
+				harmonics[i] = i == 0 ? 1. : 0.;
+				break;
+			case WavetableSet::Waveform::Saw:
+				harmonics[i] = (odd ? 1. : -1.) / h;		// Rising ramp
+				break;
+			case WavetableSet::Waveform::Square:
+				harmonics[i] = odd ? 1. / h : 0.;
+				break;
+			case WavetableSet::Waveform::Triangle:
+				harmonics[i] = odd ? ((i % 4) == 0 ? 1. : -1.) / (h * h) : 0.;
+				break;
+			}
+		}
+		return harmonics;
+	}
+
+	const WavetableSet& WavetableSet::Get(Waveform waveform)
+	{
+		// Function statics are built once, thread safe, on first use
+		static const WavetableSet sine(StandardHarmonics(Waveform::Sine));
+		static const WavetableSet saw(StandardHarmonics(Waveform::Saw));
+		static const WavetableSet square(StandardHarmonics(Waveform::Square));
+		static const WavetableSet triangle(StandardHarmonics(Waveform::Triangle));
+
+		switch (waveform) {
+		case Waveform::Saw: return saw;
+		case Waveform::Square: return square;
+		case Waveform::Triangle: return triangle;
+		default: return sine;
+		}
+	}
+
+	int WavetableSet::LevelFor(double normalizedFrequency)
+	{
+		// (tableSize / 4) >> l harmonics of f must stay below 0.5
+		const double octaves = std::ceil(std::log2(normalizedFrequency * (tableSize / 2)));
+		return (int)std::min<double>(std::max(octaves, 0.), numLevels - 1);
+	}
+
+	WavetableOscillator::WavetableOscillator(const WavetableSet& tables, double frequency, double samplerate, double gain)
+		: mTables{ &tables }
+		, mSamplerate{ samplerate }
+		, mGain{ (float)gain }
+	{
+		SetFrequency(frequency);
+	}
+
+	void WavetableOscillator::Generate(double* output, int nFrames)
+	{
+		constexpr std::uint32_t fractionMask = (1u << fractionBits) - 1;
+		constexpr float fractionScale = 1.f / (float)(1u << fractionBits);
+
+		const float* table = mLevel;
+		const std::uint32_t phase = mPhase;
+		const std::uint32_t increment = mIncrement;
+		const float gain = mGain;
+
+		// Independent iterations, the phase of each sample is computed from the start of the block
+		for (int i = 0; i < nFrames; i++) {
+			const std::uint32_t p = phase + (std::uint32_t)i * increment;
+			const std::uint32_t index = p >> fractionBits;
+			const float fraction = (float)(p & fractionMask) * fractionScale;
+			const float a = table[index];
+			const float b = table[index + 1];
+			output[i] = (double)(gain * (a + fraction * (b - a)));
+		}
+
+		mPhase = phase + (std::uint32_t)nFrames * increment;
+	}
+
+	void WavetableOscillator::SetFrequency(double frequency)
+	{
+		// Negative frequencies wrap to an equivalent positive increment
+		double normalized = frequency / mSamplerate;
+		normalized -= std::floor(normalized);
+		mIncrement = (std::uint32_t)(std::uint64_t)std::llround(normalized * 4294967296.);
+		mLevel = mTables->GetLevel(WavetableSet::LevelFor(std::min(normalized, 1. - normalized)));
+	}
+
+	void WavetableOscillator::SetPhase(double phase)
+	{
+		phase -= std::floor(phase);
+		mPhase = (std::uint32_t)(std::uint64_t)std::llround(phase * 4294967296.);
+	}
+
+	static inline std::uint64_t SplitMix64(std::uint64_t& state) {
+		std::uint64_t z = (state += 0x9e3779b97f4a7c15);
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+		return z ^ (z >> 31);
+	}
+
+	static inline std::uint64_t RotateLeft(std::uint64_t x, int k) {
+		return (x << k) | (x >> (64 - k));
+	}
+
+	RandomGenerator::RandomGenerator(std::uint64_t seed, std::uint64_t stream)
+	{
+		for (int l = 0; l < lanes; l++) {
+			// Each lane takes its own 4 outputs of the SplitMix64 sequence
+			std::uint64_t state = seed + (stream * lanes + l) * 4 * 0x9e3779b97f4a7c15;
+			s0[l] = SplitMix64(state);
+			s1[l] = SplitMix64(state);
+			s2[l] = SplitMix64(state);
+			s3[l] = SplitMix64(state);
+		}
+	}
+
+	/*
+	* One xoshiro256+ step on every lane, writing lanes values in [-1, 1) to output.
+	*/
+	template <int lanes>
+	static inline void XoshiroStep(std::uint64_t* s0, std::uint64_t* s1, std::uint64_t* s2, std::uint64_t* s3, double* output) {
+		for (int l = 0; l < lanes; l++) {
+			const std::uint64_t result = s0[l] + s3[l];
+			const std::uint64_t t = s1[l] << 17;
+
+			s2[l] ^= s0[l];
+			s3[l] ^= s1[l];
+			s1[l] ^= s2[l];
+			s0[l] ^= s3[l];
+			s2[l] ^= t;
+			s3[l] = RotateLeft(s3[l], 45);
+
+			// Upper 52 bits as the mantissa of a double in [1, 2), no integer to double conversion
+			const std::uint64_t bits = (result >> 12) | 0x3ff0000000000000;
+			double unit;
+			std::memcpy(&unit, &bits, sizeof(unit));
+			output[l] = 2. * unit - 3.;
+		}
+	}
+
+	void RandomGenerator::Step()
+	{
+		XoshiroStep<lanes>(s0, s1, s2, s3, values);
+		nextValue = 0;
+	}
+
+	void RandomGenerator::FillUniform(double* output, int nFrames)
+	{
+		int i = 0;
+		// Use what's left from the last call first so the sequence doesn't depend on block sizes
+		while (i < nFrames && nextValue < lanes) {
+			output[i++] = values[nextValue++];
+		}
+
+		// Whole steps straight into the output, with the state in locals so it stays in registers
+		if (nFrames - i >= lanes) {
+			std::uint64_t r0[lanes], r1[lanes], r2[lanes], r3[lanes];
+			std::copy(s0, s0 + lanes, r0);
+			std::copy(s1, s1 + lanes, r1);
+			std::copy(s2, s2 + lanes, r2);
+			std::copy(s3, s3 + lanes, r3);
+			for (; nFrames - i >= lanes; i += lanes) {
+				XoshiroStep<lanes>(r0, r1, r2, r3, output + i);
+			}
+			std::copy(r0, r0 + lanes, s0);
+			std::copy(r1, r1 + lanes, s1);
+			std::copy(r2, r2 + lanes, s2);
+			std::copy(r3, r3 + lanes, s3);
+		}
+
+		if (i < nFrames) {
+			Step();
+			while (i < nFrames) {
+				output[i++] = values[nextValue++];
+			}
+		}
+	}
+
+	/*
+	* Box-Muller, each pair of uniform values gives a pair of normal values.
+	* The odd value left at the end of a block is kept for the next one.
+	*/
+	static inline void BoxMuller(double& a, double& b) {
+		const double u1 = .5 - .5 * a;		// (0, 1]
+		const double radius = std::sqrt(-2. * std::log(u1));
+		a = radius * std::cos(PI<double> * b);
+		b = radius * std::sin(PI<double> * b);
+	}
+
+	void RandomGenerator::FillGaussian(double* output, int nFrames)
+	{
+		int i = 0;
+		if (hasSpare && nFrames > 0) {
+			output[i++] = spare;
+			hasSpare = false;
+		}
+
+		const int pairs = (nFrames - i) / 2;
+		FillUniform(output + i, pairs * 2);
+		for (int p = 0; p < pairs; p++, i += 2) {
+			BoxMuller(output[i], output[i + 1]);
+		}
+
+		if (i < nFrames) {
+			double pair[2];
+			FillUniform(pair, 2);
+			BoxMuller(pair[0], pair[1]);
+			output[i] = pair[0];
+			spare = pair[1];
+			hasSpare = true;
+		}
+	}
+
+	WhiteNoise::WhiteNoise(Distribution distribution, double gain, std::uint64_t seed, std::uint64_t stream)
+		: mRandom{ seed, stream }
+		, mDistribution{ distribution }
+		, mGain{ gain }
+	{
+	}
+
+	void WhiteNoise::Generate(double* output, int nFrames)
+	{
+		if (mDistribution == Distribution::Uniform) {
+			mRandom.FillUniform(output, nFrames);
+		}
+		else {
+			mRandom.FillGaussian(output, nFrames);
+		}
+
+		for (int i = 0; i < nFrames; i++) {
+			output[i] *= mGain;
+		}
+	}
+
+	PinkNoise::PinkNoise(double gain, std::uint64_t seed, std::uint64_t stream)
+		: mRandom{ seed, stream }
+		, mGain{ gain }
+	{
+	}
+
+	void PinkNoise::Generate(double* output, int nFrames)
+	{
+		mRandom.FillUniform(output, nFrames);
+
+		// Output of the filter peaks around 9 for a full scale input
+		const double scale = mGain * .11;
+
+		for (int i = 0; i < nFrames; i++) {
+			const double white = output[i];
+			b0 = 0.99886 * b0 + white * 0.0555179;
+			b1 = 0.99332 * b1 + white * 0.0750759;
+			b2 = 0.96900 * b2 + white * 0.1538520;
+			b3 = 0.86650 * b3 + white * 0.3104856;
+			b4 = 0.55000 * b4 + white * 0.5329522;
+			b5 = -0.7616 * b5 - white * 0.0168980;
+			output[i] = (b0 + b1 + b2 + b3 + b4 + b5 + b6 + white * 0.5362) * scale;
+			b6 = white * 0.115926;
+		}
+	}
 }
\ No newline at end of file
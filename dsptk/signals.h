@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <vector>
 
 namespace dsptk {
@@ -7,4 +8,286 @@ namespace dsptk {
 	std::vector<double> sin(double freq, int numberOfSamples, double gain = 1.);
 
 	std::vector<double> sin(double freq, double samplerate, int numberOfSamples, double gain = 1.);
+
+	/**
+	 * @brief Creates an exponential (logarithmic) sine sweep for impulse response measurements.
+	 * @param startFreq the initial frequency in Hz.
+	 * @param endFreq the final frequency in Hz.
+	 * @param duration the length of the sweep in seconds.
+	 * @param samplerate the sample rate in samples/second.
+	 * @param gain the peak amplitude of the signal.
+	*/
+	std::vector<double> exponential_sweep(double startFreq, double endFreq, double duration, double samplerate, double gain = 1.);
+
+	/**
+	 * @brief Creates the inverse filter of a unity gain exponential_sweep with the same parameters.
+	 *
+	 * It is the time reversed sweep with an amplitude envelope compensating its pink spectrum, scaled so
+	 * convolving the sweep with it gives a unity gain impulse in the swept band, delayed by the sweep length minus one.
+	*/
+	std::vector<double> exponential_sweep_inverse(double startFreq, double endFreq, double duration, double samplerate);
+
+	/**
+	 * @brief Sine oscillator generating into caller buffers.
+	*/
+	class Oscillator {
+	public:
+		/**
+		 * @brief Generation algorithms.
+		*/
+		enum class Mode {
+			/** std::sin of an accumulated phase on every sample. */
+			Exact,
+			/** Rotates a (cos, sin) pair by a fixed angle each sample, renormalized periodically to keep the amplitude stable. */
+			Quadrature,
+			/** Polynomial sine of an accumulated phase, no dependency between samples so blocks vectorize. */
+			Polynomial
+		};
+
+		/**
+		 * @brief Creates a sine oscillator starting at phase 0.
+		 * @param frequency the frequency in Hz.
+		 * @param samplerate the sample rate in samples/second.
+		 * @param mode the generation algorithm.
+		 * @param gain the peak amplitude of the signal.
+		*/
+		Oscillator(double frequency, double samplerate, Mode mode = Mode::Quadrature, double gain = 1.);
+
+		/**
+		 * @brief Writes the next nFrames samples of the signal.
+		 * @param output the buffer receiving the samples.
+		 * @param nFrames the number of samples.
+		*/
+		void Generate(double* output, int nFrames);
+
+		/**
+		 * @brief Changes the frequency keeping the current phase.
+		 * @param frequency the frequency in Hz.
+		*/
+		void SetFrequency(double frequency);
+
+		/**
+		 * @brief Sets the current phase.
+		 * @param phase the phase in cycles (1.0 is a whole period).
+		*/
+		void SetPhase(double phase);
+
+		void SetGain(double gain) { mGain = gain; }
+
+	private:
+		static constexpr int renormalizationPeriod = 1024;
+
+		Mode mMode;
+		double mFrequency;
+		double mSamplerate;
+		double mGain;
+
+		// Phase accumulator, in cycles
+		double mPhase = 0.;
+		double mIncrement;
+
+		// Quadrature rotation state
+		double mCos = 1.;
+		double mSin = 0.;
+		double mRotationCos;
+		double mRotationSin;
+		int mSamplesToRenormalize = renormalizationPeriod;
+
+		void CalculateConstants();
+		void GenerateQuadrature(double* output, int nFrames);
+	};
+
+	/**
+	 * @brief Immutable set of band limited single cycle tables, one mip level per octave.
+	 * 
+	 * Level l holds the harmonics up to (tableSize / 4) >> l, so a level chosen for a frequency never
+	 * has partials above Nyquist. Tables are float, with a guard point, to keep a whole set around 80KB.
+	 * The standard waveforms are built once per process by Get and shared by every oscillator.
+	*/
+	class WavetableSet {
+	public:
+		enum class Waveform { Sine, Saw, Square, Triangle };
+
+		static constexpr int tableBits = 11;
+		static constexpr int tableSize = 1 << tableBits;
+		static constexpr int numLevels = tableBits - 1;
+
+		/**
+		 * @brief Builds the tables of a waveform given by its spectrum, normalized to a peak of 1.
+		 * @param harmonics the sine amplitude of each harmonic, harmonics[0] is the fundamental.
+		*/
+		explicit WavetableSet(const std::vector<double>& harmonics);
+
+		/**
+		 * @brief The shared tables of a standard waveform, built on first use.
+		*/
+		static const WavetableSet& Get(Waveform waveform);
+
+		/**
+		 * @brief The level without aliasing at frequency / samplerate.
+		*/
+		static int LevelFor(double normalizedFrequency);
+
+		/**
+		 * @brief The tableSize + 1 samples of a level, the last one repeats the first.
+		*/
+		const float* GetLevel(int level) const { return mTables.data() + level * (tableSize + 1); }
+
+	private:
+		std::vector<float> mTables;
+	};
+
+	/**
+	 * @brief Alias free oscillator reading a shared WavetableSet.
+	 * 
+	 * The phase is a 32 bit fixed point accumulator, the top bits index the table and the rest interpolate
+	 * linearly, so it wraps for free and the sample loop has no dependency but the phase increment.
+	 * The voice state is a few words, thousands of voices share a set's tables in cache.
+	*/
+	class WavetableOscillator {
+	public:
+		/**
+		 * @brief Creates an oscillator starting at phase 0.
+		 * @param tables the tables to read, must outlive the oscillator.
+		 * @param frequency the frequency in Hz.
+		 * @param samplerate the sample rate in samples/second.
+		 * @param gain the peak amplitude of the signal.
+		*/
+		WavetableOscillator(const WavetableSet& tables, double frequency, double samplerate, double gain = 1.);
+
+		/**
+		 * @brief Writes the next nFrames samples of the signal.
+		*/
+		void Generate(double* output, int nFrames);
+
+		/**
+		 * @brief Changes the frequency, and the table level, keeping the current phase.
+		 * @param frequency the frequency in Hz.
+		*/
+		void SetFrequency(double frequency);
+
+		/**
+		 * @brief Sets the current phase.
+		 * @param phase the phase in cycles (1.0 is a whole period).
+		*/
+		void SetPhase(double phase);
+
+		void SetGain(double gain) { mGain = (float)gain; }
+
+	private:
+		static constexpr int fractionBits = 32 - WavetableSet::tableBits;
+
+		const WavetableSet* mTables;
+		const float* mLevel;
+		double mSamplerate;
+		std::uint32_t mPhase = 0;
+		std::uint32_t mIncrement;
+		float mGain;
+	};
+
+	/**
+	 * @brief Pseudo random number generator.
+	 * 
+	 * Runs several xoshiro256+ generators side by side, the state is kept as one array per word
+	 * so each step is the same operation over all lanes and vectorizes.
+	 * Lanes are seeded from consecutive, non overlapping SplitMix64 outputs of the seed, so every
+	 * (seed, stream) pair gives an independent and reproducible sequence, e.g. one stream per thread.
+	 * 
+	 * @see <a href="https://prng.di.unimi.it/">David Blackman, Sebastiano Vigna - xoshiro / xoroshiro generators</a>
+	*/
+	class RandomGenerator {
+	public:
+		static constexpr int lanes = 4;
+
+		/**
+		 * @brief Creates a generator.
+		 * @param seed the seed, the same seed and stream always produce the same sequence.
+		 * @param stream the stream index.
+		*/
+		explicit RandomGenerator(std::uint64_t seed, std::uint64_t stream = 0);
+
+		/**
+		 * @brief Fills a buffer with uniformly distributed values in [-1, 1).
+		*/
+		void FillUniform(double* output, int nFrames);
+
+		/**
+		 * @brief Fills a buffer with normally distributed values, mean 0 and standard deviation 1.
+		*/
+		void FillGaussian(double* output, int nFrames);
+
+	private:
+		std::uint64_t s0[lanes], s1[lanes], s2[lanes], s3[lanes];
+
+		// Buffered values from the last step, used from nextValue up
+		double values[lanes];
+		int nextValue = lanes;
+
+		// Second normal value of the last pair when a block ended on an odd count
+		double spare = 0.;
+		bool hasSpare = false;
+
+		void Step();
+	};
+
+	/**
+	 * @brief White noise generator.
+	*/
+	class WhiteNoise {
+	public:
+		enum class Distribution {
+			/** Uniform in [-gain, gain). */
+			Uniform,
+			/** Normal with standard deviation gain. */
+			Gaussian
+		};
+
+		/**
+		 * @brief Creates a white noise generator.
+		 * @param distribution the amplitude distribution.
+		 * @param gain the peak amplitude (uniform) or standard deviation (gaussian).
+		 * @param seed the seed, see RandomGenerator.
+		 * @param stream the stream index, see RandomGenerator.
+		*/
+		WhiteNoise(Distribution distribution, double gain, std::uint64_t seed, std::uint64_t stream = 0);
+
+		/**
+		 * @brief Writes the next nFrames samples of noise.
+		*/
+		void Generate(double* output, int nFrames);
+
+	private:
+		RandomGenerator mRandom;
+		Distribution mDistribution;
+		double mGain;
+	};
+
+	/**
+	 * @brief Pink noise generator.
+	 * 
+	 * Uniform white noise through Paul Kellet's refined pinking filter, -3dB/octave within
+	 * 0.05dB above 9.2Hz at 44.1kHz (the poles are fixed, so the range scales with the sample rate).
+	 * 
+	 * @see <a href="https://www.firstpr.com.au/dsp/pink-noise/">Phil Burk, Paul Kellet - DSP Generation of Pink Noise</a>
+	*/
+	class PinkNoise {
+	public:
+		/**
+		 * @brief Creates a pink noise generator.
+		 * @param gain output scale, the peak amplitude stays around gain.
+		 * @param seed the seed, see RandomGenerator.
+		 * @param stream the stream index, see RandomGenerator.
+		*/
+		PinkNoise(double gain, std::uint64_t seed, std::uint64_t stream = 0);
+
+		/**
+		 * @brief Writes the next nFrames samples of noise.
+		*/
+		void Generate(double* output, int nFrames);
+
+	private:
+		RandomGenerator mRandom;
+		double mGain;
+		double b0 = 0., b1 = 0., b2 = 0., b3 = 0., b4 = 0., b5 = 0., b6 = 0.;
+	};
 }
@@ -0,0 +1,134 @@
+#include "simd.h"
+#include "simd_kernels.h"
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+
+#ifdef DSPTK_HAVE_X86_KERNELS
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace dsptk {
+	namespace simd {
+
+		namespace {
+
+#ifdef DSPTK_HAVE_X86_KERNELS
+			struct CpuidRegisters {
+				unsigned eax, ebx, ecx, edx;
+			};
+
+			CpuidRegisters Cpuid(unsigned leaf, unsigned subleaf) {
+				CpuidRegisters registers{};
+#ifdef _MSC_VER
+				int values[4];
+				__cpuidex(values, (int)leaf, (int)subleaf);
+				registers = { (unsigned)values[0], (unsigned)values[1], (unsigned)values[2], (unsigned)values[3] };
+#else
+				__cpuid_count(leaf, subleaf, registers.eax, registers.ebx, registers.ecx, registers.edx);
+#endif
+				return registers;
+			}
+
+			// The register state the OS saves on context switches (XCR0)
+			unsigned long long EnabledStateComponents() {
+#ifdef _MSC_VER
+				return _xgetbv(0);
+#else
+				unsigned eax, edx;
+				__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+				return ((unsigned long long)edx << 32) | eax;
+#endif
+			}
+
+			Isa DetectIsa() {
+				const unsigned maxLeaf = Cpuid(0, 0).eax;
+				const CpuidRegisters features = Cpuid(1, 0);
+				if (!(features.ecx & (1u << 20))) return Isa::Generic;
+
+				// AVX registers need the OS to save them: OSXSAVE, then the SSE and AVX state bits of XCR0
+				const bool osxsave = (features.ecx & (1u << 27)) != 0;
+				const bool avx = (features.ecx & (1u << 28)) != 0;
+				if (!osxsave || !avx || maxLeaf < 7) return Isa::Sse42;
+				const unsigned long long state = EnabledStateComponents();
+				if ((state & 0x6) != 0x6) return Isa::Sse42;
+
+				const CpuidRegisters extended = Cpuid(7, 0);
+				if (!(extended.ebx & (1u << 5))) return Isa::Sse42;
+				// AVX-512F, with the opmask and both halves of the ZMM state enabled
+				if ((extended.ebx & (1u << 16)) && (state & 0xe0) == 0xe0) return Isa::Avx512;
+				return Isa::Avx2;
+			}
+#else
+			Isa DetectIsa() {
+				return Isa::Generic;
+			}
+#endif
+
+			Kernels KernelsFor(Isa isa) {
+				switch (isa) {
+#ifdef DSPTK_HAVE_X86_KERNELS
+				case Isa::Sse42: return GetSse42Kernels();
+				case Isa::Avx2: return GetAvx2Kernels();
+				case Isa::Avx512: return GetAvx512Kernels();
+#endif
+				default: return MakeKernels(Isa::Generic);
+				}
+			}
+
+			// The supported instruction set, lowered by DSPTK_ISA
+			Isa InitialIsa() {
+				const Isa supported = GetSupportedIsa();
+				Isa requested;
+				const char* name = std::getenv("DSPTK_ISA");
+				if (name != nullptr && ParseIsa(name, requested) && requested < supported) {
+					return requested;
+				}
+				return supported;
+			}
+
+			Kernels& ActiveKernels() {
+				static Kernels kernels = KernelsFor(InitialIsa());
+				return kernels;
+			}
+		}
+
+		Isa GetSupportedIsa() {
+			static const Isa supported = DetectIsa();
+			return supported;
+		}
+
+		const Kernels& GetKernels() {
+			return ActiveKernels();
+		}
+
+		bool SetIsa(Isa isa) {
+			if (isa > GetSupportedIsa()) return false;
+			ActiveKernels() = KernelsFor(isa);
+			return true;
+		}
+
+		const char* GetIsaName(Isa isa) {
+			switch (isa) {
+			case Isa::Sse42: return "sse4.2";
+			case Isa::Avx2: return "avx2";
+			case Isa::Avx512: return "avx512";
+			default: return "generic";
+			}
+		}
+
+		bool ParseIsa(const char* name, Isa& isa) {
+			for (Isa candidate : { Isa::Generic, Isa::Sse42, Isa::Avx2, Isa::Avx512 }) {
+				if (std::strcmp(name, GetIsaName(candidate)) == 0) {
+					isa = candidate;
+					return true;
+				}
+			}
+			return false;
+		}
+	}
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+
+namespace dsptk {
+
+	/**
+	 * @brief Runtime dispatch of the inner loops to the best instruction set of the CPU.
+	 *
+	 * The library is built for the baseline of its target, the kernels below are also compiled for SSE4.2,
+	 * AVX2 and AVX-512 on x86. The first call of GetKernels detects what the CPU runs (cpuid and the
+	 * register state the OS saves) and binds the kernels of the best instruction set; the DSPTK_ISA
+	 * environment variable (generic, sse4.2, avx2, avx512) lowers the choice, to compare or test the paths.
+	 *
+	 * Every path computes the same operations in the same order without fused multiply-adds, so the results
+	 * are the same bit for bit whatever machine a file is processed on; wider registers only do more of them
+	 * at once.
+	*/
+	namespace simd {
+
+		/**
+		 * @brief Instruction sets with kernels, in increasing order.
+		*/
+		enum class Isa { Generic, Sse42, Avx2, Avx512 };
+
+		/**
+		 * @brief Coefficients of a direct form II biquad, a0 normalized to 1.
+		*/
+		struct BiquadCoefficients {
+			double b0, b1, b2, a1, a2;
+		};
+
+		/**
+		 * @brief The kernels of an instruction set.
+		*/
+		struct Kernels {
+			Isa isa;
+
+			/**
+			 * @brief Direct form II biquad, state holds w[n - 1] and w[n - 2] between blocks; output may be input.
+			*/
+			void (*biquad)(const BiquadCoefficients& coefficients, double* state, const double* input, double* output, int nFrames);
+
+			/**
+			 * @brief Sum of a[i] b[i], the FIR inner product.
+			*/
+			double (*dotProduct)(const double* a, const double* b, int n);
+
+			/**
+			 * @brief Sum of x[i]^2.
+			*/
+			double (*sumOfSquares)(const double* x, int n);
+
+			/**
+			 * @brief Radix 2 butterflies of the FFT stage of size len over the interleaved complex values
+			 * [begin, end). The len / 2 twiddles of the stage come as wr, -wi, wi, wr: the complex product
+			 * is then two sums of products, which no compiler turns into fused multiply-add/subtract.
+			*/
+			void (*fftButterflies)(double* data, std::size_t len, std::size_t begin, std::size_t end, const double* twiddles);
+
+			/**
+			 * @brief 20 log10 |x|, -infinity for 0, within 2 ulp. Input and output may not overlap.
+			*/
+			void (*linearToDb)(const double* input, double* output, int n);
+
+			/**
+			 * @brief 10^(x / 20), within 2 ulp of 10^(rounded x ln 10 / 20) so the error grows with |x| like
+			 * pow(10, x / 20)'s does. Input and output may not overlap.
+			*/
+			void (*dbToLinear)(const double* input, double* output, int n);
+		};
+
+		/**
+		 * @brief The best instruction set the CPU and the OS support, detected once.
+		*/
+		Isa GetSupportedIsa();
+
+		/**
+		 * @brief The kernels in use, selected on the first call.
+		*/
+		const Kernels& GetKernels();
+
+		/**
+		 * @brief Switches the kernels in use, while no other thread processes (for tests and benchmarks).
+		 * @return false if the CPU doesn't support isa, the kernels don't change then.
+		*/
+		bool SetIsa(Isa isa);
+
+		/**
+		 * @brief The name DSPTK_ISA takes for isa.
+		*/
+		const char* GetIsaName(Isa isa);
+
+		/**
+		 * @brief Reads the name of an instruction set.
+		 * @return false if the name is unknown.
+		*/
+		bool ParseIsa(const char* name, Isa& isa);
+	}
+}
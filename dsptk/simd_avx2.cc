@@ -0,0 +1,11 @@
+// Kernels compiled for AVX2, see the flags of this file in CMakeLists.txt
+#include "simd_kernels.h"
+
+namespace dsptk {
+	namespace simd {
+
+		Kernels GetAvx2Kernels() {
+			return MakeKernels(Isa::Avx2);
+		}
+	}
+}
@@ -0,0 +1,11 @@
+// Kernels compiled for AVX-512F, see the flags of this file in CMakeLists.txt
+#include "simd_kernels.h"
+
+namespace dsptk {
+	namespace simd {
+
+		Kernels GetAvx512Kernels() {
+			return MakeKernels(Isa::Avx512);
+		}
+	}
+}
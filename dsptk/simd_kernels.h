@@ -0,0 +1,181 @@
+#pragma once
+
+// Kernel bodies, included by the translation unit of each instruction set: they have internal linkage so
+// every copy is compiled with the flags of its own unit. Not installed.
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include "simd.h"
+
+namespace dsptk {
+	namespace simd {
+
+		Kernels GetSse42Kernels();
+		Kernels GetAvx2Kernels();
+		Kernels GetAvx512Kernels();
+
+		namespace {
+
+			// Accumulators of the reductions: the sums are split the same way whatever the register width, so
+			// every instruction set adds in the same order
+			constexpr int reductionLanes = 8;
+
+			inline std::uint64_t ToBits(double x) {
+				std::uint64_t bits;
+				std::memcpy(&bits, &x, sizeof bits);
+				return bits;
+			}
+
+			inline double FromBits(std::uint64_t bits) {
+				double x;
+				std::memcpy(&x, &bits, sizeof x);
+				return x;
+			}
+
+			// 2^k for an integer k in [-1022, 1023], through the bits of 2^52 + 1023 + k
+			inline double Pow2(double k) {
+				return FromBits(ToBits(k + (0x1p52 + 1023.)) << 52);
+			}
+
+			// Rounds to nearest for |x| < 2^51
+			inline double Round(double x) {
+				const double magic = 0x1.8p52;
+				return (x + magic) - magic;
+			}
+
+			const double ln2Hi = 6.93147180369123816490e-01;	// 32 bits, n ln2Hi is exact
+			const double ln2Lo = 1.90821492927058770002e-10;
+
+			inline double LinearToDbSample(double x) {
+				const double a = std::fabs(x);
+				// Subnormals are scaled to the normal range first
+				const bool subnormal = a < std::numeric_limits<double>::min();
+				const double scaled = a * 0x1p54;
+				const std::uint64_t bits = ToBits(subnormal ? scaled : a);
+				// The exponent as a double without an integer conversion: (2^52 + biased exponent) - 2^52 - bias
+				double exponent = (FromBits((bits >> 52) | 0x4330000000000000ull) - 0x1p52) - (subnormal ? 1077. : 1023.);
+				double m = FromBits((bits & 0x000fffffffffffffull) | 0x3ff0000000000000ull);
+				// m in [sqrt(1/2), sqrt(2))
+				const bool high = m > 1.4142135623730951;
+				m = high ? .5 * m : m;
+				exponent = high ? exponent + 1. : exponent;
+				// ln m = 2 atanh(s) = 2 s (1 + s^2 / 3 + s^4 / 5 + ...), |s| < 0.172
+				const double s = (m - 1.) / (m + 1.);
+				const double z = s * s;
+				double q = 1. / 19.;
+				q = q * z + 1. / 17.;
+				q = q * z + 1. / 15.;
+				q = q * z + 1. / 13.;
+				q = q * z + 1. / 11.;
+				q = q * z + 1. / 9.;
+				q = q * z + 1. / 7.;
+				q = q * z + 1. / 5.;
+				q = q * z + 1. / 3.;
+				const double lnM = 2. * s + 2. * s * (z * q);
+				const double ln = exponent * ln2Hi + (exponent * ln2Lo + lnM);
+				double db = ln * 8.6858896380650365;	// 20 / ln 10
+				db = a == 0. ? -std::numeric_limits<double>::infinity() : db;
+				db = a == std::numeric_limits<double>::infinity() ? a : db;
+				return a != a ? a : db;
+			}
+
+			inline double DbToLinearSample(double x) {
+				const double y = x * .11512925464970229;	// ln 10 / 20
+				// exp(y) = 2^n exp(r), |r| <= ln 2 / 2
+				const double n = Round(y * 1.4426950408889634);
+				const double r = (y - n * ln2Hi) - n * ln2Lo;
+				// Taylor series to r^13 / 13!
+				double p = 1. / 6227020800.;
+				p = p * r + 1. / 479001600.;
+				p = p * r + 1. / 39916800.;
+				p = p * r + 1. / 3628800.;
+				p = p * r + 1. / 362880.;
+				p = p * r + 1. / 40320.;
+				p = p * r + 1. / 5040.;
+				p = p * r + 1. / 720.;
+				p = p * r + 1. / 120.;
+				p = p * r + 1. / 24.;
+				p = p * r + 1. / 6.;
+				p = p * r + .5;
+				p = p * r + 1.;
+				p = p * r + 1.;
+				// 2^n in two normal factors, n reaches -1075 before the result underflows to 0
+				const double h = Round(.5 * n);
+				double gain = (p * Pow2(h)) * Pow2(n - h);
+				gain = y > 710. ? std::numeric_limits<double>::infinity() : gain;
+				gain = y < -746. ? 0. : gain;
+				return x != x ? x : gain;
+			}
+
+			void Biquad(const BiquadCoefficients& c, double* state, const double* input, double* output, int nFrames) {
+				const double b0 = c.b0, b1 = c.b1, b2 = c.b2, a1 = c.a1, a2 = c.a2;
+				double w1 = state[0];
+				double w2 = state[1];
+				for (int i = 0; i < nFrames; i++) {
+					const double w0 = input[i] - a1 * w1 - a2 * w2;
+					output[i] = b0 * w0 + b1 * w1 + b2 * w2;
+					w2 = w1;
+					w1 = w0;
+				}
+				state[0] = w1;
+				state[1] = w2;
+			}
+
+			double DotProduct(const double* a, const double* b, int n) {
+				double sums[reductionLanes] = {};
+				int i = 0;
+				for (; i + reductionLanes <= n; i += reductionLanes) {
+					for (int j = 0; j < reductionLanes; j++) {
+						sums[j] += a[i + j] * b[i + j];
+					}
+				}
+				for (int j = 0; i + j < n; j++) {
+					sums[j] += a[i + j] * b[i + j];
+				}
+				return ((sums[0] + sums[4]) + (sums[2] + sums[6])) + ((sums[1] + sums[5]) + (sums[3] + sums[7]));
+			}
+
+			double SumOfSquares(const double* x, int n) {
+				return DotProduct(x, x, n);
+			}
+
+			void FftButterflies(double* x, std::size_t len, std::size_t begin, std::size_t end, const double* w) {
+				const std::size_t halfLen = len / 2;
+				for (std::size_t start = begin; start < end; start += len) {
+					double* a = x + 2 * start;
+					double* b = a + 2 * halfLen;
+					for (std::size_t k = 0; k < halfLen; k++) {
+						// b w, as sums of products only (see Kernels::fftButterflies)
+						const double* t = w + 4 * k;
+						const double br = b[2 * k] * t[0] + b[2 * k + 1] * t[1];
+						const double bi = b[2 * k] * t[2] + b[2 * k + 1] * t[3];
+						const double ar = a[2 * k];
+						const double ai = a[2 * k + 1];
+						a[2 * k] = ar + br;
+						a[2 * k + 1] = ai + bi;
+						b[2 * k] = ar - br;
+						b[2 * k + 1] = ai - bi;
+					}
+				}
+			}
+
+			void LinearToDb(const double* input, double* output, int n) {
+				for (int i = 0; i < n; i++) {
+					output[i] = LinearToDbSample(input[i]);
+				}
+			}
+
+			void DbToLinear(const double* input, double* output, int n) {
+				for (int i = 0; i < n; i++) {
+					output[i] = DbToLinearSample(input[i]);
+				}
+			}
+
+			Kernels MakeKernels(Isa isa) {
+				return { isa, Biquad, DotProduct, SumOfSquares, FftButterflies, LinearToDb, DbToLinear };
+			}
+		}
+	}
+}
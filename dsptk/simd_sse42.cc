@@ -0,0 +1,11 @@
+// Kernels compiled for SSE4.2, see the flags of this file in CMakeLists.txt
+#include "simd_kernels.h"
+
+namespace dsptk {
+	namespace simd {
+
+		Kernels GetSse42Kernels() {
+			return MakeKernels(Isa::Sse42);
+		}
+	}
+}
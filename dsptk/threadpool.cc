@@ -0,0 +1,148 @@
+#include "threadpool.h"
+#include <cassert>
+
+#ifdef __linux__
+#include <climits>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
+namespace dsptk {
+
+	namespace {
+		// Rounds of polling before an idle worker sleeps, a few microseconds
+		const int spinCount = 4096;
+
+		// Tells the core the thread is spinning, so it gives its resources to the sibling hyper-thread
+		inline void CpuRelax() {
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+			_mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+			__asm__ __volatile__("yield");
+#else
+			std::this_thread::yield();
+#endif
+		}
+	}
+
+	WorkStealingDeque::WorkStealingDeque(int capacity) {
+		assert(capacity > 0);
+		std::size_t size = 1;
+		while (size < (std::size_t)capacity) size <<= 1;
+		slots.reset(new std::atomic<Task*>[size]);
+		for (std::size_t i = 0; i < size; i++) {
+			slots[i].store(nullptr, std::memory_order_relaxed);
+		}
+		mask = size - 1;
+	}
+
+	void Parker::Wait(std::uint32_t seenEpoch) {
+#ifdef __linux__
+		sleepers.fetch_add(1, std::memory_order_seq_cst);
+		// Returns at once if the epoch moved since seenEpoch was read
+		syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&epoch), FUTEX_WAIT_PRIVATE, seenEpoch, nullptr, nullptr, 0);
+		sleepers.fetch_sub(1, std::memory_order_relaxed);
+#else
+		std::unique_lock<std::mutex> lock(mutex);
+		sleepers.fetch_add(1, std::memory_order_seq_cst);
+		condition.wait(lock, [&]() { return epoch.load(std::memory_order_seq_cst) != seenEpoch; });
+		sleepers.fetch_sub(1, std::memory_order_relaxed);
+#endif
+	}
+
+	void Parker::Notify() {
+		epoch.fetch_add(1, std::memory_order_seq_cst);
+		if (sleepers.load(std::memory_order_seq_cst) == 0) {
+			return;
+		}
+#ifdef __linux__
+		syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&epoch), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#else
+		{
+			// The waiter checks the epoch under the lock, so it either sees the new one or is already waiting
+			std::lock_guard<std::mutex> lock(mutex);
+		}
+		condition.notify_all();
+#endif
+	}
+
+	WorkStealingPool::WorkStealingPool(int numThreads, int queueCapacity) {
+		assert(numThreads >= 1);
+		for (int i = 0; i < numThreads; i++) {
+			queues.push_back(std::make_unique<WorkStealingDeque>(queueCapacity));
+		}
+		for (int i = 1; i < numThreads; i++) {
+			threads.emplace_back(&WorkStealingPool::Work, this, i);
+		}
+	}
+
+	WorkStealingPool::~WorkStealingPool() {
+		stopping.store(true, std::memory_order_seq_cst);
+		parker.Notify();
+		for (auto& thread : threads) {
+			thread.join();
+		}
+	}
+
+	void WorkStealingPool::Push(int worker, Task* task) {
+		if (!queues[worker]->Push(task)) {
+			task->Run(*this, worker);
+			return;
+		}
+		parker.Notify();
+	}
+
+	void WorkStealingPool::Run(Task* const* tasks, int count, const std::atomic<int>& remaining) {
+		for (int i = 0; i < count; i++) {
+			Push(0, tasks[i]);
+		}
+		while (remaining.load(std::memory_order_acquire) > 0) {
+			if (Task* task = FindTask(0)) {
+				task->Run(*this, 0);
+			}
+			else {
+				CpuRelax();
+			}
+		}
+	}
+
+	Task* WorkStealingPool::FindTask(int worker) {
+		if (Task* task = queues[worker]->Pop()) {
+			return task;
+		}
+		const int numQueues = (int)queues.size();
+		for (int i = 1; i < numQueues; i++) {
+			if (Task* task = queues[(worker + i) % numQueues]->Steal()) {
+				return task;
+			}
+		}
+		return nullptr;
+	}
+
+	void WorkStealingPool::Work(int worker) {
+		while (!stopping.load(std::memory_order_acquire)) {
+			Task* task = nullptr;
+			for (int spin = 0; spin < spinCount && task == nullptr; spin++) {
+				task = FindTask(worker);
+				if (task == nullptr) CpuRelax();
+			}
+			if (task == nullptr) {
+				// Pushes after this reading change the epoch, so Wait doesn't sleep through them
+				const std::uint32_t epoch = parker.GetEpoch();
+				task = FindTask(worker);
+				if (task == nullptr) {
+					if (stopping.load(std::memory_order_acquire)) break;
+					parker.Wait(epoch);
+					continue;
+				}
+			}
+			task->Run(*this, worker);
+		}
+	}
+
+}
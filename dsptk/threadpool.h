@@ -0,0 +1,188 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dsptk {
+
+	class WorkStealingPool;
+
+	/**
+	 * @brief A unit of work of a WorkStealingPool. Tasks are owned by the caller (preallocated graph nodes for
+	 * instance), the pool only queues pointers to them.
+	*/
+	class Task {
+	public:
+		virtual ~Task() = default;
+
+		/**
+		 * @brief Runs the task on a worker of the pool; it may queue more tasks with pool.Push(worker, ...).
+		*/
+		virtual void Run(WorkStealingPool& pool, int worker) = 0;
+	};
+
+	/**
+	 * @brief Chase-Lev work stealing deque of fixed capacity (Lê, Pop, Cohen, Zappa Nardelli, PPoPP 2013).
+	 *
+	 * The owner thread pushes and pops at the bottom, any other thread steals from the top; none of them
+	 * locks or allocates. The capacity doesn't grow: Push fails when the deque is full.
+	*/
+	class WorkStealingDeque {
+	public:
+		/**
+		 * @param capacity rounded up to a power of two.
+		*/
+		explicit WorkStealingDeque(int capacity);
+
+		/**
+		 * @brief Queues a task at the bottom, owner only.
+		 * @return false if the deque is full.
+		*/
+		bool Push(Task* task) {
+			const std::int64_t b = bottom.load(std::memory_order_relaxed);
+			const std::int64_t t = top.load(std::memory_order_acquire);
+			if (b - t > (std::int64_t)mask) {
+				return false;
+			}
+			slots[b & mask].store(task, std::memory_order_relaxed);
+			bottom.store(b + 1, std::memory_order_release);
+			return true;
+		}
+
+		/**
+		 * @brief Takes the last queued task, owner only.
+		 * @return nullptr when empty.
+		*/
+		Task* Pop() {
+			const std::int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+			bottom.store(b, std::memory_order_seq_cst);
+			std::int64_t t = top.load(std::memory_order_seq_cst);
+			if (t > b) {
+				bottom.store(b + 1, std::memory_order_relaxed);
+				return nullptr;
+			}
+			Task* task = slots[b & mask].load(std::memory_order_relaxed);
+			if (t == b) {
+				// Last task: a thief may be taking it too, the top decides
+				if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+					task = nullptr;
+				}
+				bottom.store(b + 1, std::memory_order_relaxed);
+			}
+			return task;
+		}
+
+		/**
+		 * @brief Takes the first queued task, any thread.
+		 * @return nullptr when empty or when another thread took it first.
+		*/
+		Task* Steal() {
+			std::int64_t t = top.load(std::memory_order_seq_cst);
+			const std::int64_t b = bottom.load(std::memory_order_seq_cst);
+			if (t >= b) {
+				return nullptr;
+			}
+			Task* task = slots[t & mask].load(std::memory_order_relaxed);
+			if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+				return nullptr;
+			}
+			return task;
+		}
+
+		bool IsEmpty() const {
+			return top.load(std::memory_order_acquire) >= bottom.load(std::memory_order_acquire);
+		}
+
+	private:
+		static constexpr std::size_t cacheLineSize = 64;
+
+		alignas(cacheLineSize) std::atomic<std::int64_t> top{ 0 };
+		alignas(cacheLineSize) std::atomic<std::int64_t> bottom{ 0 };
+		alignas(cacheLineSize) std::unique_ptr<std::atomic<Task*>[]> slots;
+		std::size_t mask;
+	};
+
+	/**
+	 * @brief Wake up of sleeping threads: a futex on Linux, a condition variable elsewhere.
+	 *
+	 * A waiter reads the epoch, checks for work, then sleeps only if the epoch didn't change; Notify bumps
+	 * the epoch and makes the system call only if a thread sleeps. On Linux notifying never blocks (a futex
+	 * wake), the condition variable fallback briefly takes a mutex.
+	*/
+	class Parker {
+	public:
+		std::uint32_t GetEpoch() const { return epoch.load(std::memory_order_seq_cst); }
+
+		/**
+		 * @brief Sleeps until Notify unless it was called since the epoch was read.
+		*/
+		void Wait(std::uint32_t seenEpoch);
+
+		/**
+		 * @brief Wakes up every waiting thread.
+		*/
+		void Notify();
+
+	private:
+		std::atomic<std::uint32_t> epoch{ 0 };
+		std::atomic<int> sleepers{ 0 };
+#ifndef __linux__
+		std::mutex mutex;
+		std::condition_variable condition;
+#endif
+	};
+
+	/**
+	 * @brief Thread pool scheduling Task graphs by work stealing, for block processing.
+	 *
+	 * The thread calling Run is worker 0 and takes part, the pool adds numThreads - 1 threads. Each worker has
+	 * a deque: tasks queued by a task go to the bottom of its worker's deque, so dependent work stays on the
+	 * core that produced its input, and idle workers steal from the top of the others'. Idle workers spin for
+	 * a while (blocks come back at short intervals) then sleep on a Parker; queuing wakes them.
+	 * Nothing allocates after construction.
+	 *
+	 * Only one thread may call Run at a time.
+	*/
+	class WorkStealingPool final {
+	public:
+		/**
+		 * @param numThreads workers including the thread calling Run, at least 1.
+		 * @param queueCapacity tasks each deque holds, more tasks run immediately on the queuing worker.
+		*/
+		explicit WorkStealingPool(int numThreads, int queueCapacity = 4096);
+
+		WorkStealingPool(const WorkStealingPool&) = delete;
+		WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+		~WorkStealingPool();
+
+		int GetNumThreads() const { return (int)queues.size(); }
+
+		/**
+		 * @brief Queues a task from a task running on worker, waking idle workers.
+		*/
+		void Push(int worker, Task* task);
+
+		/**
+		 * @brief Queues tasks and works with the pool until remaining is zero.
+		 * @param tasks the tasks ready to run, the rest is queued by them.
+		 * @param remaining decremented (with release order) by the tasks as they complete.
+		*/
+		void Run(Task* const* tasks, int count, const std::atomic<int>& remaining);
+
+	private:
+		Task* FindTask(int worker);
+		void Work(int worker);
+
+		std::vector<std::unique_ptr<WorkStealingDeque>> queues;
+		std::vector<std::thread> threads;
+		Parker parker;
+		std::atomic<bool> stopping{ false };
+	};
+
+}
@@ -0,0 +1,209 @@
+#include "tracing.h"
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace dsptk {
+	namespace tracing {
+
+		namespace {
+
+			struct Event {
+				std::atomic<const char*> name{ nullptr };
+				std::atomic<std::int64_t> arg{ -1 };
+				std::atomic<std::int64_t> begin{ 0 };
+				std::atomic<std::int64_t> end{ 0 };
+			};
+
+			/*
+			* Single writer ring: the owner thread stores the event and then publishes the new head.
+			* Readers copy the events below head and drop the ones the writer may have overwritten meanwhile.
+			* A spare slot keeps the last capacity events readable while the next one is being written.
+			*/
+			struct ThreadBuffer {
+				ThreadBuffer(std::size_t capacity, int id)
+					: events(new Event[capacity + 1])
+					, capacity(capacity)
+					, id(id) {}
+
+				std::unique_ptr<Event[]> events;
+				const std::size_t capacity;
+				const int id;
+				std::string name;
+				std::atomic<std::uint64_t> head{ 0 };
+				// Events before it were discarded by Clear
+				std::atomic<std::uint64_t> start{ 0 };
+			};
+
+			struct Registry {
+				std::mutex mutex;
+				// Buffers outlive their threads so their events can still be written
+				std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+				std::size_t capacity = 1 << 16;
+				const std::int64_t origin = Now();
+			};
+
+			Registry& GetRegistry() {
+				static Registry registry;
+				return registry;
+			}
+
+			thread_local ThreadBuffer* threadBuffer = nullptr;
+
+			ThreadBuffer& GetThreadBuffer() {
+				if (!threadBuffer) {
+					Registry& registry = GetRegistry();
+					std::lock_guard<std::mutex> lock(registry.mutex);
+					registry.buffers.push_back(std::make_unique<ThreadBuffer>(registry.capacity, (int)registry.buffers.size() + 1));
+					threadBuffer = registry.buffers.back().get();
+				}
+				return *threadBuffer;
+			}
+
+			// Characters of the names are written as is but quotes and backslashes
+			void WriteString(std::ostream& stream, const char* text) {
+				stream << '"';
+				for (const char* c = text; *c; c++) {
+					if (*c == '"' || *c == '\\') {
+						stream << '\\';
+					}
+					if ((unsigned char)*c >= 0x20) {
+						stream << *c;
+					}
+				}
+				stream << '"';
+			}
+
+			// Microseconds with nanosecond decimals
+			void WriteMicroseconds(std::ostream& stream, std::int64_t ns) {
+				if (ns < 0) {
+					stream << '-';
+					ns = -ns;
+				}
+				const std::int64_t decimals = ns % 1000;
+				stream << ns / 1000 << '.' << (char)('0' + decimals / 100) << (char)('0' + decimals / 10 % 10) << (char)('0' + decimals % 10);
+			}
+		}
+
+		namespace detail {
+			std::atomic<bool> enabled{ false };
+
+			void Record(const char* name, std::int64_t arg, std::int64_t begin, std::int64_t end) {
+				ThreadBuffer& buffer = GetThreadBuffer();
+				const std::uint64_t head = buffer.head.load(std::memory_order_relaxed);
+				Event& event = buffer.events[head % (buffer.capacity + 1)];
+				event.name.store(name, std::memory_order_relaxed);
+				event.arg.store(arg, std::memory_order_relaxed);
+				event.begin.store(begin, std::memory_order_relaxed);
+				event.end.store(end, std::memory_order_relaxed);
+				buffer.head.store(head + 1, std::memory_order_release);
+			}
+		}
+
+		void Enable() {
+			GetRegistry();
+			detail::enabled.store(true, std::memory_order_relaxed);
+		}
+
+		void Disable() {
+			detail::enabled.store(false, std::memory_order_relaxed);
+		}
+
+		void Clear() {
+			Registry& registry = GetRegistry();
+			std::lock_guard<std::mutex> lock(registry.mutex);
+			for (auto& buffer : registry.buffers) {
+				buffer->start.store(buffer->head.load(std::memory_order_acquire), std::memory_order_relaxed);
+			}
+		}
+
+		void SetBufferCapacity(std::size_t events) {
+			Registry& registry = GetRegistry();
+			std::lock_guard<std::mutex> lock(registry.mutex);
+			registry.capacity = std::max<std::size_t>(events, 1);
+		}
+
+		void RegisterThread(const char* name) {
+			ThreadBuffer& buffer = GetThreadBuffer();
+			if (name) {
+				std::lock_guard<std::mutex> lock(GetRegistry().mutex);
+				buffer.name = name;
+			}
+		}
+
+		void WriteChromeTrace(std::ostream& stream) {
+			struct Copy {
+				const char* name;
+				std::int64_t arg;
+				std::int64_t begin;
+				std::int64_t end;
+			};
+
+			Registry& registry = GetRegistry();
+			std::lock_guard<std::mutex> lock(registry.mutex);
+
+			stream << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+			bool first = true;
+			auto separator = [&] {
+				if (!first) {
+					stream << ",\n";
+				}
+				first = false;
+			};
+
+			std::vector<Copy> copies;
+			for (auto& buffer : registry.buffers) {
+				if (!buffer->name.empty()) {
+					separator();
+					stream << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << buffer->id << ",\"args\":{\"name\":";
+					WriteString(stream, buffer->name.c_str());
+					stream << "}}";
+				}
+
+				const std::uint64_t head = buffer->head.load(std::memory_order_acquire);
+				std::uint64_t oldest = std::max(buffer->start.load(std::memory_order_relaxed), head > buffer->capacity ? head - buffer->capacity : 0);
+				copies.clear();
+				for (std::uint64_t i = oldest; i < head; i++) {
+					const Event& event = buffer->events[i % (buffer->capacity + 1)];
+					copies.push_back({
+						event.name.load(std::memory_order_relaxed),
+						event.arg.load(std::memory_order_relaxed),
+						event.begin.load(std::memory_order_relaxed),
+						event.end.load(std::memory_order_relaxed) });
+				}
+				// Events written while copying may have replaced the oldest ones, the one being written included
+				std::atomic_thread_fence(std::memory_order_acquire);
+				const std::uint64_t newHead = buffer->head.load(std::memory_order_relaxed);
+				const std::uint64_t overwritten = newHead > buffer->capacity ? newHead - buffer->capacity : 0;
+				const std::size_t skip = (std::size_t)std::min<std::uint64_t>(copies.size(), overwritten > oldest ? overwritten - oldest : 0);
+
+				for (std::size_t i = skip; i < copies.size(); i++) {
+					const Copy& event = copies[i];
+					separator();
+					stream << "{\"ph\":\"X\",\"cat\":\"dsptk\",\"name\":";
+					WriteString(stream, event.name);
+					stream << ",\"pid\":1,\"tid\":" << buffer->id << ",\"ts\":";
+					WriteMicroseconds(stream, event.begin - registry.origin);
+					stream << ",\"dur\":";
+					WriteMicroseconds(stream, event.end - event.begin);
+					if (event.arg >= 0) {
+						stream << ",\"args\":{\"arg\":" << event.arg << "}";
+					}
+					stream << "}";
+				}
+			}
+			stream << "]}\n";
+		}
+
+		bool WriteChromeTrace(const std::string& path) {
+			std::ofstream file(path);
+			if (!file) {
+				return false;
+			}
+			WriteChromeTrace(file);
+			return (bool)file;
+		}
+	}
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#define DSPTK_TRACE_CONCAT_IMPL(a, b) a##b
+#define DSPTK_TRACE_CONCAT(a, b) DSPTK_TRACE_CONCAT_IMPL(a, b)
+
+/**
+ * @brief Traces the enclosing scope as a timeline event, name must be a string literal.
+ * An optional integer argument (a filter index, a transform size...) is shown with the event.
+*/
+#define DSPTK_TRACE_SCOPE(...) \
+	::dsptk::tracing::Scope DSPTK_TRACE_CONCAT(dsptkTraceScope, __LINE__)(__VA_ARGS__)
+
+namespace dsptk {
+	namespace tracing {
+
+		namespace detail {
+			extern std::atomic<bool> enabled;
+
+			/**
+			 * @brief Appends a complete event to the ring buffer of the calling thread.
+			*/
+			void Record(const char* name, std::int64_t arg, std::int64_t begin, std::int64_t end);
+		}
+
+		/**
+		 * @brief Whether events are being recorded, false by default.
+		*/
+		inline bool IsEnabled() {
+			return detail::enabled.load(std::memory_order_relaxed);
+		}
+
+		/**
+		 * @brief Starts recording events.
+		*/
+		void Enable();
+
+		/**
+		 * @brief Stops recording events, the recorded ones are kept until Clear.
+		*/
+		void Disable();
+
+		/**
+		 * @brief Discards the recorded events of every thread.
+		*/
+		void Clear();
+
+		/**
+		 * @brief Number of events kept per thread, older ones are overwritten.
+		 * Applies to the threads that record their first event afterwards.
+		*/
+		void SetBufferCapacity(std::size_t events);
+
+		/**
+		 * @brief Allocates the ring buffer of the calling thread and names it in the trace.
+		 * Otherwise the buffer is allocated by the first event of the thread: call it before
+		 * entering a real time context.
+		 * @param name the thread name shown by the trace viewers, nullptr to keep the default.
+		*/
+		void RegisterThread(const char* name = nullptr);
+
+		/**
+		 * @brief Writes the recorded events in the Chrome trace event JSON format
+		 * (chrome://tracing, ui.perfetto.dev). Can be called while other threads record.
+		*/
+		void WriteChromeTrace(std::ostream& stream);
+
+		/**
+		 * @copydoc WriteChromeTrace(std::ostream&)
+		 * @return false if the file can't be written.
+		*/
+		bool WriteChromeTrace(const std::string& path);
+
+		/**
+		 * @brief Timestamp of the events, steady_clock nanoseconds.
+		*/
+		inline std::int64_t Now() {
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+
+		/**
+		 * @brief Records its lifetime as an event when tracing is enabled at construction.
+		*/
+		class Scope {
+		public:
+			explicit Scope(const char* name, std::int64_t arg = -1)
+				: name(name), arg(arg), begin(IsEnabled() ? Now() : 0) {}
+
+			~Scope() {
+				if (begin != 0) {
+					detail::Record(name, arg, begin, Now());
+				}
+			}
+
+			Scope(const Scope&) = delete;
+			Scope& operator=(const Scope&) = delete;
+
+		private:
+			const char* name;
+			std::int64_t arg;
+			std::int64_t begin;
+		};
+	}
+}
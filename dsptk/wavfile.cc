@@ -0,0 +1,496 @@
+#include "wavfile.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <utility>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace dsptk {
+
+	namespace {
+
+		// RIFF sizes are 32 bits, larger ones are in the ds64 chunk of RF64 files
+		constexpr std::uint64_t riffLimit = 0xFFFFFFFFu;
+		// ds64 chunk without table: RIFF size, data size and sample count (64 bits each), table length
+		constexpr std::uint32_t ds64Bytes = 28;
+
+		constexpr std::uint16_t tagPcm = 1;
+		constexpr std::uint16_t tagFloat = 3;
+		constexpr std::uint16_t tagExtensible = 0xFFFE;
+		// Sub format GUID of WAVE_FORMAT_EXTENSIBLE after the 2 bytes of the format tag
+		constexpr unsigned char guidTail[14] = { 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71 };
+
+		std::uint16_t Get16(const unsigned char* p) {
+			return (std::uint16_t)(p[0] | p[1] << 8);
+		}
+
+		std::uint32_t Get32(const unsigned char* p) {
+			return (std::uint32_t)p[0] | (std::uint32_t)p[1] << 8 | (std::uint32_t)p[2] << 16 | (std::uint32_t)p[3] << 24;
+		}
+
+		std::uint64_t Get64(const unsigned char* p) {
+			return (std::uint64_t)Get32(p) | (std::uint64_t)Get32(p + 4) << 32;
+		}
+
+		bool IsId(const unsigned char* p, const char* id) {
+			return std::memcmp(p, id, 4) == 0;
+		}
+
+		void PutId(std::vector<unsigned char>& header, const char* id) {
+			header.insert(header.end(), id, id + 4);
+		}
+
+		void Put16(std::vector<unsigned char>& header, std::uint32_t value) {
+			header.push_back((unsigned char)value);
+			header.push_back((unsigned char)(value >> 8));
+		}
+
+		void Put32(std::vector<unsigned char>& header, std::uint32_t value) {
+			Put16(header, value);
+			Put16(header, value >> 16);
+		}
+
+		void Put64(std::vector<unsigned char>& header, std::uint64_t value) {
+			Put32(header, (std::uint32_t)value);
+			Put32(header, (std::uint32_t)(value >> 32));
+		}
+
+		bool ParseFmt(const unsigned char* body, std::uint64_t size, WavFormat& format) {
+			if (size < 16) {
+				return false;
+			}
+			std::uint16_t tag = Get16(body);
+			const int numChannels = Get16(body + 2);
+			const int blockAlign = Get16(body + 12);
+			const int bits = Get16(body + 14);
+			if (tag == tagExtensible) {
+				if (size < 40) {
+					return false;
+				}
+				tag = Get16(body + 24);
+			}
+
+			if (tag == tagPcm && bits == 16) {
+				format.format = SampleFormat::Int16;
+			}
+			else if (tag == tagPcm && bits == 24) {
+				format.format = SampleFormat::Int24;
+			}
+			else if (tag == tagPcm && bits == 32) {
+				format.format = SampleFormat::Int32;
+			}
+			else if (tag == tagFloat && bits == 32) {
+				format.format = SampleFormat::Float32;
+			}
+			else {
+				return false;
+			}
+			format.numChannels = numChannels;
+			format.sampleRate = (int)Get32(body + 4);
+			return numChannels > 0 && blockAlign == format.GetFrameBytes();
+		}
+
+		const unsigned char* MapFile(const std::string& path, std::uint64_t& size) {
+#ifdef _WIN32
+			HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+			if (file == INVALID_HANDLE_VALUE) {
+				return nullptr;
+			}
+			LARGE_INTEGER fileSize;
+			void* view = nullptr;
+			if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0) {
+				// The view keeps the mapping alive once the handles are closed
+				HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+				if (mapping) {
+					view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+					CloseHandle(mapping);
+				}
+				size = (std::uint64_t)fileSize.QuadPart;
+			}
+			CloseHandle(file);
+			return static_cast<const unsigned char*>(view);
+#else
+			const int file = ::open(path.c_str(), O_RDONLY);
+			if (file < 0) {
+				return nullptr;
+			}
+			struct stat status;
+			void* view = MAP_FAILED;
+			if (fstat(file, &status) == 0 && status.st_size > 0) {
+				size = (std::uint64_t)status.st_size;
+				view = mmap(nullptr, (std::size_t)size, PROT_READ, MAP_PRIVATE, file, 0);
+				if (view != MAP_FAILED) {
+					madvise(view, (std::size_t)size, MADV_SEQUENTIAL);
+				}
+			}
+			::close(file);
+			return view == MAP_FAILED ? nullptr : static_cast<const unsigned char*>(view);
+#endif
+		}
+
+		void UnmapFile(const unsigned char* mapping, std::uint64_t size) {
+#ifdef _WIN32
+			(void)size;
+			UnmapViewOfFile(mapping);
+#else
+			munmap(const_cast<unsigned char*>(mapping), (std::size_t)size);
+#endif
+		}
+
+		bool SeekFile(std::FILE* file, std::int64_t offset) {
+#ifdef _WIN32
+			return _fseeki64(file, offset, SEEK_SET) == 0;
+#else
+			return fseeko(file, (off_t)offset, SEEK_SET) == 0;
+#endif
+		}
+
+		bool TruncateFile(std::FILE* file, std::int64_t size) {
+#ifdef _WIN32
+			return _chsize_s(_fileno(file), size) == 0;
+#else
+			return ftruncate(fileno(file), (off_t)size) == 0;
+#endif
+		}
+
+		// Best effort: file systems without preallocation just allocate on write
+		void AllocateFile(std::FILE* file, std::int64_t offset, std::int64_t bytes) {
+#if defined(_WIN32)
+			FILE_ALLOCATION_INFO allocation;
+			allocation.AllocationSize.QuadPart = offset + bytes;
+			SetFileInformationByHandle((HANDLE)_get_osfhandle(_fileno(file)), FileAllocationInfo, &allocation, sizeof(allocation));
+#elif defined(__linux__)
+			posix_fallocate(fileno(file), (off_t)offset, (off_t)bytes);
+#else
+			(void)file;
+			(void)offset;
+			(void)bytes;
+#endif
+		}
+	}
+
+	WavReader::WavReader(WavReader&& other) noexcept
+	{
+		*this = std::move(other);
+	}
+
+	WavReader& WavReader::operator=(WavReader&& other) noexcept
+	{
+		if (this != &other) {
+			Close();
+			mapping = std::exchange(other.mapping, nullptr);
+			mappingSize = std::exchange(other.mappingSize, 0);
+			samples = std::exchange(other.samples, nullptr);
+			numFrames = std::exchange(other.numFrames, 0);
+			format = other.format;
+			rf64 = other.rf64;
+		}
+		return *this;
+	}
+
+	bool WavReader::Open(const std::string& path)
+	{
+		Close();
+		mapping = MapFile(path, mappingSize);
+		if (mapping && !Parse()) {
+			Close();
+		}
+		return IsOpen();
+	}
+
+	void WavReader::Close()
+	{
+		if (mapping) {
+			UnmapFile(mapping, mappingSize);
+		}
+		mapping = nullptr;
+		mappingSize = 0;
+		samples = nullptr;
+		numFrames = 0;
+		format = WavFormat();
+		rf64 = false;
+	}
+
+	bool WavReader::Parse()
+	{
+		const unsigned char* file = mapping;
+		const std::uint64_t size = mappingSize;
+		if (size < 12 || !IsId(file + 8, "WAVE")) {
+			return false;
+		}
+		rf64 = IsId(file, "RF64") || IsId(file, "BW64");
+		if (!rf64 && !IsId(file, "RIFF")) {
+			return false;
+		}
+
+		std::uint64_t ds64DataSize = 0;
+		bool hasDs64 = false;
+		bool hasFmt = false;
+		// Chunks are word aligned, the data is after the fmt chunk and the ds64 chunk first
+		for (std::uint64_t position = 12; position + 8 <= size;) {
+			const unsigned char* chunk = file + position;
+			const std::uint64_t chunkSize = Get32(chunk + 4);
+			const std::uint64_t available = std::min(chunkSize, size - position - 8);
+
+			if (IsId(chunk, "ds64") && available >= 24) {
+				ds64DataSize = Get64(chunk + 16);
+				hasDs64 = true;
+			}
+			else if (IsId(chunk, "fmt ")) {
+				if (!ParseFmt(chunk + 8, available, format)) {
+					return false;
+				}
+				hasFmt = true;
+			}
+			else if (IsId(chunk, "data")) {
+				if (!hasFmt) {
+					return false;
+				}
+				std::uint64_t dataSize = available;
+				if (rf64 && chunkSize == riffLimit) {
+					if (!hasDs64) {
+						return false;
+					}
+					// Truncated recordings keep the frames that made it to disk
+					dataSize = std::min(ds64DataSize, size - position - 8);
+				}
+				samples = chunk + 8;
+				numFrames = (std::int64_t)(dataSize / format.GetFrameBytes());
+				return true;
+			}
+			position += 8 + chunkSize + (chunkSize & 1);
+		}
+		return false;
+	}
+
+	template <typename T>
+	int WavReader::ReadFrames(std::int64_t start, BufferView<T> output) const
+	{
+		assert(output.GetNumChannels() == format.numChannels);
+		if (start < 0 || start >= numFrames) {
+			return 0;
+		}
+		const int nFrames = (int)std::min<std::int64_t>(output.GetNumFrames(), numFrames - start);
+		const int frameBytes = format.GetFrameBytes();
+		const auto* frames = static_cast<const unsigned char*>(GetFrames(start));
+
+		const std::size_t alignment = format.format == SampleFormat::Int24 ? 1 : (std::size_t)BytesPerSample(format.format);
+		if (reinterpret_cast<std::uintptr_t>(frames) % alignment == 0) {
+			Deinterleave(frames, format.format, output.SubBlock(0, nFrames));
+		}
+		else {
+			// Samples misaligned by the chunks before them: copied to aligned memory first
+			const int blockFrames = std::max(1, (1 << 16) / frameBytes);
+			std::vector<std::uint32_t> block(((std::size_t)blockFrames * frameBytes + 3) / 4);
+			for (int done = 0; done < nFrames;) {
+				const int n = std::min(blockFrames, nFrames - done);
+				std::memcpy(block.data(), frames + (std::size_t)done * frameBytes, (std::size_t)n * frameBytes);
+				Deinterleave(block.data(), format.format, output.SubBlock(done, n));
+				done += n;
+			}
+		}
+		return nFrames;
+	}
+
+	int WavReader::Read(std::int64_t start, BufferView<double> output) const
+	{
+		return ReadFrames(start, output);
+	}
+
+	int WavReader::Read(std::int64_t start, BufferView<float> output) const
+	{
+		return ReadFrames(start, output);
+	}
+
+	bool WavWriter::Open(const std::string& path, const WavFormat& format, bool forceRf64, std::int64_t expectedFrames)
+	{
+		Close();
+		if (format.numChannels < 1 || format.numChannels > 0xFFFF || format.sampleRate <= 0) {
+			return false;
+		}
+		file = std::fopen(path.c_str(), "wb");
+		if (!file) {
+			return false;
+		}
+		// Only whole chunks are written, stdio buffering would just copy them
+		std::setvbuf(file, nullptr, _IONBF, 0);
+
+		this->format = format;
+		this->forceRf64 = forceRf64;
+		failed = false;
+		numFrames = 0;
+		bufferedFrames = 0;
+		chunkFrames = std::max(1, chunkBytes / format.GetFrameBytes());
+		chunk.assign((std::size_t)chunkFrames * format.GetFrameBytes(), 0);
+
+		const auto header = Header(false);
+		headerBytes = (std::int64_t)header.size();
+		allocatedBytes = 0;
+		if (expectedFrames > 0) {
+			Preallocate(headerBytes + expectedFrames * format.GetFrameBytes());
+		}
+		failed = std::fwrite(header.data(), 1, header.size(), file) != header.size();
+		writtenBytes = headerBytes;
+		return !failed;
+	}
+
+	template <typename T>
+	bool WavWriter::WriteFrames(BufferView<const T> input, TpdfDither* dither)
+	{
+		if (!file) {
+			return false;
+		}
+		assert(input.GetNumChannels() == format.numChannels);
+		const int frameBytes = format.GetFrameBytes();
+		for (int done = 0; done < input.GetNumFrames();) {
+			const int n = std::min(chunkFrames - bufferedFrames, input.GetNumFrames() - done);
+			Interleave(input.SubBlock(done, n), chunk.data() + (std::size_t)bufferedFrames * frameBytes, format.format, dither);
+			bufferedFrames += n;
+			numFrames += n;
+			done += n;
+			if (bufferedFrames == chunkFrames) {
+				Flush();
+			}
+		}
+		return !failed;
+	}
+
+	bool WavWriter::Write(BufferView<const double> input, TpdfDither* dither)
+	{
+		return WriteFrames(input, dither);
+	}
+
+	bool WavWriter::Write(BufferView<const float> input, TpdfDither* dither)
+	{
+		return WriteFrames(input, dither);
+	}
+
+	bool WavWriter::WriteInterleaved(const void* frames, std::int64_t nFrames)
+	{
+		if (!file) {
+			return false;
+		}
+		const int frameBytes = format.GetFrameBytes();
+		const auto* input = static_cast<const unsigned char*>(frames);
+		for (std::int64_t done = 0; done < nFrames;) {
+			const int n = (int)std::min<std::int64_t>(chunkFrames - bufferedFrames, nFrames - done);
+			std::memcpy(chunk.data() + (std::size_t)bufferedFrames * frameBytes, input + done * frameBytes, (std::size_t)n * frameBytes);
+			bufferedFrames += n;
+			numFrames += n;
+			done += n;
+			if (bufferedFrames == chunkFrames) {
+				Flush();
+			}
+		}
+		return !failed;
+	}
+
+	bool WavWriter::Flush()
+	{
+		if (bufferedFrames > 0) {
+			const std::size_t bytes = (std::size_t)bufferedFrames * format.GetFrameBytes();
+			if (writtenBytes + (std::int64_t)bytes > allocatedBytes) {
+				Preallocate(writtenBytes + (std::int64_t)bytes + preallocationBytes);
+			}
+			failed |= std::fwrite(chunk.data(), 1, bytes, file) != bytes;
+			writtenBytes += (std::int64_t)bytes;
+			bufferedFrames = 0;
+		}
+		return !failed;
+	}
+
+	void WavWriter::Preallocate(std::int64_t bytes)
+	{
+		if (bytes > allocatedBytes) {
+			AllocateFile(file, allocatedBytes, bytes - allocatedBytes);
+			allocatedBytes = bytes;
+		}
+	}
+
+	bool WavWriter::Close()
+	{
+		if (!file) {
+			return false;
+		}
+		Flush();
+		const std::int64_t dataBytes = numFrames * format.GetFrameBytes();
+		if (dataBytes & 1) {
+			// Chunks are word aligned
+			const unsigned char pad = 0;
+			failed |= std::fwrite(&pad, 1, 1, file) != 1;
+		}
+		const std::int64_t fileBytes = headerBytes + dataBytes + (dataBytes & 1);
+		const bool asRf64 = forceRf64 || (std::uint64_t)(fileBytes - 8) > riffLimit;
+
+		const auto header = Header(asRf64);
+		failed |= !SeekFile(file, 0) || std::fwrite(header.data(), 1, header.size(), file) != header.size();
+		// Drops the space preallocated past the end
+		failed |= !TruncateFile(file, fileBytes);
+		failed |= std::fclose(file) != 0;
+		file = nullptr;
+		chunk = std::vector<unsigned char>();
+		return !failed;
+	}
+
+	std::vector<unsigned char> WavWriter::Header(bool asRf64) const
+	{
+		const int sampleBytes = BytesPerSample(format.format);
+		const bool isFloat = format.format == SampleFormat::Float32;
+		const bool extensible = format.numChannels > 2 || (!isFloat && sampleBytes > 2);
+		const std::uint32_t fmtBytes = extensible ? 40 : 16;
+		const std::uint64_t dataBytes = (std::uint64_t)numFrames * format.GetFrameBytes();
+		const std::uint64_t riffBytes = 4 + (8 + ds64Bytes) + (8 + fmtBytes) + 8 + dataBytes + (dataBytes & 1);
+
+		std::vector<unsigned char> header;
+		PutId(header, asRf64 ? "RF64" : "RIFF");
+		Put32(header, asRf64 ? (std::uint32_t)riffLimit : (std::uint32_t)riffBytes);
+		PutId(header, "WAVE");
+
+		// Same size either way so the data doesn't move when a file becomes RF64
+		PutId(header, asRf64 ? "ds64" : "JUNK");
+		Put32(header, ds64Bytes);
+		if (asRf64) {
+			Put64(header, riffBytes);
+			Put64(header, dataBytes);
+			Put64(header, (std::uint64_t)numFrames);
+			Put32(header, 0);
+		}
+		else {
+			header.insert(header.end(), ds64Bytes, 0);
+		}
+
+		const std::uint16_t tag = isFloat ? tagFloat : tagPcm;
+		PutId(header, "fmt ");
+		Put32(header, fmtBytes);
+		Put16(header, extensible ? tagExtensible : tag);
+		Put16(header, (std::uint32_t)format.numChannels);
+		Put32(header, (std::uint32_t)format.sampleRate);
+		Put32(header, (std::uint32_t)format.sampleRate * (std::uint32_t)format.GetFrameBytes());
+		Put16(header, (std::uint32_t)format.GetFrameBytes());
+		Put16(header, (std::uint32_t)sampleBytes * 8);
+		if (extensible) {
+			Put16(header, 22);
+			Put16(header, (std::uint32_t)sampleBytes * 8);
+			// No speaker assignment
+			Put32(header, 0);
+			Put16(header, tag);
+			header.insert(header.end(), std::begin(guidTail), std::end(guidTail));
+		}
+
+		PutId(header, "data");
+		Put32(header, asRf64 ? (std::uint32_t)riffLimit : (std::uint32_t)dataBytes);
+		return header;
+	}
+
+}
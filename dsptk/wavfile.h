@@ -0,0 +1,193 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "audiobuffer.h"
+#include "conversion.h"
+
+namespace dsptk {
+
+	/**
+	 * @brief Sample layout of a WAV file.
+	*/
+	struct WavFormat {
+		SampleFormat format = SampleFormat::Int16;
+		int numChannels = 1;
+		int sampleRate = 48000;
+
+		/** Bytes of an interleaved frame. */
+		int GetFrameBytes() const { return numChannels * BytesPerSample(format); }
+	};
+
+	/**
+	 * @brief WAV and RF64 (EBU Tech 3306, BW64) reader mapping the file in memory.
+	 *
+	 * Nothing is read at open beyond the headers: the samples are paged in by the OS as they are accessed
+	 * (the mapping is advised as sequential), so files of any size, past 4GB included, stream through a
+	 * processing chain block by block without being copied to memory first. Read converts a frame range
+	 * straight from the mapping into the caller's planar block, GetFrames gives the interleaved frames
+	 * themselves.
+	 *
+	 * Supports 16, 24 and 32 bits integer and 32 bits float PCM, plain or WAVE_FORMAT_EXTENSIBLE, on little
+	 * endian hosts. 64-bit builds are needed for files larger than the address space of 32-bit ones.
+	*/
+	class WavReader final {
+	public:
+		WavReader() = default;
+
+		/**
+		 * @brief Opens a file, see Open.
+		*/
+		explicit WavReader(const std::string& path) { Open(path); }
+
+		WavReader(WavReader&& other) noexcept;
+		WavReader& operator=(WavReader&& other) noexcept;
+		WavReader(const WavReader&) = delete;
+		WavReader& operator=(const WavReader&) = delete;
+
+		~WavReader() { Close(); }
+
+		/**
+		 * @brief Maps a file and parses its headers.
+		 * @return false if the file can't be mapped, isn't a WAV/RF64 file or has an unsupported format.
+		*/
+		bool Open(const std::string& path);
+
+		/**
+		 * @brief Unmaps the file, pointers given by GetFrames become invalid.
+		*/
+		void Close();
+
+		bool IsOpen() const { return mapping != nullptr; }
+
+		/**
+		 * @brief True for RF64 and BW64 files, their sizes come from the ds64 chunk.
+		*/
+		bool IsRf64() const { return rf64; }
+
+		const WavFormat& GetFormat() const { return format; }
+
+		std::int64_t GetNumFrames() const { return numFrames; }
+
+		/**
+		 * @brief Interleaved frames from a frame on, in the mapping (zero copy).
+		 *
+		 * They're aligned to the sample type unless the file was written with odd sized chunks before
+		 * the data, Read handles both.
+		*/
+		const void* GetFrames(std::int64_t start) const { return samples + start * format.GetFrameBytes(); }
+
+		/**
+		 * @brief Converts frames to planar samples.
+		 * @param start first frame to read.
+		 * @param output receives up to output.GetNumFrames() frames, it must have the channels of the file.
+		 * @return the frames read, fewer than requested at the end of the file (the rest of output is untouched).
+		*/
+		int Read(std::int64_t start, BufferView<double> output) const;
+
+		/**
+		 * @copydoc Read(std::int64_t, BufferView<double>) const
+		*/
+		int Read(std::int64_t start, BufferView<float> output) const;
+
+	private:
+		template <typename T>
+		int ReadFrames(std::int64_t start, BufferView<T> output) const;
+
+		bool Parse();
+
+		const unsigned char* mapping = nullptr;
+		std::uint64_t mappingSize = 0;
+		const unsigned char* samples = nullptr;
+		std::int64_t numFrames = 0;
+		WavFormat format;
+		bool rf64 = false;
+	};
+
+	/**
+	 * @brief WAV writer switching to RF64 when the file outgrows the 4GB of RIFF.
+	 *
+	 * The header reserves room for a ds64 chunk with a JUNK chunk, which Close turns into ds64 (and the
+	 * file into RF64) if the data doesn't fit in RIFF sizes, so plain WAV readers get a plain WAV file
+	 * whenever possible. Frames are interleaved into a chunk buffer written to the file sequentially when
+	 * full, in space preallocated ahead of the writes so large files don't fragment; Close trims the file
+	 * to its final size.
+	 *
+	 * Files with more than 2 channels or integers of more than 16 bits are written as WAVE_FORMAT_EXTENSIBLE.
+	*/
+	class WavWriter final {
+	public:
+		/** Size of the chunks written to the file. */
+		static constexpr int chunkBytes = 1 << 20;
+		/** File space allocated at once ahead of the writes. */
+		static constexpr std::int64_t preallocationBytes = std::int64_t(64) << 20;
+
+		WavWriter() = default;
+		WavWriter(const WavWriter&) = delete;
+		WavWriter& operator=(const WavWriter&) = delete;
+
+		/**
+		 * @brief Closes the file if still open, errors are lost: call Close to know about them.
+		*/
+		~WavWriter() { Close(); }
+
+		/**
+		 * @brief Creates (or truncates) a file and writes its header.
+		 * @param forceRf64 writes RF64 whatever the size.
+		 * @param expectedFrames frames to preallocate space for at once, 0 if unknown.
+		 * @return false if the file can't be created or the format is invalid.
+		*/
+		bool Open(const std::string& path, const WavFormat& format, bool forceRf64 = false, std::int64_t expectedFrames = 0);
+
+		/**
+		 * @brief Appends planar frames, converted to the format of the file.
+		 * @param input frames with the channels of the file.
+		 * @param dither dither for integer formats, nullptr for none.
+		 * @return false on write errors.
+		*/
+		bool Write(BufferView<const double> input, TpdfDither* dither = nullptr);
+
+		/**
+		 * @copydoc Write(BufferView<const double>, TpdfDither*)
+		*/
+		bool Write(BufferView<const float> input, TpdfDither* dither = nullptr);
+
+		/**
+		 * @brief Appends frames already interleaved in the format of the file.
+		*/
+		bool WriteInterleaved(const void* frames, std::int64_t nFrames);
+
+		/**
+		 * @brief Writes the buffered frames, completes the header and closes the file.
+		 * @return false if any write failed since Open.
+		*/
+		bool Close();
+
+		bool IsOpen() const { return file != nullptr; }
+
+		std::int64_t GetNumFrames() const { return numFrames; }
+
+	private:
+		template <typename T>
+		bool WriteFrames(BufferView<const T> input, TpdfDither* dither);
+
+		bool Flush();
+		void Preallocate(std::int64_t bytes);
+		std::vector<unsigned char> Header(bool asRf64) const;
+
+		std::FILE* file = nullptr;
+		WavFormat format;
+		bool forceRf64 = false;
+		bool failed = false;
+		std::vector<unsigned char> chunk;
+		int chunkFrames = 0;
+		int bufferedFrames = 0;
+		std::int64_t numFrames = 0;
+		std::int64_t headerBytes = 0;
+		std::int64_t writtenBytes = 0;
+		std::int64_t allocatedBytes = 0;
+	};
+
+}
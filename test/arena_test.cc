@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <cstdint>
+#include <vector>
+#include "dsptk/arena.h"
+#include "dsptk/dynamics.h"
+#include "dsptk/signals.h"
+
+namespace arena {
+
+	bool IsAligned(const void* pointer) {
+		return reinterpret_cast<std::uintptr_t>(pointer) % dsptk::ScratchArena::alignment == 0;
+	}
+
+	namespace scratch {
+
+		TEST(ScratchArena, AllocationsAreAlignedAndConsecutive) {
+			dsptk::ScratchArena sut(1024);
+
+			double* first = sut.Allocate<double>(3);
+			float* second = sut.Allocate<float>(20);
+
+			EXPECT_TRUE(IsAligned(first));
+			EXPECT_TRUE(IsAligned(second));
+			EXPECT_EQ(reinterpret_cast<unsigned char*>(second) - reinterpret_cast<unsigned char*>(first), 64);
+			EXPECT_EQ(sut.GetStats().used, 64 + 128);
+			EXPECT_EQ(sut.GetAvailable(), 1024 - 192);
+		}
+
+		TEST(ScratchArena, BytesForRoundsToAlignment) {
+			EXPECT_EQ(dsptk::ScratchArena::BytesFor<double>(0), 0);
+			EXPECT_EQ(dsptk::ScratchArena::BytesFor<double>(1), 64);
+			EXPECT_EQ(dsptk::ScratchArena::BytesFor<double>(8), 64);
+			EXPECT_EQ(dsptk::ScratchArena::BytesFor<double>(9), 128);
+		}
+
+		TEST(ScratchArena, ScopeGivesMemoryBack) {
+			dsptk::ScratchArena sut(1024);
+			sut.Allocate<double>(8);
+
+			const double* inner;
+			{
+				dsptk::ScratchScope scope(sut);
+				inner = sut.Allocate<double>(32);
+				EXPECT_EQ(sut.GetStats().used, 64 + 256);
+			}
+			EXPECT_EQ(sut.GetStats().used, 64);
+			EXPECT_EQ(sut.Allocate<double>(1), inner);
+		}
+
+		TEST(ScratchArena, HighWaterSurvivesReset) {
+			dsptk::ScratchArena sut(4096);
+			sut.Allocate<double>(100);
+			sut.Reset();
+			sut.Allocate<double>(10);
+
+			auto stats = sut.GetStats();
+			EXPECT_EQ(stats.capacity, 4096);
+			EXPECT_EQ(stats.used, 128);
+			EXPECT_EQ(stats.highWater, 832);
+			EXPECT_EQ(stats.overflows, 0);
+
+			sut.ResetStats();
+			EXPECT_EQ(sut.GetStats().highWater, 128);
+		}
+
+		TEST(ScratchArena, ChannelViews) {
+			dsptk::ScratchArena sut(1024);
+			auto channel = sut.AllocateChannel<double>(16);
+
+			EXPECT_EQ(channel.size(), 16);
+			EXPECT_TRUE(IsAligned(channel.data()));
+		}
+
+		TEST(ScratchArena, CopiesHaveTheirOwnMemory) {
+			dsptk::ScratchArena original(256);
+			original.Allocate<double>(4);
+			dsptk::ScratchArena copy(original);
+
+			EXPECT_EQ(copy.GetCapacity(), 256);
+			EXPECT_EQ(copy.GetStats().used, 0);
+			EXPECT_NE(copy.Allocate<double>(1), original.Allocate<double>(1));
+		}
+
+#ifdef NDEBUG
+		TEST(ScratchArena, OverflowFallsBackToTheHeap) {
+			dsptk::ScratchArena sut(128);
+			sut.Allocate<double>(8);
+
+			double* overflowed = sut.Allocate<double>(32);
+			ASSERT_NE(overflowed, nullptr);
+			EXPECT_TRUE(IsAligned(overflowed));
+			overflowed[31] = 1.;
+
+			auto stats = sut.GetStats();
+			EXPECT_EQ(stats.overflows, 1);
+			EXPECT_EQ(stats.highWater, 64 + 256);
+
+			sut.Reset();
+			EXPECT_EQ(sut.GetStats().overflows, 1);
+		}
+#else
+		TEST(ScratchArenaDeathTest, OverflowAssertsInDebug) {
+			dsptk::ScratchArena sut(128);
+			EXPECT_DEATH(sut.Allocate<double>(32), "ScratchArena overflow");
+		}
+#endif
+	}
+
+	namespace compressor {
+
+		const double sampleRate = 48000.;
+
+		std::vector<double> Process(dsptk::Compressor& sut, std::vector<double> signal, int blockSize) {
+			std::vector<double> gain(signal.size());
+			for (int start = 0; start < (int)signal.size(); start += blockSize) {
+				const int n = std::min(blockSize, (int)signal.size() - start);
+				sut.ProcessBlock(signal.data() + start, nullptr, signal.data() + start, gain.data() + start, n);
+			}
+			return signal;
+		}
+
+		TEST(Compressor, SharedArenaMatchesOwnScratch) {
+			dsptk::Compressor reference(-20., 4., 6., sampleRate, 5., 50.);
+			dsptk::Compressor sut(-20., 4., 6., sampleRate, 5., 50.);
+			dsptk::ScratchArena scratch(dsptk::Compressor::ScratchBytes(256));
+			sut.Prepare(256, &scratch);
+			auto input = dsptk::sin(440., sampleRate, 4096);
+
+			auto expected = Process(reference, input, 256);
+			auto output = Process(sut, input, 256);
+
+			EXPECT_EQ(output, expected);
+			EXPECT_EQ(scratch.GetStats().highWater, dsptk::Compressor::ScratchBytes(256));
+			EXPECT_EQ(scratch.GetStats().used, 0);
+			EXPECT_EQ(scratch.GetStats().overflows, 0);
+		}
+
+		TEST(Compressor, BlocksLargerThanPreparedAreChunked) {
+			dsptk::Compressor reference(-20., 4., 6., sampleRate, 5., 50.);
+			dsptk::Compressor sut(-20., 4., 6., sampleRate, 5., 50.);
+			dsptk::ScratchArena scratch(dsptk::Compressor::ScratchBytes(64));
+			sut.Prepare(64, &scratch);
+			auto input = dsptk::sin(440., sampleRate, 4096);
+
+			auto expected = Process(reference, input, 4096);
+			auto output = Process(sut, input, 1000);
+
+			for (size_t i = 0; i < input.size(); i++) {
+				EXPECT_DOUBLE_EQ(output[i], expected[i]) << i;
+			}
+			EXPECT_EQ(scratch.GetStats().overflows, 0);
+		}
+	}
+}
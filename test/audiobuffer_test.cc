@@ -0,0 +1,228 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "dsptk/audiobuffer.h"
+#include "dsptk/detector.h"
+#include "dsptk/dynamics.h"
+#include "dsptk/filters.h"
+#include "dsptk/metering.h"
+#include "dsptk/signals.h"
+
+namespace audiobuffer {
+
+	const double sampleRate = 48000.;
+
+	bool IsAligned(const void* pointer) {
+		return reinterpret_cast<std::uintptr_t>(pointer) % dsptk::AudioBuffer<double>::alignment == 0;
+	}
+
+	// Fills channel c with c * 1000 + frame
+	template <typename T>
+	void FillIndices(dsptk::AudioBuffer<T>& buffer) {
+		for (int c = 0; c < buffer.GetNumChannels(); c++) {
+			auto channel = buffer.GetChannel(c);
+			for (int i = 0; i < channel.size(); i++) {
+				channel[i] = (T)(c * 1000 + i);
+			}
+		}
+	}
+
+	namespace buffer {
+
+		TEST(AudioBuffer, ChannelsAreAlignedAndSilent) {
+			for (int nFrames : { 1, 7, 8, 100, 1024 }) {
+				dsptk::AudioBuffer<double> sut(3, nFrames);
+				ASSERT_EQ(sut.GetNumChannels(), 3);
+				ASSERT_EQ(sut.GetNumFrames(), nFrames);
+				for (int c = 0; c < 3; c++) {
+					EXPECT_TRUE(IsAligned(sut.GetChannel(c).data())) << nFrames << " " << c;
+					EXPECT_EQ(sut.GetChannel(c).size(), nFrames);
+					for (double sample : sut.GetChannel(c)) {
+						EXPECT_EQ(sample, 0.);
+					}
+				}
+			}
+		}
+
+		TEST(AudioBuffer, FloatChannelsAreAligned) {
+			dsptk::AudioBuffer<float> sut(4, 33);
+			for (int c = 0; c < 4; c++) {
+				EXPECT_TRUE(IsAligned(sut.GetChannel(c).data())) << c;
+			}
+		}
+
+		TEST(AudioBuffer, ChannelsDontOverlap) {
+			dsptk::AudioBuffer<double> sut(2, 9);
+			FillIndices(sut);
+			EXPECT_EQ(sut[0][8], 8.);
+			EXPECT_EQ(sut[1][0], 1000.);
+			EXPECT_EQ(sut.GetChannelPointers()[1][8], 1008.);
+		}
+
+		TEST(AudioBuffer, CopyIsDeepAndMoveTransfers) {
+			dsptk::AudioBuffer<double> original(2, 16);
+			FillIndices(original);
+
+			dsptk::AudioBuffer<double> copy(original);
+			copy[1][3] = -1.;
+			EXPECT_EQ(original[1][3], 1003.);
+			EXPECT_EQ(copy[0][15], 15.);
+
+			const double* data = original[0].data();
+			dsptk::AudioBuffer<double> moved(std::move(original));
+			EXPECT_EQ(moved[0].data(), data);
+			EXPECT_EQ(original.GetNumChannels(), 0);
+
+			copy = moved;
+			EXPECT_EQ(copy[1][3], 1003.);
+		}
+
+		TEST(AudioBuffer, ResizeAndClear) {
+			dsptk::AudioBuffer<double> sut(1, 4);
+			FillIndices(sut);
+			sut.Clear();
+			EXPECT_EQ(sut[0][3], 0.);
+
+			sut.Resize(5, 300);
+			EXPECT_EQ(sut.GetNumChannels(), 5);
+			EXPECT_EQ(sut.GetNumFrames(), 300);
+			EXPECT_TRUE(IsAligned(sut[4].data()));
+		}
+	}
+
+	namespace views {
+
+		TEST(BufferView, SubBlocksShareTheSamples) {
+			dsptk::AudioBuffer<double> buffer(2, 100);
+			FillIndices(buffer);
+
+			auto block = buffer.SubBlock(10, 20);
+			EXPECT_EQ(block.GetNumChannels(), 2);
+			EXPECT_EQ(block.GetNumFrames(), 20);
+			EXPECT_EQ(block[1][0], 1010.);
+
+			auto nested = block.SubBlock(5, 5);
+			EXPECT_EQ(nested.GetOffset(), 15);
+			EXPECT_EQ(nested[0][4], 19.);
+
+			nested[0][0] = -1.;
+			EXPECT_EQ(buffer[0][15], -1.);
+		}
+
+		TEST(ChannelView, SubBlockAndConversions) {
+			std::vector<double> samples{ 0., 1., 2., 3., 4. };
+			dsptk::ChannelView<double> view(samples);
+			dsptk::ChannelView<const double> constView = view.SubBlock(1, 3);
+
+			EXPECT_EQ(constView.size(), 3);
+			EXPECT_EQ(constView[0], 1.);
+			EXPECT_EQ(*(constView.end() - 1), 3.);
+
+			const std::vector<double>& constSamples = samples;
+			dsptk::ChannelView<const double> fromConst(constSamples);
+			EXPECT_EQ(fromConst.data(), samples.data());
+			EXPECT_TRUE(dsptk::ChannelView<double>().empty());
+		}
+
+		TEST(BufferView, ConstBufferGivesConstViews) {
+			dsptk::AudioBuffer<double> buffer(2, 8);
+			const auto& constBuffer = buffer;
+			dsptk::BufferView<const double> view = constBuffer;
+			dsptk::BufferView<const double> fromMutable = buffer.GetView();
+
+			EXPECT_EQ(view[1].data(), buffer[1].data());
+			EXPECT_EQ(fromMutable[0].data(), buffer[0].data());
+		}
+	}
+
+	namespace processors {
+
+		const int blockSize = 512;
+		const int subBlock = 96;
+
+		TEST(Views, FilterBankSubBlocksMatchRawBlock) {
+			auto MakeBank = [] {
+				dsptk::FilterBank bank;
+				std::shared_ptr<dsptk::Filter> lowpass = std::make_shared<dsptk::ButterworthLowPass>(2000., sampleRate);
+				bank.AddFilter(lowpass);
+				return bank;
+			};
+			auto raw = MakeBank();
+			auto viewed = MakeBank();
+			auto input = dsptk::sin(440., sampleRate, blockSize);
+			std::vector<double> expected(blockSize);
+			raw.ProcessBlock(input.data(), expected.data(), blockSize);
+
+			dsptk::AudioBuffer<double> buffer(1, blockSize);
+			std::copy(input.begin(), input.end(), buffer[0].begin());
+			for (int start = 0; start < blockSize; start += subBlock) {
+				auto block = buffer[0].SubBlock(start, std::min(subBlock, blockSize - start));
+				viewed.ProcessBlock(block, block);
+			}
+
+			for (int i = 0; i < blockSize; i++) {
+				EXPECT_EQ(buffer[0][i], expected[i]) << i;
+			}
+		}
+
+		TEST(Views, CompressorSubBlocksMatchRawBlock) {
+			dsptk::Compressor raw(-20., 4., 6., sampleRate, 5., 50.);
+			dsptk::Compressor viewed(-20., 4., 6., sampleRate, 5., 50.);
+			auto input = dsptk::sin(440., sampleRate, blockSize);
+			std::vector<double> expected(blockSize), expectedGain(blockSize);
+			raw.ProcessBlock(input.data(), nullptr, expected.data(), expectedGain.data(), blockSize);
+
+			dsptk::AudioBuffer<double> buffer(2, blockSize);
+			std::copy(input.begin(), input.end(), buffer[0].begin());
+			for (int start = 0; start < blockSize; start += subBlock) {
+				auto block = buffer.SubBlock(start, std::min(subBlock, blockSize - start));
+				viewed.ProcessBlock(block[0], {}, block[0], block[1]);
+			}
+
+			for (int i = 0; i < blockSize; i++) {
+				EXPECT_DOUBLE_EQ(buffer[0][i], expected[i]) << i;
+				EXPECT_DOUBLE_EQ(buffer[1][i], expectedGain[i]) << i;
+			}
+		}
+
+		TEST(Views, DetectorAcceptsVectors) {
+			dsptk::RmsDetector raw(sampleRate, .01);
+			dsptk::RmsDetector viewed(sampleRate, .01);
+			auto input = dsptk::sin(440., sampleRate, blockSize);
+			std::vector<double> expected(blockSize), output(blockSize);
+
+			raw.ProcessBlock(input.data(), expected.data(), blockSize);
+			viewed.ProcessBlock(input, output);
+
+			EXPECT_EQ(output, expected);
+		}
+
+		TEST(Views, MetersAcceptSubBlocks) {
+			dsptk::LoudnessMeter rawLoudness(2, sampleRate);
+			dsptk::LoudnessMeter viewedLoudness(2, sampleRate);
+			dsptk::TruePeakMeter rawPeak(2, 128);
+			dsptk::TruePeakMeter viewedPeak(2, 128);
+
+			dsptk::AudioBuffer<double> buffer(2, 48000);
+			auto left = dsptk::sin(997., sampleRate, buffer.GetNumFrames());
+			auto right = dsptk::sin(3000., sampleRate, buffer.GetNumFrames(), .5);
+			std::copy(left.begin(), left.end(), buffer[0].begin());
+			std::copy(right.begin(), right.end(), buffer[1].begin());
+
+			rawLoudness.ProcessBlock(buffer.GetChannelPointers(), buffer.GetNumFrames());
+			rawPeak.ProcessBlock(buffer.GetChannelPointers(), buffer.GetNumFrames());
+			for (int start = 0; start < buffer.GetNumFrames(); start += 1000) {
+				const auto block = buffer.SubBlock(start, std::min(1000, buffer.GetNumFrames() - start));
+				viewedLoudness.ProcessBlock(block);
+				viewedPeak.ProcessBlock(block);
+			}
+
+			EXPECT_NEAR(viewedLoudness.GetMomentaryLoudness(), rawLoudness.GetMomentaryLoudness(), 1e-9);
+			EXPECT_EQ(viewedPeak.GetMaxPeak(0), rawPeak.GetMaxPeak(0));
+			EXPECT_EQ(viewedPeak.GetMaxPeak(1), rawPeak.GetMaxPeak(1));
+		}
+	}
+}
@@ -0,0 +1,160 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "dsptk/conversion.h"
+#include "dsptk/audiobuffer.h"
+#include "dsptk/signals.h"
+
+namespace conversion {
+
+	// Interleaved test pattern: a distinct value per channel and frame
+	std::vector<std::int16_t> Int16Pattern(int numChannels, int nFrames) {
+		std::vector<std::int16_t> samples((std::size_t)numChannels * nFrames);
+		for (int f = 0; f < nFrames; f++) {
+			for (int c = 0; c < numChannels; c++) {
+				samples[(std::size_t)f * numChannels + c] = (std::int16_t)((f * 131 + c * 7919) % 65536 - 32768);
+			}
+		}
+		return samples;
+	}
+
+	class Channels : public ::testing::TestWithParam<int> {};
+
+	TEST_P(Channels, Int16RoundTripIsExact) {
+		const int numChannels = GetParam();
+		const int nFrames = 1000;
+		auto input = Int16Pattern(numChannels, nFrames);
+
+		dsptk::AudioBuffer<double> planar(numChannels, nFrames);
+		dsptk::Deinterleave(input.data(), dsptk::SampleFormat::Int16, planar);
+		std::vector<std::int16_t> output(input.size());
+		dsptk::Interleave(planar.GetView(), output.data(), dsptk::SampleFormat::Int16);
+
+		EXPECT_EQ(output, input);
+		EXPECT_EQ(planar[numChannels - 1][nFrames - 1], input.back() / 32768.);
+	}
+
+	TEST_P(Channels, FloatRoundTripIsExact) {
+		const int numChannels = GetParam();
+		const int nFrames = 333;
+		std::vector<float> input((std::size_t)numChannels * nFrames);
+		for (std::size_t i = 0; i < input.size(); i++) {
+			input[i] = (float)std::sin(i * .01) * 1.5f;
+		}
+
+		dsptk::AudioBuffer<float> planar(numChannels, nFrames);
+		dsptk::Deinterleave(input.data(), dsptk::SampleFormat::Float32, planar);
+		std::vector<float> output(input.size());
+		dsptk::Interleave(planar.GetView(), output.data(), dsptk::SampleFormat::Float32);
+
+		EXPECT_EQ(output, input);
+		EXPECT_EQ(planar[0][1], input[numChannels]);
+	}
+
+	TEST_P(Channels, Int24RoundTripIsExact) {
+		const int numChannels = GetParam();
+		const int nFrames = 500;
+		std::vector<std::int32_t> values((std::size_t)numChannels * nFrames);
+		std::vector<unsigned char> input(values.size() * 3);
+		for (std::size_t i = 0; i < values.size(); i++) {
+			values[i] = (std::int32_t)((i * 104729) % 16777216) - 8388608;
+			input[i * 3] = (unsigned char)values[i];
+			input[i * 3 + 1] = (unsigned char)(values[i] >> 8);
+			input[i * 3 + 2] = (unsigned char)(values[i] >> 16);
+		}
+
+		dsptk::AudioBuffer<double> planar(numChannels, nFrames);
+		dsptk::Deinterleave(input.data(), dsptk::SampleFormat::Int24, planar);
+		std::vector<unsigned char> output(input.size());
+		dsptk::Interleave(planar.GetView(), output.data(), dsptk::SampleFormat::Int24);
+
+		EXPECT_EQ(output, input);
+		for (int c = 0; c < numChannels; c++) {
+			EXPECT_EQ(planar[c][3], values[3 * numChannels + c] / 8388608.) << c;
+		}
+	}
+
+	INSTANTIATE_TEST_SUITE_P(Conversion, Channels, ::testing::Values(1, 2, 3, 8, 64));
+
+	TEST(Conversion, Int32FullScale) {
+		const std::int32_t input[] = { INT32_MIN, -1, 0, 1, INT32_MAX };
+		dsptk::AudioBuffer<double> planar(1, 5);
+
+		dsptk::Deinterleave(input, dsptk::SampleFormat::Int32, planar);
+		EXPECT_EQ(planar[0][0], -1.);
+		EXPECT_EQ(planar[0][2], 0.);
+		EXPECT_NEAR(planar[0][4], 1., 1e-9);
+
+		std::int32_t output[5];
+		dsptk::Interleave(planar.GetView(), output, dsptk::SampleFormat::Int32);
+		EXPECT_THAT(output, ::testing::ElementsAreArray(input));
+	}
+
+	TEST(Conversion, IntegersRoundAndClip) {
+		const double samples[] = { 1.5, 1., -1., -3., .5 / 32768., -.5 / 32768., .4 / 32768., 100.6 / 32768. };
+		const double* channels[] = { samples };
+		dsptk::BufferView<const double> input(channels, 1, 8);
+
+		std::int16_t output[8];
+		dsptk::Interleave(input, output, dsptk::SampleFormat::Int16);
+
+		EXPECT_THAT(output, ::testing::ElementsAre(32767, 32767, -32768, -32768, 1, -1, 0, 101));
+	}
+
+	TEST(Conversion, SubBlocksConvertInPlace) {
+		const int numChannels = 4;
+		auto input = Int16Pattern(numChannels, 100);
+		dsptk::AudioBuffer<double> planar(numChannels, 200);
+
+		// Second half of the buffer, the first one stays silent
+		dsptk::Deinterleave(input.data(), dsptk::SampleFormat::Int16, planar.SubBlock(100, 100));
+
+		EXPECT_EQ(planar[2][99], 0.);
+		EXPECT_EQ(planar[2][100], input[2] / 32768.);
+		EXPECT_EQ(planar[3][199], input.back() / 32768.);
+	}
+
+	TEST(Conversion, DitherIsTpdfOfOneLsb) {
+		const int nFrames = 1 << 16;
+		// A constant a quarter LSB above zero: undithered it always rounds to 0
+		std::vector<double> samples(nFrames, .25 / 32768.);
+		const double* channels[] = { samples.data() };
+		dsptk::BufferView<const double> input(channels, 1, nFrames);
+
+		std::vector<std::int16_t> plain(nFrames), dithered(nFrames);
+		dsptk::TpdfDither dither(1);
+		dsptk::Interleave(input, plain.data(), dsptk::SampleFormat::Int16);
+		dsptk::Interleave(input, dithered.data(), dsptk::SampleFormat::Int16, &dither);
+
+		double sum = 0.;
+		for (int i = 0; i < nFrames; i++) {
+			EXPECT_EQ(plain[i], 0);
+			EXPECT_GE(dithered[i], -1);
+			EXPECT_LE(dithered[i], 1);
+			sum += dithered[i];
+		}
+		// Dither makes the average output the input level
+		EXPECT_NEAR(sum / nFrames, .25, .01);
+	}
+
+	TEST(Conversion, DitherIsIgnoredForFloat) {
+		const double samples[] = { .1, -.2 };
+		const double* channels[] = { samples };
+		dsptk::TpdfDither dither(1);
+		float output[2];
+
+		dsptk::Interleave(dsptk::BufferView<const double>(channels, 1, 2), output, dsptk::SampleFormat::Float32, &dither);
+
+		EXPECT_EQ(output[0], .1f);
+		EXPECT_EQ(output[1], -.2f);
+	}
+
+	TEST(Conversion, BytesPerSample) {
+		EXPECT_EQ(dsptk::BytesPerSample(dsptk::SampleFormat::Int16), 2);
+		EXPECT_EQ(dsptk::BytesPerSample(dsptk::SampleFormat::Int24), 3);
+		EXPECT_EQ(dsptk::BytesPerSample(dsptk::SampleFormat::Int32), 4);
+		EXPECT_EQ(dsptk::BytesPerSample(dsptk::SampleFormat::Float32), 4);
+	}
+}
@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
+#include <algorithm>
 #include <vector>
+#include <cmath>
 
 #include "dsptk/convolution.h"
 
@@ -135,5 +137,76 @@ namespace convolution {
 
 	}
 
-}
+	namespace fftAlgorithm {
+		TEST(FftConvolution, MatchesDirectConvolution) {
+
+			std::vector<double> input(300);
+			std::vector<double> kernel(37);
+			for (size_t i = 0; i < input.size(); i++) input[i] = std::sin(0.1 * i) + (i % 3);
+			for (size_t i = 0; i < kernel.size(); i++) kernel[i] = 1. / (1. + i);
+
+			std::vector<double> expectedResult = dsptk::convolve(input, kernel);
+			std::vector<double> result = dsptk::fft_convolve(input, kernel);
+
+			ASSERT_EQ(expectedResult.size(), result.size());
+			for (size_t i = 0; i < result.size(); i++) {
+				EXPECT_NEAR(expectedResult[i], result[i], 1e-10);
+			}
+		}
+
+		TEST(FftConvolution, EmptyInput) {
+			EXPECT_TRUE(dsptk::fft_convolve({}, { 1., 2. }).empty());
+		}
+	}
+
+	namespace blockConvolver {
+		// The stream through a BlockConvolver in blocks of the given sizes, in place, against the direct convolution
+		void ExpectDirectConvolution(size_t irSize, int partitionSize, const std::vector<int>& blockSizes) {
+			std::vector<double> input(1500);
+			std::vector<double> impulseResponse(irSize);
+			for (size_t i = 0; i < input.size(); i++) input[i] = std::sin(0.37 * i) + (i % 5) * .1;
+			for (size_t i = 0; i < impulseResponse.size(); i++) impulseResponse[i] = std::cos(0.2 * i) / (1. + .01 * i);
+			const std::vector<double> expected = dsptk::convolve(input, impulseResponse);
+
+			dsptk::BlockConvolver convolver(impulseResponse, partitionSize);
+			std::vector<double> output(input);
+			for (size_t start = 0, b = 0; start < output.size(); b++) {
+				const int n = std::min(blockSizes[b % blockSizes.size()], (int)(output.size() - start));
+				convolver.ProcessBlock(output.data() + start, output.data() + start, n);
+				start += n;
+			}
+			for (size_t i = 0; i < output.size(); i++) {
+				ASSERT_NEAR(output[i], expected[i], 1e-10) << irSize << " " << partitionSize << " " << i;
+			}
+		}
+
+		TEST(BlockConvolver, MatchesDirectConvolution) {
+			// Shorter, as long as and longer than a partition, blocks aligned or not
+			for (size_t irSize : { 1, 20, 64, 65, 700 }) {
+				ExpectDirectConvolution(irSize, 64, { 64 });
+				ExpectDirectConvolution(irSize, 64, { 1, 17, 100, 64, 3 });
+				ExpectDirectConvolution(irSize, 50, { 1000 });
+			}
+		}
+
+		TEST(BlockConvolver, ResetForgetsTheTail) {
+			dsptk::BlockConvolver convolver({ 0., 0., 1. }, 2);
+			double block[4] = { 1., 2., 3., 4. };
+			convolver.ProcessBlock(block, block, 4);
+			EXPECT_NEAR(block[2], 1., 1e-12);
+			convolver.Reset();
+			double silence[2] = { 0., 0. };
+			convolver.ProcessBlock(silence, silence, 2);
+			EXPECT_NEAR(silence[0], 0., 1e-12);
+			EXPECT_NEAR(silence[1], 0., 1e-12);
+		}
 
+		TEST(BlockConvolver, EmptyResponseIsSilent) {
+			dsptk::BlockConvolver convolver({});
+			double block[3] = { 1., 2., 3. };
+			convolver.ProcessBlock(block, block, 3);
+			EXPECT_EQ(block[1], 0.);
+		}
+	}
+
+}
@@ -1,6 +1,9 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 #include "dsptk/detector.h"
+#include "dsptk/constants.h"
+#include <cmath>
+#include <vector>
 
 
 namespace detector {
@@ -81,6 +84,111 @@ namespace detector {
 			ASSERT_NEAR(sut.ProcessSample(0.), sampleValue * .1, expectedDetectorError);
 		}
 
+		TEST(DecoupledPeakDetectorOperation, BlockProcessingMatchesSampleProcessing) {
+			dsptk::DecoupledPeakDetector bySample{ sampleRate, attackTime, releaseTime };
+			dsptk::DecoupledPeakDetector byBlock{ sampleRate, attackTime, releaseTime };
+
+			std::vector<double> input(attackSamples * 5);
+			for (int i = 0; i < input.size(); i++) {
+				input[i] = i < attackSamples * 2 ? std::sin(0.1 * i) * sampleValue : 0.;
+			}
+
+			// Through a base class reference
+			dsptk::Detector& detector = byBlock;
+			std::vector<double> output(input.size());
+			detector.ProcessBlock(input.data(), output.data(), (int)input.size());
+
+			for (int i = 0; i < input.size(); i++) {
+				EXPECT_EQ(output[i], bySample.ProcessSample(input[i]));
+			}
+		}
+
 	}
-}
 
+	namespace rms {
+
+		// Test Values
+		const double sampleRate = 1000.;
+		const double windowTime = 0.1;
+		const int windowSamples = (int)std::round(sampleRate * windowTime);
+
+		TEST(RmsDetectorOperation, DetectorShoulInitInZero) {
+			dsptk::RmsDetector sut{ sampleRate, windowTime };
+
+			EXPECT_EQ(.0, sut.ProcessSample(0));
+		}
+
+		TEST(RmsDetectorOperation, ConstantInputReachesItsValueAfterWindow) {
+			dsptk::RmsDetector sut{ sampleRate, windowTime };
+
+			for (int i = 0; i < windowSamples - 1; i++) {
+				sut.ProcessSample(-2.);
+			}
+
+			EXPECT_NEAR(sut.ProcessSample(-2.), 2., 1e-12);
+		}
+
+		TEST(RmsDetectorOperation, SineRmsIsPeakOverSquareRootOfTwo) {
+			dsptk::RmsDetector sut{ sampleRate, windowTime };
+
+			// 50Hz fits exactly 5 cycles in the window
+			double output = 0.;
+			for (int i = 0; i < windowSamples * 3; i++) {
+				output = sut.ProcessSample(std::sin(dsptk::DOUBLE_PI<double> * 50. * i / sampleRate));
+			}
+
+			EXPECT_NEAR(output, 1. / std::sqrt(2.), 1e-9);
+		}
+
+		TEST(RmsDetectorOperation, ReturnsToZeroAfterSilenceWindow) {
+			dsptk::RmsDetector sut{ sampleRate, windowTime };
+
+			// Large values followed by silence would leave a residue without renormalization
+			for (int i = 0; i < windowSamples * 10 + 7; i++) {
+				sut.ProcessSample(i % 3 ? 1e6 : 1e-3);
+			}
+			double output = 0.;
+			for (int i = 0; i < windowSamples; i++) {
+				output = sut.ProcessSample(0.);
+			}
+
+			EXPECT_EQ(output, 0.);
+		}
+
+		TEST(RmsDetectorOperation, BlockProcessingMatchesSampleProcessing) {
+			dsptk::RmsDetector bySample{ sampleRate, windowTime };
+			dsptk::RmsDetector byBlock{ sampleRate, windowTime };
+
+			std::vector<double> input(windowSamples * 4 + 13);
+			for (int i = 0; i < input.size(); i++) {
+				input[i] = std::sin(0.37 * i) * (1. + i % 5);
+			}
+
+			std::vector<double> output(input.size());
+			// Uneven block sizes so blocks straddle the window wrap
+			const int blockSizes[] = { 1, 64, 37, 128 };
+			int start = 0;
+			for (int b = 0; start < input.size(); b++) {
+				int n = std::min(blockSizes[b % 4], (int)input.size() - start);
+				byBlock.ProcessBlock(input.data() + start, output.data() + start, n);
+				start += n;
+			}
+
+			for (int i = 0; i < input.size(); i++) {
+				EXPECT_NEAR(output[i], bySample.ProcessSample(input[i]), 1e-9);
+			}
+		}
+
+		TEST(RmsDetectorOperation, SampleRateChangeResizesWindow) {
+			dsptk::RmsDetector sut{ sampleRate, windowTime };
+			sut.setSampleRate(sampleRate * 2);
+
+			// A constant input needs the whole (now doubled) window to settle
+			for (int i = 0; i < windowSamples; i++) {
+				sut.ProcessSample(1.);
+			}
+			EXPECT_NEAR(sut.ProcessSample(1.), std::sqrt((windowSamples + 1) / (2. * windowSamples)), 1e-12);
+		}
+
+	}
+}
@@ -2,6 +2,8 @@
 #include <gmock/gmock.h>
 #include <vector>
 #include <array>
+#include <cmath>
+#include <complex>
 
 #include "dsptk/dft.h"
 
@@ -55,4 +57,92 @@ namespace dft {
 		std::vector<double> reX = result[0];
 		EXPECT_EQ(reX, expectedResult);
 	}
-}
\ No newline at end of file
+
+	TEST(Fft, MatchesDft) {
+
+		std::vector<double> input(64);
+		std::vector<std::complex<double>> data(input.size());
+		for (size_t i = 0; i < input.size(); i++) {
+			input[i] = std::sin(0.3 * i) + 0.5 * std::cos(1.7 * i + 0.2) + (i % 5) * 0.1;
+			data[i] = input[i];
+		}
+
+		std::array<std::vector<double>, 2> expected = dsptk::real_dft_analysis(input);
+		dsptk::fft(data);
+
+		for (size_t k = 0; k < expected[0].size(); k++) {
+			EXPECT_NEAR(data[k].real(), expected[0][k], 1e-9);
+			EXPECT_NEAR(data[k].imag(), expected[1][k], 1e-9);
+		}
+	}
+
+	TEST(Fft, InverseRoundTrip) {
+
+		std::vector<std::complex<double>> input(1024);
+		for (size_t i = 0; i < input.size(); i++) {
+			input[i] = { std::sin(0.01 * i * i), std::cos(0.37 * i) };
+		}
+
+		auto data = input;
+		dsptk::fft(data);
+		dsptk::fft(data, true);
+
+		for (size_t i = 0; i < input.size(); i++) {
+			EXPECT_NEAR(data[i].real(), input[i].real(), 1e-12);
+			EXPECT_NEAR(data[i].imag(), input[i].imag(), 1e-12);
+		}
+	}
+
+	TEST(Fft, RealInverseMatchesComplexInverse) {
+
+		std::vector<std::complex<double>> spectrum(256);
+		for (size_t i = 0; i < spectrum.size(); i++) {
+			spectrum[i] = 0.3 * std::sin(0.7 * i) + (i % 4) - 1.;
+		}
+		dsptk::fft(spectrum);
+
+		std::vector<std::complex<double>> half(spectrum.begin(), spectrum.begin() + spectrum.size() / 2 + 1);
+		std::vector<double> result = dsptk::ifft_real(half);
+		dsptk::fft(spectrum, true);
+
+		ASSERT_EQ(spectrum.size(), result.size());
+		for (size_t i = 0; i < result.size(); i++) {
+			EXPECT_NEAR(spectrum[i].real(), result[i], 1e-12);
+		}
+	}
+
+	TEST(Fft, PlanMatchesUnplanned) {
+
+		// 1 << 15 runs past the cache blocked stages
+		for (size_t size : { 1, 2, 8, 1024, 1 << 15 }) {
+			const dsptk::FftPlan plan(size);
+			ASSERT_EQ(size, plan.GetSize());
+			for (bool inverse : { false, true }) {
+				std::vector<std::complex<double>> expected(size);
+				for (size_t i = 0; i < size; i++) {
+					expected[i] = { std::sin(0.01 * i * i), std::cos(0.37 * i) };
+				}
+				auto data = expected;
+				dsptk::fft(expected, inverse);
+				dsptk::fft(data, plan, inverse);
+				for (size_t i = 0; i < size; i++) {
+					ASSERT_EQ(expected[i], data[i]) << size << " " << inverse << " " << i;
+				}
+			}
+		}
+	}
+
+#ifndef NDEBUG
+	TEST(FftDeathTest, SizesOtherThanPowersOfTwoAssert) {
+		std::vector<std::complex<double>> data(12);
+		EXPECT_DEATH(dsptk::fft(data), "power of two");
+		EXPECT_DEATH(dsptk::FftPlan(12), "power of two");
+	}
+#endif
+
+	TEST(Fft, Size) {
+		EXPECT_EQ(1u, dsptk::fft_size(1));
+		EXPECT_EQ(8u, dsptk::fft_size(5));
+		EXPECT_EQ(1024u, dsptk::fft_size(1024));
+	}
+}
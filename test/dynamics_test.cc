@@ -0,0 +1,340 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "dsptk/dynamics.h"
+#include "dsptk/filters.h"
+#include "dsptk/signals.h"
+#include "dsptk/dsptypes.h"
+
+namespace dynamics {
+
+	namespace gaintable {
+
+		// Test Values
+		const double threshold = -20.;
+		const double ratio = 4.;
+		const double kneeWidth = 6.;
+		const double minDb = -96.;
+		const double maxDb = 24.;
+		const int tableSize = 1201;		// One point each 0.1dB
+
+		TEST(GainReductionTable, MatchesCurveAtTablePoints) {
+			dsptk::GainReductionComputer reference{ threshold, ratio, kneeWidth };
+			dsptk::GainReductionComputer sut{ threshold, ratio, kneeWidth };
+			sut.EnableTable(minDb, maxDb, tableSize);
+
+			for (int i = 0; i < tableSize; i++) {
+				double level = minDb + i * .1;
+				EXPECT_NEAR(sut.Compute(level), reference.Compute(level), 1e-9) << level;
+			}
+		}
+
+		TEST(GainReductionTable, InterpolatesBetweenTablePoints) {
+			dsptk::GainReductionComputer reference{ threshold, ratio, kneeWidth };
+			dsptk::GainReductionComputer sut{ threshold, ratio, kneeWidth };
+			sut.EnableTable(minDb, maxDb, tableSize);
+
+			const double kneeEnd = threshold + kneeWidth / 2.;
+			for (double level = -40.; level < 0.; level += .0137) {
+				// The built in curve steps at the knee end, the segment holding it can't follow the step
+				if (std::abs(level - kneeEnd) < .1) continue;
+				EXPECT_NEAR(sut.Compute(level), reference.Compute(level), .01) << level;
+			}
+		}
+
+		TEST(GainReductionTable, OutOfRangeLevels) {
+			dsptk::GainReductionComputer reference{ threshold, ratio, kneeWidth };
+			dsptk::GainReductionComputer sut{ threshold, ratio, kneeWidth };
+			sut.EnableTable(minDb, maxDb, tableSize);
+
+			EXPECT_EQ(sut.Compute(-200.), 0.);
+			EXPECT_EQ(sut.Compute(-INFINITY), 0.);
+			EXPECT_EQ(sut.Compute(NAN), 0.);
+			// Past the knee the curve is a straight line so extrapolation is exact
+			EXPECT_NEAR(sut.Compute(40.), reference.Compute(40.), 1e-9);
+		}
+
+		TEST(GainReductionTable, RebuildsWhenParametersChange) {
+			dsptk::GainReductionComputer reference{ threshold, ratio, kneeWidth };
+			dsptk::GainReductionComputer sut{ threshold, ratio, kneeWidth };
+			sut.EnableTable(minDb, maxDb, tableSize);
+
+			sut.SetThreshold(-30.);
+			sut.SetRatio(8.);
+			sut.SetKneeWidth(0.);
+			reference.SetThreshold(-30.);
+			reference.SetRatio(8.);
+			reference.SetKneeWidth(0.);
+
+			EXPECT_NEAR(sut.Compute(-10.), reference.Compute(-10.), 1e-9);
+			EXPECT_NEAR(sut.Compute(-35.), reference.Compute(-35.), 1e-9);
+		}
+
+#ifdef NDEBUG
+		TEST(GainReductionTable, EmptyOrReversedRangesAreRefused) {
+			dsptk::GainReductionComputer sut{ threshold, ratio, kneeWidth };
+			EXPECT_FALSE(sut.EnableTable(-20., -20.));
+			EXPECT_FALSE(sut.EnableTable(24., -96.));
+			EXPECT_FALSE(sut.EnableTable(-96., NAN));
+			EXPECT_FALSE(sut.IsTableEnabled());
+			EXPECT_EQ(sut.Compute(-10.), dsptk::GainReductionComputer(threshold, ratio, kneeWidth).Compute(-10.));
+
+			// An enabled table is kept
+			ASSERT_TRUE(sut.EnableTable(minDb, maxDb, tableSize));
+			const double reduction = sut.Compute(-10.);
+			EXPECT_FALSE(sut.EnableTable(0., -10.));
+			EXPECT_TRUE(sut.IsTableEnabled());
+			EXPECT_EQ(sut.Compute(-10.), reduction);
+
+			dsptk::Compressor compressor(threshold, ratio, kneeWidth, 48000., 5., 50.);
+			EXPECT_FALSE(compressor.EnableGainTable(0., 0.));
+		}
+#else
+		TEST(GainReductionTableDeathTest, EmptyRangeAssertsInDebug) {
+			dsptk::GainReductionComputer sut{ threshold, ratio, kneeWidth };
+			EXPECT_DEATH(sut.EnableTable(-20., -20.), "Gain table range is empty");
+			EXPECT_DEATH(sut.EnableTable(24., -96.), "Gain table range is empty");
+		}
+#endif
+
+		TEST(GainReductionTable, BlockMatchesSingleValues) {
+			dsptk::GainReductionComputer sut{ threshold, ratio, kneeWidth };
+			sut.EnableTable(minDb, maxDb, tableSize);
+
+			std::vector<double> levels(500);
+			for (int i = 0; i < levels.size(); i++) {
+				levels[i] = -60. + i * .13;
+			}
+			std::vector<double> output(levels.size());
+			sut.ComputeBlock(levels.data(), output.data(), (int)levels.size());
+
+			for (int i = 0; i < levels.size(); i++) {
+				EXPECT_EQ(output[i], sut.Compute(levels[i]));
+			}
+		}
+
+		TEST(GainReductionTable, UserDefinedCurve) {
+			dsptk::GainReductionComputer sut{ threshold, ratio, kneeWidth };
+
+			// 2:1 downward expander below -60dB, 4:1 compressor above -10dB
+			sut.SetTransferCurve([](double level) {
+				if (level < -60.) return (level + 60.);
+				if (level > -10.) return (level + 10.) * -.75;
+				return 0.;
+			});
+
+			EXPECT_TRUE(sut.IsTableEnabled());
+			EXPECT_NEAR(sut.Compute(-70.), -10., 1e-9);
+			EXPECT_NEAR(sut.Compute(-30.), 0., 1e-9);
+			EXPECT_NEAR(sut.Compute(-2.), -6., 1e-9);
+
+			// Built in parameters do not override a user curve
+			sut.SetThreshold(-40.);
+			EXPECT_NEAR(sut.Compute(-30.), 0., 1e-9);
+
+			sut.ClearTransferCurve();
+			dsptk::GainReductionComputer reference{ -40., ratio, kneeWidth };
+			EXPECT_NEAR(sut.Compute(-30.), reference.Compute(-30.), 1e-9);
+		}
+
+		TEST(GainReductionTable, CompressorGoesBackToTheBuiltInCurve) {
+			// Gain on the last sample of a second of sine, the detector has settled by then
+			auto settledGain = [](dsptk::Compressor& compressor) {
+				auto signal = dsptk::sin(1000., 48000., 48000, .5);
+				std::vector<double> gain(signal.size());
+				compressor.ProcessBlock(signal.data(), nullptr, signal.data(), gain.data(), (int)signal.size());
+				return gain.back();
+			};
+			dsptk::Compressor reference(threshold, ratio, kneeWidth, 48000., .005, .05);
+			const double expected = settledGain(reference);
+
+			dsptk::Compressor sut(threshold, ratio, kneeWidth, 48000., .005, .05);
+			sut.SetTransferCurve([](double) { return -40.; });
+			EXPECT_LT(settledGain(sut), .02);
+
+			sut.ClearTransferCurve();
+			sut.DisableGainTable();
+			EXPECT_NEAR(settledGain(sut), expected, 1e-9);
+		}
+	}
+
+	namespace multiband {
+
+		// Test Values
+		const double sampleRate = 48000.;
+		const int blockSize = 256;
+		const int testSamples = 48000;
+
+		double GainDB(const std::vector<double>& input, const std::vector<double>& output) {
+			return 10 * std::log10(dsptk::MeanSquare(output) / dsptk::MeanSquare(input));
+		}
+
+		std::vector<double> Process(dsptk::MultibandCompressor& sut, std::vector<double> signal) {
+			for (int start = 0; start < signal.size(); start += blockSize) {
+				sut.ProcessBlock(signal.data() + start, std::min(blockSize, (int)signal.size() - start));
+			}
+			return signal;
+		}
+
+		TEST(MultibandCompressor, WithoutCompressionMagnitudeIsFlat) {
+			for (double fTest : { 50., 200., 1000., 2000., 5000., 15000. }) {
+				dsptk::MultibandCompressor sut({ 200., 2000., 8000. }, sampleRate);
+				sut.Prepare(sampleRate, blockSize);
+				EXPECT_EQ(sut.GetNumBands(), 4);
+
+				auto input = dsptk::sin(fTest, sampleRate, testSamples, .5);
+				auto output = Process(sut, input);
+
+				EXPECT_NEAR(GainDB(input, output), 0., .01) << fTest;
+			}
+		}
+
+		TEST(MultibandCompressor, CompressesOnlyTheLoudBand) {
+			dsptk::MultibandCompressor sut({ 200., 2000. }, sampleRate);
+			sut.Prepare(sampleRate, blockSize);
+			sut.SetThreshold(2, -30.);
+			sut.SetRatio(2, 10.);
+
+			auto low = dsptk::sin(100., sampleRate, testSamples, .5);
+			auto lowOutput = Process(sut, low);
+			EXPECT_NEAR(GainDB(low, lowOutput), 0., .1);
+
+			auto high = dsptk::sin(6000., sampleRate, testSamples, .5);
+			auto highOutput = Process(sut, high);
+			EXPECT_LT(GainDB(high, highOutput), -10.);
+
+			// Low band gain stays at unity while the high band is reduced
+			EXPECT_DOUBLE_EQ(sut.GetBandGain(0)[blockSize - 1], 1.);
+			EXPECT_LT(sut.GetBandGain(2)[blockSize - 1], .5);
+		}
+
+		TEST(MultibandCompressor, BlocksLargerThanPreparedAreProcessed) {
+			dsptk::MultibandCompressor sut({ 1000. }, sampleRate);
+			sut.Prepare(sampleRate, 64);
+
+			auto input = dsptk::sin(500., sampleRate, 1000, .5);
+			auto output = input;
+			sut.ProcessBlock(output.data(), (int)output.size());
+
+			// Skip the filters transient, compare 5 whole cycles
+			std::vector<double> steadyInput(input.begin() + 520, input.end());
+			std::vector<double> steadyOutput(output.begin() + 520, output.end());
+			EXPECT_NEAR(GainDB(steadyInput, steadyOutput), 0., .05);
+		}
+
+		TEST(MultibandCompressor, ProcessesWithoutPrepare) {
+			dsptk::MultibandCompressor sut({ 1000. }, sampleRate);
+			sut.SetThreshold(0, -30.);
+			sut.SetRatio(0, 10.);
+
+			auto input = dsptk::sin(200., sampleRate, 3000, .5);
+			auto output = input;
+			sut.ProcessBlock(output.data(), (int)output.size());
+
+			EXPECT_LT(GainDB(input, output), -10.);
+		}
+	}
+
+	namespace gate {
+
+		// Test Values
+		const double sampleRate = 48000.;
+		const double attackTime = .001;
+		const double releaseTime = .05;
+		const double threshold = -40.;
+		const double range = -60.;
+
+		double Amplitude(double dB) {
+			return std::pow(10., dB / 20.);
+		}
+
+		// Processes a sine and returns the gain applied on the last sample
+		double ProcessSine(dsptk::Expander& sut, double dB, int nFrames) {
+			auto input = dsptk::sin(1000., sampleRate, nFrames, Amplitude(dB));
+			std::vector<double> output(nFrames);
+			std::vector<double> gain(nFrames);
+			sut.ProcessBlock(input.data(), nullptr, output.data(), gain.data(), nFrames);
+			return gain[nFrames - 1];
+		}
+
+		TEST(Gate, ClosedBelowThreshold) {
+			dsptk::Gate sut{ threshold, range, sampleRate, attackTime, releaseTime };
+
+			EXPECT_NEAR(ProcessSine(sut, -50., 4800), Amplitude(range), 1e-9);
+		}
+
+		TEST(Gate, OpensAboveThreshold) {
+			dsptk::Gate sut{ threshold, range, sampleRate, attackTime, releaseTime };
+
+			ProcessSine(sut, -50., 4800);
+			EXPECT_NEAR(ProcessSine(sut, -30., 4800), 1., 1e-6);
+		}
+
+		TEST(Gate, HysteresisKeepsItOpen) {
+			dsptk::Gate sut{ threshold, range, sampleRate, attackTime, releaseTime };
+			sut.SetHysteresis(6.);
+
+			ProcessSine(sut, -30., 4800);
+			// Below the threshold but above the closing level
+			EXPECT_NEAR(ProcessSine(sut, -43., 48000), 1., 1e-6);
+			// Below the closing level
+			EXPECT_NEAR(ProcessSine(sut, -50., 48000), Amplitude(range), 1e-6);
+		}
+
+		TEST(Gate, HoldDelaysClosing) {
+			dsptk::Gate sut{ threshold, range, sampleRate, attackTime, releaseTime };
+			sut.SetHoldTime(.5);
+
+			ProcessSine(sut, -30., 4800);
+			// Silence shorter than the hold time
+			EXPECT_NEAR(ProcessSine(sut, -100., 19200), 1., 1e-6);
+			// Past the hold time, allowing for the release tail
+			EXPECT_NEAR(ProcessSine(sut, -100., 19200), Amplitude(range), 1e-4);
+		}
+
+		TEST(Expander, ExpandsBelowThreshold) {
+			dsptk::Expander sut{ threshold, 2., range, sampleRate, attackTime, 1. };
+
+			// 10dB below the threshold with 1:2 expansion is attenuated 10dB more
+			double gain = ProcessSine(sut, -50., 48000);
+			EXPECT_NEAR(dsptk::DB::fromLinearGain(gain).asDB(), -10., .2);
+		}
+
+		TEST(Expander, AttenuationIsLimitedByRange) {
+			dsptk::Expander sut{ threshold, 4., -20., sampleRate, attackTime, 1. };
+
+			// Would be -30dB
+			double gain = ProcessSine(sut, -50., 48000);
+			EXPECT_NEAR(dsptk::DB::fromLinearGain(gain).asDB(), -20., .01);
+		}
+
+		TEST(Expander, OutputIsInputTimesGain) {
+			dsptk::Expander sut{ threshold, 2., range, sampleRate, attackTime, releaseTime };
+
+			auto input = dsptk::sin(1000., sampleRate, 4800, Amplitude(-45.));
+			std::vector<double> output(input.size());
+			std::vector<double> gain(input.size());
+			sut.ProcessBlock(input.data(), nullptr, output.data(), gain.data(), (int)input.size());
+
+			for (int i = 0; i < input.size(); i++) {
+				EXPECT_DOUBLE_EQ(output[i], input[i] * gain[i]);
+			}
+		}
+
+		TEST(Expander, SidechainControlsTheGain) {
+			dsptk::Gate sut{ threshold, range, sampleRate, attackTime, releaseTime };
+
+			// Quiet input keyed open by a loud sidechain, both read only
+			const auto input = dsptk::sin(1000., sampleRate, 4800, Amplitude(-60.));
+			const auto sidechain = dsptk::sin(1000., sampleRate, 4800, Amplitude(-20.));
+			std::vector<double> output(input.size());
+			std::vector<double> gain(input.size());
+			sut.ProcessBlock(input, sidechain, output, gain);
+
+			EXPECT_NEAR(gain.back(), 1., 1e-6);
+			EXPECT_DOUBLE_EQ(output.back(), input.back() * gain.back());
+		}
+	}
+}
@@ -891,4 +891,147 @@ namespace filters {
 
 	}
 
-}
\ No newline at end of file
+	namespace biquad {
+
+		double GainDB(const std::vector<double>& input, const std::vector<double>& output) {
+			return 10 * std::log10(dsptk::MeanSquare(output) / dsptk::MeanSquare(input));
+		}
+
+		TEST(ButterworthLowPass, WhenFreqIsFcShouldCut3dB) {
+			dsptk::ButterworthLowPass sut(100., sampleRate);
+
+			auto input = dsptk::sin(100., sampleRate, testSamples);
+			auto output = ProduceOutput(input, sut);
+
+			EXPECT_NEAR(GainDB(input, output), -3.01, .05);
+		}
+
+		TEST(ButterworthLowPass, WhenFreqIsAnOctaveAboveShouldCut12dB) {
+			dsptk::ButterworthLowPass sut(50., sampleRate);
+
+			auto input = dsptk::sin(100., sampleRate, testSamples);
+			auto output = ProduceOutput(input, sut);
+
+			// 12dB/octave slope, -12.3dB for the analog prototype, bilinear transform warping adds a bit more
+			double warped = std::tan(dsptk::PI<double> * 100. / sampleRate) / std::tan(dsptk::PI<double> * 50. / sampleRate);
+			EXPECT_NEAR(GainDB(input, output), -10 * std::log10(1 + std::pow(warped, 4)), .05);
+		}
+
+		TEST(ButterworthHiPass, WhenFreqIsFcShouldCut3dB) {
+			dsptk::ButterworthHiPass sut(100., sampleRate);
+
+			auto input = dsptk::sin(100., sampleRate, testSamples);
+			auto output = ProduceOutput(input, sut);
+
+			EXPECT_NEAR(GainDB(input, output), -3.01, .05);
+		}
+
+		TEST(AllPassFilter, ShouldNotChangeMagnitude) {
+			for (double fTest : { 10., 100., 250., 400. }) {
+				dsptk::AllPassFilter sut(100., sampleRate);
+
+				auto input = dsptk::sin(fTest, sampleRate, testSamples);
+				auto output = ProduceOutput(input, sut);
+
+				EXPECT_NEAR(GainDB(input, output), 0., .01) << fTest;
+			}
+		}
+
+		TEST(LinkwitzRileyCrossover, BandsAre6dBDownAtCrossover) {
+			dsptk::LinkwitzRileyCrossover sut(100., sampleRate);
+
+			auto input = dsptk::sin(100., sampleRate, testSamples);
+			std::vector<double> low(input.size());
+			std::vector<double> high(input.size());
+			for (int i = 0; i < input.size(); i++) {
+				sut.ProcessSample(input[i], low[i], high[i]);
+			}
+
+			EXPECT_NEAR(GainDB(input, low), -6.02, .05);
+			EXPECT_NEAR(GainDB(input, high), -6.02, .05);
+		}
+
+		TEST(LinkwitzRileyCrossover, BandsSumLikeAnAllPass) {
+			dsptk::LinkwitzRileyCrossover sut(100., sampleRate);
+			dsptk::AllPassFilter reference(100., sampleRate);
+
+			for (int i = 0; i < 1000; i++) {
+				double input = i == 0 ? 1. : 0.;
+				double low, high;
+				sut.ProcessSample(input, low, high);
+				EXPECT_NEAR(low + high, reference.ProcessSample(input), 1e-12);
+			}
+		}
+
+		TEST(KWeightingFilter, MatchesStandardCoefficientsAt48k) {
+			// ITU-R BS.1770 coefficients for 48kHz, both stages in direct form I
+			const double b1[] = { 1.53512485958697, -2.69169618940638, 1.19839281085285 };
+			const double a1[] = { 1., -1.69065929318241, 0.73248077421585 };
+			const double b2[] = { 1., -2., 1. };
+			const double a2[] = { 1., -1.99004745483398, 0.99007225036621 };
+
+			dsptk::KWeightingFilter sut(48000.);
+
+			double x[3] = {}, y[3] = {}, z[3] = {};
+			for (int i = 0; i < 2000; i++) {
+				x[2] = x[1]; x[1] = x[0]; x[0] = i == 0 ? 1. : 0.;
+				y[2] = y[1]; y[1] = y[0];
+				y[0] = b1[0] * x[0] + b1[1] * x[1] + b1[2] * x[2] - a1[1] * y[1] - a1[2] * y[2];
+				double out = b2[0] * y[0] + b2[1] * y[1] + b2[2] * y[2] - a2[1] * z[0] - a2[2] * z[1];
+				z[1] = z[0]; z[0] = out;
+
+				EXPECT_NEAR(sut.ProcessSample(x[0]), out, 1e-9) << i;
+			}
+		}
+	}
+
+	namespace filterbank {
+
+		dsptk::FilterBank MakeBank() {
+			dsptk::FilterBank bank;
+			std::shared_ptr<dsptk::Filter> lowpass = std::make_shared<dsptk::ButterworthLowPass>(200., sampleRate);
+			std::shared_ptr<dsptk::Filter> dcBlocker = std::make_shared<dsptk::DCBlocker>(5., sampleRate);
+			bank.AddFilter(lowpass);
+			bank.AddFilter(dcBlocker);
+			return bank;
+		}
+
+		TEST(FilterBank, ProcessBlockMatchesProcessSample) {
+			auto perSample = MakeBank();
+			auto perBlock = MakeBank();
+			auto input = dsptk::sin(50., sampleRate, 1000);
+
+			std::vector<double> output(input.size());
+			for (int start = 0; start < (int)input.size(); start += 100) {
+				perBlock.ProcessBlock(input.data() + start, output.data() + start, 100);
+			}
+
+			for (size_t i = 0; i < input.size(); i++) {
+				EXPECT_NEAR(output[i], perSample.ProcessSample(input[i]), 1e-12) << i;
+			}
+		}
+
+		TEST(FilterBank, ProcessBlockInPlace) {
+			auto reference = MakeBank();
+			auto sut = MakeBank();
+			auto input = dsptk::sin(50., sampleRate, 256);
+
+			std::vector<double> expected(input.size());
+			reference.ProcessBlock(input.data(), expected.data(), (int)input.size());
+			sut.ProcessBlock(input.data(), input.data(), (int)input.size());
+
+			EXPECT_EQ(input, expected);
+		}
+
+		TEST(FilterBank, EmptyBankCopiesTheInput) {
+			dsptk::FilterBank sut;
+			auto input = dsptk::sin(50., sampleRate, 64);
+			std::vector<double> output(input.size());
+
+			sut.ProcessBlock(input.data(), output.data(), (int)input.size());
+
+			EXPECT_EQ(output, input);
+		}
+	}
+
+}
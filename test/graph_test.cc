@@ -0,0 +1,288 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+#include "dsptk/graph.h"
+#include "dsptk/audiobuffer.h"
+
+namespace graph {
+
+	dsptk::AudioBuffer<double> Noise(int numChannels, int nFrames) {
+		dsptk::AudioBuffer<double> buffer(numChannels, nFrames);
+		unsigned state = 1;
+		for (int c = 0; c < numChannels; c++) {
+			for (int f = 0; f < nFrames; f++) {
+				state = state * 1664525u + 1013904223u;
+				buffer[c][f] = (state >> 8) / 16777216. - .5;
+			}
+		}
+		return buffer;
+	}
+
+	// Adds a constant, to tell the paths apart
+	class OffsetNode final : public dsptk::GraphNode {
+	public:
+		explicit OffsetNode(double offset) : GraphNode(1, 1), offset(offset) {}
+
+		void Process(dsptk::BufferView<const double> inputs, dsptk::BufferView<double> outputs) override {
+			for (int f = 0; f < inputs.GetNumFrames(); f++) outputs[0][f] = inputs[0][f] + offset;
+		}
+
+	private:
+		double offset;
+	};
+
+	// Output is the running count of processed frames, and records the block sizes
+	class CounterNode final : public dsptk::GraphNode {
+	public:
+		explicit CounterNode(std::vector<int>& blocks) : GraphNode(0, 1), blocks(blocks) {}
+
+		void Process(dsptk::BufferView<const double> /*inputs*/, dsptk::BufferView<double> outputs) override {
+			blocks.push_back(outputs.GetNumFrames());
+			for (int f = 0; f < outputs.GetNumFrames(); f++) outputs[0][f] = count++;
+		}
+
+	private:
+		std::vector<int>& blocks;
+		int count = 0;
+	};
+
+	namespace topology {
+
+		TEST(ProcessingGraph, RejectsInvalidEdges) {
+			dsptk::ProcessingGraph sut(1, 1);
+			const int node = sut.AddNode(std::make_unique<OffsetNode>(1.));
+			EXPECT_FALSE(sut.Connect(node, 0, node + 1, 0));
+			EXPECT_FALSE(sut.Connect(node, 1, node, 0));
+			EXPECT_FALSE(sut.ConnectInput(1, node, 0));
+			EXPECT_FALSE(sut.ConnectOutput(node, 0, 1));
+			EXPECT_TRUE(sut.ConnectInput(0, node, 0));
+			EXPECT_TRUE(sut.ConnectOutput(node, 0, 0));
+		}
+
+		TEST(ProcessingGraph, CyclesFailToPrepare) {
+			dsptk::ProcessingGraph sut(1, 1);
+			const int a = sut.AddNode(std::make_unique<OffsetNode>(1.));
+			const int b = sut.AddNode(std::make_unique<OffsetNode>(2.));
+			sut.Connect(a, 0, b, 0);
+			EXPECT_TRUE(sut.Prepare(16));
+			sut.Connect(b, 0, a, 0);
+			EXPECT_FALSE(sut.Prepare(16));
+		}
+
+		TEST(ProcessingGraph, UnpreparedGraphsAreSilent) {
+			std::vector<int> blocks;
+			auto makeGraph = [&blocks]() {
+				auto graph = std::make_unique<dsptk::ProcessingGraph>(1, 1);
+				const int counter = graph->AddNode(std::make_unique<CounterNode>(blocks));
+				graph->ConnectOutput(counter, 0, 0);
+				return graph;
+			};
+			dsptk::AudioBuffer<double> input(1, 32);
+			auto expectSilence = [&](dsptk::ProcessingGraph& graph) {
+				dsptk::AudioBuffer<double> output(1, 32);
+				output[0][5] = 1.;
+				EXPECT_FALSE(graph.Process(input, output));
+				EXPECT_EQ(output[0][5], 0.);
+				EXPECT_TRUE(blocks.empty());
+			};
+
+			// Never prepared
+			auto graph = makeGraph();
+			expectSilence(*graph);
+
+			// Prepare failed on a cycle
+			graph = makeGraph();
+			const int a = graph->AddNode(std::make_unique<OffsetNode>(1.));
+			const int b = graph->AddNode(std::make_unique<OffsetNode>(1.));
+			graph->Connect(a, 0, b, 0);
+			graph->Connect(b, 0, a, 0);
+			EXPECT_FALSE(graph->Prepare(16));
+			expectSilence(*graph);
+
+			// A node added after Prepare
+			graph = makeGraph();
+			ASSERT_TRUE(graph->Prepare(16));
+			graph->AddNode(std::make_unique<OffsetNode>(1.));
+			expectSilence(*graph);
+
+			// An edge added after Prepare
+			graph = makeGraph();
+			const int offset = graph->AddNode(std::make_unique<OffsetNode>(1.));
+			ASSERT_TRUE(graph->Prepare(16));
+			graph->ConnectInput(0, offset, 0);
+			expectSilence(*graph);
+
+			// Prepared again
+			ASSERT_TRUE(graph->Prepare(16));
+			dsptk::AudioBuffer<double> output(1, 32);
+			EXPECT_TRUE(graph->Process(input, output));
+			EXPECT_EQ(blocks, std::vector<int>({ 16, 16 }));
+		}
+
+		TEST(ProcessingGraph, InputsSumTheirEdges) {
+			// in -> a (+1) -> c, in -> b (+2) -> c, c (+0) and a -> out
+			dsptk::ProcessingGraph sut(1, 1);
+			const int a = sut.AddNode(std::make_unique<OffsetNode>(1.));
+			const int b = sut.AddNode(std::make_unique<OffsetNode>(2.));
+			const int c = sut.AddNode(std::make_unique<OffsetNode>(0.));
+			sut.ConnectInput(0, a, 0);
+			sut.ConnectInput(0, b, 0);
+			sut.Connect(a, 0, c, 0);
+			sut.Connect(b, 0, c, 0);
+			sut.ConnectOutput(c, 0, 0);
+			sut.ConnectOutput(a, 0, 0);
+			ASSERT_TRUE(sut.Prepare(8));
+
+			dsptk::AudioBuffer<double> input(1, 4);
+			input[0][2] = 10.;
+			dsptk::AudioBuffer<double> output(1, 4);
+			sut.Process(input, output);
+			// (x + 1) + (x + 2) + (x + 1)
+			EXPECT_EQ(output[0][0], 4.);
+			EXPECT_EQ(output[0][2], 34.);
+		}
+
+		TEST(ProcessingGraph, UnconnectedInputsAndOutputsAreSilent) {
+			dsptk::ProcessingGraph sut(1, 2);
+			const int node = sut.AddNode(std::make_unique<OffsetNode>(1.));
+			sut.ConnectOutput(node, 0, 0);
+			ASSERT_TRUE(sut.Prepare(8));
+
+			dsptk::AudioBuffer<double> input(1, 4);
+			input[0][0] = 5.;
+			dsptk::AudioBuffer<double> output(2, 4);
+			output[1][0] = 3.;
+			sut.Process(input, output);
+			EXPECT_EQ(output[0][0], 1.);
+			EXPECT_EQ(output[1][0], 0.);
+		}
+
+		TEST(ProcessingGraph, LongBlocksAreProcessedInChunks) {
+			std::vector<int> blocks;
+			dsptk::ProcessingGraph sut(0, 1);
+			sut.ConnectOutput(sut.AddNode(std::make_unique<CounterNode>(blocks)), 0, 0);
+			ASSERT_TRUE(sut.Prepare(64));
+
+			dsptk::AudioBuffer<double> output(1, 150);
+			sut.Process(dsptk::BufferView<const double>(nullptr, 0, 150), output);
+			EXPECT_EQ(blocks, std::vector<int>({ 64, 64, 22 }));
+			EXPECT_EQ(output[0][149], 149.);
+		}
+	}
+
+	namespace nodes {
+
+		TEST(ProcessingGraph, CompressorNodeMatchesTheCompressor) {
+			const auto input = Noise(1, 3000);
+			dsptk::Compressor compressor(-20., 4., 6., 48000., 5., 50.);
+			dsptk::ProcessingGraph sut(1, 2);
+			const int node = sut.AddNode(std::make_unique<dsptk::CompressorNode>(compressor));
+			sut.ConnectInput(0, node, 0);
+			sut.ConnectOutput(node, 0, 0);
+			sut.ConnectOutput(node, 1, 1);
+			ASSERT_TRUE(sut.Prepare(512));
+			dsptk::AudioBuffer<double> output(2, 3000);
+			sut.Process(input, output);
+
+			compressor.Prepare(512);
+			std::vector<double> expected(3000), gain(3000);
+			compressor.ProcessBlock(input[0].data(), nullptr, expected.data(), gain.data(), 3000);
+			for (int f = 0; f < 3000; f++) {
+				ASSERT_EQ(output[0][f], expected[f]) << f;
+				ASSERT_EQ(output[1][f], gain[f]) << f;
+			}
+		}
+
+		TEST(ProcessingGraph, ConvolverNodeCarriesTheTail) {
+			std::vector<double> impulseResponse(40, 0.);
+			impulseResponse[39] = 1.;
+			const auto input = Noise(1, 200);
+			dsptk::ProcessingGraph sut(1, 1);
+			const int node = sut.AddNode(std::make_unique<dsptk::ConvolverNode>(impulseResponse));
+			sut.ConnectInput(0, node, 0);
+			sut.ConnectOutput(node, 0, 0);
+			ASSERT_TRUE(sut.Prepare(16));
+			dsptk::AudioBuffer<double> output(1, 200);
+			sut.Process(input, output);
+
+			for (int f = 0; f < 200; f++) {
+				ASSERT_NEAR(output[0][f], f < 39 ? 0. : input[0][f - 39], 1e-12) << f;
+			}
+		}
+	}
+
+	// A 16 channel mix: per channel filters and compressor, two buses with a convolution reverb send, a
+	// master compressor
+	namespace parallel {
+
+		const int numChannels = 16;
+
+		std::unique_ptr<dsptk::ProcessingGraph> MakeMix() {
+			auto graph = std::make_unique<dsptk::ProcessingGraph>(numChannels, 2);
+			const double sampleRate = 48000.;
+			const int buses[2] = {
+				graph->AddNode(std::make_unique<dsptk::GainNode>(1, .5)),
+				graph->AddNode(std::make_unique<dsptk::GainNode>(1, .5)),
+			};
+			std::vector<double> impulseResponse(300);
+			for (int i = 0; i < 300; i++) impulseResponse[i] = std::exp(-i / 50.) * ((i * 7919) % 13 - 6) / 20.;
+			const int reverb = graph->AddNode(std::make_unique<dsptk::ConvolverNode>(impulseResponse));
+
+			for (int c = 0; c < numChannels; c++) {
+				dsptk::FilterBank bank;
+				std::shared_ptr<dsptk::Filter> highPass = std::make_shared<dsptk::ButterworthHiPass>(40. + c, sampleRate);
+				std::shared_ptr<dsptk::Filter> peak = std::make_shared<dsptk::ParametricFilter>(500. + 100. * c, 200., dsptk::DB(-3.), sampleRate);
+				bank.AddFilter(highPass);
+				bank.AddFilter(peak);
+				const int eq = graph->AddNode(std::make_unique<dsptk::FilterBankNode>(bank));
+				const int compressor = graph->AddNode(std::make_unique<dsptk::CompressorNode>(dsptk::Compressor(-18. - c, 3., 6., sampleRate, 5., 80.)));
+				const int send = graph->AddNode(std::make_unique<dsptk::FilterNode>(std::make_shared<dsptk::SinglePoleLowPass>(4000., sampleRate)));
+				graph->ConnectInput(c, eq, 0);
+				graph->Connect(eq, 0, compressor, 0);
+				graph->Connect(compressor, 0, buses[c % 2], 0);
+				graph->Connect(compressor, 0, send, 0);
+				graph->Connect(send, 0, reverb, 0);
+			}
+
+			const int master = graph->AddNode(std::make_unique<dsptk::CompressorNode>(dsptk::Compressor(-12., 2., 6., sampleRate, 10., 100.), true));
+			graph->Connect(buses[0], 0, master, 0);
+			graph->Connect(buses[1], 0, master, 0);
+			graph->Connect(reverb, 0, master, 0);
+			graph->Connect(buses[0], 0, master, 1);
+			graph->ConnectOutput(master, 0, 0);
+			graph->ConnectOutput(reverb, 0, 1);
+			return graph;
+		}
+
+		// Blocks of 1000 frames, chunked by the graph
+		dsptk::AudioBuffer<double> ProcessMix(const dsptk::AudioBuffer<double>& input, dsptk::WorkStealingPool* pool) {
+			auto graph = MakeMix();
+			EXPECT_TRUE(graph->Prepare(256));
+			dsptk::AudioBuffer<double> output(2, input.GetNumFrames());
+			for (int offset = 0; offset < input.GetNumFrames(); offset += 1000) {
+				const int n = std::min(1000, input.GetNumFrames() - offset);
+				graph->Process(input.SubBlock(offset, n), output.SubBlock(offset, n), pool);
+			}
+			return output;
+		}
+
+		TEST(ProcessingGraph, ParallelOutputIsBitExact) {
+			const int nFrames = 48000 / 4;
+			const auto input = Noise(numChannels, nFrames);
+			const auto expected = ProcessMix(input, nullptr);
+
+			for (int numThreads : { 1, 2, 4 }) {
+				dsptk::WorkStealingPool pool(numThreads);
+				const auto output = ProcessMix(input, &pool);
+
+				int differences = 0;
+				for (int c = 0; c < 2; c++) {
+					for (int f = 0; f < nFrames; f++) differences += output[c][f] != expected[c][f];
+				}
+				EXPECT_EQ(differences, 0) << numThreads << " threads";
+			}
+		}
+	}
+}
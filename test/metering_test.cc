@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "dsptk/metering.h"
+#include "dsptk/signals.h"
+#include "dsptk/constants.h"
+
+namespace metering {
+
+	namespace loudness {
+
+		// Test Values
+		const double sampleRate = 48000.;
+		const int blockSize = 512;
+
+		// Feeds the same signal to every channel in blocks
+		void Feed(dsptk::LoudnessMeter& sut, const std::vector<double>& signal, int numChannels) {
+			std::vector<const double*> channels(numChannels);
+			for (int start = 0; start < signal.size(); start += blockSize) {
+				for (auto& channel : channels) {
+					channel = signal.data() + start;
+				}
+				sut.ProcessBlock(channels.data(), std::min(blockSize, (int)signal.size() - start));
+			}
+		}
+
+		std::vector<double> Sine(double dBFS, double seconds) {
+			return dsptk::sin(1000., sampleRate, (int)(seconds * sampleRate), std::pow(10., dBFS / 20.));
+		}
+
+		TEST(LoudnessMeter, SilenceIsMinusInfinity) {
+			dsptk::LoudnessMeter sut(2, sampleRate);
+
+			Feed(sut, std::vector<double>(48000, 0.), 2);
+
+			EXPECT_EQ(sut.GetIntegratedLoudness(), -INFINITY);
+			EXPECT_EQ(sut.GetMomentaryLoudness(), -INFINITY);
+		}
+
+		// EBU Tech 3341 case 1: stereo 1kHz sine at -23dBFS reads -23 LUFS
+		TEST(LoudnessMeter, StereoSineAtMinus23) {
+			dsptk::LoudnessMeter sut(2, sampleRate);
+
+			Feed(sut, Sine(-23., 20.), 2);
+
+			EXPECT_NEAR(sut.GetMomentaryLoudness(), -23., .1);
+			EXPECT_NEAR(sut.GetShortTermLoudness(), -23., .1);
+			EXPECT_NEAR(sut.GetIntegratedLoudness(), -23., .1);
+		}
+
+		// EBU Tech 3341 case 3: -36, -23, -36 dBFS sections, the relative gate drops the quiet parts
+		TEST(LoudnessMeter, RelativeGate) {
+			dsptk::LoudnessMeter sut(2, sampleRate);
+
+			Feed(sut, Sine(-36., 10.), 2);
+			Feed(sut, Sine(-23., 60.), 2);
+			Feed(sut, Sine(-36., 10.), 2);
+
+			EXPECT_NEAR(sut.GetIntegratedLoudness(), -23., .1);
+		}
+
+		// Silence is below the absolute gate and doesn't change the integrated loudness
+		TEST(LoudnessMeter, AbsoluteGate) {
+			dsptk::LoudnessMeter sut(2, sampleRate);
+
+			Feed(sut, Sine(-23., 20.), 2);
+			Feed(sut, std::vector<double>(20 * 48000, 0.), 2);
+
+			EXPECT_NEAR(sut.GetIntegratedLoudness(), -23., .1);
+			EXPECT_EQ(sut.GetMomentaryLoudness(), -INFINITY);
+		}
+
+		TEST(LoudnessMeter, ChannelWeights) {
+			dsptk::LoudnessMeter sut(2, sampleRate);
+			sut.SetChannelWeight(1, 0.);
+
+			Feed(sut, Sine(-23., 5.), 2);
+
+			// Only one channel counts, 3dB less
+			EXPECT_NEAR(sut.GetIntegratedLoudness(), -26.01, .1);
+		}
+
+		TEST(LoudnessMeter, ResetClearsMeasurements) {
+			dsptk::LoudnessMeter sut(1, sampleRate);
+
+			Feed(sut, Sine(-10., 5.), 1);
+			sut.Reset();
+			Feed(sut, Sine(-30., 5.), 1);
+
+			EXPECT_NEAR(sut.GetIntegratedLoudness(), -33.01, .1);
+		}
+	}
+
+	namespace truepeak {
+
+		// Test Values
+		const int blockSize = 256;
+		const int testSamples = 4800;
+
+		double MeterPeak(dsptk::TruePeakMeter& sut, const std::vector<double>& signal) {
+			const double* channels[] = { signal.data() };
+			for (int start = 0; start < signal.size(); start += blockSize) {
+				channels[0] = signal.data() + start;
+				sut.ProcessBlock(channels, std::min(blockSize, (int)signal.size() - start));
+			}
+			return sut.GetMaxPeak(0);
+		}
+
+		TEST(TruePeakMeter, SilenceIsZero) {
+			dsptk::TruePeakMeter sut(1, blockSize);
+
+			EXPECT_EQ(MeterPeak(sut, std::vector<double>(testSamples, 0.)), 0.);
+		}
+
+		TEST(TruePeakMeter, LowFrequencyPeakIsSamplePeak) {
+			dsptk::TruePeakMeter sut(1, blockSize);
+
+			auto input = dsptk::sin(.01, testSamples, .5);
+
+			EXPECT_NEAR(MeterPeak(sut, input), .5, .005);
+		}
+
+		// A sine at a quarter of the sample rate with 45 degrees phase has all its samples at +-0.707
+		TEST(TruePeakMeter, FindsInterSamplePeaks) {
+			dsptk::TruePeakMeter sut(1, blockSize);
+
+			std::vector<double> input(testSamples);
+			for (int i = 0; i < input.size(); i++) {
+				input[i] = std::sin(dsptk::DOUBLE_PI<double> * .25 * i + dsptk::PI<double> / 4.);
+			}
+
+			double samplePeak = *std::max_element(input.begin(), input.end());
+			EXPECT_NEAR(samplePeak, std::sqrt(.5), 1e-9);
+			EXPECT_NEAR(MeterPeak(sut, input), 1., .02);
+			EXPECT_NEAR(sut.GetMaxPeakDB(0), 0., .2);
+		}
+
+		TEST(TruePeakMeter, ChannelsAreIndependentAndBlocksChunked) {
+			// Prepared for smaller blocks than the ones received
+			dsptk::TruePeakMeter sut(2, 100);
+
+			auto loud = dsptk::sin(.01, 1000, .9);
+			auto quiet = dsptk::sin(.01, 1000, .1);
+			const double* channels[] = { loud.data(), quiet.data() };
+			sut.ProcessBlock(channels, 1000);
+
+			EXPECT_NEAR(sut.GetBlockPeak(0), .9, .01);
+			EXPECT_NEAR(sut.GetBlockPeak(1), .1, .01);
+
+			sut.Reset();
+			EXPECT_EQ(sut.GetMaxPeak(0), 0.);
+		}
+	}
+}
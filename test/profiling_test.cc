@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "dsptk/profiling.h"
+#include "dsptk/dynamics.h"
+#include "dsptk/filters.h"
+#include "dsptk/signals.h"
+
+namespace profiling {
+
+	namespace profiler {
+
+		TEST(Profiler, RecordAccumulates) {
+			dsptk::profiling::Profiler sut({ "a", "b" });
+
+			sut.Record(0, 100, 64);
+			sut.Record(0, 300, 64);
+			sut.Record(1, 50, 32);
+
+			auto snapshot = sut.Snapshot();
+			ASSERT_EQ(snapshot.size(), 2);
+			EXPECT_EQ(snapshot[0].name, "a");
+			EXPECT_EQ(snapshot[0].cycles, 400);
+			EXPECT_EQ(snapshot[0].maxCycles, 300);
+			EXPECT_EQ(snapshot[0].samples, 128);
+			EXPECT_EQ(snapshot[0].calls, 2);
+			EXPECT_EQ(snapshot[1].name, "b");
+			EXPECT_EQ(snapshot[1].cycles, 50);
+			EXPECT_EQ(snapshot[1].calls, 1);
+		}
+
+		TEST(Profiler, ResetZeroesTheCounters) {
+			dsptk::profiling::Profiler sut({ "a" });
+			sut.Record(0, 100, 64);
+
+			sut.Reset();
+
+			auto snapshot = sut.Snapshot();
+			EXPECT_EQ(snapshot[0].name, "a");
+			EXPECT_EQ(snapshot[0].cycles, 0);
+			EXPECT_EQ(snapshot[0].maxCycles, 0);
+			EXPECT_EQ(snapshot[0].samples, 0);
+			EXPECT_EQ(snapshot[0].calls, 0);
+		}
+
+		TEST(Profiler, StagesKeepTheirCountersWhenOthersChange) {
+			dsptk::profiling::Profiler sut;
+			EXPECT_EQ(sut.AddStage("a"), 0);
+			EXPECT_EQ(sut.AddStage("b"), 1);
+			sut.Record(1, 10, 1);
+			EXPECT_EQ(sut.AddStage("c"), 2);
+			sut.Record(2, 20, 1);
+
+			sut.RemoveStage(0);
+
+			auto snapshot = sut.Snapshot();
+			ASSERT_EQ(snapshot.size(), 2);
+			EXPECT_EQ(snapshot[0].name, "b");
+			EXPECT_EQ(snapshot[0].cycles, 10);
+			EXPECT_EQ(snapshot[1].name, "c");
+			EXPECT_EQ(snapshot[1].cycles, 20);
+		}
+
+		TEST(Profiler, ScopedStageRecordsACall) {
+			dsptk::profiling::Profiler sut({ "a" });
+			{
+				dsptk::profiling::ScopedStage stage(sut, 0, 256);
+			}
+
+			auto snapshot = sut.Snapshot();
+			EXPECT_EQ(snapshot[0].calls, 1);
+			EXPECT_EQ(snapshot[0].samples, 256);
+			EXPECT_EQ(snapshot[0].cycles, snapshot[0].maxCycles);
+		}
+
+		TEST(Profiler, CyclesAdvance) {
+			auto start = dsptk::profiling::ReadCycles();
+			std::this_thread::sleep_for(std::chrono::milliseconds(2));
+			EXPECT_GT(dsptk::profiling::ReadCycles(), start);
+			EXPECT_GT(dsptk::profiling::CyclesPerSecond(), 1e6);
+		}
+
+		TEST(Profiler, SnapshotsAreConsistentWhileRecording) {
+			// Every record adds the same amounts to both stages, a torn snapshot would show them different
+			dsptk::profiling::Profiler sut({ "a", "b" });
+			std::atomic<bool> done{ false };
+			std::atomic<int> inconsistent{ 0 };
+			std::atomic<int> snapshots{ 0 };
+
+			std::thread monitor([&] {
+				while (!done.load()) {
+					auto snapshot = sut.Snapshot();
+					if (snapshot[0].cycles != snapshot[1].cycles || snapshot[0].calls != snapshot[1].calls
+						|| snapshot[0].samples != snapshot[1].samples) {
+						inconsistent++;
+					}
+					snapshots++;
+				}
+			});
+
+			for (int i = 0; i < 200000 || snapshots.load() < 100; i++) {
+				sut.Record(0, i, 1);
+				sut.Record(1, i, 1);
+				if (i % 1000 == 0) {
+					std::this_thread::yield();
+				}
+			}
+			done = true;
+			monitor.join();
+
+			EXPECT_EQ(inconsistent.load(), 0);
+		}
+	}
+
+#ifdef DSPTK_ENABLE_PROFILING
+	namespace instrumented {
+
+		const double sampleRate = 48000.;
+		const int blockSize = 256;
+
+		TEST(FilterBankProfiling, OneStagePerFilter) {
+			dsptk::FilterBank sut;
+			std::shared_ptr<dsptk::Filter> lowpass = std::make_shared<dsptk::ButterworthLowPass>(1000., sampleRate);
+			std::shared_ptr<dsptk::Filter> hipass = std::make_shared<dsptk::ButterworthHiPass>(100., sampleRate);
+			sut.AddFilter(lowpass);
+			sut.AddFilter(hipass);
+			auto signal = dsptk::sin(440., sampleRate, blockSize);
+
+			for (int i = 0; i < 4; i++) {
+				sut.ProcessBlock(signal.data(), signal.data(), blockSize);
+			}
+
+			auto snapshot = sut.GetProfiler().Snapshot();
+			ASSERT_EQ(snapshot.size(), 2);
+			for (const auto& stage : snapshot) {
+				EXPECT_EQ(stage.calls, 4);
+				EXPECT_EQ(stage.samples, 4 * blockSize);
+				EXPECT_GT(stage.cycles, 0);
+			}
+
+			sut.RemoveFilterAt(0);
+			EXPECT_EQ(sut.GetProfiler().GetNumStages(), 1);
+		}
+
+		TEST(CompressorProfiling, RecordsEveryStage) {
+			dsptk::Compressor sut(-20., 4., 6., sampleRate, 5., 50.);
+			auto signal = dsptk::sin(440., sampleRate, blockSize);
+			std::vector<double> output(blockSize), gain(blockSize);
+
+			sut.ProcessBlock(signal.data(), nullptr, output.data(), gain.data(), blockSize);
+
+			auto snapshot = sut.GetProfiler().Snapshot();
+			ASSERT_EQ(snapshot.size(), 4);
+			EXPECT_EQ(snapshot[dsptk::Compressor::Level].name, "level");
+			EXPECT_EQ(snapshot[dsptk::Compressor::Gain].name, "gain");
+			for (const auto& stage : snapshot) {
+				EXPECT_EQ(stage.calls, 1);
+				EXPECT_EQ(stage.samples, blockSize);
+			}
+		}
+	}
+#endif
+
+}
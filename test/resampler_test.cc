@@ -0,0 +1,297 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <vector>
+#include "dsptk/resampler.h"
+#include "dsptk/audiobuffer.h"
+#include "dsptk/constants.h"
+#include "dsptk/signals.h"
+
+namespace resampler {
+
+	using dsptk::Resampler;
+	using dsptk::ResamplerQuality;
+
+	// Resamples a mono signal in blocks of blockSize input samples
+	std::vector<double> Resample(Resampler& resampler, const std::vector<double>& input, int blockSize) {
+		resampler.Prepare(blockSize);
+		std::vector<double> result;
+		dsptk::AudioBuffer<double> output(1, resampler.GetMaxOutputFrames(blockSize));
+		for (std::size_t start = 0; start < input.size(); start += blockSize) {
+			const int nFrames = (int)std::min<std::size_t>(blockSize, input.size() - start);
+			const double* channel = input.data() + start;
+			const int nOutput = resampler.ProcessBlock(dsptk::BufferView<const double>(&channel, 1, nFrames), output.GetView());
+			result.insert(result.end(), output[0].data(), output[0].data() + nOutput);
+		}
+		return result;
+	}
+
+	std::vector<double> Sine(double frequency, double samplerate, int nFrames) {
+		return dsptk::sin(frequency, samplerate, nFrames, .5);
+	}
+
+	// Largest difference with the input sine at the output rate, delayed by the latency, past the start up
+	double SineError(const std::vector<double>& output, double frequency, double outputRate, double delay) {
+		double error = 0.;
+		for (std::size_t n = (std::size_t)(2. * delay * outputRate) + 1; n < output.size(); n++) {
+			const double expected = .5 * std::sin(dsptk::DOUBLE_PI<double> * frequency * (n / outputRate - delay));
+			error = std::max(error, std::fabs(output[n] - expected));
+		}
+		return error;
+	}
+
+	double Rms(const std::vector<double>& values, std::size_t start) {
+		double sum = 0.;
+		for (std::size_t i = start; i < values.size(); i++) sum += values[i] * values[i];
+		return std::sqrt(sum / (values.size() - start));
+	}
+
+	namespace table {
+
+		TEST(PolyphaseTable, IsSharedBetweenResamplersOfTheSameDesign) {
+			const auto a = dsptk::PolyphaseTable::Get(32, 16, .45, 80.);
+			const auto b = dsptk::PolyphaseTable::Get(32, 16, .45, 80.);
+			const auto c = dsptk::PolyphaseTable::Get(32, 16, .4, 80.);
+			EXPECT_EQ(a.get(), b.get());
+			EXPECT_NE(a.get(), c.get());
+		}
+
+		TEST(PolyphaseTable, EveryPhaseHasUnityGain) {
+			const auto table = dsptk::PolyphaseTable::Get(24, 7, .4, 90.);
+			for (int p = 0; p <= table->GetNumPhases(); p++) {
+				const double* taps = table->GetPhase(p);
+				EXPECT_NEAR(std::accumulate(taps, taps + table->GetNumTaps(), 0.), 1., 1e-14) << p;
+			}
+		}
+
+		TEST(PolyphaseTable, PhasesMirrorEachOther) {
+			// The kernel is symmetric around its center, phase p reversed is phase numPhases - p
+			const auto table = dsptk::PolyphaseTable::Get(16, 5, .45, 80.);
+			for (int p = 0; p <= 5; p++) {
+				const double* taps = table->GetPhase(p);
+				const double* mirror = table->GetPhase(5 - p);
+				for (int i = 0; i < 16; i++) {
+					EXPECT_NEAR(taps[i], mirror[15 - i], 1e-15) << p << " " << i;
+				}
+			}
+		}
+	}
+
+	namespace conversion {
+
+		TEST(Resampler, ConvertsASineFrom44100To48000) {
+			Resampler resampler(1, 160, 147);
+			ASSERT_TRUE(resampler.IsRational());
+			const auto output = Resample(resampler, Sine(1000., 44100., 44100), 512);
+			EXPECT_LT(SineError(output, 1000., 48000., resampler.GetLatency() / 44100.), 3e-5);
+		}
+
+		TEST(Resampler, ConvertsASineFrom96000To44100) {
+			auto resampler = Resampler::ForRates(1, 96000., 44100.);
+			ASSERT_TRUE(resampler.IsRational());
+			const auto output = Resample(resampler, Sine(15000., 96000., 96000), 1000);
+			EXPECT_LT(SineError(output, 15000., 44100., resampler.GetLatency() / 96000.), 3e-5);
+		}
+
+		TEST(Resampler, DcPassesUnchanged) {
+			for (double ratio : { 160. / 147., 147. / 160., 2.5, .3 }) {
+				Resampler resampler(1, ratio);
+				const auto output = Resample(resampler, std::vector<double>(2000, .7), 256);
+				for (std::size_t n = (std::size_t)(2. * resampler.GetLatency() * ratio) + 1; n < output.size(); n++) {
+					ASSERT_NEAR(output[n], .7, 1e-13) << ratio << " " << n;
+				}
+			}
+		}
+
+		TEST(Resampler, OutputCountFollowsTheRatio) {
+			// Outputs at n M / L input samples, before the end of the input
+			Resampler resampler(1, 160, 147);
+			const auto output = Resample(resampler, std::vector<double>(10000), 333);
+			EXPECT_EQ((int)output.size(), (10000 * 160 + 146) / 147);
+
+			Resampler down(1, 1, 3);
+			EXPECT_EQ((int)Resample(down, std::vector<double>(1000), 100).size(), (1000 + 2) / 3);
+		}
+
+		TEST(Resampler, ArbitraryRatioMatchesTheRationalOne) {
+			const auto input = Sine(3000., 44100., 20000);
+			Resampler rational(1, 160, 147);
+			Resampler arbitrary(1, 160. / 147.);
+			ASSERT_FALSE(arbitrary.IsRational());
+			const auto expected = Resample(rational, input, 1024);
+			const auto output = Resample(arbitrary, input, 1024);
+			ASSERT_EQ(output.size(), expected.size());
+			for (std::size_t n = 0; n < output.size(); n++) {
+				ASSERT_NEAR(output[n], expected[n], 1e-5) << n;
+			}
+		}
+
+		TEST(Resampler, RatiosWithTooManyPhasesBecomeArbitrary) {
+			auto resampler = Resampler::ForRates(1, 44100., 48001.);
+			EXPECT_FALSE(resampler.IsRational());
+			EXPECT_DOUBLE_EQ(resampler.GetRatio(), 48001. / 44100.);
+			const auto output = Resample(resampler, Sine(1000., 44100., 20000), 512);
+			EXPECT_LT(SineError(output, 1000., 48001., resampler.GetLatency() / 44100.), 3e-5);
+
+			EXPECT_FALSE(Resampler::ForRates(1, 44100.5, 48000.).IsRational());
+		}
+	}
+
+	namespace quality {
+
+		class Qualities : public ::testing::TestWithParam<ResamplerQuality> {};
+
+		// A tone above the output Nyquist frequency is removed down to the stopband attenuation of the preset
+		TEST_P(Qualities, RejectsAliases) {
+			const double attenuation[] = { 70., 100., 140. };
+			for (double frequency : { 22500., 30000., 45000. }) {
+				auto resampler = Resampler::ForRates(1, 96000., 44100., GetParam());
+				const auto output = Resample(resampler, Sine(frequency, 96000., 48000), 1024);
+				const double level = 20. * std::log10(Rms(output, (std::size_t)(2. * resampler.GetLatency() * resampler.GetRatio())) / (.5 / std::sqrt(2.)));
+				EXPECT_LT(level, -attenuation[(int)GetParam()]) << frequency;
+			}
+		}
+
+		TEST_P(Qualities, PassesThePassband) {
+			const double passband[] = { 16000., 19000., 19800. };
+			auto resampler = Resampler::ForRates(1, 44100., 48000., GetParam());
+			const double frequency = passband[(int)GetParam()];
+			const auto output = Resample(resampler, Sine(frequency, 44100., 44100), 1024);
+			EXPECT_LT(SineError(output, frequency, 48000., resampler.GetLatency() / 44100.), .01);
+		}
+
+		TEST_P(Qualities, VariableRatioRejectsAliasesAtItsLowestRatio) {
+			Resampler resampler(1, 1., GetParam(), .5);
+			EXPECT_TRUE(resampler.SetRatio(.5));
+			const auto output = Resample(resampler, Sine(30000., 96000., 48000), 1024);
+			EXPECT_LT(20. * std::log10(Rms(output, (std::size_t)(2. * resampler.GetLatency() * resampler.GetRatio())) / .35), -60.);
+		}
+
+		INSTANTIATE_TEST_SUITE_P(Resampler, Qualities, ::testing::Values(ResamplerQuality::Fast, ResamplerQuality::Normal, ResamplerQuality::High));
+	}
+
+	namespace streaming {
+
+		TEST(Resampler, BlockSizesDontChangeTheOutput) {
+			dsptk::RandomGenerator random(3);
+			std::vector<double> input(5000);
+			random.FillUniform(input.data(), (int)input.size());
+			for (bool rational : { true, false }) {
+				Resampler whole = rational ? Resampler(1, 3, 7) : Resampler(1, 3. / 7.);
+				const auto expected = Resample(whole, input, 5000);
+				for (int blockSize : { 1, 7, 64, 1000 }) {
+					Resampler blocks = rational ? Resampler(1, 3, 7) : Resampler(1, 3. / 7.);
+					const auto output = Resample(blocks, input, blockSize);
+					ASSERT_EQ(output.size(), expected.size()) << blockSize;
+					EXPECT_EQ(std::memcmp(output.data(), expected.data(), output.size() * sizeof(double)), 0) << blockSize;
+				}
+			}
+		}
+
+		TEST(Resampler, BlocksLongerThanPreparedAreChunked) {
+			dsptk::RandomGenerator random(4);
+			std::vector<double> input(5000);
+			random.FillUniform(input.data(), (int)input.size());
+			for (bool rational : { true, false }) {
+				Resampler reference = rational ? Resampler(1, 160, 147) : Resampler(1, 160. / 147.);
+				const auto expected = Resample(reference, input, 100);
+
+				// Prepared for less, and never prepared (1024 by default)
+				Resampler prepared = rational ? Resampler(1, 160, 147) : Resampler(1, 160. / 147.);
+				prepared.Prepare(100);
+				Resampler unprepared = rational ? Resampler(1, 160, 147) : Resampler(1, 160. / 147.);
+				for (Resampler* resampler : { &prepared, &unprepared }) {
+					dsptk::AudioBuffer<double> output(1, resampler->GetMaxOutputFrames(5000));
+					const double* channel = input.data();
+					const int nOutput = resampler->ProcessBlock(dsptk::BufferView<const double>(&channel, 1, 5000), output.GetView());
+					ASSERT_EQ(nOutput, (int)expected.size());
+					EXPECT_EQ(std::memcmp(output[0].data(), expected.data(), expected.size() * sizeof(double)), 0);
+				}
+			}
+		}
+
+#ifdef NDEBUG
+		TEST(Resampler, EmptyChunksProcessOneFrameAtATime) {
+			const auto input = Sine(1000., 44100., 1000);
+			Resampler reference(1, 160, 147);
+			const auto expected = Resample(reference, input, 1);
+
+			Resampler resampler(1, 160, 147);
+			resampler.Prepare(0);
+			dsptk::AudioBuffer<double> output(1, resampler.GetMaxOutputFrames(1000));
+			const double* channel = input.data();
+			const int nOutput = resampler.ProcessBlock(dsptk::BufferView<const double>(&channel, 1, 1000), output.GetView());
+			ASSERT_EQ(nOutput, (int)expected.size());
+			EXPECT_EQ(std::memcmp(output[0].data(), expected.data(), expected.size() * sizeof(double)), 0);
+		}
+#else
+		TEST(ResamplerDeathTest, EmptyChunksAssertInDebug) {
+			Resampler resampler(1, 160, 147);
+			EXPECT_DEATH(resampler.Prepare(0), "maxBlockSize > 0");
+		}
+#endif
+
+		TEST(Resampler, ChannelsAreIndependent) {
+			const auto left = Sine(440., 48000., 4000);
+			const auto right = Sine(5000., 48000., 4000);
+			dsptk::AudioBuffer<double> input(2, 4000);
+			std::copy(left.begin(), left.end(), input[0].begin());
+			std::copy(right.begin(), right.end(), input[1].begin());
+
+			Resampler stereo(2, 147, 160);
+			stereo.Prepare(4000);
+			dsptk::AudioBuffer<double> output(2, stereo.GetMaxOutputFrames(4000));
+			const int nOutput = stereo.ProcessBlock(input.GetView(), output.GetView());
+
+			Resampler mono(1, 147, 160);
+			const auto expectedLeft = Resample(mono, left, 4000);
+			const auto expectedRight = Resample(mono, right, 4000);
+			ASSERT_EQ(nOutput, (int)expectedLeft.size());
+			for (int n = 0; n < nOutput; n++) {
+				ASSERT_EQ(output[0][n], expectedLeft[n]);
+				ASSERT_EQ(output[1][n], expectedRight[n]);
+			}
+		}
+
+		TEST(Resampler, ResetStartsANewStream) {
+			const auto input = Sine(1000., 48000., 3000);
+			Resampler resampler(1, 2, 3);
+			const auto first = Resample(resampler, input, 500);
+			resampler.Reset();
+			EXPECT_EQ(Resample(resampler, input, 500), first);
+		}
+
+		TEST(Resampler, SetRatioChangesTheArbitraryRatioOnly) {
+			Resampler variable(1, 1.5, ResamplerQuality::Normal, 1.);
+			EXPECT_TRUE(variable.SetRatio(1.));
+			EXPECT_TRUE(variable.SetRatio(2.));
+			EXPECT_FALSE(variable.SetRatio(.9));
+			EXPECT_EQ(variable.GetRatio(), 2.);
+			EXPECT_EQ((int)Resample(variable, std::vector<double>(1000), 100).size(), 2000);
+
+			Resampler rational(1, 3, 2);
+			EXPECT_FALSE(rational.SetRatio(1.));
+			EXPECT_EQ(rational.GetRatio(), 1.5);
+		}
+
+		TEST(Resampler, RatioChangesKeepTheSignalContinuous) {
+			// A slow sine read at a varying speed never jumps
+			const auto input = Sine(200., 48000., 48000);
+			Resampler resampler(1, 1., ResamplerQuality::Normal, .5);
+			resampler.Prepare(100);
+			std::vector<double> output;
+			dsptk::AudioBuffer<double> block(1, resampler.GetMaxOutputFrames(100) * 2);
+			for (int start = 0; start < 48000; start += 100) {
+				resampler.SetRatio(1.5 + .5 * std::sin(start * 1e-3));
+				const double* channel = input.data() + start;
+				const int nOutput = resampler.ProcessBlock(dsptk::BufferView<const double>(&channel, 1, 100), block.GetView());
+				output.insert(output.end(), block[0].data(), block[0].data() + nOutput);
+			}
+			for (std::size_t n = 1; n < output.size(); n++) {
+				ASSERT_LT(std::fabs(output[n] - output[n - 1]), .02) << n;
+			}
+		}
+	}
+}
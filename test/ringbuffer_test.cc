@@ -0,0 +1,196 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <cstdint>
+#include <random>
+#include <thread>
+#include <vector>
+#include "dsptk/ringbuffer.h"
+#include "dsptk/audiobuffer.h"
+
+namespace ringbuffer {
+
+	namespace single {
+
+		TEST(RingBuffer, CapacityIsRoundedToAPowerOfTwo) {
+			EXPECT_EQ(dsptk::RingBuffer<float>(1).GetCapacity(), 1);
+			EXPECT_EQ(dsptk::RingBuffer<float>(100).GetCapacity(), 128);
+			EXPECT_EQ(dsptk::RingBuffer<float>(128).GetCapacity(), 128);
+		}
+
+		TEST(RingBuffer, WritesUntilFullReadsUntilEmpty) {
+			dsptk::RingBuffer<int> sut(8);
+			const int input[10] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+
+			EXPECT_EQ(sut.Write(input, 10), 8);
+			EXPECT_EQ(sut.GetWriteAvailable(), 0);
+			EXPECT_EQ(sut.GetReadAvailable(), 8);
+
+			int output[10] = {};
+			EXPECT_EQ(sut.Read(output, 3), 3);
+			EXPECT_THAT(std::vector<int>(output, output + 3), ::testing::ElementsAre(0, 1, 2));
+			EXPECT_EQ(sut.Write(input + 8, 2), 2);
+			EXPECT_EQ(sut.Read(output, 10), 7);
+			EXPECT_THAT(std::vector<int>(output, output + 7), ::testing::ElementsAre(3, 4, 5, 6, 7, 8, 9));
+			EXPECT_EQ(sut.GetReadAvailable(), 0);
+			EXPECT_EQ(sut.Read(output, 1), 0);
+		}
+
+		TEST(RingBuffer, SpansWrapAroundTheEnd) {
+			dsptk::RingBuffer<int> sut(8);
+			int scratch[6];
+			sut.Write(scratch, 6);
+			sut.Read(scratch, 6);
+
+			auto write = sut.PrepareWrite(5);
+			EXPECT_EQ(write.first.size(), 2);
+			EXPECT_EQ(write.second.size(), 3);
+			for (int i = 0; i < write.first.size(); i++) write.first[i] = 10 + i;
+			for (int i = 0; i < write.second.size(); i++) write.second[i] = 12 + i;
+			sut.CommitWrite(write.size());
+
+			auto read = sut.PrepareRead(8);
+			ASSERT_EQ(read.size(), 5);
+			EXPECT_EQ(read.first.data() + read.first.size(), read.second.data() + sut.GetCapacity());
+			EXPECT_THAT(std::vector<int>(read.first.begin(), read.first.end()), ::testing::ElementsAre(10, 11));
+			EXPECT_THAT(std::vector<int>(read.second.begin(), read.second.end()), ::testing::ElementsAre(12, 13, 14));
+			sut.CommitRead(2);
+			EXPECT_EQ(sut.GetReadAvailable(), 3);
+		}
+
+		TEST(RingBuffer, UncommittedSlotsAreNotVisible) {
+			dsptk::RingBuffer<int> sut(4);
+			auto spans = sut.PrepareWrite(4);
+			spans.first[0] = 1;
+
+			EXPECT_EQ(sut.GetReadAvailable(), 0);
+			sut.CommitWrite(1);
+			EXPECT_EQ(sut.GetReadAvailable(), 1);
+		}
+
+		TEST(RingBuffer, ProducerAndConsumerDontShareCacheLines) {
+			EXPECT_EQ(alignof(dsptk::RingIndices), dsptk::RingIndices::cacheLineSize);
+			// Constants, producer and consumer lines
+			EXPECT_GE(sizeof(dsptk::RingIndices), 3 * dsptk::RingIndices::cacheLineSize);
+		}
+	}
+
+	namespace multichannel {
+
+		TEST(MultichannelRingBuffer, MovesFramesOfEveryChannel) {
+			dsptk::MultichannelRingBuffer<double> sut(3, 16);
+			dsptk::AudioBuffer<double> input(3, 12);
+			for (int c = 0; c < 3; c++) {
+				for (int f = 0; f < 12; f++) input[c][f] = c * 100 + f;
+			}
+			dsptk::AudioBuffer<double> output(3, 12);
+
+			// Second round wraps
+			for (int round = 0; round < 2; round++) {
+				EXPECT_EQ(sut.Write(input), 12);
+				EXPECT_EQ(sut.GetWriteAvailable(), 4);
+				EXPECT_EQ(sut.Read(output), 12);
+				for (int c = 0; c < 3; c++) {
+					EXPECT_EQ(output[c][0], c * 100);
+					EXPECT_EQ(output[c][11], c * 100 + 11);
+				}
+			}
+		}
+
+		TEST(MultichannelRingBuffer, SpansAreViewsOfTheChannels) {
+			dsptk::MultichannelRingBuffer<float> sut(2, 8);
+			dsptk::AudioBuffer<float> frames(2, 6);
+			sut.Write(frames);
+			sut.Read(frames);
+
+			auto spans = sut.PrepareWrite(4);
+			ASSERT_EQ(spans.GetNumFrames(), 4);
+			EXPECT_EQ(spans.first.GetNumFrames(), 2);
+			EXPECT_EQ(spans.second.GetNumFrames(), 2);
+			spans.second[1][1] = 5.f;
+			sut.CommitWrite(4);
+
+			auto read = sut.PrepareRead(4);
+			EXPECT_EQ(read.second[1][1], 5.f);
+		}
+	}
+
+	// Producer and consumer threads moving a counting sequence in random sized chunks through a small
+	// ring; run the ThreadSanitizer build (DSPTK_ENABLE_TSAN) to check the synchronization
+	namespace stress {
+
+		const int totalItems = 1 << 20;
+
+		TEST(RingBufferStress, SequenceSurvivesConcurrentUse) {
+			dsptk::RingBuffer<std::uint32_t> sut(64);
+
+			std::thread producer([&]() {
+				std::minstd_rand random(1);
+				for (std::uint32_t next = 0; next < totalItems;) {
+					auto spans = sut.PrepareWrite(1 + random() % 48);
+					for (auto& item : spans.first) item = next++;
+					for (auto& item : spans.second) item = next++;
+					sut.CommitWrite(spans.size());
+					if (spans.size() == 0) std::this_thread::yield();
+				}
+			});
+
+			std::minstd_rand random(2);
+			std::vector<std::uint32_t> chunk(48);
+			std::uint32_t expected = 0;
+			bool inOrder = true;
+			while (expected < totalItems) {
+				const int n = sut.Read(chunk.data(), 1 + random() % 48);
+				for (int i = 0; i < n; i++) {
+					inOrder &= chunk[i] == expected++;
+				}
+				if (n == 0) std::this_thread::yield();
+			}
+			producer.join();
+
+			EXPECT_TRUE(inOrder);
+			EXPECT_EQ(sut.GetReadAvailable(), 0);
+		}
+
+		TEST(RingBufferStress, MultichannelFramesSurviveConcurrentUse) {
+			const int numChannels = 4;
+			const int numFrames = totalItems / 8;
+			dsptk::MultichannelRingBuffer<float> sut(numChannels, 128);
+
+			std::thread producer([&]() {
+				std::minstd_rand random(3);
+				dsptk::AudioBuffer<float> block(numChannels, 100);
+				for (int next = 0; next < numFrames;) {
+					const int n = std::min<int>(1 + random() % 100, numFrames - next);
+					for (int c = 0; c < numChannels; c++) {
+						for (int f = 0; f < n; f++) block[c][f] = (float)((next + f) * numChannels + c);
+					}
+					for (int written = 0; written < n;) {
+						const int count = sut.Write(block.SubBlock(written, n - written));
+						if (count == 0) std::this_thread::yield();
+						written += count;
+					}
+					next += n;
+				}
+			});
+
+			std::minstd_rand random(4);
+			int expected = 0;
+			bool inOrder = true;
+			while (expected < numFrames) {
+				auto spans = sut.PrepareRead(1 + random() % 100);
+				for (const auto& view : { spans.first, spans.second }) {
+					for (int f = 0; f < view.GetNumFrames(); f++, expected++) {
+						for (int c = 0; c < numChannels; c++) {
+							inOrder &= view[c][f] == (float)(expected * numChannels + c);
+						}
+					}
+				}
+				sut.CommitRead(spans.GetNumFrames());
+				if (spans.GetNumFrames() == 0) std::this_thread::yield();
+			}
+			producer.join();
+
+			EXPECT_TRUE(inOrder);
+		}
+	}
+}
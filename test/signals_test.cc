@@ -0,0 +1,395 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <vector>
+#include "dsptk/signals.h"
+#include "dsptk/convolution.h"
+#include "dsptk/dft.h"
+#include "dsptk/constants.h"
+#include "dsptk/filters.h"
+
+namespace signals {
+
+	namespace oscillator {
+
+		// Test Values
+		const double sampleRate = 48000.;
+		const double frequency = 997.;
+
+		double Expected(int n, double freq = frequency) {
+			return std::sin(dsptk::DOUBLE_PI<double> * freq / sampleRate * n);
+		}
+
+		class OscillatorModes : public ::testing::TestWithParam<std::tuple<dsptk::Oscillator::Mode, double>> {};
+
+		TEST_P(OscillatorModes, MatchesSine) {
+			auto [mode, tolerance] = GetParam();
+			dsptk::Oscillator sut(frequency, sampleRate, mode);
+
+			std::vector<double> output(4800);
+			sut.Generate(output.data(), (int)output.size());
+
+			for (int i = 0; i < output.size(); i++) {
+				EXPECT_NEAR(output[i], Expected(i), tolerance) << i;
+			}
+		}
+
+		TEST_P(OscillatorModes, BlocksAreContinuous) {
+			auto [mode, tolerance] = GetParam();
+			dsptk::Oscillator whole(frequency, sampleRate, mode, .5);
+			dsptk::Oscillator split(frequency, sampleRate, mode, .5);
+
+			std::vector<double> expected(3000);
+			whole.Generate(expected.data(), (int)expected.size());
+
+			std::vector<double> output(expected.size());
+			const int blockSizes[] = { 1, 63, 512, 7 };
+			for (int start = 0, b = 0; start < output.size(); b++) {
+				int n = std::min(blockSizes[b % 4], (int)output.size() - start);
+				split.Generate(output.data() + start, n);
+				start += n;
+			}
+
+			for (int i = 0; i < output.size(); i++) {
+				EXPECT_NEAR(output[i], expected[i], tolerance) << i;
+			}
+		}
+
+		// Ten minutes of signal, the amplitude should not drift
+		TEST_P(OscillatorModes, StableOnLongRuns) {
+			auto [mode, tolerance] = GetParam();
+			dsptk::Oscillator sut(frequency, sampleRate, mode);
+
+			std::vector<double> output(48000);
+			for (int second = 0; second < 600; second++) {
+				sut.Generate(output.data(), (int)output.size());
+			}
+			// 997 full cycles per second, the phase is back at 0
+			for (int i = 0; i < 100; i++) {
+				EXPECT_NEAR(output[i], Expected(i), 1e-7) << i;
+			}
+		}
+
+		INSTANTIATE_TEST_SUITE_P(Oscillator, OscillatorModes, ::testing::Values(
+			std::make_tuple(dsptk::Oscillator::Mode::Exact, 1e-12),
+			std::make_tuple(dsptk::Oscillator::Mode::Quadrature, 1e-12),
+			std::make_tuple(dsptk::Oscillator::Mode::Polynomial, 1e-10)
+		));
+
+		TEST(Oscillator, FrequencyChangeKeepsPhase) {
+			dsptk::Oscillator sut(frequency, sampleRate, dsptk::Oscillator::Mode::Polynomial);
+
+			std::vector<double> output(100);
+			sut.Generate(output.data(), 100);
+			sut.SetFrequency(frequency * 2);
+			sut.Generate(output.data(), 100);
+
+			double phase = frequency / sampleRate * 100.;
+			for (int i = 0; i < 100; i++) {
+				EXPECT_NEAR(output[i], std::sin(dsptk::DOUBLE_PI<double> * (phase + 2 * frequency / sampleRate * i)), 1e-10);
+			}
+		}
+
+		TEST(Oscillator, NegativeFrequencyIsInverted) {
+			dsptk::Oscillator sut(-frequency, sampleRate, dsptk::Oscillator::Mode::Polynomial);
+
+			std::vector<double> output(100);
+			sut.Generate(output.data(), 100);
+
+			for (int i = 0; i < 100; i++) {
+				EXPECT_NEAR(output[i], -Expected(i), 1e-10);
+			}
+		}
+
+		TEST(Oscillator, SetPhaseStartsAtCosine) {
+			dsptk::Oscillator sut(frequency, sampleRate, dsptk::Oscillator::Mode::Quadrature);
+			sut.SetPhase(.25);
+
+			std::vector<double> output(100);
+			sut.Generate(output.data(), 100);
+
+			for (int i = 0; i < 100; i++) {
+				EXPECT_NEAR(output[i], std::cos(dsptk::DOUBLE_PI<double> * frequency / sampleRate * i), 1e-12);
+			}
+		}
+	}
+
+	namespace wavetable {
+
+		// Test Values
+		const double sampleRate = 48000.;
+		const size_t fftSize = 1 << 16;
+
+		// Frequency of a whole number of cycles in fftSize samples, so the spectrum has no leakage
+		double BinFrequency(size_t bin) {
+			return bin * sampleRate / fftSize;
+		}
+
+		// Largest component outside the harmonics of the fundamental bin, relative to the fundamental
+		double WorstSpuriousDb(const std::vector<double>& signal, size_t fundamentalBin) {
+			std::vector<std::complex<double>> spectrum(signal.begin(), signal.end());
+			dsptk::fft(spectrum);
+			double worst = 0.;
+			for (size_t k = 1; k < fftSize / 2; k++) {
+				if (k % fundamentalBin != 0) {
+					worst = std::max(worst, std::abs(spectrum[k]));
+				}
+			}
+			return 20. * std::log10(worst / std::abs(spectrum[fundamentalBin]));
+		}
+
+		TEST(WavetableSet, SharedPerProcess) {
+			auto& saw = dsptk::WavetableSet::Get(dsptk::WavetableSet::Waveform::Saw);
+			EXPECT_EQ(&saw, &dsptk::WavetableSet::Get(dsptk::WavetableSet::Waveform::Saw));
+			EXPECT_NE(&saw, &dsptk::WavetableSet::Get(dsptk::WavetableSet::Waveform::Square));
+		}
+
+		TEST(WavetableSet, LevelPerOctave) {
+			EXPECT_EQ(0, dsptk::WavetableSet::LevelFor(20. / sampleRate));
+			EXPECT_EQ(5, dsptk::WavetableSet::LevelFor(1000. / sampleRate));
+			EXPECT_EQ(6, dsptk::WavetableSet::LevelFor(2000. / sampleRate));
+			EXPECT_EQ(dsptk::WavetableSet::numLevels - 1, dsptk::WavetableSet::LevelFor(0.4));
+		}
+
+		TEST(WavetableSet, SineTable) {
+			const float* table = dsptk::WavetableSet::Get(dsptk::WavetableSet::Waveform::Sine).GetLevel(0);
+			for (int i = 0; i <= dsptk::WavetableSet::tableSize; i++) {
+				EXPECT_NEAR(std::sin(dsptk::DOUBLE_PI<double> * i / dsptk::WavetableSet::tableSize), table[i], 1e-6);
+			}
+		}
+
+		TEST(WavetableOscillator, MatchesSine) {
+			dsptk::WavetableOscillator sut(dsptk::WavetableSet::Get(dsptk::WavetableSet::Waveform::Sine), 997., sampleRate, 0.5);
+
+			std::vector<double> output(4800);
+			sut.Generate(output.data(), 1000);
+			sut.Generate(output.data() + 1000, 3800);
+
+			for (size_t i = 0; i < output.size(); i++) {
+				EXPECT_NEAR(0.5 * std::sin(dsptk::DOUBLE_PI<double> * 997. / sampleRate * i), output[i], 1e-5) << i;
+			}
+		}
+
+		class WavetableAliasing : public ::testing::TestWithParam<std::tuple<dsptk::WavetableSet::Waveform, size_t>> {};
+
+		TEST_P(WavetableAliasing, NoSpuriousComponents) {
+			auto [waveform, bin] = GetParam();
+			dsptk::WavetableOscillator sut(dsptk::WavetableSet::Get(waveform), BinFrequency(bin), sampleRate);
+
+			std::vector<double> output(fftSize);
+			sut.Generate(output.data(), (int)output.size());
+
+			// Levels are scaled as the first one, with fewer partials the square's ripple grows up to 8%
+			EXPECT_LT(*std::max_element(output.begin(), output.end()), 1.1);
+			EXPECT_LT(WorstSpuriousDb(output, bin), -60.);
+		}
+
+		// 100Hz, 1kHz, 5kHz and 15kHz
+		INSTANTIATE_TEST_SUITE_P(Waveforms, WavetableAliasing, ::testing::Combine(
+			::testing::Values(dsptk::WavetableSet::Waveform::Saw, dsptk::WavetableSet::Waveform::Square, dsptk::WavetableSet::Waveform::Triangle),
+			::testing::Values(137, 1365, 6827, 20480)));
+	}
+
+	namespace noise {
+
+		// Test Values
+		const std::uint64_t seed = 1234;
+		const int testSamples = 100000;
+
+		double Mean(const std::vector<double>& values) {
+			double sum = 0.;
+			for (double value : values) sum += value;
+			return sum / values.size();
+		}
+
+		double Variance(const std::vector<double>& values) {
+			double mean = Mean(values);
+			double sum = 0.;
+			for (double value : values) sum += (value - mean) * (value - mean);
+			return sum / values.size();
+		}
+
+		TEST(RandomGenerator, SameSeedAndStreamRepeatsRegardlessOfBlockSize) {
+			dsptk::RandomGenerator first(seed, 3);
+			dsptk::RandomGenerator second(seed, 3);
+
+			std::vector<double> expected(1000);
+			first.FillGaussian(expected.data(), (int)expected.size());
+
+			std::vector<double> output(expected.size());
+			const int blockSizes[] = { 1, 7, 64, 3 };
+			for (int start = 0, b = 0; start < output.size(); b++) {
+				int n = std::min(blockSizes[b % 4], (int)output.size() - start);
+				second.FillGaussian(output.data() + start, n);
+				start += n;
+			}
+
+			EXPECT_EQ(output, expected);
+		}
+
+		TEST(RandomGenerator, StreamsAreUncorrelated) {
+			dsptk::RandomGenerator first(seed, 0);
+			dsptk::RandomGenerator second(seed, 1);
+
+			std::vector<double> a(testSamples), b(testSamples);
+			first.FillUniform(a.data(), testSamples);
+			second.FillUniform(b.data(), testSamples);
+
+			double correlation = 0.;
+			for (int i = 0; i < testSamples; i++) {
+				correlation += a[i] * b[i];
+			}
+			// Uniform [-1, 1) has variance 1/3
+			correlation /= testSamples / 3.;
+
+			EXPECT_NE(a, b);
+			EXPECT_NEAR(correlation, 0., .02);
+		}
+
+		TEST(WhiteNoise, UniformDistribution) {
+			dsptk::WhiteNoise sut(dsptk::WhiteNoise::Distribution::Uniform, .5, seed);
+
+			std::vector<double> output(testSamples);
+			sut.Generate(output.data(), testSamples);
+
+			EXPECT_NEAR(Mean(output), 0., .01);
+			EXPECT_NEAR(Variance(output), .25 / 3., .002);
+			EXPECT_LE(*std::max_element(output.begin(), output.end()), .5);
+			EXPECT_GE(*std::min_element(output.begin(), output.end()), -.5);
+		}
+
+		TEST(WhiteNoise, GaussianDistribution) {
+			dsptk::WhiteNoise sut(dsptk::WhiteNoise::Distribution::Gaussian, 2., seed);
+
+			std::vector<double> output(testSamples);
+			sut.Generate(output.data(), testSamples);
+
+			EXPECT_NEAR(Mean(output), 0., .03);
+			EXPECT_NEAR(Variance(output), 4., .08);
+		}
+
+		// Measures the power in an octave band splitting with crossovers
+		double OctavePower(const std::vector<double>& signal, double lowFrequency) {
+			const double sampleRate = 48000.;
+			dsptk::LinkwitzRileyCrossover low(lowFrequency, sampleRate);
+			dsptk::LinkwitzRileyCrossover high(lowFrequency * 2., sampleRate);
+			double power = 0.;
+			for (double x : signal) {
+				double below, above, band, rest;
+				low.ProcessSample(x, below, above);
+				high.ProcessSample(above, band, rest);
+				power += band * band;
+			}
+			return 10. * std::log10(power);
+		}
+
+		TEST(PinkNoise, EqualPowerPerOctave) {
+			dsptk::PinkNoise sut(1., seed);
+
+			std::vector<double> output(480000);
+			sut.Generate(output.data(), (int)output.size());
+
+			EXPECT_NEAR(OctavePower(output, 250.), OctavePower(output, 1000.), 1.);
+			EXPECT_NEAR(OctavePower(output, 1000.), OctavePower(output, 4000.), 1.);
+			EXPECT_LT(*std::max_element(output.begin(), output.end()), 1.);
+		}
+	}
+
+	namespace sweep {
+
+		// Test Values
+		const double sampleRate = 48000.;
+		const double startFreq = 20.;
+		const double endFreq = 20000.;
+		const double duration = 2.;
+		const size_t irLength = 4096;
+
+		// Magnitude of the response at freq
+		double Magnitude(const std::vector<double>& ir, double freq) {
+			std::vector<std::complex<double>> spectrum(ir.begin(), ir.end());
+			dsptk::fft(spectrum);
+			return std::abs(spectrum[(size_t)std::lround(freq * ir.size() / sampleRate)]);
+		}
+
+		TEST(ExponentialSweep, FrequencyRange) {
+			auto sut = dsptk::exponential_sweep(startFreq, endFreq, duration, sampleRate, 0.5);
+
+			ASSERT_EQ((size_t)(duration * sampleRate), sut.size());
+			EXPECT_NEAR(0., sut.front(), 1e-12);
+			EXPECT_NEAR(0.5, *std::max_element(sut.begin(), sut.end()), 1e-6);
+
+			// Zero crossings spacing gives the instantaneous frequency, 200 Hz a third of the way through
+			size_t first = (size_t)(sampleRate * duration / 3.);
+			while (!(sut[first] <= 0. && sut[first + 1] > 0.)) first++;
+			size_t second = first + 1;
+			while (!(sut[second] <= 0. && sut[second + 1] > 0.)) second++;
+			EXPECT_NEAR(sampleRate / 200., (double)(second - first), sampleRate / 200. * 0.03);
+		}
+
+		TEST(ExponentialSweep, InverseFlattensSpectrum) {
+			auto sweep = dsptk::exponential_sweep(startFreq, endFreq, duration, sampleRate);
+			auto inverse = dsptk::exponential_sweep_inverse(startFreq, endFreq, duration, sampleRate);
+			ASSERT_EQ(sweep.size(), inverse.size());
+
+			auto impulse = dsptk::fft_convolve(sweep, inverse);
+			impulse.resize(dsptk::fft_size(impulse.size()));
+
+			std::vector<std::complex<double>> spectrum(impulse.begin(), impulse.end());
+			dsptk::fft(spectrum);
+
+			// Averaged over a few bins, the abrupt ends of the sweep add a ripple of a few percent
+			for (double freq : { 100., 1000., 10000. }) {
+				const size_t bin = (size_t)std::lround(freq * spectrum.size() / sampleRate);
+				double magnitude = 0.;
+				for (size_t k = bin - 20; k <= bin + 20; k++) {
+					magnitude += std::abs(spectrum[k]) / 41.;
+				}
+				EXPECT_NEAR(1., magnitude, 0.01) << freq;
+			}
+		}
+
+		TEST(ExponentialSweep, DeconvolvesDelayAndGain) {
+			const size_t delay = 100;
+			auto excitation = dsptk::exponential_sweep(startFreq, endFreq, duration, sampleRate);
+
+			std::vector<double> recorded(excitation.size() + irLength, 0.);
+			for (size_t i = 0; i < excitation.size(); i++) {
+				recorded[i + delay] = 0.5 * excitation[i];
+			}
+
+			auto sut = dsptk::deconvolve_sweep(recorded, startFreq, endFreq, duration, sampleRate, irLength);
+
+			ASSERT_EQ(irLength, sut.linear.size());
+			EXPECT_TRUE(sut.harmonics.empty());
+			auto peak = std::max_element(sut.linear.begin(), sut.linear.end(), [](double a, double b) { return std::abs(a) < std::abs(b); });
+			EXPECT_EQ(delay, (size_t)(peak - sut.linear.begin()));
+
+			// Same response as the sweep itself, delayed and scaled
+			auto reference = dsptk::deconvolve_sweep(excitation, startFreq, endFreq, duration, sampleRate, irLength);
+			for (size_t i = 0; i < irLength - delay; i++) {
+				ASSERT_NEAR(0.5 * reference.linear[i], sut.linear[i + delay], 1e-9) << i;
+			}
+		}
+
+		TEST(ExponentialSweep, SeparatesHarmonicDistortion) {
+			auto excitation = dsptk::exponential_sweep(startFreq, endFreq, duration, sampleRate);
+
+			// x + 0.2 x^2, the square adds a 2nd harmonic of amplitude 0.1.
+			// The delay keeps the pre ringing of the band limited responses inside their windows.
+			const size_t delay = 1000;
+			std::vector<double> recorded(excitation.size() + irLength, 0.);
+			for (size_t i = 0; i < excitation.size(); i++) {
+				recorded[i + delay] = excitation[i] + 0.2 * excitation[i] * excitation[i];
+			}
+
+			auto sut = dsptk::deconvolve_sweep(recorded, startFreq, endFreq, duration, sampleRate, irLength, 2);
+
+			ASSERT_EQ(2u, sut.harmonics.size());
+			EXPECT_NEAR(1., Magnitude(sut.linear, 1000.), 0.005);
+			EXPECT_NEAR(0.1, Magnitude(sut.harmonics[0], 2000.), 0.005);
+			EXPECT_NEAR(0., Magnitude(sut.harmonics[1], 3000.), 0.005);
+		}
+	}
+}
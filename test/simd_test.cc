@@ -0,0 +1,248 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <complex>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+#include "dsptk/simd.h"
+#include "dsptk/dft.h"
+#include "dsptk/filters.h"
+
+// The kernels of every instruction set the machine runs against the generic ones; the whole suite also runs with
+// DSPTK_ISA forcing each lower instruction set (see CMakeLists.txt)
+namespace simd {
+
+	using dsptk::simd::Isa;
+
+	const Isa allIsas[] = { Isa::Generic, Isa::Sse42, Isa::Avx2, Isa::Avx512 };
+
+	// Switches the kernels for a scope
+	class ScopedIsa {
+	public:
+		explicit ScopedIsa(Isa isa) : previous(dsptk::simd::GetKernels().isa) {
+			supported = dsptk::simd::SetIsa(isa);
+		}
+		~ScopedIsa() { dsptk::simd::SetIsa(previous); }
+
+		bool supported;
+
+	private:
+		Isa previous;
+	};
+
+	std::vector<double> Random(int n, double scale, unsigned seed) {
+		std::mt19937 generator(seed);
+		std::uniform_real_distribution<double> distribution(-scale, scale);
+		std::vector<double> values(n);
+		for (auto& value : values) value = distribution(generator);
+		return values;
+	}
+
+	bool BitwiseEqual(const std::vector<double>& a, const std::vector<double>& b) {
+		return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(double)) == 0;
+	}
+
+	namespace dispatch {
+
+		TEST(Simd, NamesRoundTrip) {
+			for (Isa isa : allIsas) {
+				Isa parsed;
+				ASSERT_TRUE(dsptk::simd::ParseIsa(dsptk::simd::GetIsaName(isa), parsed));
+				EXPECT_EQ(parsed, isa);
+			}
+			Isa parsed;
+			EXPECT_FALSE(dsptk::simd::ParseIsa("neon", parsed));
+		}
+
+		TEST(Simd, ActiveIsaIsTheSupportedOneOrTheRequestedOne) {
+			const Isa supported = dsptk::simd::GetSupportedIsa();
+			Isa expected = supported;
+			Isa requested;
+			const char* name = std::getenv("DSPTK_ISA");
+			if (name != nullptr && dsptk::simd::ParseIsa(name, requested) && requested < supported) {
+				expected = requested;
+			}
+			EXPECT_EQ(dsptk::simd::GetKernels().isa, expected) << dsptk::simd::GetIsaName(supported);
+		}
+
+		TEST(Simd, UnsupportedIsaIsRefused) {
+			for (Isa isa : allIsas) {
+				ScopedIsa scope(isa);
+				EXPECT_EQ(scope.supported, isa <= dsptk::simd::GetSupportedIsa());
+				if (scope.supported) {
+					EXPECT_EQ(dsptk::simd::GetKernels().isa, isa);
+				}
+			}
+		}
+	}
+
+	namespace accuracy {
+
+		TEST(SimdKernels, LinearToDbMatchesLog10) {
+			std::vector<double> input = Random(1000, 2., 1);
+			for (double value : { 1., -1., .5, 2., 1e-300, 1e300, 4.9e-324, 3e-310, std::numeric_limits<double>::max() }) {
+				input.push_back(value);
+			}
+			std::vector<double> output(input.size());
+			dsptk::simd::GetKernels().linearToDb(input.data(), output.data(), (int)input.size());
+			for (std::size_t i = 0; i < input.size(); i++) {
+				const double expected = 20. * std::log10(std::fabs(input[i]));
+				ASSERT_NEAR(output[i], expected, 4e-16 * std::fabs(expected) + 1e-15) << input[i];
+			}
+		}
+
+		TEST(SimdKernels, LinearToDbSpecialValues) {
+			const double input[] = { 0., -0., INFINITY, -INFINITY, NAN };
+			double output[5];
+			dsptk::simd::GetKernels().linearToDb(input, output, 5);
+			EXPECT_EQ(output[0], -INFINITY);
+			EXPECT_EQ(output[1], -INFINITY);
+			EXPECT_EQ(output[2], INFINITY);
+			EXPECT_EQ(output[3], INFINITY);
+			EXPECT_TRUE(std::isnan(output[4]));
+		}
+
+		TEST(SimdKernels, DbToLinearMatchesPow) {
+			std::vector<double> input = Random(1000, 200., 2);
+			for (double value : { 0., -6., 6., -700., 300., -6000. }) {
+				input.push_back(value);
+			}
+			std::vector<double> output(input.size());
+			dsptk::simd::GetKernels().dbToLinear(input.data(), output.data(), (int)input.size());
+			for (std::size_t i = 0; i < input.size(); i++) {
+				// Both round the exponent y, an error of |y| ulp each
+				const double expected = std::pow(10., input[i] / 20.);
+				const double y = std::fabs(input[i]) * .115;
+				ASSERT_NEAR(output[i], expected, (4. + 2. * y) * 1.1e-16 * expected) << input[i];
+			}
+		}
+
+		TEST(SimdKernels, DbToLinearSpecialValues) {
+			const double input[] = { -INFINITY, INFINITY, NAN, -1e6, 1e6, -6440. };
+			double output[6];
+			dsptk::simd::GetKernels().dbToLinear(input, output, 6);
+			EXPECT_EQ(output[0], 0.);
+			EXPECT_EQ(output[1], INFINITY);
+			EXPECT_TRUE(std::isnan(output[2]));
+			EXPECT_EQ(output[3], 0.);
+			EXPECT_EQ(output[4], INFINITY);
+			// Subnormal
+			EXPECT_NEAR(output[5], 1e-322, 1e-323);
+		}
+
+		TEST(SimdKernels, DotProductOfEveryLength) {
+			const auto a = Random(40, 1., 3);
+			const auto b = Random(40, 1., 4);
+			for (int n = 0; n <= 40; n++) {
+				double expected = 0.;
+				for (int i = 0; i < n; i++) expected += a[i] * b[i];
+				EXPECT_NEAR(dsptk::simd::GetKernels().dotProduct(a.data(), b.data(), n), expected, 1e-13) << n;
+			}
+			EXPECT_DOUBLE_EQ(dsptk::simd::GetKernels().sumOfSquares(a.data(), 3), a[0] * a[0] + a[1] * a[1] + a[2] * a[2]);
+		}
+
+		TEST(SimdKernels, BiquadBlocksMatchTheSamples) {
+			dsptk::ButterworthLowPass reference(1000., 48000.);
+			dsptk::ButterworthLowPass sut(1000., 48000.);
+			const auto input = Random(1000, 1., 5);
+			std::vector<double> output(input.size());
+			// Uneven blocks carry the state
+			for (int start = 0, size = 1; start < 1000; start += size, size = size * 2 + 1) {
+				sut.ProcessBlock(input.data() + start, output.data() + start, std::min(size, 1000 - start));
+			}
+			for (int i = 0; i < 1000; i++) {
+				ASSERT_DOUBLE_EQ(output[i], reference.ProcessSample(input[i])) << i;
+			}
+			EXPECT_DOUBLE_EQ(sut.ProcessSample(.5), reference.ProcessSample(.5));
+		}
+	}
+
+	// Every instruction set gives the generic results bit for bit
+	namespace equivalence {
+
+		class SimdPaths : public ::testing::TestWithParam<Isa> {
+		protected:
+			void SetUp() override {
+				if (GetParam() > dsptk::simd::GetSupportedIsa()) {
+					GTEST_SKIP() << dsptk::simd::GetIsaName(GetParam()) << " not supported";
+				}
+			}
+
+			template <typename Run>
+			static void ExpectSameAsGeneric(Run run) {
+				std::vector<double> expected;
+				{
+					ScopedIsa scope(Isa::Generic);
+					expected = run();
+				}
+				ScopedIsa scope(GetParam());
+				EXPECT_TRUE(BitwiseEqual(run(), expected));
+			}
+		};
+
+		TEST_P(SimdPaths, Biquad) {
+			const auto input = Random(999, 1., 6);
+			ExpectSameAsGeneric([&]() {
+				const dsptk::simd::BiquadCoefficients coefficients{ .2, .4, .2, -.6, .3 };
+				double state[2] = { .1, -.1 };
+				std::vector<double> output(input.size());
+				dsptk::simd::GetKernels().biquad(coefficients, state, input.data(), output.data(), (int)input.size());
+				output.push_back(state[0]);
+				output.push_back(state[1]);
+				return output;
+			});
+		}
+
+		TEST_P(SimdPaths, DotProductAndSumOfSquares) {
+			const auto a = Random(1027, 1., 7);
+			const auto b = Random(1027, 1., 8);
+			ExpectSameAsGeneric([&]() {
+				std::vector<double> results;
+				for (int n : { 0, 1, 7, 8, 9, 63, 1027 }) {
+					results.push_back(dsptk::simd::GetKernels().dotProduct(a.data(), b.data(), n));
+					results.push_back(dsptk::simd::GetKernels().sumOfSquares(a.data(), n));
+				}
+				return results;
+			});
+		}
+
+		TEST_P(SimdPaths, Fft) {
+			const auto values = Random(2 * 4096, 1., 9);
+			ExpectSameAsGeneric([&]() {
+				std::vector<std::complex<double>> data(4096);
+				for (int i = 0; i < 4096; i++) data[i] = { values[2 * i], values[2 * i + 1] };
+				dsptk::fft(data);
+				std::vector<double> result;
+				for (const auto& value : data) {
+					result.push_back(value.real());
+					result.push_back(value.imag());
+				}
+				return result;
+			});
+		}
+
+		TEST_P(SimdPaths, DbConversions) {
+			std::vector<double> input = Random(1001, 100., 10);
+			const double infinity = std::numeric_limits<double>::infinity();
+			for (double value : { 0., -0., infinity, -infinity, 3e-310, -1e6 }) input.push_back(value);
+			ExpectSameAsGeneric([&]() {
+				std::vector<double> db(input.size());
+				std::vector<double> linear(input.size());
+				dsptk::simd::GetKernels().linearToDb(input.data(), db.data(), (int)input.size());
+				dsptk::simd::GetKernels().dbToLinear(input.data(), linear.data(), (int)input.size());
+				db.insert(db.end(), linear.begin(), linear.end());
+				return db;
+			});
+		}
+
+		std::string IsaTestName(const ::testing::TestParamInfo<Isa>& info) {
+			const char* names[] = { "Generic", "Sse42", "Avx2", "Avx512" };
+			return names[(int)info.param];
+		}
+
+		INSTANTIATE_TEST_SUITE_P(Simd, SimdPaths, ::testing::ValuesIn(allIsas), IsaTestName);
+	}
+}
@@ -0,0 +1,152 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "dsptk/threadpool.h"
+
+namespace threadpool {
+
+	// Counts its runs, then queues its children and completes
+	class CountingTask : public dsptk::Task {
+	public:
+		void Run(dsptk::WorkStealingPool& pool, int worker) override {
+			runs.fetch_add(1, std::memory_order_relaxed);
+			for (CountingTask* child : children) {
+				pool.Push(worker, child);
+			}
+			remaining->fetch_sub(1, std::memory_order_release);
+		}
+
+		std::vector<CountingTask*> children;
+		std::atomic<int> runs{ 0 };
+		std::atomic<int>* remaining = nullptr;
+	};
+
+	namespace deque {
+
+		TEST(WorkStealingDeque, OwnerPopsLastThievesStealFirst) {
+			dsptk::WorkStealingDeque sut(8);
+			CountingTask tasks[3];
+			for (auto& task : tasks) EXPECT_TRUE(sut.Push(&task));
+
+			EXPECT_EQ(sut.Pop(), &tasks[2]);
+			EXPECT_EQ(sut.Steal(), &tasks[0]);
+			EXPECT_EQ(sut.Pop(), &tasks[1]);
+			EXPECT_TRUE(sut.IsEmpty());
+			EXPECT_EQ(sut.Pop(), nullptr);
+			EXPECT_EQ(sut.Steal(), nullptr);
+		}
+
+		TEST(WorkStealingDeque, PushFailsWhenFull) {
+			dsptk::WorkStealingDeque sut(3);
+			CountingTask task;
+			for (int i = 0; i < 4; i++) EXPECT_TRUE(sut.Push(&task));
+			EXPECT_FALSE(sut.Push(&task));
+			sut.Steal();
+			EXPECT_TRUE(sut.Push(&task));
+		}
+
+		// Every pushed task is taken exactly once, by the owner or by one of the thieves
+		TEST(WorkStealingDeque, ConcurrentStealsTakeEachTaskOnce) {
+			const int numTasks = 1 << 16;
+			const int numThieves = 3;
+			dsptk::WorkStealingDeque sut(64);
+			std::vector<CountingTask> tasks(numTasks);
+			std::atomic<int> taken{ 0 };
+
+			std::vector<std::thread> thieves;
+			for (int t = 0; t < numThieves; t++) {
+				thieves.emplace_back([&]() {
+					while (taken.load(std::memory_order_relaxed) < numTasks) {
+						if (dsptk::Task* task = sut.Steal()) {
+							static_cast<CountingTask*>(task)->runs.fetch_add(1, std::memory_order_relaxed);
+							taken.fetch_add(1, std::memory_order_relaxed);
+						}
+						else {
+							std::this_thread::yield();
+						}
+					}
+				});
+			}
+			for (int i = 0; i < numTasks;) {
+				if (sut.Push(&tasks[i])) {
+					i++;
+				}
+				// Pop one every few pushes so the owner races the thieves on the last task too
+				if (i % 3 == 0 || i == numTasks) {
+					if (dsptk::Task* task = sut.Pop()) {
+						static_cast<CountingTask*>(task)->runs.fetch_add(1, std::memory_order_relaxed);
+						taken.fetch_add(1, std::memory_order_relaxed);
+					}
+				}
+			}
+			while (dsptk::Task* task = sut.Pop()) {
+				static_cast<CountingTask*>(task)->runs.fetch_add(1, std::memory_order_relaxed);
+				taken.fetch_add(1, std::memory_order_relaxed);
+			}
+			for (auto& thief : thieves) thief.join();
+
+			int wrong = 0;
+			for (auto& task : tasks) wrong += task.runs.load() != 1;
+			EXPECT_EQ(wrong, 0);
+		}
+	}
+
+	namespace pool {
+
+		TEST(WorkStealingPool, RunsTaskTreesToCompletion) {
+			for (int numThreads : { 1, 2, 4 }) {
+				dsptk::WorkStealingPool sut(numThreads);
+				EXPECT_EQ(sut.GetNumThreads(), numThreads);
+
+				// 8 roots with 32 children each, run for many blocks
+				std::vector<CountingTask> tasks(8 + 8 * 32);
+				std::atomic<int> remaining;
+				std::vector<dsptk::Task*> roots;
+				for (int r = 0; r < 8; r++) {
+					roots.push_back(&tasks[r]);
+					for (int c = 0; c < 32; c++) tasks[r].children.push_back(&tasks[8 + r * 32 + c]);
+				}
+				for (auto& task : tasks) task.remaining = &remaining;
+
+				for (int block = 0; block < 200; block++) {
+					remaining.store((int)tasks.size());
+					sut.Run(roots.data(), (int)roots.size(), remaining);
+					EXPECT_EQ(remaining.load(), 0);
+				}
+				int wrong = 0;
+				for (auto& task : tasks) wrong += task.runs.load() != 200;
+				EXPECT_EQ(wrong, 0) << numThreads;
+			}
+		}
+
+		TEST(WorkStealingPool, FullQueueRunsTasksInline) {
+			dsptk::WorkStealingPool sut(2, 2);
+			std::vector<CountingTask> tasks(10);
+			std::atomic<int> remaining{ 10 };
+			std::vector<dsptk::Task*> roots;
+			for (auto& task : tasks) {
+				task.remaining = &remaining;
+				roots.push_back(&task);
+			}
+			sut.Run(roots.data(), (int)roots.size(), remaining);
+			for (auto& task : tasks) EXPECT_EQ(task.runs.load(), 1);
+		}
+
+		TEST(WorkStealingPool, WakesUpSleepingWorkers) {
+			dsptk::WorkStealingPool sut(3);
+			CountingTask task;
+			std::atomic<int> remaining;
+			task.remaining = &remaining;
+			dsptk::Task* root = &task;
+			// Workers go to sleep between the runs
+			for (int i = 0; i < 3; i++) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(20));
+				remaining.store(1);
+				sut.Run(&root, 1, remaining);
+			}
+			EXPECT_EQ(task.runs.load(), 3);
+		}
+	}
+}
@@ -0,0 +1,186 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <complex>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "dsptk/tracing.h"
+#include "dsptk/dft.h"
+#include "dsptk/dynamics.h"
+#include "dsptk/filters.h"
+#include "dsptk/signals.h"
+
+namespace tracing {
+
+	// Count of the non overlapping occurrences of pattern in text
+	int Count(const std::string& text, const std::string& pattern) {
+		int count = 0;
+		for (auto position = text.find(pattern); position != std::string::npos; position = text.find(pattern, position + pattern.size())) {
+			count++;
+		}
+		return count;
+	}
+
+	std::string Trace() {
+		std::ostringstream stream;
+		dsptk::tracing::WriteChromeTrace(stream);
+		return stream.str();
+	}
+
+	// Tracing state is global, every test starts and ends disabled and empty
+	class Tracing : public ::testing::Test {
+	protected:
+		void SetUp() override {
+			dsptk::tracing::Disable();
+			dsptk::tracing::Clear();
+		}
+
+		void TearDown() override {
+			dsptk::tracing::Disable();
+			dsptk::tracing::Clear();
+		}
+	};
+
+	TEST_F(Tracing, DisabledByDefault) {
+		EXPECT_FALSE(dsptk::tracing::IsEnabled());
+		{
+			DSPTK_TRACE_SCOPE("disabled scope");
+		}
+		EXPECT_EQ(Count(Trace(), "disabled scope"), 0);
+	}
+
+	TEST_F(Tracing, WritesCompleteEvents) {
+		dsptk::tracing::Enable();
+		{
+			DSPTK_TRACE_SCOPE("outer");
+			DSPTK_TRACE_SCOPE("inner", 3);
+		}
+		dsptk::tracing::Disable();
+
+		auto trace = Trace();
+		EXPECT_EQ(trace.rfind("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", 0), 0);
+		EXPECT_EQ(trace.substr(trace.size() - 3), "]}\n");
+		EXPECT_EQ(Count(trace, "\"ph\":\"X\""), 2);
+		EXPECT_EQ(Count(trace, "\"name\":\"outer\""), 1);
+		EXPECT_EQ(Count(trace, "\"name\":\"inner\""), 1);
+		EXPECT_EQ(Count(trace, "\"args\":{\"arg\":3}"), 1);
+	}
+
+	TEST_F(Tracing, ScopesStartedWhileDisabledAreNotRecorded) {
+		{
+			DSPTK_TRACE_SCOPE("started disabled");
+			dsptk::tracing::Enable();
+		}
+		dsptk::tracing::Disable();
+		EXPECT_EQ(Count(Trace(), "started disabled"), 0);
+	}
+
+	TEST_F(Tracing, ClearDiscardsTheEvents) {
+		dsptk::tracing::Enable();
+		{
+			DSPTK_TRACE_SCOPE("cleared");
+		}
+		dsptk::tracing::Clear();
+		{
+			DSPTK_TRACE_SCOPE("kept");
+		}
+		dsptk::tracing::Disable();
+
+		auto trace = Trace();
+		EXPECT_EQ(Count(trace, "cleared"), 0);
+		EXPECT_EQ(Count(trace, "kept"), 1);
+	}
+
+	TEST_F(Tracing, RingKeepsTheLatestEvents) {
+		const int capacity = 16;
+		std::string trace;
+		// New thread so its buffer gets the small capacity
+		std::thread worker([&] {
+			dsptk::tracing::SetBufferCapacity(capacity);
+			dsptk::tracing::RegisterThread("ring worker");
+			dsptk::tracing::SetBufferCapacity(1 << 16);
+			dsptk::tracing::Enable();
+			for (int i = 0; i < 100; i++) {
+				DSPTK_TRACE_SCOPE("ring", i);
+			}
+			dsptk::tracing::Disable();
+		});
+		worker.join();
+		trace = Trace();
+
+		EXPECT_EQ(Count(trace, "\"name\":\"ring\""), capacity);
+		EXPECT_EQ(Count(trace, "\"arg\":83}"), 0);
+		EXPECT_EQ(Count(trace, "\"arg\":84}"), 1);
+		EXPECT_EQ(Count(trace, "\"arg\":99}"), 1);
+		EXPECT_EQ(Count(trace, "\"name\":\"thread_name\",\"pid\":1,\"tid\":"), 1);
+		EXPECT_EQ(Count(trace, "\"args\":{\"name\":\"ring worker\"}"), 1);
+	}
+
+	TEST_F(Tracing, ThreadsHaveTheirOwnTrack) {
+		dsptk::tracing::Enable();
+		std::string mainTid, workerTid;
+		{
+			DSPTK_TRACE_SCOPE("main thread");
+		}
+		std::thread worker([] {
+			DSPTK_TRACE_SCOPE("worker thread");
+		});
+		worker.join();
+		dsptk::tracing::Disable();
+
+		auto trace = Trace();
+		auto TidOf = [&](const std::string& name) {
+			auto event = trace.find("\"name\":\"" + name + "\"");
+			auto tid = trace.find("\"tid\":", event);
+			return trace.substr(tid, trace.find(',', tid) - tid);
+		};
+		EXPECT_NE(TidOf("main thread"), TidOf("worker thread"));
+	}
+
+	TEST_F(Tracing, ProcessorsAreInstrumented) {
+		const double sampleRate = 48000.;
+		const int blockSize = 128;
+		auto signal = dsptk::sin(440., sampleRate, blockSize);
+		std::vector<double> output(blockSize), gain(blockSize);
+
+		dsptk::FilterBank bank;
+		std::shared_ptr<dsptk::Filter> lowpass = std::make_shared<dsptk::ButterworthLowPass>(1000., sampleRate);
+		std::shared_ptr<dsptk::Filter> hipass = std::make_shared<dsptk::ButterworthHiPass>(100., sampleRate);
+		bank.AddFilter(lowpass);
+		bank.AddFilter(hipass);
+		dsptk::Compressor compressor(-20., 4., 6., sampleRate, 5., 50.);
+		std::vector<std::complex<double>> spectrum(256);
+
+		dsptk::tracing::Enable();
+		bank.ProcessBlock(signal.data(), output.data(), blockSize);
+		compressor.ProcessBlock(signal.data(), nullptr, output.data(), gain.data(), blockSize);
+		dsptk::fft(spectrum);
+		dsptk::tracing::Disable();
+
+		auto trace = Trace();
+		EXPECT_EQ(Count(trace, "\"name\":\"FilterBank filter\""), 2);
+		EXPECT_EQ(Count(trace, "\"name\":\"Compressor level\""), 1);
+		EXPECT_EQ(Count(trace, "\"name\":\"Compressor curve\""), 1);
+		EXPECT_EQ(Count(trace, "\"name\":\"Compressor smoothing\""), 1);
+		EXPECT_EQ(Count(trace, "\"name\":\"Compressor gain\""), 1);
+		EXPECT_EQ(Count(trace, "\"name\":\"fft\""), 1);
+	}
+
+	TEST_F(Tracing, WritingWhileRecordingIsSafe) {
+		dsptk::tracing::Enable();
+		std::atomic<bool> done{ false };
+		std::thread worker([&] {
+			while (!done.load()) {
+				DSPTK_TRACE_SCOPE("busy");
+			}
+		});
+		for (int i = 0; i < 20; i++) {
+			auto trace = Trace();
+			EXPECT_EQ(trace.substr(trace.size() - 3), "]}\n");
+		}
+		done = true;
+		worker.join();
+	}
+}
@@ -0,0 +1,285 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "dsptk/wavfile.h"
+#include "dsptk/audiobuffer.h"
+
+namespace wavfile {
+
+	std::string TempPath(const std::string& name) {
+		return ::testing::TempDir() + "dsptk_" + name;
+	}
+
+	std::vector<unsigned char> ReadBytes(const std::string& path) {
+		std::ifstream file(path, std::ios::binary);
+		return std::vector<unsigned char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+
+	std::uint32_t Get32(const std::vector<unsigned char>& bytes, std::size_t position) {
+		std::uint32_t value;
+		std::memcpy(&value, bytes.data() + position, 4);
+		return value;
+	}
+
+	std::string Id(const std::vector<unsigned char>& bytes, std::size_t position) {
+		return std::string(bytes.begin() + position, bytes.begin() + position + 4);
+	}
+
+	void Fill(dsptk::AudioBuffer<double>& buffer) {
+		for (int c = 0; c < buffer.GetNumChannels(); c++) {
+			for (int f = 0; f < buffer.GetNumFrames(); f++) {
+				buffer[c][f] = std::round(std::sin(f * .01 + c) * 30000.) / 32768.;
+			}
+		}
+	}
+
+	void ExpectEqual(const dsptk::AudioBuffer<double>& expected, const dsptk::AudioBuffer<double>& actual) {
+		for (int c = 0; c < expected.GetNumChannels(); c++) {
+			for (int f = 0; f < expected.GetNumFrames(); f++) {
+				ASSERT_EQ(actual[c][f], expected[c][f]) << c << " " << f;
+			}
+		}
+	}
+
+	namespace writer {
+
+		TEST(WavWriter, WritesPlainWaveWithRoomForDs64) {
+			const auto path = TempPath("plain.wav");
+			dsptk::AudioBuffer<double> input(2, 1000);
+			Fill(input);
+
+			dsptk::WavWriter sut;
+			ASSERT_TRUE(sut.Open(path, { dsptk::SampleFormat::Int16, 2, 44100 }));
+			ASSERT_TRUE(sut.Write(input));
+			EXPECT_TRUE(sut.Close());
+
+			auto bytes = ReadBytes(path);
+			// Header of 80 bytes and the samples, the preallocated space is trimmed
+			ASSERT_EQ(bytes.size(), 80 + 4000);
+			EXPECT_EQ(Id(bytes, 0), "RIFF");
+			EXPECT_EQ(Get32(bytes, 4), bytes.size() - 8);
+			EXPECT_EQ(Id(bytes, 12), "JUNK");
+			EXPECT_EQ(Get32(bytes, 16), 28);
+			EXPECT_EQ(Id(bytes, 48), "fmt ");
+			EXPECT_EQ(Get32(bytes, 60), 44100);
+			EXPECT_EQ(Id(bytes, 72), "data");
+			EXPECT_EQ(Get32(bytes, 76), 4000);
+		}
+
+		TEST(WavWriter, ForcedRf64TurnsJunkIntoDs64) {
+			const auto path = TempPath("forced.wav");
+			dsptk::AudioBuffer<double> input(1, 10);
+
+			dsptk::WavWriter sut;
+			ASSERT_TRUE(sut.Open(path, { dsptk::SampleFormat::Int16, 1, 48000 }, true));
+			sut.Write(input);
+			ASSERT_TRUE(sut.Close());
+
+			auto bytes = ReadBytes(path);
+			EXPECT_EQ(Id(bytes, 0), "RF64");
+			EXPECT_EQ(Get32(bytes, 4), 0xFFFFFFFFu);
+			EXPECT_EQ(Id(bytes, 12), "ds64");
+			EXPECT_EQ(Get32(bytes, 20), bytes.size() - 8);
+			EXPECT_EQ(Get32(bytes, 28), 20);
+			EXPECT_EQ(Get32(bytes, 36), 10);
+			EXPECT_EQ(Get32(bytes, 76), 0xFFFFFFFFu);
+		}
+
+		TEST(WavWriter, WritesAcrossChunks) {
+			const auto path = TempPath("chunks.wav");
+			// 24 bits stereo: 6 byte frames don't divide the chunk size
+			const int nFrames = dsptk::WavWriter::chunkBytes / 6 * 2 + 123;
+			dsptk::AudioBuffer<double> input(2, nFrames);
+			Fill(input);
+
+			dsptk::WavWriter sut;
+			ASSERT_TRUE(sut.Open(path, { dsptk::SampleFormat::Int24, 2, 48000 }, false, nFrames));
+			for (int start = 0; start < nFrames; start += 1000) {
+				ASSERT_TRUE(sut.Write(input.SubBlock(start, std::min(1000, nFrames - start))));
+			}
+			ASSERT_TRUE(sut.Close());
+
+			dsptk::WavReader reader(path);
+			ASSERT_TRUE(reader.IsOpen());
+			ASSERT_EQ(reader.GetNumFrames(), nFrames);
+			dsptk::AudioBuffer<double> output(2, nFrames);
+			EXPECT_EQ(reader.Read(0, output), nFrames);
+			ExpectEqual(input, output);
+		}
+
+		TEST(WavWriter, OddDataIsPadded) {
+			const auto path = TempPath("odd.wav");
+			const unsigned char frame[3] = { 1, 2, 3 };
+
+			dsptk::WavWriter sut;
+			ASSERT_TRUE(sut.Open(path, { dsptk::SampleFormat::Int24, 1, 48000 }));
+			sut.WriteInterleaved(frame, 1);
+			ASSERT_TRUE(sut.Close());
+
+			auto bytes = ReadBytes(path);
+			ASSERT_EQ(bytes.size(), 104 + 4);
+			EXPECT_EQ(Get32(bytes, 100), 3);
+			EXPECT_EQ(bytes[104], 1);
+			EXPECT_EQ(bytes.back(), 0);
+		}
+
+		TEST(WavWriter, InvalidFormatOrPathFails) {
+			dsptk::WavWriter sut;
+			EXPECT_FALSE(sut.Open(TempPath("invalid.wav"), { dsptk::SampleFormat::Int16, 0, 48000 }));
+			EXPECT_FALSE(sut.Open(TempPath("missing/directory.wav"), { dsptk::SampleFormat::Int16, 1, 48000 }));
+			EXPECT_FALSE(sut.IsOpen());
+		}
+	}
+
+	namespace reader {
+
+		class Formats : public ::testing::TestWithParam<std::tuple<dsptk::SampleFormat, int, bool>> {};
+
+		TEST_P(Formats, RoundTrip) {
+			const auto [format, numChannels, rf64] = GetParam();
+			const auto path = TempPath("roundtrip.wav");
+			dsptk::AudioBuffer<double> input(numChannels, 4000);
+			Fill(input);
+
+			dsptk::WavWriter writer;
+			ASSERT_TRUE(writer.Open(path, { format, numChannels, 96000 }, rf64));
+			writer.Write(input);
+			ASSERT_TRUE(writer.Close());
+
+			dsptk::WavReader sut(path);
+			ASSERT_TRUE(sut.IsOpen());
+			EXPECT_EQ(sut.IsRf64(), rf64);
+			EXPECT_EQ(sut.GetFormat().format, format);
+			EXPECT_EQ(sut.GetFormat().numChannels, numChannels);
+			EXPECT_EQ(sut.GetFormat().sampleRate, 96000);
+			ASSERT_EQ(sut.GetNumFrames(), 4000);
+
+			dsptk::AudioBuffer<double> output(numChannels, 4000);
+			for (int start = 0; start < 4000; start += 512) {
+				sut.Read(start, output.SubBlock(start, std::min(512, 4000 - start)));
+			}
+			ExpectEqual(input, output);
+		}
+
+		INSTANTIATE_TEST_SUITE_P(WavReader, Formats, ::testing::Combine(
+			::testing::Values(dsptk::SampleFormat::Int16, dsptk::SampleFormat::Int24, dsptk::SampleFormat::Int32, dsptk::SampleFormat::Float32),
+			::testing::Values(1, 2, 6),
+			::testing::Bool()));
+
+		TEST(WavReader, FramesAreInTheMapping) {
+			const auto path = TempPath("frames.wav");
+			const std::int16_t frames[] = { 1, -1, 2, -2, 3, -3 };
+			dsptk::WavWriter writer;
+			ASSERT_TRUE(writer.Open(path, { dsptk::SampleFormat::Int16, 2, 48000 }));
+			writer.WriteInterleaved(frames, 3);
+			ASSERT_TRUE(writer.Close());
+
+			dsptk::WavReader sut(path);
+			auto* samples = static_cast<const std::int16_t*>(sut.GetFrames(1));
+			EXPECT_EQ(samples[0], 2);
+			EXPECT_EQ(samples[3], -3);
+		}
+
+		TEST(WavReader, ReadStopsAtTheEnd) {
+			const auto path = TempPath("end.wav");
+			dsptk::AudioBuffer<double> input(1, 100);
+			Fill(input);
+			dsptk::WavWriter writer;
+			ASSERT_TRUE(writer.Open(path, { dsptk::SampleFormat::Int16, 1, 48000 }));
+			writer.Write(input);
+			ASSERT_TRUE(writer.Close());
+
+			dsptk::WavReader sut(path);
+			dsptk::AudioBuffer<double> output(1, 64);
+			output[0][63] = 7.;
+
+			EXPECT_EQ(sut.Read(90, output), 10);
+			EXPECT_EQ(output[0][9], input[0][99]);
+			EXPECT_EQ(output[0][10], 0.);
+			EXPECT_EQ(output[0][63], 7.);
+			EXPECT_EQ(sut.Read(100, output), 0);
+		}
+
+		// Hand written file: a LIST chunk of odd size before fmt leaves the float samples misaligned
+		TEST(WavReader, SkipsUnknownChunksAndHandlesMisalignedData) {
+			const auto path = TempPath("foreign.wav");
+			std::vector<unsigned char> bytes = { 'R', 'I', 'F', 'F', 0, 0, 0, 0, 'W', 'A', 'V', 'E',
+				'L', 'I', 'S', 'T', 1, 0, 0, 0, 'a', 0,
+				'f', 'm', 't', ' ', 16, 0, 0, 0, 3, 0, 1, 0, 0x44, 0xAC, 0, 0, 0x10, 0xB1, 2, 0, 4, 0, 32, 0,
+				'd', 'a', 't', 'a', 12, 0, 0, 0 };
+			ASSERT_EQ(bytes.size() % 4, 2);
+			const float samples[] = { .5f, -.25f, 1.f };
+			bytes.insert(bytes.end(), reinterpret_cast<const unsigned char*>(samples), reinterpret_cast<const unsigned char*>(samples) + sizeof(samples));
+			std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(bytes.data()), (std::streamsize)bytes.size());
+
+			dsptk::WavReader sut(path);
+			ASSERT_TRUE(sut.IsOpen());
+			EXPECT_FALSE(sut.IsRf64());
+			EXPECT_EQ(sut.GetFormat().sampleRate, 44100);
+			ASSERT_EQ(sut.GetNumFrames(), 3);
+			dsptk::AudioBuffer<float> output(1, 3);
+			sut.Read(0, output);
+			EXPECT_EQ(output[0][0], .5f);
+			EXPECT_EQ(output[0][1], -.25f);
+			EXPECT_EQ(output[0][2], 1.f);
+		}
+
+		TEST(WavReader, RejectsInvalidFiles) {
+			const auto path = TempPath("invalid.wav");
+			std::ofstream(path, std::ios::binary) << "RIFF\x04\0\0\0AVI ";
+
+			dsptk::WavReader sut;
+			EXPECT_FALSE(sut.Open(path));
+			EXPECT_FALSE(sut.Open(TempPath("does_not_exist.wav")));
+			EXPECT_FALSE(sut.IsOpen());
+		}
+
+		// A sparse RF64 file of more than 4GB: the sizes come from ds64 and frames past 4GB are addressable
+		TEST(WavReader, FilesLargerThan4GB) {
+			const auto path = TempPath("large.wav");
+			const std::int64_t nFrames = (std::int64_t(5) << 30) / 2;
+			dsptk::AudioBuffer<double> input(1, 1);
+			{
+				dsptk::WavWriter writer;
+				ASSERT_TRUE(writer.Open(path, { dsptk::SampleFormat::Int16, 1, 48000 }, true));
+				writer.Write(input);
+				ASSERT_TRUE(writer.Close());
+			}
+			// Patches the sizes in ds64 and extends the file without writing the samples
+			const std::uint64_t dataBytes = (std::uint64_t)nFrames * 2;
+			const std::uint64_t riffBytes = 80 - 8 + dataBytes;
+			std::error_code error;
+			std::filesystem::resize_file(path, 80 + dataBytes, error);
+			if (error) {
+				GTEST_SKIP() << "no room for a sparse file: " << error.message();
+			}
+			{
+				std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+				file.seekp(20);
+				file.write(reinterpret_cast<const char*>(&riffBytes), 8);
+				file.write(reinterpret_cast<const char*>(&dataBytes), 8);
+				file.write(reinterpret_cast<const char*>(&nFrames), 8);
+				const std::int16_t last = 16384;
+				file.seekp(80 + (std::streamoff)dataBytes - 2);
+				file.write(reinterpret_cast<const char*>(&last), 2);
+			}
+
+			{
+				dsptk::WavReader sut(path);
+				ASSERT_TRUE(sut.IsOpen());
+				EXPECT_TRUE(sut.IsRf64());
+				ASSERT_EQ(sut.GetNumFrames(), nFrames);
+				dsptk::AudioBuffer<double> output(1, 4);
+				EXPECT_EQ(sut.Read(nFrames - 2, output), 2);
+				EXPECT_EQ(output[0][0], 0.);
+				EXPECT_EQ(output[0][1], .5);
+			}
+			std::filesystem::remove(path);
+		}
+	}
+}
@@ -0,0 +1,661 @@
+/*
+* dsptk_process - Offline batch processing of WAV files.
+*
+* Runs every file of a batch through a processing chain read from a description file and writes the
+* results to an output directory, one file per worker thread. Files longer than a threshold are
+* processed one at a time with their channels spread over the workers instead, so a few long
+* recordings still use every core.
+*
+* Chain description, one processor per line, '#' starts a comment:
+*   highpass frequency=40                         Butterworth high pass (Hz)
+*   lowpass frequency=18000                       Butterworth low pass (Hz)
+*   lowshelf frequency=200 gain=3                 shelving filters (Hz, dB)
+*   highshelf frequency=8000 gain=2
+*   peak frequency=1000 bandwidth=200 gain=-6     parametric filter (Hz, Hz, dB)
+*   compressor threshold=-20 ratio=4 knee=6 attack=5 release=50   (dB, dB, ms)
+*   convolution ir=room.wav gain=0                FIR of an impulse response file (dB), channel c uses IR channel c % IR channels
+* Consecutive filters run in one FilterBank. Channels are processed independently, each with its own chain,
+* and the output has the length of the input (reverb tails are cut).
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "dsptk/audiobuffer.h"
+#include "dsptk/conversion.h"
+#include "dsptk/convolution.h"
+#include "dsptk/dsptypes.h"
+#include "dsptk/dynamics.h"
+#include "dsptk/filters.h"
+#include "dsptk/wavfile.h"
+
+#ifdef _WIN32
+#include <io.h>
+#define isatty _isatty
+#define fileno _fileno
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+	// Chain description
+
+	struct StageType {
+		const char* name;
+		// Parameters and their defaults, NAN when required
+		std::vector<std::pair<std::string, double>> parameters;
+	};
+
+	const StageType stageTypes[] = {
+		{ "highpass", { { "frequency", NAN } } },
+		{ "lowpass", { { "frequency", NAN } } },
+		{ "lowshelf", { { "frequency", NAN }, { "gain", NAN } } },
+		{ "highshelf", { { "frequency", NAN }, { "gain", NAN } } },
+		{ "peak", { { "frequency", NAN }, { "bandwidth", NAN }, { "gain", NAN } } },
+		{ "compressor", { { "threshold", -20. }, { "ratio", 4. }, { "knee", 6. }, { "attack", 5. }, { "release", 50. } } },
+		{ "convolution", { { "gain", 0. } } },
+	};
+
+	struct StageSpec {
+		std::string type;
+		std::map<std::string, double> values;
+		// Impulse response of a convolution, per channel, loaded once for every file
+		std::shared_ptr<const std::vector<std::vector<double>>> impulseResponse;
+		int impulseRate = 0;
+		std::string impulsePath;
+
+		bool IsFilter() const { return type != "compressor" && type != "convolution"; }
+	};
+
+	bool LoadImpulseResponse(StageSpec& spec, std::string& error) {
+		dsptk::WavReader reader(spec.impulsePath);
+		if (!reader.IsOpen() || reader.GetNumFrames() == 0) {
+			error = "can't read the impulse response " + spec.impulsePath;
+			return false;
+		}
+		const int numChannels = reader.GetFormat().numChannels;
+		const int nFrames = (int)reader.GetNumFrames();
+		dsptk::AudioBuffer<double> samples(numChannels, nFrames);
+		reader.Read(0, samples);
+
+		const double gain = dsptk::DB(spec.values["gain"]).asLinearGain();
+		auto channels = std::make_shared<std::vector<std::vector<double>>>();
+		for (int c = 0; c < numChannels; c++) {
+			channels->emplace_back(samples[c].begin(), samples[c].end());
+			for (double& sample : channels->back()) {
+				sample *= gain;
+			}
+		}
+		spec.impulseResponse = channels;
+		spec.impulseRate = reader.GetFormat().sampleRate;
+		return true;
+	}
+
+	bool ParseStage(const std::string& line, StageSpec& spec, std::string& error) {
+		std::istringstream tokens(line);
+		tokens >> spec.type;
+		const StageType* type = nullptr;
+		for (const auto& candidate : stageTypes) {
+			if (spec.type == candidate.name) type = &candidate;
+		}
+		if (!type) {
+			error = "unknown processor '" + spec.type + "'";
+			return false;
+		}
+		for (const auto& parameter : type->parameters) {
+			spec.values[parameter.first] = parameter.second;
+		}
+
+		for (std::string token; tokens >> token;) {
+			const auto equals = token.find('=');
+			const std::string key = token.substr(0, equals);
+			const std::string value = equals == std::string::npos ? "" : token.substr(equals + 1);
+			if (spec.type == "convolution" && key == "ir") {
+				spec.impulsePath = value;
+				continue;
+			}
+			char* end = nullptr;
+			const double number = std::strtod(value.c_str(), &end);
+			if (!spec.values.count(key) || value.empty() || *end != '\0') {
+				error = "invalid parameter '" + token + "' of " + spec.type;
+				return false;
+			}
+			spec.values[key] = number;
+		}
+
+		for (const auto& value : spec.values) {
+			if (std::isnan(value.second)) {
+				error = spec.type + " needs " + value.first;
+				return false;
+			}
+		}
+		if (spec.type == "convolution") {
+			if (spec.impulsePath.empty()) {
+				error = "convolution needs ir";
+				return false;
+			}
+			return LoadImpulseResponse(spec, error);
+		}
+		return true;
+	}
+
+	bool ParseChain(const std::string& path, std::vector<StageSpec>& chain, std::string& error) {
+		std::ifstream file(path);
+		if (!file) {
+			error = "can't read " + path;
+			return false;
+		}
+		int lineNumber = 0;
+		for (std::string line; std::getline(file, line);) {
+			lineNumber++;
+			line = line.substr(0, line.find('#'));
+			if (line.find_first_not_of(" \t\r") == std::string::npos) {
+				continue;
+			}
+			StageSpec spec;
+			if (!ParseStage(line, spec, error)) {
+				error = path + ":" + std::to_string(lineNumber) + ": " + error;
+				return false;
+			}
+			chain.push_back(std::move(spec));
+		}
+		if (chain.empty()) {
+			error = path + ": empty chain";
+			return false;
+		}
+		return true;
+	}
+
+	// Processors, in place on a mono block
+
+	class Stage {
+	public:
+		virtual ~Stage() = default;
+		virtual void Process(double* buffer, int nFrames) = 0;
+	};
+
+	class FilterBankStage : public Stage {
+	public:
+		void Add(std::shared_ptr<dsptk::Filter> filter) {
+			bank.AddFilter(filter);
+		}
+
+		void Process(double* buffer, int nFrames) override {
+			bank.ProcessBlock(buffer, buffer, nFrames);
+		}
+
+	private:
+		dsptk::FilterBank bank;
+	};
+
+	class CompressorStage : public Stage {
+	public:
+		CompressorStage(const StageSpec& spec, double sampleRate, int maxBlockSize)
+			: compressor(spec.values.at("threshold"), spec.values.at("ratio"), spec.values.at("knee"), sampleRate,
+				spec.values.at("attack"), spec.values.at("release")), gain(maxBlockSize)
+		{
+			compressor.Prepare(maxBlockSize);
+		}
+
+		void Process(double* buffer, int nFrames) override {
+			compressor.ProcessBlock(buffer, nullptr, buffer, gain.data(), nFrames);
+		}
+
+	private:
+		dsptk::Compressor compressor;
+		std::vector<double> gain;
+	};
+
+	class ConvolutionStage : public Stage {
+	public:
+		ConvolutionStage(const std::vector<double>& impulseResponse, int maxBlockSize) : convolver(impulseResponse, maxBlockSize) {}
+
+		void Process(double* buffer, int nFrames) override {
+			convolver.ProcessBlock(buffer, buffer, nFrames);
+		}
+
+	private:
+		dsptk::BlockConvolver convolver;
+	};
+
+	std::shared_ptr<dsptk::Filter> MakeFilter(const StageSpec& spec, double sampleRate) {
+		const auto& values = spec.values;
+		if (spec.type == "highpass") return std::make_shared<dsptk::ButterworthHiPass>(values.at("frequency"), sampleRate);
+		if (spec.type == "lowpass") return std::make_shared<dsptk::ButterworthLowPass>(values.at("frequency"), sampleRate);
+		if (spec.type == "lowshelf") return std::make_shared<dsptk::LowPassShelvingFilter>(values.at("frequency"), dsptk::DB(values.at("gain")), sampleRate);
+		if (spec.type == "highshelf") return std::make_shared<dsptk::HiPassShelvingFilter>(values.at("frequency"), dsptk::DB(values.at("gain")), sampleRate);
+		return std::make_shared<dsptk::ParametricFilter>(values.at("frequency"), values.at("bandwidth"), dsptk::DB(values.at("gain")), sampleRate);
+	}
+
+	using Chain = std::vector<std::unique_ptr<Stage>>;
+
+	Chain MakeChain(const std::vector<StageSpec>& specs, double sampleRate, int channel, int maxBlockSize) {
+		Chain chain;
+		FilterBankStage* bank = nullptr;
+		for (const auto& spec : specs) {
+			if (spec.IsFilter()) {
+				if (!bank) {
+					auto stage = std::make_unique<FilterBankStage>();
+					bank = stage.get();
+					chain.push_back(std::move(stage));
+				}
+				bank->Add(MakeFilter(spec, sampleRate));
+				continue;
+			}
+			bank = nullptr;
+			if (spec.type == "compressor") {
+				chain.push_back(std::make_unique<CompressorStage>(spec, sampleRate, maxBlockSize));
+			}
+			else {
+				const auto& channels = *spec.impulseResponse;
+				chain.push_back(std::make_unique<ConvolutionStage>(channels[channel % channels.size()], maxBlockSize));
+			}
+		}
+		return chain;
+	}
+
+	// Workers
+
+	/**
+	 * @brief Fixed set of threads running the iterations of a loop, the calling thread takes part.
+	*/
+	class ThreadPool {
+	public:
+		explicit ThreadPool(int numThreads) {
+			for (int i = 1; i < numThreads; i++) {
+				workers.emplace_back([this]() { Work(); });
+			}
+		}
+
+		~ThreadPool() {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				stopping = true;
+			}
+			wake.notify_all();
+			for (auto& worker : workers) {
+				worker.join();
+			}
+		}
+
+		int GetNumThreads() const { return (int)workers.size() + 1; }
+
+		/**
+		 * @brief Runs task(i) for every i in [0, count) and returns once they are all done.
+		*/
+		void Run(int count, const std::function<void(int)>& task) {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				this->task = &task;
+				this->count = count;
+				next = 0;
+				active = (int)workers.size();
+				generation++;
+			}
+			wake.notify_all();
+			RunTasks();
+			std::unique_lock<std::mutex> lock(mutex);
+			done.wait(lock, [this]() { return active == 0; });
+			this->task = nullptr;
+		}
+
+	private:
+		void Work() {
+			std::uint64_t seen = 0;
+			for (;;) {
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					wake.wait(lock, [&]() { return stopping || generation != seen; });
+					if (stopping) return;
+					seen = generation;
+				}
+				RunTasks();
+				std::lock_guard<std::mutex> lock(mutex);
+				if (--active == 0) done.notify_one();
+			}
+		}
+
+		void RunTasks() {
+			for (int i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+				(*task)(i);
+			}
+		}
+
+		std::vector<std::thread> workers;
+		std::mutex mutex;
+		std::condition_variable wake;
+		std::condition_variable done;
+		const std::function<void(int)>* task = nullptr;
+		int count = 0;
+		std::atomic<int> next{ 0 };
+		int active = 0;
+		std::uint64_t generation = 0;
+		bool stopping = false;
+	};
+
+	/**
+	 * @brief Progress line on stderr, redrawn from a thread of its own, and the per file report on stdout.
+	*/
+	class Progress {
+	public:
+		Progress(std::int64_t totalFrames, int totalFiles, bool enabled)
+			: totalFrames(totalFrames), totalFiles(totalFiles), enabled(enabled), start(std::chrono::steady_clock::now())
+		{
+			if (enabled) {
+				reporter = std::thread([this]() {
+					std::unique_lock<std::mutex> lock(mutex);
+					while (!finished) {
+						Draw();
+						wake.wait_for(lock, std::chrono::milliseconds(500));
+					}
+				});
+			}
+		}
+
+		~Progress() {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				finished = true;
+			}
+			wake.notify_one();
+			if (reporter.joinable()) {
+				reporter.join();
+				std::fprintf(stderr, "\n");
+			}
+		}
+
+		void AddFrames(std::int64_t nFrames) {
+			frames.fetch_add(nFrames, std::memory_order_relaxed);
+		}
+
+		void FileDone(const std::string& report) {
+			std::lock_guard<std::mutex> lock(mutex);
+			filesDone++;
+			if (enabled) {
+				std::fprintf(stderr, "\r%-78s\r", "");
+			}
+			std::printf("%s\n", report.c_str());
+			std::fflush(stdout);
+			if (enabled) {
+				Draw();
+			}
+		}
+
+	private:
+		// Called with the mutex held
+		void Draw() {
+			const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			const double done = totalFrames ? (double)frames.load(std::memory_order_relaxed) / totalFrames : 1.;
+			std::fprintf(stderr, "\r[%5.1f%%] %d/%d files, %.0f s elapsed", done * 100., filesDone, totalFiles, elapsed);
+			if (done > 0. && done < 1.) {
+				std::fprintf(stderr, ", %.0f s left", elapsed / done - elapsed);
+			}
+			std::fprintf(stderr, "   ");
+			std::fflush(stderr);
+		}
+
+		const std::int64_t totalFrames;
+		const int totalFiles;
+		const bool enabled;
+		const std::chrono::steady_clock::time_point start;
+		std::atomic<std::int64_t> frames{ 0 };
+		int filesDone = 0;
+		bool finished = false;
+		std::mutex mutex;
+		std::condition_variable wake;
+		std::thread reporter;
+	};
+
+	// Command line
+
+	struct Options {
+		std::string chainFile;
+		std::string outputDirectory;
+		std::vector<std::string> inputs;
+		int threads = (int)std::max(1u, std::thread::hardware_concurrency());
+		int blockSize = 4096;
+		bool convertFormat = false;
+		dsptk::SampleFormat format = dsptk::SampleFormat::Int16;
+		bool dither = false;
+		double splitSeconds = 600.;
+		// The progress line is redrawn in place, only on terminals
+		bool progress = isatty(fileno(stderr)) != 0;
+	};
+
+	void PrintUsage() {
+		std::printf(
+			"Usage: dsptk_process --chain FILE --output-dir DIR [options] input.wav...\n"
+			"  --chain FILE        processing chain, one processor per line:\n"
+			"                        highpass|lowpass frequency=F\n"
+			"                        lowshelf|highshelf frequency=F gain=dB\n"
+			"                        peak frequency=F bandwidth=B gain=dB\n"
+			"                        compressor threshold=dB ratio=R knee=dB attack=ms release=ms\n"
+			"                        convolution ir=FILE.wav gain=dB\n"
+			"  --output-dir DIR    where the processed files are written, with the names of the inputs\n"
+			"  --list FILE         also process the files listed in FILE, one path per line\n"
+			"  --threads N         worker threads, default the number of cores\n"
+			"  --block N           block size in frames, default 4096\n"
+			"  --format F          output format int16, int24, int32 or float32, default the input's\n"
+			"  --dither            TPDF dither when writing integers\n"
+			"  --split-seconds S   files longer than S seconds are processed channel-parallel, default 600\n"
+			"  --no-progress       don't draw the progress line (only drawn on terminals)\n");
+	}
+
+	bool ParseFormat(const std::string& name, dsptk::SampleFormat& format) {
+		if (name == "int16") format = dsptk::SampleFormat::Int16;
+		else if (name == "int24") format = dsptk::SampleFormat::Int24;
+		else if (name == "int32") format = dsptk::SampleFormat::Int32;
+		else if (name == "float32") format = dsptk::SampleFormat::Float32;
+		else return false;
+		return true;
+	}
+
+	bool ParseOptions(int argc, char** argv, Options& options) {
+		for (int i = 1; i < argc; i++) {
+			const std::string arg = argv[i];
+			const bool hasValue = i + 1 < argc;
+			if (arg == "--chain" && hasValue) options.chainFile = argv[++i];
+			else if (arg == "--output-dir" && hasValue) options.outputDirectory = argv[++i];
+			else if (arg == "--list" && hasValue) {
+				std::ifstream list(argv[++i]);
+				if (!list) return false;
+				for (std::string path; std::getline(list, path);) {
+					if (!path.empty() && path.back() == '\r') path.pop_back();
+					if (!path.empty()) options.inputs.push_back(path);
+				}
+			}
+			else if (arg == "--threads" && hasValue) options.threads = std::atoi(argv[++i]);
+			else if (arg == "--block" && hasValue) options.blockSize = std::atoi(argv[++i]);
+			else if (arg == "--format" && hasValue) {
+				if (!ParseFormat(argv[++i], options.format)) return false;
+				options.convertFormat = true;
+			}
+			else if (arg == "--dither") options.dither = true;
+			else if (arg == "--split-seconds" && hasValue) options.splitSeconds = std::atof(argv[++i]);
+			else if (arg == "--no-progress") options.progress = false;
+			else if (!arg.empty() && arg[0] != '-') options.inputs.push_back(arg);
+			else return false;
+		}
+		return !options.chainFile.empty() && !options.outputDirectory.empty() && !options.inputs.empty()
+			&& options.threads > 0 && options.blockSize > 0 && options.splitSeconds >= 0.;
+	}
+
+	// Batch
+
+	struct Job {
+		std::string input;
+		std::string output;
+		dsptk::WavFormat format;
+		std::int64_t numFrames = 0;
+		bool channelParallel = false;
+	};
+
+	/**
+	 * @brief Processes a file block by block, the channels of a block on the pool when given one.
+	 * @return an empty string or the error.
+	*/
+	std::string ProcessFile(const Options& options, const std::vector<StageSpec>& specs, const Job& job, int index,
+		ThreadPool* channelPool, Progress& progress)
+	{
+		dsptk::WavReader reader(job.input);
+		if (!reader.IsOpen()) {
+			return "can't read the file";
+		}
+		const int numChannels = job.format.numChannels;
+		for (const auto& spec : specs) {
+			if (spec.impulseResponse && spec.impulseRate != job.format.sampleRate) {
+				return "the sample rate of " + spec.impulsePath + " is " + std::to_string(spec.impulseRate) + " Hz";
+			}
+		}
+
+		std::vector<Chain> chains;
+		for (int c = 0; c < numChannels; c++) {
+			chains.push_back(MakeChain(specs, job.format.sampleRate, c, options.blockSize));
+		}
+
+		dsptk::WavFormat outputFormat = job.format;
+		if (options.convertFormat) {
+			outputFormat.format = options.format;
+		}
+		dsptk::WavWriter writer;
+		if (!writer.Open(job.output, outputFormat, false, job.numFrames)) {
+			return "can't create " + job.output;
+		}
+		dsptk::TpdfDither dither((std::uint64_t)index + 1);
+
+		dsptk::AudioBuffer<double> buffer(numChannels, options.blockSize);
+		int nFrames = 0;
+		const std::function<void(int)> processChannel = [&](int c) {
+			for (auto& stage : chains[c]) {
+				stage->Process(buffer[c].data(), nFrames);
+			}
+		};
+		for (std::int64_t start = 0; start < job.numFrames; start += nFrames) {
+			nFrames = reader.Read(start, buffer);
+			if (nFrames == 0) {
+				return "the file was truncated";
+			}
+			if (channelPool) {
+				channelPool->Run(numChannels, processChannel);
+			}
+			else {
+				for (int c = 0; c < numChannels; c++) processChannel(c);
+			}
+			if (!writer.Write(buffer.SubBlock(0, nFrames), options.dither ? &dither : nullptr)) {
+				return "can't write " + job.output;
+			}
+			progress.AddFrames(nFrames);
+		}
+		return writer.Close() ? std::string() : "can't write " + job.output;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Options options;
+	if (!ParseOptions(argc, argv, options)) {
+		PrintUsage();
+		return 2;
+	}
+
+	std::vector<StageSpec> specs;
+	std::string error;
+	if (!ParseChain(options.chainFile, specs, error)) {
+		std::printf("%s\n", error.c_str());
+		return 2;
+	}
+
+	std::error_code directoryError;
+	std::filesystem::create_directories(options.outputDirectory, directoryError);
+	if (directoryError) {
+		std::printf("Can't create %s: %s\n", options.outputDirectory.c_str(), directoryError.message().c_str());
+		return 2;
+	}
+
+	// Headers are read up front for the progress total and to pick the mode of each file
+	std::vector<Job> jobs;
+	std::set<std::string> outputs;
+	std::int64_t totalFrames = 0;
+	for (const auto& input : options.inputs) {
+		Job job;
+		job.input = input;
+		job.output = (std::filesystem::path(options.outputDirectory) / std::filesystem::path(input).filename()).string();
+		dsptk::WavReader reader(input);
+		if (!reader.IsOpen()) {
+			std::printf("Can't read %s: missing, not a WAV file or unsupported format\n", input.c_str());
+			return 2;
+		}
+		std::error_code sameError;
+		if (!outputs.insert(job.output).second || std::filesystem::equivalent(input, job.output, sameError)) {
+			std::printf("%s would overwrite an input or another output\n", job.output.c_str());
+			return 2;
+		}
+		job.format = reader.GetFormat();
+		job.numFrames = reader.GetNumFrames();
+		job.channelParallel = job.format.numChannels > 1 && options.threads > 1
+			&& job.numFrames > options.splitSeconds * job.format.sampleRate;
+		totalFrames += job.numFrames;
+		jobs.push_back(job);
+	}
+
+	ThreadPool pool(options.threads);
+	std::atomic<int> failures{ 0 };
+	const auto batchStart = std::chrono::steady_clock::now();
+	double audioSeconds = 0.;
+	{
+		Progress progress(totalFrames, (int)jobs.size(), options.progress);
+		auto run = [&](int index, ThreadPool* channelPool) {
+			const Job& job = jobs[index];
+			const auto start = std::chrono::steady_clock::now();
+			const std::string fileError = ProcessFile(options, specs, job, index, channelPool, progress);
+			const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			const double duration = (double)job.numFrames / job.format.sampleRate;
+
+			char report[160];
+			if (fileError.empty()) {
+				std::snprintf(report, sizeof(report), "%8.2f s %8.1fx realtime%s  ", seconds, duration / std::max(seconds, 1e-9),
+					channelPool ? " (channels)" : "");
+			}
+			else {
+				failures++;
+				std::snprintf(report, sizeof(report), "  FAILED: %s  ", fileError.c_str());
+			}
+			progress.FileDone(report + job.input + " -> " + job.output);
+		};
+
+		// Long files first, each with all the workers, then the others a file per worker
+		std::vector<int> perFile;
+		for (int i = 0; i < (int)jobs.size(); i++) {
+			if (jobs[i].channelParallel) {
+				run(i, &pool);
+			}
+			else {
+				perFile.push_back(i);
+			}
+			audioSeconds += (double)jobs[i].numFrames / jobs[i].format.sampleRate;
+		}
+		pool.Run((int)perFile.size(), [&](int i) { run(perFile[i], nullptr); });
+	}
+
+	const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - batchStart).count();
+	std::printf("%zu files, %d failed, %.1f s of audio in %.2f s (%.1fx realtime) on %d threads\n", jobs.size(), failures.load(),
+		audioSeconds, elapsed, audioSeconds / std::max(elapsed, 1e-9), pool.GetNumThreads());
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,148 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "dsptk/audiobuffer.h"
+#include "dsptk/wavfile.h"
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#endif
+
+// End to end runs of dsptk_process (DSPTK_PROCESS is its path) on generated files
+namespace process {
+
+	namespace fs = std::filesystem;
+
+	class Process : public ::testing::Test {
+	protected:
+		void SetUp() override {
+			directory = fs::path(::testing::TempDir()) / ("dsptk_process_" + std::string(::testing::UnitTest::GetInstance()->current_test_info()->name()));
+			fs::remove_all(directory);
+			fs::create_directories(directory);
+		}
+
+		void TearDown() override {
+			fs::remove_all(directory);
+		}
+
+		std::string Path(const std::string& name) const {
+			return (directory / name).string();
+		}
+
+		void WriteChain(const std::string& text) const {
+			std::ofstream(Path("chain.txt")) << text;
+		}
+
+		std::string WriteInput(const std::string& name, int numChannels, int nFrames, dsptk::SampleFormat format = dsptk::SampleFormat::Float32) const {
+			dsptk::AudioBuffer<double> samples(numChannels, nFrames);
+			for (int c = 0; c < numChannels; c++) {
+				for (int f = 0; f < nFrames; f++) {
+					samples[c][f] = .5 * std::sin(f * .01 * (c + 1)) + .1;
+				}
+			}
+			dsptk::WavWriter writer;
+			writer.Open(Path(name), { format, numChannels, 48000 });
+			writer.Write(samples);
+			writer.Close();
+			return Path(name);
+		}
+
+		int Run(const std::string& arguments) const {
+			const std::string command = std::string("\"") + DSPTK_PROCESS + "\" --no-progress --chain \"" + Path("chain.txt")
+				+ "\" --output-dir \"" + Path("out") + "\" " + arguments + " > \"" + Path("log.txt") + "\"";
+			const int status = std::system(command.c_str());
+#ifdef _WIN32
+			return status;
+#else
+			return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+#endif
+		}
+
+		dsptk::AudioBuffer<double> ReadOutput(const std::string& name) const {
+			dsptk::WavReader reader(Path("out/" + name));
+			EXPECT_TRUE(reader.IsOpen()) << name;
+			dsptk::AudioBuffer<double> samples(reader.GetFormat().numChannels, (int)reader.GetNumFrames());
+			reader.Read(0, samples);
+			return samples;
+		}
+
+		fs::path directory;
+	};
+
+	TEST_F(Process, ProcessesABatch) {
+		WriteChain("# cleanup\nhighpass frequency=40\npeak frequency=1000 bandwidth=200 gain=-6\ncompressor threshold=-20 ratio=4\n");
+		const auto first = WriteInput("first.wav", 2, 10000, dsptk::SampleFormat::Int16);
+		const auto second = WriteInput("second.wav", 1, 5000, dsptk::SampleFormat::Int24);
+
+		ASSERT_EQ(Run("--threads 2 \"" + first + "\" \"" + second + "\""), 0);
+
+		dsptk::WavReader output(Path("out/first.wav"));
+		ASSERT_TRUE(output.IsOpen());
+		EXPECT_EQ(output.GetFormat().format, dsptk::SampleFormat::Int16);
+		EXPECT_EQ(output.GetFormat().numChannels, 2);
+		EXPECT_EQ(output.GetNumFrames(), 10000);
+		auto samples = ReadOutput("second.wav");
+		EXPECT_EQ(samples.GetNumFrames(), 5000);
+		// The high pass removed the offset
+		double sum = 0.;
+		for (int f = 2500; f < 5000; f++) sum += samples[0][f];
+		EXPECT_NEAR(sum / 2500, 0., .02);
+	}
+
+	TEST_F(Process, ChannelParallelMatchesFileParallel) {
+		WriteChain("lowshelf frequency=200 gain=3\ncompressor\nhighshelf frequency=8000 gain=2\n");
+		const auto input = WriteInput("long.wav", 4, 20000);
+
+		ASSERT_EQ(Run("--threads 3 --block 1000 --split-seconds 1000 \"" + input + "\""), 0);
+		auto expected = ReadOutput("long.wav");
+		ASSERT_EQ(Run("--threads 3 --block 1000 --split-seconds 0 \"" + input + "\""), 0);
+		auto output = ReadOutput("long.wav");
+
+		for (int c = 0; c < 4; c++) {
+			for (int f = 0; f < 20000; f++) {
+				ASSERT_EQ(output[c][f], expected[c][f]) << c << " " << f;
+			}
+		}
+		std::ifstream log(Path("log.txt"));
+		EXPECT_NE(std::string(std::istreambuf_iterator<char>(log), {}).find("(channels)"), std::string::npos);
+	}
+
+	TEST_F(Process, ConvolutionCarriesTheTailAcrossBlocks) {
+		// A delayed impulse, at half gain: a delay longer than the blocks
+		dsptk::AudioBuffer<double> impulse(1, 100);
+		impulse[0][99] = .5;
+		dsptk::WavWriter writer;
+		writer.Open(Path("ir.wav"), { dsptk::SampleFormat::Float32, 1, 48000 });
+		writer.Write(impulse);
+		writer.Close();
+		WriteChain("convolution ir=" + Path("ir.wav") + " gain=6.0206\n");
+		const auto input = WriteInput("dry.wav", 2, 1000);
+
+		ASSERT_EQ(Run("--block 64 --format float32 \"" + input + "\""), 0);
+
+		dsptk::WavReader reader(input);
+		dsptk::AudioBuffer<double> dry(2, 1000);
+		reader.Read(0, dry);
+		auto wet = ReadOutput("dry.wav");
+		for (int c = 0; c < 2; c++) {
+			EXPECT_NEAR(wet[c][98], 0., 1e-9);
+			for (int f = 99; f < 1000; f++) {
+				ASSERT_NEAR(wet[c][f], dry[c][f - 99], 1e-6) << c << " " << f;
+			}
+		}
+	}
+
+	TEST_F(Process, InvalidChainFails) {
+		WriteChain("highpass\n");
+		const auto input = WriteInput("input.wav", 1, 100);
+		EXPECT_EQ(Run("\"" + input + "\""), 2);
+
+		WriteChain("equalizer frequency=100\n");
+		EXPECT_EQ(Run("\"" + input + "\""), 2);
+		EXPECT_FALSE(fs::exists(Path("out/input.wav")));
+	}
+}
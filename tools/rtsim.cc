@@ -0,0 +1,493 @@
+/*
+* dsptk_rtsim - Real-time callback simulator.
+*
+* Drives a chain of dsptk processors from a timer thread at a fixed block size, as an audio driver would,
+* and reports the distribution of the per block execution time against the block deadline.
+* Global operator new/delete are replaced in this program so any heap allocation made while the
+* callback runs is counted: allocating in the audio thread can block on the allocator lock.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "dsptk/arena.h"
+#include "dsptk/convolution.h"
+#include "dsptk/detector.h"
+#include "dsptk/dynamics.h"
+#include "dsptk/filters.h"
+#include "dsptk/metering.h"
+#include "dsptk/signals.h"
+#include "dsptk/tracing.h"
+
+// Allocation tracking
+
+namespace {
+	thread_local bool inCallback = false;
+	std::atomic<std::uint64_t> callbackAllocations{ 0 };
+	std::atomic<std::uint64_t> callbackDeallocations{ 0 };
+
+	void* Allocate(std::size_t size) {
+		if (inCallback) callbackAllocations.fetch_add(1, std::memory_order_relaxed);
+		if (void* p = std::malloc(size ? size : 1)) return p;
+		throw std::bad_alloc();
+	}
+
+	void* AllocateAligned(std::size_t size, std::align_val_t alignment) {
+		if (inCallback) callbackAllocations.fetch_add(1, std::memory_order_relaxed);
+		const std::size_t align = (std::size_t)alignment;
+#ifdef _WIN32
+		if (void* p = _aligned_malloc(size ? size : 1, align)) return p;
+#else
+		// aligned_alloc needs a multiple of the alignment
+		if (void* p = std::aligned_alloc(align, (std::max<std::size_t>(size, 1) + align - 1) / align * align)) return p;
+#endif
+		throw std::bad_alloc();
+	}
+
+	void Deallocate(void* p) noexcept {
+		if (p && inCallback) callbackDeallocations.fetch_add(1, std::memory_order_relaxed);
+		std::free(p);
+	}
+
+	void DeallocateAligned(void* p) noexcept {
+		if (p && inCallback) callbackDeallocations.fetch_add(1, std::memory_order_relaxed);
+#ifdef _WIN32
+		_aligned_free(p);
+#else
+		std::free(p);
+#endif
+	}
+}
+
+void* operator new(std::size_t size) { return Allocate(size); }
+void* operator new[](std::size_t size) { return Allocate(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { try { return Allocate(size); } catch (...) { return nullptr; } }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { try { return Allocate(size); } catch (...) { return nullptr; } }
+void* operator new(std::size_t size, std::align_val_t alignment) { return AllocateAligned(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return AllocateAligned(size, alignment); }
+void operator delete(void* p) noexcept { Deallocate(p); }
+void operator delete[](void* p) noexcept { Deallocate(p); }
+void operator delete(void* p, std::size_t) noexcept { Deallocate(p); }
+void operator delete[](void* p, std::size_t) noexcept { Deallocate(p); }
+void operator delete(void* p, std::align_val_t) noexcept { DeallocateAligned(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { DeallocateAligned(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { DeallocateAligned(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { DeallocateAligned(p); }
+
+// Processing chain
+
+namespace {
+
+	/**
+	 * @brief A processor of the chain, in place on a mono block. Buffers are allocated by the constructor,
+	 * temporary ones come from the scratch arena shared by the chain.
+	*/
+	class Stage {
+	public:
+		virtual ~Stage() = default;
+		virtual void Process(double* buffer, int nFrames) = 0;
+
+		/**
+		 * @brief Scratch memory the stage takes from the arena per block.
+		*/
+		virtual std::size_t ScratchBytes(int /*maxBlockSize*/) const { return 0; }
+		virtual void Prepare(int /*maxBlockSize*/, dsptk::ScratchArena& /*arena*/) {}
+	};
+
+	// 4 band equalizer
+	class FilterBankStage : public Stage {
+	public:
+		explicit FilterBankStage(double sampleRate) {
+			std::shared_ptr<dsptk::Filter> filters[] = {
+				std::make_shared<dsptk::ButterworthHiPass>(40., sampleRate),
+				std::make_shared<dsptk::LowPassShelvingFilter>(200., dsptk::DB(3.), sampleRate),
+				std::make_shared<dsptk::ParametricFilter>(1000., 200., dsptk::DB(-6.), sampleRate),
+				std::make_shared<dsptk::HiPassShelvingFilter>(8000., dsptk::DB(2.), sampleRate)
+			};
+			for (auto& filter : filters) {
+				bank.AddFilter(filter);
+			}
+		}
+
+		void Process(double* buffer, int nFrames) override {
+			bank.ProcessBlock(buffer, buffer, nFrames);
+		}
+
+	private:
+		dsptk::FilterBank bank;
+	};
+
+	class CompressorStage : public Stage {
+	public:
+		CompressorStage(double sampleRate, int maxBlockSize)
+			: compressor(-20., 4., 6., sampleRate, 0.005, 0.1), gain(maxBlockSize) {}
+
+		void Process(double* buffer, int nFrames) override {
+			compressor.ProcessBlock(buffer, nullptr, buffer, gain.data(), nFrames);
+		}
+
+		std::size_t ScratchBytes(int maxBlockSize) const override {
+			return dsptk::Compressor::ScratchBytes(maxBlockSize);
+		}
+
+		void Prepare(int maxBlockSize, dsptk::ScratchArena& arena) override {
+			compressor.Prepare(maxBlockSize, &arena);
+		}
+
+	private:
+		dsptk::Compressor compressor;
+		std::vector<double> gain;
+	};
+
+	class GateStage : public Stage {
+	public:
+		GateStage(double sampleRate, int maxBlockSize)
+			: gate(-50., -80., sampleRate, 0.001, 0.1), gain(maxBlockSize) {}
+
+		void Process(double* buffer, int nFrames) override {
+			gate.ProcessBlock(buffer, nullptr, buffer, gain.data(), nFrames);
+		}
+
+	private:
+		dsptk::Gate gate;
+		std::vector<double> gain;
+	};
+
+	class MultibandStage : public Stage {
+	public:
+		MultibandStage(double sampleRate, int maxBlockSize)
+			: compressor({ 200., 2000., 8000. }, sampleRate)
+		{
+			compressor.Prepare(sampleRate, maxBlockSize);
+			for (int band = 0; band < compressor.GetNumBands(); band++) {
+				compressor.SetThreshold(band, -20.);
+				compressor.SetRatio(band, 4.);
+			}
+		}
+
+		void Process(double* buffer, int nFrames) override {
+			compressor.ProcessBlock(buffer, nFrames);
+		}
+
+	private:
+		dsptk::MultibandCompressor compressor;
+	};
+
+	class LoudnessStage : public Stage {
+	public:
+		explicit LoudnessStage(double sampleRate) : meter(1, sampleRate) {}
+
+		void Process(double* buffer, int nFrames) override {
+			const double* channels[] = { buffer };
+			meter.ProcessBlock(channels, nFrames);
+		}
+
+	private:
+		dsptk::LoudnessMeter meter;
+	};
+
+	class TruePeakStage : public Stage {
+	public:
+		explicit TruePeakStage(int maxBlockSize) : meter(1, maxBlockSize) {}
+
+		void Process(double* buffer, int nFrames) override {
+			const double* channels[] = { buffer };
+			meter.ProcessBlock(channels, nFrames);
+		}
+
+	private:
+		dsptk::TruePeakMeter meter;
+	};
+
+	class RmsStage : public Stage {
+	public:
+		RmsStage(double sampleRate, int maxBlockSize) : detector(sampleRate, 0.3), level(maxBlockSize) {}
+
+		void Process(double* buffer, int nFrames) override {
+			detector.ProcessBlock(buffer, level.data(), nFrames);
+		}
+
+	private:
+		dsptk::RmsDetector detector;
+		std::vector<double> level;
+	};
+
+	// Convolution reverb with half a second of exponentially decaying noise, 60 dB down at its end
+	class ConvolverStage : public Stage {
+	public:
+		ConvolverStage(double sampleRate, int maxBlockSize) : convolver(Reverb(sampleRate), maxBlockSize) {}
+
+		void Process(double* buffer, int nFrames) override {
+			convolver.ProcessBlock(buffer, buffer, nFrames);
+		}
+
+	private:
+		dsptk::BlockConvolver convolver;
+
+		static std::vector<double> Reverb(double sampleRate) {
+			std::vector<double> response((std::size_t)(0.5 * sampleRate));
+			dsptk::WhiteNoise(dsptk::WhiteNoise::Distribution::Gaussian, 0.05, 2).Generate(response.data(), (int)response.size());
+			for (std::size_t i = 0; i < response.size(); i++) {
+				response[i] *= std::exp(-6.9 * i / response.size());
+			}
+			return response;
+		}
+	};
+
+	const char* stageNames = "filterbank, compressor, gate, multiband, loudness, truepeak, rms, convolver";
+
+	std::unique_ptr<Stage> MakeStage(const std::string& name, double sampleRate, int maxBlockSize) {
+		if (name == "filterbank") return std::make_unique<FilterBankStage>(sampleRate);
+		if (name == "compressor") return std::make_unique<CompressorStage>(sampleRate, maxBlockSize);
+		if (name == "gate") return std::make_unique<GateStage>(sampleRate, maxBlockSize);
+		if (name == "multiband") return std::make_unique<MultibandStage>(sampleRate, maxBlockSize);
+		if (name == "loudness") return std::make_unique<LoudnessStage>(sampleRate);
+		if (name == "truepeak") return std::make_unique<TruePeakStage>(maxBlockSize);
+		if (name == "rms") return std::make_unique<RmsStage>(sampleRate, maxBlockSize);
+		if (name == "convolver") return std::make_unique<ConvolverStage>(sampleRate, maxBlockSize);
+		return nullptr;
+	}
+
+	// Command line
+
+	struct Options {
+		std::vector<std::string> chain{ "filterbank", "compressor" };
+		int blockSize = 256;
+		double sampleRate = 48000.;
+		double seconds = 10.;
+		bool failOnAllocation = false;
+		bool failOnMiss = false;
+		std::string traceFile;
+	};
+
+	void PrintUsage() {
+		std::printf(
+			"Usage: dsptk_rtsim [options]\n"
+			"  --chain a,b,...     processors in order (%s), default filterbank,compressor\n"
+			"  --block N           block size in samples, default 256\n"
+			"  --rate R            sample rate, default 48000\n"
+			"  --seconds S         simulated time, default 10\n"
+			"  --fail-on-alloc     exit with an error when the callback allocates\n"
+			"  --fail-on-miss      exit with an error when a block takes longer than its deadline\n"
+			"  --trace FILE        write a Chrome trace (chrome://tracing, ui.perfetto.dev) of the callbacks\n",
+			stageNames);
+	}
+
+	bool ParseOptions(int argc, char** argv, Options& options) {
+		for (int i = 1; i < argc; i++) {
+			const std::string arg = argv[i];
+			const bool hasValue = i + 1 < argc;
+			if (arg == "--chain" && hasValue) {
+				options.chain.clear();
+				std::stringstream list(argv[++i]);
+				for (std::string name; std::getline(list, name, ',');) {
+					options.chain.push_back(name);
+				}
+			}
+			else if (arg == "--block" && hasValue) options.blockSize = std::atoi(argv[++i]);
+			else if (arg == "--rate" && hasValue) options.sampleRate = std::atof(argv[++i]);
+			else if (arg == "--seconds" && hasValue) options.seconds = std::atof(argv[++i]);
+			else if (arg == "--fail-on-alloc") options.failOnAllocation = true;
+			else if (arg == "--fail-on-miss") options.failOnMiss = true;
+			else if (arg == "--trace" && hasValue) options.traceFile = argv[++i];
+			else return false;
+		}
+		return options.blockSize > 0 && options.sampleRate > 0. && options.seconds > 0.;
+	}
+
+	// Statistics
+
+	double Percentile(const std::vector<double>& sorted, double p) {
+		if (sorted.empty()) return 0.;
+		const std::size_t index = std::min(sorted.size() - 1, (std::size_t)std::ceil(p / 100. * sorted.size()) - 1);
+		return sorted[index];
+	}
+
+	void PrintHistogram(const std::vector<double>& times, double deadline) {
+		// Octave buckets in microseconds, [2^(b-1), 2^b) us, bucket 0 below 1 us
+		constexpr int buckets = 24;
+		std::size_t counts[buckets] = {};
+		for (double t : times) {
+			const int b = t < 1e-6 ? 0 : 1 + (int)std::floor(std::log2(t * 1e6));
+			counts[std::min(b, buckets - 1)]++;
+		}
+
+		int first = 0, last = buckets - 1;
+		while (first < last && counts[first] == 0) first++;
+		while (last > first && counts[last] == 0) last--;
+		const std::size_t largest = *std::max_element(counts, counts + buckets);
+
+		for (int b = first; b <= last; b++) {
+			const double low = b == 0 ? 0. : std::ldexp(1., b - 1);
+			const double high = std::ldexp(1., b);
+			const int width = (int)std::ceil(50. * counts[b] / largest);
+			std::printf("  %8.0f-%-8.0f us %-50s %zu%s\n", low, high, std::string(width, '#').c_str(), counts[b],
+				deadline * 1e6 >= low && deadline * 1e6 < high ? "  <- deadline" : "");
+		}
+	}
+
+	void PromoteToRealtime() {
+#if defined(__unix__) || defined(__APPLE__)
+		sched_param param{};
+		param.sched_priority = sched_get_priority_max(SCHED_FIFO);
+		if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) != 0) {
+			std::printf("note: running without real-time priority (SCHED_FIFO not permitted)\n");
+		}
+#endif
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Options options;
+	if (!ParseOptions(argc, argv, options)) {
+		PrintUsage();
+		return 2;
+	}
+
+	std::vector<std::unique_ptr<Stage>> chain;
+	for (auto& name : options.chain) {
+		auto stage = MakeStage(name, options.sampleRate, options.blockSize);
+		if (!stage) {
+			std::printf("Unknown processor '%s', available: %s\n", name.c_str(), stageNames);
+			return 2;
+		}
+		chain.push_back(std::move(stage));
+	}
+
+	// Stages run one after the other and give their scratch back, the arena holds the largest need
+	std::size_t scratchBytes = 0;
+	for (auto& stage : chain) {
+		scratchBytes = std::max(scratchBytes, stage->ScratchBytes(options.blockSize));
+	}
+	dsptk::ScratchArena scratch(scratchBytes);
+	for (auto& stage : chain) {
+		stage->Prepare(options.blockSize, scratch);
+	}
+
+	// One second of pink noise played in a loop, the driver's input
+	std::vector<double> source((std::size_t)options.sampleRate);
+	dsptk::PinkNoise(0.5, 1).Generate(source.data(), (int)source.size());
+
+	const std::size_t numBlocks = (std::size_t)std::ceil(options.seconds * options.sampleRate / options.blockSize);
+	const std::chrono::duration<double> period(options.blockSize / options.sampleRate);
+	std::vector<double> executionTimes(numBlocks);
+	std::vector<double> wakeLatencies(numBlocks);
+	std::vector<std::size_t> allocatingBlocks;
+	allocatingBlocks.reserve(16);
+	std::vector<double> buffer(options.blockSize);
+
+	if (!options.traceFile.empty()) {
+		// A second of blocks per stage is enough to look at, the ring keeps the last ones
+		dsptk::tracing::SetBufferCapacity(1 << 18);
+		dsptk::tracing::Enable();
+	}
+
+	std::thread audioThread([&]() {
+		PromoteToRealtime();
+		if (dsptk::tracing::IsEnabled()) {
+			dsptk::tracing::RegisterThread("audio callback");
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+		std::size_t sourcePosition = 0;
+		for (std::size_t block = 0; block < numBlocks; block++) {
+			const auto due = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(period * (double)block);
+			std::this_thread::sleep_until(due);
+
+			// Driver side: hand over the next input block
+			for (double& sample : buffer) {
+				sample = source[sourcePosition];
+				sourcePosition = sourcePosition + 1 == source.size() ? 0 : sourcePosition + 1;
+			}
+			const std::uint64_t allocationsBefore = callbackAllocations.load(std::memory_order_relaxed);
+
+			const auto begin = std::chrono::steady_clock::now();
+			inCallback = true;
+			{
+				DSPTK_TRACE_SCOPE("callback", (std::int64_t)block);
+				for (auto& stage : chain) {
+					stage->Process(buffer.data(), options.blockSize);
+				}
+				scratch.Reset();
+			}
+			inCallback = false;
+			const auto end = std::chrono::steady_clock::now();
+
+			executionTimes[block] = std::chrono::duration<double>(end - begin).count();
+			wakeLatencies[block] = std::chrono::duration<double>(begin - due).count();
+			if (callbackAllocations.load(std::memory_order_relaxed) != allocationsBefore && allocatingBlocks.size() < allocatingBlocks.capacity()) {
+				allocatingBlocks.push_back(block);
+			}
+		}
+	});
+	audioThread.join();
+
+	if (!options.traceFile.empty()) {
+		dsptk::tracing::Disable();
+		if (!dsptk::tracing::WriteChromeTrace(options.traceFile)) {
+			std::printf("Can't write the trace to %s\n", options.traceFile.c_str());
+			return 2;
+		}
+	}
+
+	// A block misses its deadline when it is not done by the time the next one is due,
+	// overruns are the misses the processing causes by itself, whatever the wake up latency
+	const double deadline = period.count();
+	std::size_t misses = 0;
+	std::size_t overruns = 0;
+	for (std::size_t block = 0; block < numBlocks; block++) {
+		if (wakeLatencies[block] + executionTimes[block] > deadline) misses++;
+		if (executionTimes[block] > deadline) overruns++;
+	}
+
+	std::vector<double> sortedTimes = executionTimes;
+	std::sort(sortedTimes.begin(), sortedTimes.end());
+	std::vector<double> sortedLatencies = wakeLatencies;
+	std::sort(sortedLatencies.begin(), sortedLatencies.end());
+
+	std::printf("Chain:");
+	for (auto& name : options.chain) std::printf(" %s", name.c_str());
+	std::printf("\nBlocks: %zu x %d samples at %.0f Hz, deadline %.1f us\n\n", numBlocks, options.blockSize, options.sampleRate, deadline * 1e6);
+
+	std::printf("Execution time     p50 %9.2f us  p99 %9.2f us  p99.9 %9.2f us  max %9.2f us (%.1f%% of the deadline)\n",
+		Percentile(sortedTimes, 50.) * 1e6, Percentile(sortedTimes, 99.) * 1e6, Percentile(sortedTimes, 99.9) * 1e6,
+		sortedTimes.back() * 1e6, sortedTimes.back() / deadline * 100.);
+	std::printf("Wake up latency    p50 %9.2f us  p99 %9.2f us  p99.9 %9.2f us  max %9.2f us\n\n",
+		Percentile(sortedLatencies, 50.) * 1e6, Percentile(sortedLatencies, 99.) * 1e6, Percentile(sortedLatencies, 99.9) * 1e6,
+		sortedLatencies.back() * 1e6);
+
+	std::printf("Execution time histogram:\n");
+	PrintHistogram(executionTimes, deadline);
+
+	std::printf("\nDeadline misses: %zu, execution alone over the deadline: %zu\n", misses, overruns);
+	std::printf("Allocations in the callback: %llu, deallocations: %llu\n",
+		(unsigned long long)callbackAllocations.load(), (unsigned long long)callbackDeallocations.load());
+	const dsptk::ArenaStats scratchStats = scratch.GetStats();
+	std::printf("Scratch arena: %zu bytes, high water %zu bytes, overflows %zu\n",
+		scratchStats.capacity, scratchStats.highWater, scratchStats.overflows);
+	if (!allocatingBlocks.empty()) {
+		std::printf("  first allocating blocks:");
+		for (std::size_t block : allocatingBlocks) std::printf(" %zu", block);
+		std::printf("\n");
+	}
+
+	if (options.failOnAllocation && (callbackAllocations.load() || callbackDeallocations.load())) return 1;
+	if (options.failOnMiss && overruns) return 1;
+	return 0;
+}